@@ -0,0 +1,1539 @@
+﻿/*
+Copyright (C) 2013 Peter Huene
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "MonoDataSqliteWrapper.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+
+/*
+Fixed-size scratch storage that lives on the stack and only falls back to the heap when a value
+does not fit.  The heap block, if any, is released with the buffer, so conversions never leak.
+*/
+template <typename T, size_t N>
+class scratch_buffer
+{
+public:
+	scratch_buffer() : _data(_inline), _capacity(N)
+	{
+	}
+
+	~scratch_buffer()
+	{
+		if (_data != _inline)
+		{
+			delete[] _data;
+		}
+	}
+
+	// Makes room for count elements, preserving the first keep elements already written
+	T* reserve(size_t count, size_t keep = 0)
+	{
+		if (count > _capacity)
+		{
+			T* data = new T[count];
+			std::copy(_data, _data + keep, data);
+			if (_data != _inline)
+			{
+				delete[] _data;
+			}
+			_data = data;
+			_capacity = count;
+		}
+		return _data;
+	}
+
+	T* data()
+	{
+		return _data;
+	}
+
+private:
+	scratch_buffer(scratch_buffer const&);
+	scratch_buffer& operator=(scratch_buffer const&);
+
+	T _inline[N];
+	T* _data;
+	size_t _capacity;
+};
+
+/*
+Null-terminated copy of a UTF-8 pointer and byte count pair, for the sqlite functions that take no length.
+A null pointer stays null, so callers can tell a missing name from an empty one.
+*/
+class c_string
+{
+public:
+	c_string(char const* text, int bytes) : _text(nullptr), _bytes(0)
+	{
+		if (text)
+		{
+			_bytes = bytes < 0 ? static_cast<int>(std::strlen(text)) : bytes;
+			char* data = _buffer.reserve(_bytes + 1);
+			std::memcpy(data, text, _bytes);
+			data[_bytes] = '\0';
+			_text = data;
+		}
+	}
+
+	char const* data() const
+	{
+		return _text;
+	}
+
+	// The string, or fallback if it is missing or empty
+	char const* data_or(char const* fallback) const
+	{
+		return _bytes == 0 ? fallback : _text;
+	}
+
+	int length() const
+	{
+		return _bytes;
+	}
+
+private:
+	scratch_buffer<char, 256> _buffer;
+	char const* _text;
+	int _bytes;
+};
+
+void set_text(char const* value, char const** text, int* bytes)
+{
+	if (text) *text = value;
+	if (bytes) *bytes = value ? static_cast<int>(std::strlen(value)) : 0;
+}
+
+// Copies at most count bytes of [data + sourceOffset, data + length) into destination.
+// Returns the number of bytes copied, or the total length when no destination is given.
+int copy_blob_range(void const* data, int length, int sourceOffset, void* destination, int count)
+{
+	if (length < 0)
+	{
+		length = 0;
+	}
+
+	if (!destination)
+	{
+		return length;
+	}
+
+	if (sourceOffset < 0 || count <= 0 || sourceOffset >= length)
+	{
+		return 0;
+	}
+
+	count = std::min(count, length - sourceOffset);
+	std::memcpy(destination, static_cast<unsigned char const*>(data) + sourceOffset, count);
+	return count;
+}
+
+// Reads count decimal digits at text into value. Returns false if any of them is not a digit.
+bool parse_digits(char const* text, int count, int* value)
+{
+	int result = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (text[i] < '0' || text[i] > '9')
+		{
+			return false;
+		}
+		result = result * 10 + (text[i] - '0');
+	}
+	*value = result;
+	return true;
+}
+
+/*
+Parses the ISO-8601 shapes dates are almost always stored in straight from the UTF-8 column text:
+yyyy-MM-dd, optionally followed by a space or a T and HH:mm, HH:mm:ss or HH:mm:ss.FFFFFFF, optionally followed by Z.
+Stores the value in .NET ticks and returns its DateTimeKind (0 unspecified, 1 UTC), or -1 for any other shape.
+*/
+int parse_iso8601(char const* text, int length, sqlite3_int64* ticks)
+{
+	static int const days_before_month[2][13] =
+	{
+		{ 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 },
+		{ 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366 }
+	};
+	int const ticks_per_second = 10000000;
+
+	int year, month, day;
+	if (!text || length < 10 || text[4] != '-' || text[7] != '-' ||
+		!parse_digits(text, 4, &year) || !parse_digits(text + 5, 2, &month) || !parse_digits(text + 8, 2, &day))
+	{
+		return -1;
+	}
+
+	int leap = (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) ? 1 : 0;
+	if (year < 1 || month < 1 || month > 12 || day < 1 ||
+		day > days_before_month[leap][month] - days_before_month[leap][month - 1])
+	{
+		return -1;
+	}
+
+	sqlite3_int64 y = year - 1;
+	sqlite3_int64 days = y * 365 + y / 4 - y / 100 + y / 400 + days_before_month[leap][month - 1] + day - 1;
+	sqlite3_int64 seconds = days * 86400;
+	sqlite3_int64 fraction = 0;
+	int kind = 0;
+	int pos = 10;
+
+	if (pos < length)
+	{
+		int hour, minute, second = 0;
+		if ((text[pos] != ' ' && text[pos] != 'T') || length < pos + 6 || text[pos + 3] != ':' ||
+			!parse_digits(text + pos + 1, 2, &hour) || !parse_digits(text + pos + 4, 2, &minute) ||
+			hour > 23 || minute > 59)
+		{
+			return -1;
+		}
+		pos += 6;
+
+		if (pos < length && text[pos] == ':')
+		{
+			if (length < pos + 3 || !parse_digits(text + pos + 1, 2, &second) || second > 59)
+			{
+				return -1;
+			}
+			pos += 3;
+
+			if (pos < length && text[pos] == '.')
+			{
+				pos++;
+				int digits = 0;
+				while (pos < length && digits < 7 && text[pos] >= '0' && text[pos] <= '9')
+				{
+					fraction = fraction * 10 + (text[pos] - '0');
+					digits++;
+					pos++;
+				}
+				if (digits == 0)
+				{
+					return -1;
+				}
+				for (; digits < 7; digits++)
+				{
+					fraction *= 10;
+				}
+			}
+		}
+
+		seconds += hour * 3600 + minute * 60 + second;
+
+		if (pos < length && text[pos] == 'Z')
+		{
+			kind = 1;
+			pos++;
+		}
+	}
+
+	if (pos != length)
+	{
+		return -1;
+	}
+
+	*ticks = seconds * ticks_per_second + fraction;
+	return kind;
+}
+
+/*
+The user data sqlite gets for a registered function or collation: the caller's callbacks and state, freed by
+destroy_cookie when sqlite no longer needs them.
+*/
+struct function_cookie
+{
+	void* state;
+	mdsw_function_callback func;
+	mdsw_function_callback step;
+	mdsw_final_callback final;
+	mdsw_collation_callback compare;
+	mdsw_destroy_callback destroy;
+};
+
+function_cookie* new_cookie(void* state, mdsw_destroy_callback destroy)
+{
+	auto cookie = static_cast<function_cookie*>(::calloc(1, sizeof(function_cookie)));
+	if (cookie)
+	{
+		cookie->state = state;
+		cookie->destroy = destroy;
+	}
+	return cookie;
+}
+
+void destroy_cookie(void* state)
+{
+	auto cookie = static_cast<function_cookie*>(state);
+	if (cookie->destroy)
+	{
+		cookie->destroy(cookie->state);
+	}
+	::free(cookie);
+}
+
+void function_callback(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+	auto cookie = static_cast<function_cookie*>(::sqlite3_user_data(context));
+	cookie->func(cookie->state, context, argc, argv);
+}
+
+void step_callback(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+	auto cookie = static_cast<function_cookie*>(::sqlite3_user_data(context));
+	cookie->step(cookie->state, context, argc, argv);
+}
+
+void final_callback(sqlite3_context* context)
+{
+	auto cookie = static_cast<function_cookie*>(::sqlite3_user_data(context));
+	cookie->final(cookie->state, context);
+}
+
+int collation_callback(void* state, int bytes1, void const* string1, int bytes2, void const* string2)
+{
+	auto cookie = static_cast<function_cookie*>(state);
+	return cookie->compare(cookie->state, bytes1, string1, bytes2, string2);
+}
+
+/*
+The values bound to a parameter by mdsw_bind_array, copied into one block that sqlite frees with the binding.
+texts holds the UTF-16 code units of every text, with offsets the start of each plus a final end, in code units.
+*/
+struct array_values
+{
+	int kind;
+	int count;
+	sqlite3_int64 const* integers;
+	double const* doubles;
+	char16_t const* texts;
+	int const* offsets;
+	unsigned char const* nulls;
+};
+
+// The type of the pointers bound by mdsw_bind_array, which only the array table accepts
+char const* const array_pointer_type = "mdsw_array";
+
+struct array_cursor
+{
+	sqlite3_vtab_cursor base;
+	array_values const* values;
+	int row;
+};
+
+// The table array(?) reads: a value column, and the hidden column the bound pointer is given to
+int array_connect(sqlite3* db, void*, int, char const* const*, sqlite3_vtab** vtab, char**)
+{
+	int result = ::sqlite3_declare_vtab(db, "CREATE TABLE x(value, pointer HIDDEN)");
+	if (result != SQLITE_OK)
+	{
+		return result;
+	}
+
+	*vtab = static_cast<sqlite3_vtab*>(::sqlite3_malloc(sizeof(sqlite3_vtab)));
+	if (!*vtab)
+	{
+		return SQLITE_NOMEM;
+	}
+	std::memset(*vtab, 0, sizeof(sqlite3_vtab));
+	return SQLITE_OK;
+}
+
+int array_disconnect(sqlite3_vtab* vtab)
+{
+	::sqlite3_free(vtab);
+	return SQLITE_OK;
+}
+
+/*
+The table can only be read for a bound array.  Without one the plan is priced out of consideration, and if it is
+used anyway it is empty.
+*/
+int array_best_index(sqlite3_vtab*, sqlite3_index_info* info)
+{
+	for (int i = 0; i < info->nConstraint; i++)
+	{
+		auto const& constraint = info->aConstraint[i];
+		if (constraint.iColumn == 1 && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ && constraint.usable)
+		{
+			info->aConstraintUsage[i].argvIndex = 1;
+			info->aConstraintUsage[i].omit = 1;
+			info->idxNum = 1;
+			info->estimatedCost = 10;
+			info->estimatedRows = 100;
+			return SQLITE_OK;
+		}
+	}
+
+	info->idxNum = 0;
+	info->estimatedCost = 2147483647;
+	info->estimatedRows = 2147483647;
+	return SQLITE_OK;
+}
+
+int array_open(sqlite3_vtab*, sqlite3_vtab_cursor** cursor)
+{
+	auto actual_cursor = static_cast<array_cursor*>(::sqlite3_malloc(sizeof(array_cursor)));
+	if (!actual_cursor)
+	{
+		return SQLITE_NOMEM;
+	}
+	std::memset(actual_cursor, 0, sizeof(array_cursor));
+	*cursor = &actual_cursor->base;
+	return SQLITE_OK;
+}
+
+int array_close(sqlite3_vtab_cursor* cursor)
+{
+	::sqlite3_free(cursor);
+	return SQLITE_OK;
+}
+
+int array_filter(sqlite3_vtab_cursor* cursor, int idxNum, char const*, int argc, sqlite3_value** argv)
+{
+	auto actual_cursor = reinterpret_cast<array_cursor*>(cursor);
+	actual_cursor->values = idxNum == 1 && argc == 1
+		? static_cast<array_values const*>(::sqlite3_value_pointer(argv[0], array_pointer_type))
+		: nullptr;
+	actual_cursor->row = 0;
+	return SQLITE_OK;
+}
+
+int array_next(sqlite3_vtab_cursor* cursor)
+{
+	reinterpret_cast<array_cursor*>(cursor)->row++;
+	return SQLITE_OK;
+}
+
+int array_eof(sqlite3_vtab_cursor* cursor)
+{
+	auto actual_cursor = reinterpret_cast<array_cursor*>(cursor);
+	return !actual_cursor->values || actual_cursor->row >= actual_cursor->values->count;
+}
+
+int array_column(sqlite3_vtab_cursor* cursor, sqlite3_context* context, int column)
+{
+	auto actual_cursor = reinterpret_cast<array_cursor*>(cursor);
+	auto values = actual_cursor->values;
+	int row = actual_cursor->row;
+
+	// The hidden column reads as NULL; pointers only go from bindings to functions
+	if (column != 0 || (values->nulls && values->nulls[row]))
+	{
+		::sqlite3_result_null(context);
+		return SQLITE_OK;
+	}
+
+	switch (values->kind)
+	{
+	case SQLITE_INTEGER:
+		::sqlite3_result_int64(context, values->integers[row]);
+		break;
+	case SQLITE_FLOAT:
+		::sqlite3_result_double(context, values->doubles[row]);
+		break;
+	default:
+		{
+			int start = values->offsets[row];
+			int length = values->offsets[row + 1] - start;
+			::sqlite3_result_text16(context, values->texts + start, length * static_cast<int>(sizeof(char16_t)), SQLITE_TRANSIENT);
+		}
+		break;
+	}
+	return SQLITE_OK;
+}
+
+int array_rowid(sqlite3_vtab_cursor* cursor, sqlite3_int64* rowid)
+{
+	*rowid = reinterpret_cast<array_cursor*>(cursor)->row + 1;
+	return SQLITE_OK;
+}
+
+sqlite3_module const* array_module()
+{
+	static sqlite3_module const module = []
+	{
+		// Without xCreate the table is eponymous-only: it exists in every schema, and CREATE VIRTUAL TABLE rejects it
+		sqlite3_module m;
+		std::memset(&m, 0, sizeof(m));
+		m.xConnect = array_connect;
+		m.xBestIndex = array_best_index;
+		m.xDisconnect = array_disconnect;
+		m.xOpen = array_open;
+		m.xClose = array_close;
+		m.xFilter = array_filter;
+		m.xNext = array_next;
+		m.xEof = array_eof;
+		m.xColumn = array_column;
+		m.xRowid = array_rowid;
+		return m;
+	}();
+	return &module;
+}
+
+// Makes the array table available on a newly opened connection
+void register_array_module(sqlite3* db)
+{
+	if (db)
+	{
+		::sqlite3_create_module(db, "array", array_module(), nullptr);
+	}
+}
+
+// The arena given to SQLITE_CONFIG_PAGECACHE, which sqlite may use until the process ends
+void* page_cache_arena = nullptr;
+
+}
+
+void mdsw_libversion(char const** text, int* bytes)
+{
+	set_text(::sqlite3_libversion(), text, bytes);
+}
+
+void mdsw_free(void* memory)
+{
+	::sqlite3_free(memory);
+}
+
+int mdsw_open(char const* filename, int filenameBytes, int flags, char const* vfs, int vfsBytes, sqlite3** db)
+{
+	c_string filename_buffer(filename ? filename : "", filename ? filenameBytes : 0);
+	c_string vfs_buffer(vfs, vfsBytes);
+
+	// Opened through the UTF-8 entry point so that the default encoding of stored strings is UTF-8 and not UTF-16
+	sqlite3* actual_db = nullptr;
+	int result = ::sqlite3_open_v2(filename_buffer.data(), &actual_db, flags, vfs_buffer.data_or(nullptr));
+	if (result == SQLITE_OK)
+	{
+		register_array_module(actual_db);
+	}
+	if (db)
+	{
+		*db = actual_db;
+	}
+	else
+	{
+		::sqlite3_close(actual_db);
+	}
+	return result;
+}
+
+int mdsw_open16(void const* filename, int filenameBytes, sqlite3** db)
+{
+	// sqlite3_open16 takes a null-terminated name
+	int length = filename && filenameBytes > 0 ? filenameBytes / static_cast<int>(sizeof(char16_t)) : 0;
+	scratch_buffer<char16_t, 128> filename_buffer;
+	char16_t* data = filename_buffer.reserve(length + 1);
+	if (length > 0)
+	{
+		std::memcpy(data, filename, length * sizeof(char16_t));
+	}
+	data[length] = 0;
+
+	sqlite3* actual_db = nullptr;
+	int result = ::sqlite3_open16(data, &actual_db);
+	if (result == SQLITE_OK)
+	{
+		register_array_module(actual_db);
+	}
+	if (db)
+	{
+		*db = actual_db;
+	}
+	else
+	{
+		::sqlite3_close(actual_db);
+	}
+	return result;
+}
+
+int mdsw_close(sqlite3* db)
+{
+	return ::sqlite3_close(db);
+}
+
+int mdsw_busy_timeout(sqlite3* db, int milliseconds)
+{
+	return ::sqlite3_busy_timeout(db, milliseconds);
+}
+
+int mdsw_busy_handler(sqlite3* db, mdsw_busy_handler_callback callback, void* state)
+{
+	return ::sqlite3_busy_handler(db, callback, callback ? state : nullptr);
+}
+
+int mdsw_progress_handler(sqlite3* db, int instructions, mdsw_progress_handler_callback callback, void* state)
+{
+	if (!db)
+	{
+		return SQLITE_MISUSE;
+	}
+
+	::sqlite3_progress_handler(db, instructions, callback, callback ? state : nullptr);
+	return SQLITE_OK;
+}
+
+int mdsw_changes(sqlite3* db)
+{
+	return ::sqlite3_changes(db);
+}
+
+sqlite3_int64 mdsw_last_insert_rowid(sqlite3* db)
+{
+	return ::sqlite3_last_insert_rowid(db);
+}
+
+void mdsw_interrupt(sqlite3* db)
+{
+	::sqlite3_interrupt(db);
+}
+
+void mdsw_errmsg(sqlite3* db, char const** text, int* bytes)
+{
+	set_text(::sqlite3_errmsg(db), text, bytes);
+}
+
+int mdsw_exec(sqlite3* db, char const* sql, int sqlBytes, char** error)
+{
+	c_string sql_buffer(sql ? sql : "", sql ? sqlBytes : 0);
+
+	char* actual_error = nullptr;
+	int result = ::sqlite3_exec(db, sql_buffer.data(), nullptr, nullptr, &actual_error);
+	if (error)
+	{
+		*error = actual_error;
+	}
+	else
+	{
+		::sqlite3_free(actual_error);
+	}
+	return result;
+}
+
+int mdsw_prepare(sqlite3* db, char const* sql, int sqlBytes, int v2, sqlite3_stmt** statement, int* tailOffset)
+{
+	sqlite3_stmt* actual_statement = nullptr;
+	char const* tail = nullptr;
+	char const* text = sql ? sql : "";
+	int bytes = sql ? sqlBytes : 0;
+	int result = v2
+		? ::sqlite3_prepare_v2(db, text, bytes, &actual_statement, &tail)
+		: ::sqlite3_prepare(db, text, bytes, &actual_statement, &tail);
+
+	if (statement)
+	{
+		*statement = actual_statement;
+	}
+	else
+	{
+		::sqlite3_finalize(actual_statement);
+	}
+	if (tailOffset)
+	{
+		*tailOffset = tail ? static_cast<int>(tail - text) : bytes;
+	}
+	return result;
+}
+
+int mdsw_prepare16(sqlite3* db, void const* sql, int sqlBytes, int v2, sqlite3_stmt** statement, int* tailOffset)
+{
+	sqlite3_stmt* actual_statement = nullptr;
+	void const* tail = nullptr;
+	void const* text = sql ? sql : u"";
+	int bytes = sql ? sqlBytes : 0;
+	int result = v2
+		? ::sqlite3_prepare16_v2(db, text, bytes, &actual_statement, &tail)
+		: ::sqlite3_prepare16(db, text, bytes, &actual_statement, &tail);
+
+	if (statement)
+	{
+		*statement = actual_statement;
+	}
+	else
+	{
+		::sqlite3_finalize(actual_statement);
+	}
+	if (tailOffset)
+	{
+		*tailOffset = tail ? static_cast<int>(static_cast<char const*>(tail) - static_cast<char const*>(text)) : bytes;
+	}
+	return result;
+}
+
+int mdsw_step(sqlite3_stmt* statement)
+{
+	return ::sqlite3_step(statement);
+}
+
+int mdsw_reset(sqlite3_stmt* statement)
+{
+	return ::sqlite3_reset(statement);
+}
+
+int mdsw_finalize(sqlite3_stmt* statement)
+{
+	return ::sqlite3_finalize(statement);
+}
+
+int mdsw_clear_bindings(sqlite3_stmt* statement)
+{
+	return ::sqlite3_clear_bindings(statement);
+}
+
+int mdsw_stmt_status(sqlite3_stmt* statement, int op, int resetFlag)
+{
+	return ::sqlite3_stmt_status(statement, op, resetFlag);
+}
+
+sqlite3_stmt* mdsw_next_stmt(sqlite3* db, sqlite3_stmt* statement)
+{
+	return ::sqlite3_next_stmt(db, statement);
+}
+
+int mdsw_bind_parameter_count(sqlite3_stmt* statement)
+{
+	return ::sqlite3_bind_parameter_count(statement);
+}
+
+int mdsw_bind_parameter_index(sqlite3_stmt* statement, char const* name, int nameBytes)
+{
+	c_string name_buffer(name ? name : "", name ? nameBytes : 0);
+	return ::sqlite3_bind_parameter_index(statement, name_buffer.data());
+}
+
+void mdsw_bind_parameter_name(sqlite3_stmt* statement, int index, char const** text, int* bytes)
+{
+	set_text(::sqlite3_bind_parameter_name(statement, index), text, bytes);
+}
+
+int mdsw_bind_null(sqlite3_stmt* statement, int index)
+{
+	return ::sqlite3_bind_null(statement, index);
+}
+
+int mdsw_bind_int(sqlite3_stmt* statement, int index, int value)
+{
+	return ::sqlite3_bind_int(statement, index, value);
+}
+
+int mdsw_bind_int64(sqlite3_stmt* statement, int index, sqlite3_int64 value)
+{
+	return ::sqlite3_bind_int64(statement, index, value);
+}
+
+int mdsw_bind_double(sqlite3_stmt* statement, int index, double value)
+{
+	return ::sqlite3_bind_double(statement, index, value);
+}
+
+int mdsw_bind_text(sqlite3_stmt* statement, int index, char const* text, int bytes)
+{
+	return ::sqlite3_bind_text(statement, index, text ? text : "", text ? bytes : 0, SQLITE_TRANSIENT);
+}
+
+int mdsw_bind_text16(sqlite3_stmt* statement, int index, void const* text, int bytes)
+{
+	return ::sqlite3_bind_text16(statement, index, text ? text : "", text ? bytes : 0, SQLITE_TRANSIENT);
+}
+
+int mdsw_bind_blob(sqlite3_stmt* statement, int index, void const* data, int bytes)
+{
+	// sqlite binds a null pointer as NULL
+	return data && bytes > 0
+		? ::sqlite3_bind_blob(statement, index, data, bytes, SQLITE_TRANSIENT)
+		: ::sqlite3_bind_zeroblob(statement, index, 0);
+}
+
+int mdsw_bind_array(sqlite3_stmt* statement, int index, int kind, int count,
+	sqlite3_int64 const* integers, double const* doubles, void const* texts, int const* textOffsets,
+	unsigned char const* nulls)
+{
+	if (count < 0 || (kind != SQLITE_INTEGER && kind != SQLITE_FLOAT && kind != SQLITE_TEXT))
+	{
+		return SQLITE_MISUSE;
+	}
+
+	// The header, then the values, the text offsets and the null flags, each aligned for what it holds
+	size_t valueBytes = kind == SQLITE_TEXT
+		? textOffsets[count] * sizeof(char16_t)
+		: count * (kind == SQLITE_INTEGER ? sizeof(sqlite3_int64) : sizeof(double));
+	size_t valueStart = (sizeof(array_values) + 7) & ~size_t(7);
+	size_t offsetStart = (valueStart + valueBytes + 3) & ~size_t(3);
+	size_t offsetBytes = kind == SQLITE_TEXT ? (count + 1) * sizeof(int) : 0;
+	size_t nullStart = offsetStart + offsetBytes;
+	size_t nullBytes = nulls ? count : 0;
+
+	auto block = static_cast<unsigned char*>(::sqlite3_malloc64(nullStart + nullBytes));
+	if (!block)
+	{
+		return SQLITE_NOMEM;
+	}
+
+	auto values = reinterpret_cast<array_values*>(block);
+	std::memset(values, 0, sizeof(array_values));
+	values->kind = kind;
+	values->count = count;
+	switch (kind)
+	{
+	case SQLITE_INTEGER:
+		std::memcpy(block + valueStart, integers, valueBytes);
+		values->integers = reinterpret_cast<sqlite3_int64 const*>(block + valueStart);
+		break;
+	case SQLITE_FLOAT:
+		std::memcpy(block + valueStart, doubles, valueBytes);
+		values->doubles = reinterpret_cast<double const*>(block + valueStart);
+		break;
+	default:
+		std::memcpy(block + valueStart, texts, valueBytes);
+		std::memcpy(block + offsetStart, textOffsets, offsetBytes);
+		values->texts = reinterpret_cast<char16_t const*>(block + valueStart);
+		values->offsets = reinterpret_cast<int const*>(block + offsetStart);
+		break;
+	}
+	if (nulls)
+	{
+		std::memcpy(block + nullStart, nulls, nullBytes);
+		values->nulls = block + nullStart;
+	}
+
+	// sqlite frees the block once the parameter is bound to something else or the statement is finalized, even if
+	// the binding fails
+	return ::sqlite3_bind_pointer(statement, index, block, array_pointer_type, ::sqlite3_free);
+}
+
+// Binds the value of parameter for row, as laid out by mdsw_step_batch
+static int bind_batch_value(sqlite3_stmt* stmt, int parameter, int kind, int slot, int row, int rowCount,
+	sqlite3_int64 const* integers, double const* doubles, void const* texts, int const* textOffsets,
+	void const* blobs, int const* blobOffsets, unsigned char const* nulls)
+{
+	if (nulls && nulls[parameter * rowCount + row])
+	{
+		return ::sqlite3_bind_null(stmt, parameter + 1);
+	}
+
+	int cell = slot * rowCount + row;
+	switch (kind)
+	{
+	case SQLITE_INTEGER:
+		return ::sqlite3_bind_int64(stmt, parameter + 1, integers[cell]);
+	case SQLITE_FLOAT:
+		return ::sqlite3_bind_double(stmt, parameter + 1, doubles[cell]);
+	case SQLITE_TEXT:
+		{
+			// The buffers outlive the batch and the bindings are cleared before returning, so nothing needs copying
+			int start = textOffsets[cell];
+			int length = textOffsets[cell + 1] - start;
+			return ::sqlite3_bind_text16(
+				stmt,
+				parameter + 1,
+				length > 0 ? static_cast<char16_t const*>(texts) + start : u"",
+				length * static_cast<int>(sizeof(char16_t)),
+				SQLITE_STATIC);
+		}
+	case SQLITE_BLOB:
+		{
+			int start = blobOffsets[cell];
+			int length = blobOffsets[cell + 1] - start;
+			return length > 0
+				? ::sqlite3_bind_blob(stmt, parameter + 1, static_cast<unsigned char const*>(blobs) + start, length, SQLITE_STATIC)
+				: ::sqlite3_bind_zeroblob(stmt, parameter + 1, 0);
+		}
+	default:
+		return SQLITE_MISUSE;
+	}
+}
+
+int mdsw_step_batch(sqlite3_stmt* statement, int firstRow, int rowCount, int const* kinds, int parameterCount,
+	sqlite3_int64 const* integers, double const* doubles, void const* texts, int const* textOffsets,
+	void const* blobs, int const* blobOffsets, unsigned char const* nulls, int* changes, int* rowsDone)
+{
+	int row = firstRow;
+	int result = SQLITE_OK;
+
+	// The position of each parameter among the parameters of the same kind
+	scratch_buffer<int, 32> slot_buffer;
+	int* slots = slot_buffer.reserve(parameterCount > 0 ? parameterCount : 0);
+	int kindCounts[SQLITE_NULL + 1] = { 0 };
+	for (int parameter = 0; parameter < parameterCount; parameter++)
+	{
+		int kind = kinds[parameter];
+		if (kind < SQLITE_INTEGER || kind > SQLITE_BLOB)
+		{
+			result = SQLITE_MISUSE;
+			break;
+		}
+		slots[parameter] = kindCounts[kind]++;
+	}
+
+	sqlite3* db = ::sqlite3_db_handle(statement);
+	while (result == SQLITE_OK && row < rowCount)
+	{
+		for (int parameter = 0; parameter < parameterCount && result == SQLITE_OK; parameter++)
+		{
+			result = bind_batch_value(statement, parameter, kinds[parameter], slots[parameter], row, rowCount,
+				integers, doubles, texts, textOffsets, blobs, blobOffsets, nulls);
+		}
+		if (result != SQLITE_OK)
+		{
+			break;
+		}
+
+		// sqlite3_changes keeps the count of the last INSERT, UPDATE or DELETE, so a step that changed nothing, such as
+		// a SELECT or CREATE, is told apart by the running total
+		int totalChanges = ::sqlite3_total_changes(db);
+		result = ::sqlite3_step(statement);
+		bool stepped = result == SQLITE_DONE || result == SQLITE_ROW;
+		if (stepped && changes)
+		{
+			changes[row] = ::sqlite3_total_changes(db) != totalChanges ? ::sqlite3_changes(db) : 0;
+		}
+
+		// sqlite3_reset reports the actual error of a failed step, which is SQLITE_ERROR with sqlite3_prepare
+		int reset = ::sqlite3_reset(statement);
+		result = stepped ? reset : (reset != SQLITE_OK ? reset : result);
+		if (result == SQLITE_OK)
+		{
+			row++;
+		}
+	}
+
+	::sqlite3_clear_bindings(statement);
+	if (rowsDone)
+	{
+		*rowsDone = row;
+	}
+	return result;
+}
+
+int mdsw_step_block(sqlite3_stmt* statement, int pending, int firstRow, int maxRows, int stride,
+	unsigned char* types, sqlite3_int64* integers, double* doubles, int* offsets,
+	char* texts, int textCapacity, void* blobs, int blobCapacity,
+	int* rowCount, int* textBytesNeeded, int* blobBytesNeeded)
+{
+	int columnCount = ::sqlite3_column_count(statement);
+	int row = firstRow;
+	int textBytes = 0;
+	int blobBytes = 0;
+	int textNeeded = 0;
+	int blobNeeded = 0;
+	int result = SQLITE_ROW;
+
+	if (firstRow < 0 || maxRows > stride || !types || !integers || !doubles || !offsets
+		|| (textCapacity > 0 && !texts) || (blobCapacity > 0 && !blobs))
+	{
+		result = SQLITE_MISUSE;
+		maxRows = 0;
+	}
+
+	while (row < maxRows)
+	{
+		if (pending)
+		{
+			pending = 0;
+		}
+		else
+		{
+			result = ::sqlite3_step(statement);
+			if (result != SQLITE_ROW)
+			{
+				break;
+			}
+		}
+
+		// A row is stored whole or not at all, so measure its texts and blobs before copying anything
+		int rowTextBytes = 0;
+		int rowBlobBytes = 0;
+		for (int column = 0; column < columnCount; column++)
+		{
+			switch (::sqlite3_column_type(statement, column))
+			{
+			case SQLITE_TEXT:
+				rowTextBytes += ::sqlite3_column_bytes(statement, column);
+				break;
+			case SQLITE_BLOB:
+				rowBlobBytes += ::sqlite3_column_bytes(statement, column);
+				break;
+			}
+		}
+		if (rowTextBytes > textCapacity - textBytes || rowBlobBytes > blobCapacity - blobBytes)
+		{
+			textNeeded = rowTextBytes > textCapacity - textBytes ? rowTextBytes : 0;
+			blobNeeded = rowBlobBytes > blobCapacity - blobBytes ? rowBlobBytes : 0;
+			result = SQLITE_ROW;
+			break;
+		}
+
+		for (int column = 0; column < columnCount; column++)
+		{
+			int cell = column * stride + row;
+			int type = ::sqlite3_column_type(statement, column);
+			types[cell] = static_cast<unsigned char>(type);
+			switch (type)
+			{
+			case SQLITE_INTEGER:
+				integers[cell] = ::sqlite3_column_int64(statement, column);
+				break;
+			case SQLITE_FLOAT:
+				doubles[cell] = ::sqlite3_column_double(statement, column);
+				break;
+			case SQLITE_TEXT:
+			{
+				// sqlite3_column_text must be called before sqlite3_column_bytes so the length matches the returned text
+				auto text = ::sqlite3_column_text(statement, column);
+				int length = ::sqlite3_column_bytes(statement, column);
+				if (length > 0)
+				{
+					std::memcpy(texts + textBytes, text, length);
+				}
+				offsets[cell] = textBytes;
+				integers[cell] = length;
+				textBytes += length;
+				break;
+			}
+			case SQLITE_BLOB:
+			{
+				auto data = ::sqlite3_column_blob(statement, column);
+				int length = ::sqlite3_column_bytes(statement, column);
+				if (length > 0)
+				{
+					std::memcpy(static_cast<unsigned char*>(blobs) + blobBytes, data, length);
+				}
+				offsets[cell] = blobBytes;
+				integers[cell] = length;
+				blobBytes += length;
+				break;
+			}
+			}
+		}
+		row++;
+	}
+
+	if (rowCount)
+	{
+		*rowCount = row;
+	}
+	if (textBytesNeeded)
+	{
+		*textBytesNeeded = textNeeded;
+	}
+	if (blobBytesNeeded)
+	{
+		*blobBytesNeeded = blobNeeded;
+	}
+	return result;
+}
+
+int mdsw_column_count(sqlite3_stmt* statement)
+{
+	return ::sqlite3_column_count(statement);
+}
+
+int mdsw_column_type(sqlite3_stmt* statement, int index)
+{
+	return ::sqlite3_column_type(statement, index);
+}
+
+int mdsw_column_int(sqlite3_stmt* statement, int index)
+{
+	return ::sqlite3_column_int(statement, index);
+}
+
+sqlite3_int64 mdsw_column_int64(sqlite3_stmt* statement, int index)
+{
+	return ::sqlite3_column_int64(statement, index);
+}
+
+double mdsw_column_double(sqlite3_stmt* statement, int index)
+{
+	return ::sqlite3_column_double(statement, index);
+}
+
+int mdsw_column_bytes(sqlite3_stmt* statement, int index)
+{
+	return ::sqlite3_column_bytes(statement, index);
+}
+
+void mdsw_column_text(sqlite3_stmt* statement, int index, char const** text, int* bytes)
+{
+	// sqlite3_column_text must be called before sqlite3_column_bytes so the length matches the returned text
+	auto result = reinterpret_cast<char const*>(::sqlite3_column_text(statement, index));
+	if (text) *text = result;
+	if (bytes) *bytes = ::sqlite3_column_bytes(statement, index);
+}
+
+void mdsw_column_text16(sqlite3_stmt* statement, int index, void const** text, int* bytes)
+{
+	auto result = ::sqlite3_column_text16(statement, index);
+	if (text) *text = result;
+	if (bytes) *bytes = ::sqlite3_column_bytes16(statement, index);
+}
+
+void mdsw_column_blob(sqlite3_stmt* statement, int index, void const** data, int* bytes)
+{
+	auto result = ::sqlite3_column_blob(statement, index);
+	if (data) *data = result;
+	if (bytes) *bytes = ::sqlite3_column_bytes(statement, index);
+}
+
+int mdsw_column_blob_copy(sqlite3_stmt* statement, int index, int sourceOffset, void* destination, int count)
+{
+	auto data = ::sqlite3_column_blob(statement, index);
+	return copy_blob_range(data, ::sqlite3_column_bytes(statement, index), sourceOffset, destination, count);
+}
+
+int mdsw_column_datetime(sqlite3_stmt* statement, int index, sqlite3_int64* ticks)
+{
+	// sqlite3_column_text must be called before sqlite3_column_bytes so the length matches the returned text
+	auto text = reinterpret_cast<char const*>(::sqlite3_column_text(statement, index));
+	int length = ::sqlite3_column_bytes(statement, index);
+	return parse_iso8601(text, length, ticks);
+}
+
+void mdsw_column_name(sqlite3_stmt* statement, int index, char const** text, int* bytes)
+{
+	set_text(::sqlite3_column_name(statement, index), text, bytes);
+}
+
+void mdsw_column_decltype(sqlite3_stmt* statement, int index, char const** text, int* bytes)
+{
+	set_text(::sqlite3_column_decltype(statement, index), text, bytes);
+}
+
+void mdsw_column_database_name(sqlite3_stmt* statement, int index, char const** text, int* bytes)
+{
+	set_text(::sqlite3_column_database_name(statement, index), text, bytes);
+}
+
+void mdsw_column_table_name(sqlite3_stmt* statement, int index, char const** text, int* bytes)
+{
+	set_text(::sqlite3_column_table_name(statement, index), text, bytes);
+}
+
+void mdsw_column_origin_name(sqlite3_stmt* statement, int index, char const** text, int* bytes)
+{
+	set_text(::sqlite3_column_origin_name(statement, index), text, bytes);
+}
+
+int mdsw_value_type(sqlite3_value* value)
+{
+	return ::sqlite3_value_type(value);
+}
+
+int mdsw_value_int(sqlite3_value* value)
+{
+	return ::sqlite3_value_int(value);
+}
+
+sqlite3_int64 mdsw_value_int64(sqlite3_value* value)
+{
+	return ::sqlite3_value_int64(value);
+}
+
+double mdsw_value_double(sqlite3_value* value)
+{
+	return ::sqlite3_value_double(value);
+}
+
+int mdsw_value_bytes(sqlite3_value* value)
+{
+	return ::sqlite3_value_bytes(value);
+}
+
+void mdsw_value_text(sqlite3_value* value, char const** text, int* bytes)
+{
+	auto result = reinterpret_cast<char const*>(::sqlite3_value_text(value));
+	if (text) *text = result;
+	if (bytes) *bytes = ::sqlite3_value_bytes(value);
+}
+
+void mdsw_value_text16(sqlite3_value* value, void const** text, int* bytes)
+{
+	auto result = ::sqlite3_value_text16(value);
+	if (text) *text = result;
+	if (bytes) *bytes = ::sqlite3_value_bytes16(value);
+}
+
+void mdsw_value_blob(sqlite3_value* value, void const** data, int* bytes)
+{
+	auto result = ::sqlite3_value_blob(value);
+	if (data) *data = result;
+	if (bytes) *bytes = ::sqlite3_value_bytes(value);
+}
+
+int mdsw_value_blob_copy(sqlite3_value* value, int sourceOffset, void* destination, int count)
+{
+	auto data = ::sqlite3_value_blob(value);
+	return copy_blob_range(data, ::sqlite3_value_bytes(value), sourceOffset, destination, count);
+}
+
+void mdsw_result_null(sqlite3_context* context)
+{
+	::sqlite3_result_null(context);
+}
+
+void mdsw_result_int(sqlite3_context* context, int value)
+{
+	::sqlite3_result_int(context, value);
+}
+
+void mdsw_result_int64(sqlite3_context* context, sqlite3_int64 value)
+{
+	::sqlite3_result_int64(context, value);
+}
+
+void mdsw_result_double(sqlite3_context* context, double value)
+{
+	::sqlite3_result_double(context, value);
+}
+
+void mdsw_result_text(sqlite3_context* context, char const* text, int bytes)
+{
+	::sqlite3_result_text(context, text ? text : "", text ? bytes : 0, SQLITE_TRANSIENT);
+}
+
+void mdsw_result_text16(sqlite3_context* context, void const* text, int bytes)
+{
+	::sqlite3_result_text16(context, text ? text : "", text ? bytes : 0, SQLITE_TRANSIENT);
+}
+
+void mdsw_result_blob(sqlite3_context* context, void const* data, int bytes)
+{
+	if (data && bytes > 0)
+	{
+		::sqlite3_result_blob(context, data, bytes, SQLITE_TRANSIENT);
+	}
+	else
+	{
+		::sqlite3_result_zeroblob(context, 0);
+	}
+}
+
+void mdsw_result_error(sqlite3_context* context, char const* text, int bytes)
+{
+	::sqlite3_result_error(context, text ? text : "", text ? bytes : 0);
+}
+
+void mdsw_result_error16(sqlite3_context* context, void const* text, int bytes)
+{
+	::sqlite3_result_error16(context, text ? text : "", text ? bytes : 0);
+}
+
+sqlite3_int64 mdsw_aggregate_context(sqlite3_context* context, int bytes)
+{
+	// The address of the aggregate's memory is the same for every step of a group and unique while it lasts
+	return reinterpret_cast<sqlite3_int64>(::sqlite3_aggregate_context(context, bytes));
+}
+
+int mdsw_create_function(sqlite3* db, char const* name, int nameBytes, int argc, void* state,
+	mdsw_function_callback func, mdsw_function_callback step, mdsw_final_callback final, mdsw_destroy_callback destroy)
+{
+	auto cookie = new_cookie(state, destroy);
+	if (!cookie)
+	{
+		if (destroy)
+		{
+			destroy(state);
+		}
+		return SQLITE_NOMEM;
+	}
+	cookie->func = func;
+	cookie->step = step;
+	cookie->final = final;
+
+	// sqlite calls destroy_cookie even when the registration fails
+	c_string name_buffer(name ? name : "", name ? nameBytes : 0);
+	return ::sqlite3_create_function_v2(
+		db,
+		name_buffer.data(),
+		argc,
+		SQLITE_UTF8,
+		cookie,
+		func ? function_callback : nullptr,
+		step ? step_callback : nullptr,
+		final ? final_callback : nullptr,
+		destroy_cookie);
+}
+
+int mdsw_create_collation(sqlite3* db, char const* name, int nameBytes, void* state,
+	mdsw_collation_callback compare, mdsw_destroy_callback destroy)
+{
+	c_string name_buffer(name ? name : "", name ? nameBytes : 0);
+	if (!compare)
+	{
+		if (destroy)
+		{
+			destroy(state);
+		}
+		return ::sqlite3_create_collation_v2(db, name_buffer.data(), SQLITE_UTF16, nullptr, nullptr, nullptr);
+	}
+
+	auto cookie = new_cookie(state, destroy);
+	if (!cookie)
+	{
+		if (destroy)
+		{
+			destroy(state);
+		}
+		return SQLITE_NOMEM;
+	}
+	cookie->compare = compare;
+
+	// Unlike sqlite3_create_function_v2, a failed registration does not call destroy_cookie
+	int result = ::sqlite3_create_collation_v2(db, name_buffer.data(), SQLITE_UTF16, cookie, collation_callback, destroy_cookie);
+	if (result != SQLITE_OK)
+	{
+		destroy_cookie(cookie);
+	}
+	return result;
+}
+
+void mdsw_update_hook(sqlite3* db, mdsw_update_hook_callback callback, void* state)
+{
+	::sqlite3_update_hook(db, callback, callback ? state : nullptr);
+}
+
+void mdsw_commit_hook(sqlite3* db, mdsw_commit_hook_callback callback, void* state)
+{
+	::sqlite3_commit_hook(db, callback, callback ? state : nullptr);
+}
+
+void mdsw_rollback_hook(sqlite3* db, mdsw_rollback_hook_callback callback, void* state)
+{
+	::sqlite3_rollback_hook(db, callback, callback ? state : nullptr);
+}
+
+void mdsw_wal_hook(sqlite3* db, mdsw_wal_hook_callback callback, void* state)
+{
+	::sqlite3_wal_hook(db, callback, callback ? state : nullptr);
+}
+
+int mdsw_wal_checkpoint_v2(sqlite3* db, char const* dbName, int dbNameBytes, int mode, int* logFrames, int* checkpointedFrames)
+{
+	c_string dbName_buffer(dbName, dbNameBytes);
+	return ::sqlite3_wal_checkpoint_v2(
+		db,
+		dbName_buffer.data_or(nullptr) /* checkpoint all attached databases */,
+		mode,
+		logFrames,
+		checkpointedFrames);
+}
+
+int mdsw_trace_v2(sqlite3* db, unsigned int mask, mdsw_trace_callback callback, void* state)
+{
+	return ::sqlite3_trace_v2(db, callback ? mask : 0, callback, callback ? state : nullptr);
+}
+
+int mdsw_table_column_metadata(sqlite3* db, char const* dbName, int dbNameBytes,
+	char const* tableName, int tableNameBytes, char const* columnName, int columnNameBytes,
+	char const** dataType, int* dataTypeBytes, char const** collSeq, int* collSeqBytes,
+	int* notNull, int* primaryKey, int* autoInc)
+{
+	c_string dbName_buffer(dbName, dbNameBytes);
+	c_string tableName_buffer(tableName ? tableName : "", tableName ? tableNameBytes : 0);
+	c_string columnName_buffer(columnName, columnNameBytes);
+
+	char const* actual_dataType = nullptr;
+	char const* actual_collSeq = nullptr;
+	int result = ::sqlite3_table_column_metadata(
+		db,
+		dbName_buffer.data_or(nullptr) /* search all attached databases */,
+		tableName_buffer.data(),
+		columnName_buffer.data(),
+		&actual_dataType,
+		&actual_collSeq,
+		notNull,
+		primaryKey,
+		autoInc);
+
+	set_text(actual_dataType, dataType, dataTypeBytes);
+	set_text(actual_collSeq, collSeq, collSeqBytes);
+	return result;
+}
+
+int mdsw_blob_open(sqlite3* db, char const* dbName, int dbNameBytes, char const* tableName, int tableNameBytes,
+	char const* columnName, int columnNameBytes, sqlite3_int64 rowid, int flags, sqlite3_blob** blob)
+{
+	c_string dbName_buffer(dbName, dbNameBytes);
+	c_string tableName_buffer(tableName ? tableName : "", tableName ? tableNameBytes : 0);
+	c_string columnName_buffer(columnName ? columnName : "", columnName ? columnNameBytes : 0);
+
+	sqlite3_blob* actual_blob = nullptr;
+	int result = ::sqlite3_blob_open(
+		db,
+		dbName_buffer.data_or("main"),
+		tableName_buffer.data(),
+		columnName_buffer.data(),
+		rowid,
+		flags,
+		&actual_blob);
+	if (blob)
+	{
+		*blob = actual_blob;
+	}
+	else
+	{
+		::sqlite3_blob_close(actual_blob);
+	}
+	return result;
+}
+
+int mdsw_blob_reopen(sqlite3_blob* blob, sqlite3_int64 rowid)
+{
+	return ::sqlite3_blob_reopen(blob, rowid);
+}
+
+int mdsw_blob_close(sqlite3_blob* blob)
+{
+	return ::sqlite3_blob_close(blob);
+}
+
+int mdsw_blob_bytes(sqlite3_blob* blob)
+{
+	return ::sqlite3_blob_bytes(blob);
+}
+
+int mdsw_blob_read(sqlite3_blob* blob, void* destination, int count, int blobOffset)
+{
+	if (!destination || count < 0)
+	{
+		return SQLITE_RANGE;
+	}
+
+	return ::sqlite3_blob_read(blob, destination, count, blobOffset);
+}
+
+int mdsw_blob_write(sqlite3_blob* blob, void const* source, int count, int blobOffset)
+{
+	if (!source || count < 0)
+	{
+		return SQLITE_RANGE;
+	}
+
+	return ::sqlite3_blob_write(blob, source, count, blobOffset);
+}
+
+sqlite3_backup* mdsw_backup_init(sqlite3* destination, char const* destinationName, int destinationNameBytes,
+	sqlite3* source, char const* sourceName, int sourceNameBytes)
+{
+	c_string destinationName_buffer(destinationName, destinationNameBytes);
+	c_string sourceName_buffer(sourceName, sourceNameBytes);
+
+	return ::sqlite3_backup_init(
+		destination,
+		destinationName_buffer.data_or("main"),
+		source,
+		sourceName_buffer.data_or("main"));
+}
+
+int mdsw_backup_step(sqlite3_backup* backup, int pages)
+{
+	return ::sqlite3_backup_step(backup, pages);
+}
+
+int mdsw_backup_finish(sqlite3_backup* backup)
+{
+	return ::sqlite3_backup_finish(backup);
+}
+
+int mdsw_backup_remaining(sqlite3_backup* backup)
+{
+	return ::sqlite3_backup_remaining(backup);
+}
+
+int mdsw_backup_pagecount(sqlite3_backup* backup)
+{
+	return ::sqlite3_backup_pagecount(backup);
+}
+
+int mdsw_config(int option)
+{
+	return ::sqlite3_config(option);
+}
+
+int mdsw_config_int(int option, int value)
+{
+	return ::sqlite3_config(option, value);
+}
+
+int mdsw_config_int_int(int option, int value1, int value2)
+{
+	return ::sqlite3_config(option, value1, value2);
+}
+
+int mdsw_config_int64_int64(int option, sqlite3_int64 value1, sqlite3_int64 value2)
+{
+	return ::sqlite3_config(option, value1, value2);
+}
+
+int mdsw_config_pagecache(int pageSize, int pageCount)
+{
+	if (pageSize <= 0 || pageCount <= 0)
+	{
+		// Let sqlite allocate the page cache from the heap again
+		return ::sqlite3_config(SQLITE_CONFIG_PAGECACHE, nullptr, 0, 0);
+	}
+
+	void* arena = ::malloc(static_cast<size_t>(pageSize) * static_cast<size_t>(pageCount));
+	if (!arena)
+	{
+		return SQLITE_NOMEM;
+	}
+
+	int result = ::sqlite3_config(SQLITE_CONFIG_PAGECACHE, arena, pageSize, pageCount);
+	if (result != SQLITE_OK)
+	{
+		::free(arena);
+		return result;
+	}
+
+	// sqlite is not initialized yet or it would have refused, so nothing can still be using the old arena
+	::free(page_cache_arena);
+	page_cache_arena = arena;
+	return result;
+}
+
+int mdsw_db_config_lookaside(sqlite3* db, int slotSize, int slotCount)
+{
+	// With no buffer, sqlite allocates the slots itself
+	return ::sqlite3_db_config(db, SQLITE_DBCONFIG_LOOKASIDE, nullptr, slotSize, slotCount);
+}
+
+sqlite3_int64 mdsw_soft_heap_limit64(sqlite3_int64 limit)
+{
+	return ::sqlite3_soft_heap_limit64(limit);
+}
+
+int mdsw_status64(int op, sqlite3_int64* current, sqlite3_int64* highwater, int resetFlag)
+{
+	sqlite3_int64 actual_current = 0;
+	sqlite3_int64 actual_highwater = 0;
+	int result = ::sqlite3_status64(op, &actual_current, &actual_highwater, resetFlag);
+
+	if (current) *current = actual_current;
+	if (highwater) *highwater = actual_highwater;
+
+	return result;
+}
+
+int mdsw_db_status(sqlite3* db, int op, int* current, int* highwater, int resetFlag)
+{
+	int actual_current = 0;
+	int actual_highwater = 0;
+	int result = ::sqlite3_db_status(db, op, &actual_current, &actual_highwater, resetFlag);
+
+	if (current) *current = actual_current;
+	if (highwater) *highwater = actual_highwater;
+
+	return result;
+}
@@ -0,0 +1,233 @@
+﻿/*
+Copyright (C) 2013 Peter Huene
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <sqlite3.h>
+
+/*
+The surface of the C++/CX MonoDataSqliteWrapper as plain C functions, for the platforms without WinRT.
+Every argument and result is blittable, so the managed side P/Invokes them without marshalling:
+ - handles are the raw sqlite pointers,
+ - strings going in are UTF-8 pointer and byte count pairs, which need no terminating null,
+ - strings coming out are a pointer and byte count pair written to the caller's variables, pointing at memory
+   sqlite owns, valid for as long as sqlite documents for the function they come from,
+ - blobs and rows are copied into buffers the caller provides.
+The statements and strings sqlite keeps as UTF-16 also have ...16 variants taking native UTF-16 and byte counts,
+so callers whose strings are UTF-16 already need no conversion.
+*/
+
+#ifdef _WIN32
+#define MDSW_API __declspec(dllexport)
+#else
+#define MDSW_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int (*mdsw_busy_handler_callback)(void* state, int count);
+typedef int (*mdsw_progress_handler_callback)(void* state);
+typedef void (*mdsw_update_hook_callback)(void* state, int operation, char const* dbName, char const* tableName, sqlite3_int64 rowid);
+typedef int (*mdsw_commit_hook_callback)(void* state);
+typedef void (*mdsw_rollback_hook_callback)(void* state);
+typedef int (*mdsw_wal_hook_callback)(void* state, sqlite3* db, char const* dbName, int frames);
+// x points at the run time of the statement in nanoseconds for SQLITE_TRACE_PROFILE
+typedef int (*mdsw_trace_callback)(unsigned int type, void* state, void* p, void* x);
+typedef void (*mdsw_function_callback)(void* state, sqlite3_context* context, int argc, sqlite3_value** argv);
+typedef void (*mdsw_final_callback)(void* state, sqlite3_context* context);
+// Registered as SQLITE_UTF16, so the strings are native UTF-16 and the lengths are in bytes
+typedef int (*mdsw_collation_callback)(void* state, int bytes1, void const* string1, int bytes2, void const* string2);
+typedef void (*mdsw_destroy_callback)(void* state);
+
+MDSW_API void mdsw_libversion(char const** text, int* bytes);
+
+MDSW_API void mdsw_free(void* memory);
+
+MDSW_API int mdsw_open(char const* filename, int filenameBytes, int flags, char const* vfs, int vfsBytes, sqlite3** db);
+// Opens a database whose new files store their strings as UTF-16
+MDSW_API int mdsw_open16(void const* filename, int filenameBytes, sqlite3** db);
+MDSW_API int mdsw_close(sqlite3* db);
+MDSW_API int mdsw_busy_timeout(sqlite3* db, int milliseconds);
+MDSW_API int mdsw_busy_handler(sqlite3* db, mdsw_busy_handler_callback callback, void* state);
+// A null callback removes the handler.
+MDSW_API int mdsw_progress_handler(sqlite3* db, int instructions, mdsw_progress_handler_callback callback, void* state);
+MDSW_API int mdsw_changes(sqlite3* db);
+MDSW_API sqlite3_int64 mdsw_last_insert_rowid(sqlite3* db);
+MDSW_API void mdsw_interrupt(sqlite3* db);
+MDSW_API void mdsw_errmsg(sqlite3* db, char const** text, int* bytes);
+// error gets the error message, if any, which the caller releases with mdsw_free
+MDSW_API int mdsw_exec(sqlite3* db, char const* sql, int sqlBytes, char** error);
+
+/*
+Prepares the first statement of sql.  tailOffset gets the number of bytes of sql it used, the rest being the
+statements that follow.  v2 selects sqlite3_prepare_v2, whose statements report errors from sqlite3_step()
+rather than only from sqlite3_reset(), over the legacy sqlite3_prepare.
+*/
+MDSW_API int mdsw_prepare(sqlite3* db, char const* sql, int sqlBytes, int v2, sqlite3_stmt** statement, int* tailOffset);
+MDSW_API int mdsw_prepare16(sqlite3* db, void const* sql, int sqlBytes, int v2, sqlite3_stmt** statement, int* tailOffset);
+MDSW_API int mdsw_step(sqlite3_stmt* statement);
+MDSW_API int mdsw_reset(sqlite3_stmt* statement);
+MDSW_API int mdsw_finalize(sqlite3_stmt* statement);
+MDSW_API int mdsw_clear_bindings(sqlite3_stmt* statement);
+MDSW_API int mdsw_stmt_status(sqlite3_stmt* statement, int op, int resetFlag);
+MDSW_API sqlite3_stmt* mdsw_next_stmt(sqlite3* db, sqlite3_stmt* statement);
+
+MDSW_API int mdsw_bind_parameter_count(sqlite3_stmt* statement);
+MDSW_API int mdsw_bind_parameter_index(sqlite3_stmt* statement, char const* name, int nameBytes);
+MDSW_API void mdsw_bind_parameter_name(sqlite3_stmt* statement, int index, char const** text, int* bytes);
+MDSW_API int mdsw_bind_null(sqlite3_stmt* statement, int index);
+MDSW_API int mdsw_bind_int(sqlite3_stmt* statement, int index, int value);
+MDSW_API int mdsw_bind_int64(sqlite3_stmt* statement, int index, sqlite3_int64 value);
+MDSW_API int mdsw_bind_double(sqlite3_stmt* statement, int index, double value);
+// Text and blobs are copied by sqlite, so the caller's memory is free again when these return
+MDSW_API int mdsw_bind_text(sqlite3_stmt* statement, int index, char const* text, int bytes);
+MDSW_API int mdsw_bind_text16(sqlite3_stmt* statement, int index, void const* text, int bytes);
+// A null data with no bytes binds an empty blob, not NULL
+MDSW_API int mdsw_bind_blob(sqlite3_stmt* statement, int index, void const* data, int bytes);
+/*
+Binds a copy of count values as the array the table-valued function array() reads, so that
+"x IN (SELECT value FROM array(?))" or a join against array(?) takes any number of values with one parameter.  The
+array table is registered on every connection mdsw_open and mdsw_open16 open.  kind is SQLITE_INTEGER, SQLITE_FLOAT
+or SQLITE_TEXT for values in integers, doubles or texts; texts holds UTF-16 code units, with textOffsets the start
+of each text plus a final end, in code units.  nulls, if given, has one flag per value that is NULL.
+*/
+MDSW_API int mdsw_bind_array(sqlite3_stmt* statement, int index, int kind, int count,
+	sqlite3_int64 const* integers, double const* doubles, void const* texts, int const* textOffsets,
+	unsigned char const* nulls);
+
+/*
+Binds, steps and resets statement once per row in [firstRow, rowCount) without leaving native code.
+kinds holds one SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT or SQLITE_BLOB per parameter.  The values of the
+parameters of one kind are concatenated column by column in integers, doubles, texts or blobs, so the value of
+the k-th parameter of its kind for row r is cell [k * rowCount + r].  texts holds UTF-16 code units, with
+textOffsets the start of each cell plus a final end, in code units; blobOffsets does the same for blobs in bytes.
+nulls, if given, has one flag per parameter and row at [parameter * rowCount + r].  changes, if given, gets the
+number of rows each row changed.  Returns the first error, with rowsDone set to the failing row.
+*/
+MDSW_API int mdsw_step_batch(sqlite3_stmt* statement, int firstRow, int rowCount, int const* kinds, int parameterCount,
+	sqlite3_int64 const* integers, double const* doubles, void const* texts, int const* textOffsets,
+	void const* blobs, int const* blobOffsets, unsigned char const* nulls, int* changes, int* rowsDone);
+
+/*
+Steps statement and stores the rows it returns column by column, starting at row firstRow of the block and
+stopping before row maxRows, so the cell of column c and row r is at [c * stride + r] in every array.  types gets
+the SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB or SQLITE_NULL type of each cell, and the value goes to
+integers or doubles; a text is copied as UTF-8 into texts and a blob into blobs, with its offset in offsets[cell]
+and its length in integers[cell].  If pending is non-zero the statement is already on a row that is stored first
+without stepping.  A row whose texts or blobs do not fit into what is left of their buffer is not stored: it stays
+pending on the statement, and textBytesNeeded or blobBytesNeeded is set to the size of its texts or blobs.
+rowCount gets the row after the last one stored.  Returns SQLITE_DONE at the end of the results, SQLITE_ROW if the
+rows stopped early, or the error of a failed step.
+*/
+MDSW_API int mdsw_step_block(sqlite3_stmt* statement, int pending, int firstRow, int maxRows, int stride,
+	unsigned char* types, sqlite3_int64* integers, double* doubles, int* offsets,
+	char* texts, int textCapacity, void* blobs, int blobCapacity,
+	int* rowCount, int* textBytesNeeded, int* blobBytesNeeded);
+
+MDSW_API int mdsw_column_count(sqlite3_stmt* statement);
+MDSW_API int mdsw_column_type(sqlite3_stmt* statement, int index);
+MDSW_API int mdsw_column_int(sqlite3_stmt* statement, int index);
+MDSW_API sqlite3_int64 mdsw_column_int64(sqlite3_stmt* statement, int index);
+MDSW_API double mdsw_column_double(sqlite3_stmt* statement, int index);
+MDSW_API int mdsw_column_bytes(sqlite3_stmt* statement, int index);
+MDSW_API void mdsw_column_text(sqlite3_stmt* statement, int index, char const** text, int* bytes);
+MDSW_API void mdsw_column_text16(sqlite3_stmt* statement, int index, void const** text, int* bytes);
+MDSW_API void mdsw_column_blob(sqlite3_stmt* statement, int index, void const** data, int* bytes);
+// Copies at most count bytes of the blob from sourceOffset into destination.  Returns the number of bytes copied,
+// or the length of the blob when no destination is given.
+MDSW_API int mdsw_column_blob_copy(sqlite3_stmt* statement, int index, int sourceOffset, void* destination, int count);
+// Parses an ISO-8601 date from the UTF-8 column text.  Returns the DateTimeKind of the value and its .NET ticks, or
+// -1 if the text is not one of the common shapes.
+MDSW_API int mdsw_column_datetime(sqlite3_stmt* statement, int index, sqlite3_int64* ticks);
+MDSW_API void mdsw_column_name(sqlite3_stmt* statement, int index, char const** text, int* bytes);
+MDSW_API void mdsw_column_decltype(sqlite3_stmt* statement, int index, char const** text, int* bytes);
+MDSW_API void mdsw_column_database_name(sqlite3_stmt* statement, int index, char const** text, int* bytes);
+MDSW_API void mdsw_column_table_name(sqlite3_stmt* statement, int index, char const** text, int* bytes);
+MDSW_API void mdsw_column_origin_name(sqlite3_stmt* statement, int index, char const** text, int* bytes);
+
+MDSW_API int mdsw_value_type(sqlite3_value* value);
+MDSW_API int mdsw_value_int(sqlite3_value* value);
+MDSW_API sqlite3_int64 mdsw_value_int64(sqlite3_value* value);
+MDSW_API double mdsw_value_double(sqlite3_value* value);
+MDSW_API int mdsw_value_bytes(sqlite3_value* value);
+MDSW_API void mdsw_value_text(sqlite3_value* value, char const** text, int* bytes);
+MDSW_API void mdsw_value_text16(sqlite3_value* value, void const** text, int* bytes);
+MDSW_API void mdsw_value_blob(sqlite3_value* value, void const** data, int* bytes);
+MDSW_API int mdsw_value_blob_copy(sqlite3_value* value, int sourceOffset, void* destination, int count);
+
+MDSW_API void mdsw_result_null(sqlite3_context* context);
+MDSW_API void mdsw_result_int(sqlite3_context* context, int value);
+MDSW_API void mdsw_result_int64(sqlite3_context* context, sqlite3_int64 value);
+MDSW_API void mdsw_result_double(sqlite3_context* context, double value);
+MDSW_API void mdsw_result_text(sqlite3_context* context, char const* text, int bytes);
+MDSW_API void mdsw_result_text16(sqlite3_context* context, void const* text, int bytes);
+MDSW_API void mdsw_result_blob(sqlite3_context* context, void const* data, int bytes);
+MDSW_API void mdsw_result_error(sqlite3_context* context, char const* text, int bytes);
+MDSW_API void mdsw_result_error16(sqlite3_context* context, void const* text, int bytes);
+// Returns a key that identifies the aggregate being computed, the same for every call of one group
+MDSW_API sqlite3_int64 mdsw_aggregate_context(sqlite3_context* context, int bytes);
+
+/*
+Registers a function whose callbacks get state instead of having to ask sqlite for their user data.  destroy,
+if given, is called with state once sqlite no longer needs it, even if the registration fails.
+*/
+MDSW_API int mdsw_create_function(sqlite3* db, char const* name, int nameBytes, int argc, void* state,
+	mdsw_function_callback func, mdsw_function_callback step, mdsw_final_callback final, mdsw_destroy_callback destroy);
+// Likewise for a collation.  A null compare removes the collation.
+MDSW_API int mdsw_create_collation(sqlite3* db, char const* name, int nameBytes, void* state,
+	mdsw_collation_callback compare, mdsw_destroy_callback destroy);
+
+MDSW_API void mdsw_update_hook(sqlite3* db, mdsw_update_hook_callback callback, void* state);
+MDSW_API void mdsw_commit_hook(sqlite3* db, mdsw_commit_hook_callback callback, void* state);
+MDSW_API void mdsw_rollback_hook(sqlite3* db, mdsw_rollback_hook_callback callback, void* state);
+// Registering a WAL hook turns off sqlite's own automatic checkpoints; removing it does not turn them back on.
+MDSW_API void mdsw_wal_hook(sqlite3* db, mdsw_wal_hook_callback callback, void* state);
+MDSW_API int mdsw_wal_checkpoint_v2(sqlite3* db, char const* dbName, int dbNameBytes, int mode, int* logFrames, int* checkpointedFrames);
+MDSW_API int mdsw_trace_v2(sqlite3* db, unsigned int mask, mdsw_trace_callback callback, void* state);
+
+MDSW_API int mdsw_table_column_metadata(sqlite3* db, char const* dbName, int dbNameBytes,
+	char const* tableName, int tableNameBytes, char const* columnName, int columnNameBytes,
+	char const** dataType, int* dataTypeBytes, char const** collSeq, int* collSeqBytes,
+	int* notNull, int* primaryKey, int* autoInc);
+
+MDSW_API int mdsw_blob_open(sqlite3* db, char const* dbName, int dbNameBytes, char const* tableName, int tableNameBytes,
+	char const* columnName, int columnNameBytes, sqlite3_int64 rowid, int flags, sqlite3_blob** blob);
+MDSW_API int mdsw_blob_reopen(sqlite3_blob* blob, sqlite3_int64 rowid);
+MDSW_API int mdsw_blob_close(sqlite3_blob* blob);
+MDSW_API int mdsw_blob_bytes(sqlite3_blob* blob);
+MDSW_API int mdsw_blob_read(sqlite3_blob* blob, void* destination, int count, int blobOffset);
+MDSW_API int mdsw_blob_write(sqlite3_blob* blob, void const* source, int count, int blobOffset);
+
+// Returns null if the backup cannot be started, with the error left on the destination connection.
+MDSW_API sqlite3_backup* mdsw_backup_init(sqlite3* destination, char const* destinationName, int destinationNameBytes,
+	sqlite3* source, char const* sourceName, int sourceNameBytes);
+MDSW_API int mdsw_backup_step(sqlite3_backup* backup, int pages);
+MDSW_API int mdsw_backup_finish(sqlite3_backup* backup);
+MDSW_API int mdsw_backup_remaining(sqlite3_backup* backup);
+MDSW_API int mdsw_backup_pagecount(sqlite3_backup* backup);
+
+// sqlite3_config() is variadic, so each shape of arguments gets its own entry point.  Process-wide options only take
+// effect before sqlite is initialized, that is before the first connection is opened.
+MDSW_API int mdsw_config(int option);
+MDSW_API int mdsw_config_int(int option, int value);
+MDSW_API int mdsw_config_int_int(int option, int value1, int value2);
+MDSW_API int mdsw_config_int64_int64(int option, sqlite3_int64 value1, sqlite3_int64 value2);
+// Allocates the page cache arena itself and keeps it for the life of the process, as sqlite requires.
+MDSW_API int mdsw_config_pagecache(int pageSize, int pageCount);
+MDSW_API int mdsw_db_config_lookaside(sqlite3* db, int slotSize, int slotCount);
+MDSW_API sqlite3_int64 mdsw_soft_heap_limit64(sqlite3_int64 limit);
+MDSW_API int mdsw_status64(int op, sqlite3_int64* current, sqlite3_int64* highwater, int resetFlag);
+MDSW_API int mdsw_db_status(sqlite3* db, int op, int* current, int* highwater, int resetFlag);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,4 +6,6 @@
 #pragma once
 
 #include <windows.h>
-#include <vector>
\ No newline at end of file
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
\ No newline at end of file
@@ -15,82 +15,532 @@ using namespace MonoDataSqliteWrapper;
 using namespace Platform;
 using namespace std;
 
-vector<char> convert_to_utf8_buffer(String^ str)
+/*
+Fixed-size scratch storage that lives on the stack and only falls back to the heap when a value
+does not fit.  The heap block, if any, is released with the buffer, so conversions never leak.
+*/
+template <typename T, size_t N>
+class scratch_buffer
 {
-	// A null value cannot be marshalled for Platform::String^, so they should never be null
-	if (str->IsEmpty())
+public:
+	scratch_buffer() : _data(_inline), _capacity(N)
+	{
+	}
+
+	~scratch_buffer()
 	{
-		// Return an "empty" string
-		return vector<char>(1);
+		if (_data != _inline)
+		{
+			delete[] _data;
+		}
 	}
 
-	// Get the size of the utf-8 string
-	int size = WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, str->Data(), str->Length(), nullptr, 0, nullptr, nullptr);
-	if (size == 0)
+	// Makes room for count elements, preserving the first keep elements already written
+	T* reserve(size_t count, size_t keep = 0)
 	{
-		// Not much we can do here; just return an empty string
-		return vector<char>(1);
+		if (count > _capacity)
+		{
+			T* data = new T[count];
+			std::copy(_data, _data + keep, data);
+			if (_data != _inline)
+			{
+				delete[] _data;
+			}
+			_data = data;
+			_capacity = count;
+		}
+		return _data;
 	}
 
-	// Allocate the buffer and do the conversion
-	vector<char> buffer(size + 1 /* null */);
-	if (WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, str->Data(), str->Length(), buffer.data(), size, nullptr, nullptr) == 0)
+	T* data()
 	{
-		// Not much we can do here; just return an empty string
-		return vector<char>(1);
+		return _data;
 	}
 
-	return std::move(buffer);
+private:
+	scratch_buffer(scratch_buffer const&);
+	scratch_buffer& operator=(scratch_buffer const&);
+
+	T _inline[N];
+	T* _data;
+	size_t _capacity;
+};
+
+// Copies the leading ASCII run of a UTF-16 string into target, four code units per test.
+// Returns the number of code units copied.
+int narrow_ascii(wchar_t const* source, int length, char* target)
+{
+	int i = 0;
+	for (; i + 4 <= length; i += 4)
+	{
+		uint64 block;
+		memcpy(&block, source + i, sizeof(block));
+		if (block & 0xFF80FF80FF80FF80ULL)
+		{
+			break;
+		}
+
+		target[i] = static_cast<char>(source[i]);
+		target[i + 1] = static_cast<char>(source[i + 1]);
+		target[i + 2] = static_cast<char>(source[i + 2]);
+		target[i + 3] = static_cast<char>(source[i + 3]);
+	}
+
+	for (; i < length && source[i] < 0x80; ++i)
+	{
+		target[i] = static_cast<char>(source[i]);
+	}
+
+	return i;
 }
 
-String^ convert_to_string(char const* str)
+// Copies the leading ASCII run of a UTF-8 string into target, eight bytes per test.
+// Returns the number of bytes copied.
+int widen_ascii(char const* source, int length, wchar_t* target)
+{
+	int i = 0;
+	for (; i + 8 <= length; i += 8)
+	{
+		uint64 block;
+		memcpy(&block, source + i, sizeof(block));
+		if (block & 0x8080808080808080ULL)
+		{
+			break;
+		}
+
+		for (int j = 0; j < 8; ++j)
+		{
+			target[i + j] = static_cast<wchar_t>(source[i + j]);
+		}
+	}
+
+	for (; i < length && static_cast<unsigned char>(source[i]) < 0x80; ++i)
+	{
+		target[i] = static_cast<wchar_t>(source[i]);
+	}
+
+	return i;
+}
+
+/*
+Null-terminated UTF-8 copy of a Platform::String^ (or of its first length code units).
+Short strings are converted on the stack; ASCII text is narrowed without calling into the OS.
+Unpaired surrogates become U+FFFD instead of failing the whole conversion.
+*/
+class utf8_string
+{
+public:
+	explicit utf8_string(String^ str, int length = -1) : _length(0)
+	{
+		// A null value cannot be marshalled for Platform::String^, so they should never be null
+		int source_length = str->IsEmpty() ? 0 : static_cast<int>(str->Length());
+		if (length >= 0 && length < source_length)
+		{
+			source_length = length;
+		}
+
+		char* target = _buffer.reserve(source_length + 1 /* null */);
+		if (source_length > 0)
+		{
+			wchar_t const* source = str->Data();
+			int ascii = narrow_ascii(source, source_length, target);
+			_length = ascii;
+
+			if (ascii < source_length)
+			{
+				int rest = WideCharToMultiByte(CP_UTF8, 0, source + ascii, source_length - ascii, nullptr, 0, nullptr, nullptr);
+				if (rest > 0)
+				{
+					target = _buffer.reserve(ascii + rest + 1 /* null */, ascii);
+					_length += WideCharToMultiByte(CP_UTF8, 0, source + ascii, source_length - ascii, target + ascii, rest, nullptr, nullptr);
+				}
+			}
+		}
+
+		target[_length] = '\0';
+	}
+
+	char const* data()
+	{
+		return _buffer.data();
+	}
+
+	int length() const
+	{
+		return _length;
+	}
+
+private:
+	scratch_buffer<char, 256> _buffer;
+	int _length;
+};
+
+String^ convert_to_string(char const* str, int length = -1)
 {
 	if (!str)
 	{
 		return ref new String();
 	}
 
-	// Get the size of the wide string
-	int size = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, str, -1, nullptr, 0);
-	if (size == 0)
+	if (length < 0)
 	{
-		return ref new String();
+		length = static_cast<int>(strlen(str));
 	}
 
-	// Allocate the buffer and do the conversion
-	vector<wchar_t> buffer(size /* already includes null from pasing -1 above */);
-	if (MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, str, -1, buffer.data(), size) == 0)
+	if (length == 0)
 	{
 		return ref new String();
 	}
 
-	return ref new String(buffer.data());
+	// Every UTF-8 byte yields at most one UTF-16 code unit, so length is always enough room
+	scratch_buffer<wchar_t, 256> buffer;
+	wchar_t* target = buffer.reserve(length);
+	int size = widen_ascii(str, length, target);
+
+	if (size < length)
+	{
+		size += MultiByteToWideChar(CP_UTF8, 0, str + size, length - size, target + size, length - size);
+	}
+
+	return ref new String(target, size);
 }
 
-String^ convert_to_string(unsigned char const* str)
+String^ convert_to_string(unsigned char const* str, int length = -1)
 {
 	char const* newStr = reinterpret_cast<char const*>(str);
-	return convert_to_string(newStr);
+	return convert_to_string(newStr, length);
+}
+
+// Copies at most count bytes of [data + sourceOffset, data + length) into destination at destinationOffset.
+// Returns the number of bytes copied, or the total length when no destination is given.
+int copy_blob_range(uint8 const* data, int length, int sourceOffset, WriteOnlyArray<uint8>^ destination, int destinationOffset, int count)
+{
+	if (length < 0)
+	{
+		length = 0;
+	}
+
+	if (!destination)
+	{
+		return length;
+	}
+
+	if (sourceOffset < 0 || destinationOffset < 0 || count <= 0 || sourceOffset >= length || destinationOffset >= static_cast<int>(destination->Length))
+	{
+		return 0;
+	}
+
+	count = min(count, length - sourceOffset);
+	count = min(count, static_cast<int>(destination->Length) - destinationOffset);
+
+	std::copy(data + sourceOffset, data + sourceOffset + count, destination->Data + destinationOffset);
+	return count;
+}
+
+// Reads count decimal digits at text into value. Returns false if any of them is not a digit.
+static bool parse_digits(char const* text, int count, int* value)
+{
+	int result = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (text[i] < '0' || text[i] > '9')
+		{
+			return false;
+		}
+		result = result * 10 + (text[i] - '0');
+	}
+	*value = result;
+	return true;
 }
 
-// Convert wchar_t* to a char*
-char* to_cstr(wchar_t *orig)
+/*
+Parses the ISO-8601 shapes dates are almost always stored in straight from the UTF-8 column text:
+yyyy-MM-dd, optionally followed by a space or a T and HH:mm, HH:mm:ss or HH:mm:ss.FFFFFFF, optionally followed by Z.
+Stores the value in .NET ticks and returns its DateTimeKind (0 unspecified, 1 UTC), or -1 for any other shape.
+*/
+static int parse_iso8601(char const* text, int length, int64* ticks)
 {
-    size_t origsize = wcslen(orig) + 1;
-    size_t convertedChars = 0;
-    char* nstring = new char[origsize];
-    wcstombs_s(&convertedChars, nstring, origsize, orig, _TRUNCATE);
-    
-	return nstring;
+	static int const days_before_month[2][13] =
+	{
+		{ 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 },
+		{ 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366 }
+	};
+	int const ticks_per_second = 10000000;
+
+	int year, month, day;
+	if (!text || length < 10 || text[4] != '-' || text[7] != '-' ||
+		!parse_digits(text, 4, &year) || !parse_digits(text + 5, 2, &month) || !parse_digits(text + 8, 2, &day))
+	{
+		return -1;
+	}
+
+	int leap = (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) ? 1 : 0;
+	if (year < 1 || month < 1 || month > 12 || day < 1 ||
+		day > days_before_month[leap][month] - days_before_month[leap][month - 1])
+	{
+		return -1;
+	}
+
+	int64 y = year - 1;
+	int64 days = y * 365 + y / 4 - y / 100 + y / 400 + days_before_month[leap][month - 1] + day - 1;
+	int64 seconds = days * 86400;
+	int64 fraction = 0;
+	int kind = 0;
+	int pos = 10;
+
+	if (pos < length)
+	{
+		int hour, minute, second = 0;
+		if ((text[pos] != ' ' && text[pos] != 'T') || length < pos + 6 || text[pos + 3] != ':' ||
+			!parse_digits(text + pos + 1, 2, &hour) || !parse_digits(text + pos + 4, 2, &minute) ||
+			hour > 23 || minute > 59)
+		{
+			return -1;
+		}
+		pos += 6;
+
+		if (pos < length && text[pos] == ':')
+		{
+			if (length < pos + 3 || !parse_digits(text + pos + 1, 2, &second) || second > 59)
+			{
+				return -1;
+			}
+			pos += 3;
+
+			if (pos < length && text[pos] == '.')
+			{
+				pos++;
+				int digits = 0;
+				while (pos < length && digits < 7 && text[pos] >= '0' && text[pos] <= '9')
+				{
+					fraction = fraction * 10 + (text[pos] - '0');
+					digits++;
+					pos++;
+				}
+				if (digits == 0)
+				{
+					return -1;
+				}
+				for (; digits < 7; digits++)
+				{
+					fraction *= 10;
+				}
+			}
+		}
+
+		seconds += hour * 3600 + minute * 60 + second;
+
+		if (pos < length && text[pos] == 'Z')
+		{
+			kind = 1;
+			pos++;
+		}
+	}
+
+	if (pos != length)
+	{
+		return -1;
+	}
+
+	*ticks = seconds * ticks_per_second + fraction;
+	return kind;
+}
+
+/*
+The values bound to a parameter by sqlite3_bind_array, copied into one block that sqlite frees with the binding.
+texts holds the UTF-16 code units of every text, with offsets the start of each plus a final end, in code units.
+*/
+struct array_values
+{
+	int kind;
+	int count;
+	int64 const* integers;
+	double const* doubles;
+	wchar_t const* texts;
+	int const* offsets;
+	unsigned char const* nulls;
+};
+
+// The type of the pointers bound by sqlite3_bind_array, which only the array table accepts
+static char const* const array_pointer_type = "MonoDataSqliteWrapper.array";
+
+struct array_cursor
+{
+	sqlite3_vtab_cursor base;
+	array_values const* values;
+	int row;
+};
+
+// The table array(?) reads: a value column, and the hidden column the bound pointer is given to
+static int array_connect(sqlite3* db, void*, int, char const* const*, sqlite3_vtab** vtab, char**)
+{
+	int result = ::sqlite3_declare_vtab(db, "CREATE TABLE x(value, pointer HIDDEN)");
+	if (result != SQLITE_OK)
+	{
+		return result;
+	}
+
+	*vtab = static_cast<sqlite3_vtab*>(::sqlite3_malloc(sizeof(sqlite3_vtab)));
+	if (!*vtab)
+	{
+		return SQLITE_NOMEM;
+	}
+	memset(*vtab, 0, sizeof(sqlite3_vtab));
+	return SQLITE_OK;
+}
+
+static int array_disconnect(sqlite3_vtab* vtab)
+{
+	::sqlite3_free(vtab);
+	return SQLITE_OK;
+}
+
+/*
+The table can only be read for a bound array.  Without one the plan is priced out of consideration, and if it is
+used anyway it is empty.
+*/
+static int array_best_index(sqlite3_vtab*, sqlite3_index_info* info)
+{
+	for (int i = 0; i < info->nConstraint; i++)
+	{
+		auto const& constraint = info->aConstraint[i];
+		if (constraint.iColumn == 1 && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ && constraint.usable)
+		{
+			info->aConstraintUsage[i].argvIndex = 1;
+			info->aConstraintUsage[i].omit = 1;
+			info->idxNum = 1;
+			info->estimatedCost = 10;
+			info->estimatedRows = 100;
+			return SQLITE_OK;
+		}
+	}
+
+	info->idxNum = 0;
+	info->estimatedCost = 2147483647;
+	info->estimatedRows = 2147483647;
+	return SQLITE_OK;
+}
+
+static int array_open(sqlite3_vtab*, sqlite3_vtab_cursor** cursor)
+{
+	auto actual_cursor = static_cast<array_cursor*>(::sqlite3_malloc(sizeof(array_cursor)));
+	if (!actual_cursor)
+	{
+		return SQLITE_NOMEM;
+	}
+	memset(actual_cursor, 0, sizeof(array_cursor));
+	*cursor = &actual_cursor->base;
+	return SQLITE_OK;
+}
+
+static int array_close(sqlite3_vtab_cursor* cursor)
+{
+	::sqlite3_free(cursor);
+	return SQLITE_OK;
+}
+
+static int array_filter(sqlite3_vtab_cursor* cursor, int idxNum, char const*, int argc, sqlite3_value** argv)
+{
+	auto actual_cursor = reinterpret_cast<array_cursor*>(cursor);
+	actual_cursor->values = idxNum == 1 && argc == 1
+		? static_cast<array_values const*>(::sqlite3_value_pointer(argv[0], array_pointer_type))
+		: nullptr;
+	actual_cursor->row = 0;
+	return SQLITE_OK;
+}
+
+static int array_next(sqlite3_vtab_cursor* cursor)
+{
+	reinterpret_cast<array_cursor*>(cursor)->row++;
+	return SQLITE_OK;
+}
+
+static int array_eof(sqlite3_vtab_cursor* cursor)
+{
+	auto actual_cursor = reinterpret_cast<array_cursor*>(cursor);
+	return !actual_cursor->values || actual_cursor->row >= actual_cursor->values->count;
+}
+
+static int array_column(sqlite3_vtab_cursor* cursor, sqlite3_context* context, int column)
+{
+	auto actual_cursor = reinterpret_cast<array_cursor*>(cursor);
+	auto values = actual_cursor->values;
+	int row = actual_cursor->row;
+
+	// The hidden column reads as NULL; pointers only go from bindings to functions
+	if (column != 0 || (values->nulls && values->nulls[row]))
+	{
+		::sqlite3_result_null(context);
+		return SQLITE_OK;
+	}
+
+	switch (values->kind)
+	{
+	case SQLITE_INTEGER:
+		::sqlite3_result_int64(context, values->integers[row]);
+		break;
+	case SQLITE_FLOAT:
+		::sqlite3_result_double(context, values->doubles[row]);
+		break;
+	default:
+		{
+			int start = values->offsets[row];
+			int length = values->offsets[row + 1] - start;
+			::sqlite3_result_text16(context, values->texts + start, length * static_cast<int>(sizeof(wchar_t)), SQLITE_TRANSIENT);
+		}
+		break;
+	}
+	return SQLITE_OK;
+}
+
+static int array_rowid(sqlite3_vtab_cursor* cursor, int64* rowid)
+{
+	*rowid = reinterpret_cast<array_cursor*>(cursor)->row + 1;
+	return SQLITE_OK;
+}
+
+static sqlite3_module const* array_module()
+{
+	static sqlite3_module const module = []
+	{
+		// Without xCreate the table is eponymous-only: it exists in every schema, and CREATE VIRTUAL TABLE rejects it
+		sqlite3_module m;
+		memset(&m, 0, sizeof(m));
+		m.xConnect = array_connect;
+		m.xBestIndex = array_best_index;
+		m.xDisconnect = array_disconnect;
+		m.xOpen = array_open;
+		m.xClose = array_close;
+		m.xFilter = array_filter;
+		m.xNext = array_next;
+		m.xEof = array_eof;
+		m.xColumn = array_column;
+		m.xRowid = array_rowid;
+		return m;
+	}();
+	return &module;
+}
+
+// Makes the array table available on a newly opened connection
+static void register_array_module(sqlite3* db)
+{
+	if (db)
+	{
+		::sqlite3_create_module(db, "array", array_module(), nullptr);
+	}
 }
 
 int UnsafeNativeMethods::sqlite3_open(String^ filename, SqliteConnectionHandle^* db)
 {
-	auto filename_buffer = convert_to_utf8_buffer(filename);
+	utf8_string filename_buffer(filename);
 
 	// Use sqlite3_open instead of sqlite3_open16 so that the default code page for stored strings is UTF-8 and not UTF-16
 	sqlite3* actual_db = nullptr;
 	int result = ::sqlite3_open(filename_buffer.data(), &actual_db);
+	if (result == SQLITE_OK)
+	{
+		register_array_module(actual_db);
+	}
 	if (db)
 	{
 		// If they didn't give us a pointer, the caller has leaked
@@ -103,6 +553,10 @@ int UnsafeNativeMethods::sqlite3_open16(String^ filename, SqliteConnectionHandle
 {
 	sqlite3* actual_db = nullptr;
 	int result = ::sqlite3_open16(filename->Data(), &actual_db);
+	if (result == SQLITE_OK)
+	{
+		register_array_module(actual_db);
+	}
 	if (db)
 	{
 		// If they didn't give us a pointer, the caller has leaked
@@ -113,15 +567,19 @@ int UnsafeNativeMethods::sqlite3_open16(String^ filename, SqliteConnectionHandle
 
 int UnsafeNativeMethods::sqlite3_open_v2(String^ filename, SqliteConnectionHandle^* db, int flags, String^ zVfs)
 {
-	auto filename_buffer = convert_to_utf8_buffer(filename);
-	auto zVfs_buffer = convert_to_utf8_buffer(zVfs);
+	utf8_string filename_buffer(filename);
+	utf8_string zVfs_buffer(zVfs);
 
 	sqlite3* actual_db = nullptr;
 	int result = ::sqlite3_open_v2(
 		filename_buffer.data(),
 		&actual_db,
 		flags,
-		zVfs_buffer.size() <= 1 /* empty string */ ? nullptr : zVfs_buffer.data());
+		zVfs_buffer.length() == 0 /* empty string */ ? nullptr : zVfs_buffer.data());
+	if (result == SQLITE_OK)
+	{
+		register_array_module(actual_db);
+	}
 	if (db)
 	{
 		// If they didn't give us a pointer, the caller has leaked
@@ -140,6 +598,66 @@ int UnsafeNativeMethods::sqlite3_busy_timeout(SqliteConnectionHandle^ db, int mi
 	return ::sqlite3_busy_timeout(db ? db->Handle : nullptr, miliseconds);
 }
 
+static int busy_handler_callback(void* state, int count)
+{
+	auto db = reinterpret_cast<SqliteConnectionHandle^>(state);
+	try
+	{
+		return db->BusyHandler(db->BusyHandlerState, count);
+	}
+	catch (Exception^)
+	{
+		// Nothing may unwind through sqlite, so stop waiting and let the caller see SQLITE_BUSY
+		return 0;
+	}
+}
+
+int UnsafeNativeMethods::sqlite3_busy_handler(SqliteConnectionHandle^ db, SqliteBusyHandlerDelegate^ callback, Object^ userState)
+{
+	if (!db)
+	{
+		return SQLITE_MISUSE;
+	}
+
+	db->BusyHandler = callback;
+	db->BusyHandlerState = userState;
+	return ::sqlite3_busy_handler(
+		db->Handle,
+		callback ? busy_handler_callback : nullptr,
+		callback ? reinterpret_cast<void*>(db) : nullptr);
+}
+
+static int progress_handler_callback(void* state)
+{
+	auto db = reinterpret_cast<SqliteConnectionHandle^>(state);
+	try
+	{
+		return db->ProgressHandler(db->ProgressHandlerState);
+	}
+	catch (Exception^)
+	{
+		// Nothing may unwind through sqlite, so let the statement run on
+		return 0;
+	}
+}
+
+int UnsafeNativeMethods::sqlite3_progress_handler(SqliteConnectionHandle^ db, int instructions, SqliteProgressHandlerDelegate^ callback, Object^ userState)
+{
+	if (!db)
+	{
+		return SQLITE_MISUSE;
+	}
+
+	db->ProgressHandler = callback;
+	db->ProgressHandlerState = userState;
+	::sqlite3_progress_handler(
+		db->Handle,
+		instructions,
+		callback ? progress_handler_callback : nullptr,
+		callback ? reinterpret_cast<void*>(db) : nullptr);
+	return SQLITE_OK;
+}
+
 int UnsafeNativeMethods::sqlite3_changes(SqliteConnectionHandle^ db)
 {
 	return ::sqlite3_changes(db ? db->Handle : nullptr);
@@ -200,6 +718,224 @@ int UnsafeNativeMethods::sqlite3_finalize(SqliteStatementHandle^ statement)
 	return ::sqlite3_finalize(statement ? statement->Handle : nullptr);
 }
 
+int UnsafeNativeMethods::sqlite3_clear_bindings(SqliteStatementHandle^ statement)
+{
+	return ::sqlite3_clear_bindings(statement ? statement->Handle : nullptr);
+}
+
+int UnsafeNativeMethods::sqlite3_stmt_status(SqliteStatementHandle^ statement, int op, int resetFlag)
+{
+	return ::sqlite3_stmt_status(statement ? statement->Handle : nullptr, op, resetFlag);
+}
+
+// Binds the value of parameter for row, as laid out by sqlite3_step_batch
+static int bind_batch_value(sqlite3_stmt* stmt, int parameter, int kind, int slot, int row, int rowCount,
+	const Array<int64>^ integers, const Array<double>^ doubles, const Array<String^>^ texts,
+	const Array<uint8>^ blobs, const Array<int>^ blobOffsets, const Array<uint8>^ nulls)
+{
+	if (nulls && nulls->Length > 0 && nulls[parameter * rowCount + row])
+	{
+		return ::sqlite3_bind_null(stmt, parameter + 1);
+	}
+
+	int cell = slot * rowCount + row;
+	switch (kind)
+	{
+	case SQLITE_INTEGER:
+		return ::sqlite3_bind_int64(stmt, parameter + 1, integers[cell]);
+	case SQLITE_FLOAT:
+		return ::sqlite3_bind_double(stmt, parameter + 1, doubles[cell]);
+	case SQLITE_TEXT:
+		{
+			// The arrays outlive the batch and the bindings are cleared before returning, so nothing needs copying
+			String^ text = texts[cell];
+			return ::sqlite3_bind_text16(
+				stmt,
+				parameter + 1,
+				text ? text->Data() : L"",
+				text ? static_cast<int>(text->Length() * sizeof(wchar_t)) : 0,
+				SQLITE_STATIC);
+		}
+	case SQLITE_BLOB:
+		{
+			int start = blobOffsets[cell];
+			int length = blobOffsets[cell + 1] - start;
+			return length > 0
+				? ::sqlite3_bind_blob(stmt, parameter + 1, blobs->Data + start, length, SQLITE_STATIC)
+				: ::sqlite3_bind_zeroblob(stmt, parameter + 1, 0);
+		}
+	default:
+		return SQLITE_MISUSE;
+	}
+}
+
+int UnsafeNativeMethods::sqlite3_step_batch(SqliteStatementHandle^ statement, int firstRow, int rowCount, const Array<int>^ kinds,
+	const Array<int64>^ integers, const Array<double>^ doubles, const Array<String^>^ texts,
+	const Array<uint8>^ blobs, const Array<int>^ blobOffsets, const Array<uint8>^ nulls,
+	WriteOnlyArray<int>^ changes, int* rowsDone)
+{
+	auto stmt = statement ? statement->Handle : nullptr;
+	int parameterCount = kinds ? static_cast<int>(kinds->Length) : 0;
+	int row = firstRow;
+	int result = SQLITE_OK;
+
+	// The position of each parameter among the parameters of the same kind
+	scratch_buffer<int, 32> slot_buffer;
+	int* slots = slot_buffer.reserve(parameterCount);
+	int kindCounts[SQLITE_NULL + 1] = { 0 };
+	for (int parameter = 0; parameter < parameterCount; parameter++)
+	{
+		int kind = kinds[parameter];
+		if (kind < SQLITE_INTEGER || kind > SQLITE_BLOB)
+		{
+			result = SQLITE_MISUSE;
+			break;
+		}
+		slots[parameter] = kindCounts[kind]++;
+	}
+
+	sqlite3* db = ::sqlite3_db_handle(stmt);
+	while (result == SQLITE_OK && row < rowCount)
+	{
+		for (int parameter = 0; parameter < parameterCount && result == SQLITE_OK; parameter++)
+		{
+			result = bind_batch_value(stmt, parameter, kinds[parameter], slots[parameter], row, rowCount, integers, doubles, texts, blobs, blobOffsets, nulls);
+		}
+		if (result != SQLITE_OK)
+		{
+			break;
+		}
+
+		// sqlite3_changes keeps the count of the last INSERT, UPDATE or DELETE, so a step that changed nothing, such as
+		// a SELECT or CREATE, is told apart by the running total
+		int totalChanges = ::sqlite3_total_changes(db);
+		result = ::sqlite3_step(stmt);
+		bool stepped = result == SQLITE_DONE || result == SQLITE_ROW;
+		if (stepped && changes)
+		{
+			changes[row] = ::sqlite3_total_changes(db) != totalChanges ? ::sqlite3_changes(db) : 0;
+		}
+
+		// sqlite3_reset reports the actual error of a failed step, which is SQLITE_ERROR with sqlite3_prepare16
+		int reset = ::sqlite3_reset(stmt);
+		result = stepped ? reset : (reset != SQLITE_OK ? reset : result);
+		if (result == SQLITE_OK)
+		{
+			row++;
+		}
+	}
+
+	::sqlite3_clear_bindings(stmt);
+	if (rowsDone)
+	{
+		*rowsDone = row;
+	}
+	return result;
+}
+
+int UnsafeNativeMethods::sqlite3_step_block(SqliteStatementHandle^ statement, int pending, int firstRow, int blobStart, int maxRows, int stride,
+	WriteOnlyArray<uint8>^ types, WriteOnlyArray<int64>^ integers, WriteOnlyArray<double>^ doubles,
+	WriteOnlyArray<String^>^ texts, WriteOnlyArray<uint8>^ blobs, WriteOnlyArray<int>^ blobOffsets,
+	int* rowCount, int* blobBytesNeeded)
+{
+	auto stmt = statement ? statement->Handle : nullptr;
+	int columnCount = ::sqlite3_column_count(stmt);
+	int cells = columnCount * stride;
+	int blobCapacity = blobs ? static_cast<int>(blobs->Length) : 0;
+	int row = firstRow;
+	int blobBytes = blobStart;
+	int needed = 0;
+	int result = SQLITE_ROW;
+
+	if (maxRows > stride || firstRow < 0 || blobStart < 0 || blobStart > blobCapacity || !types || !integers || !doubles || !texts || !blobOffsets
+		|| static_cast<int>(types->Length) < cells || static_cast<int>(integers->Length) < cells
+		|| static_cast<int>(doubles->Length) < cells || static_cast<int>(texts->Length) < cells
+		|| static_cast<int>(blobOffsets->Length) < cells)
+	{
+		result = SQLITE_MISUSE;
+		maxRows = 0;
+	}
+
+	while (row < maxRows)
+	{
+		if (pending)
+		{
+			pending = 0;
+		}
+		else
+		{
+			result = ::sqlite3_step(stmt);
+			if (result != SQLITE_ROW)
+			{
+				break;
+			}
+		}
+
+		// A row is stored whole or not at all, so measure its blobs before copying anything
+		int rowBytes = 0;
+		for (int column = 0; column < columnCount; column++)
+		{
+			if (::sqlite3_column_type(stmt, column) == SQLITE_BLOB)
+			{
+				rowBytes += ::sqlite3_column_bytes(stmt, column);
+			}
+		}
+		if (rowBytes > blobCapacity - blobBytes)
+		{
+			needed = rowBytes;
+			result = SQLITE_ROW;
+			break;
+		}
+
+		for (int column = 0; column < columnCount; column++)
+		{
+			int cell = column * stride + row;
+			int type = ::sqlite3_column_type(stmt, column);
+			types[cell] = static_cast<uint8>(type);
+			switch (type)
+			{
+			case SQLITE_INTEGER:
+				integers[cell] = ::sqlite3_column_int64(stmt, column);
+				break;
+			case SQLITE_FLOAT:
+				doubles[cell] = ::sqlite3_column_double(stmt, column);
+				break;
+			case SQLITE_TEXT:
+			{
+				// sqlite3_column_text must be called before sqlite3_column_bytes so the length matches the returned text
+				auto text = ::sqlite3_column_text(stmt, column);
+				texts[cell] = convert_to_string(text, ::sqlite3_column_bytes(stmt, column));
+				break;
+			}
+			case SQLITE_BLOB:
+			{
+				auto data = static_cast<uint8 const*>(::sqlite3_column_blob(stmt, column));
+				int length = ::sqlite3_column_bytes(stmt, column);
+				if (length > 0)
+				{
+					std::memcpy(blobs->Data + blobBytes, data, length);
+				}
+				blobOffsets[cell] = blobBytes;
+				integers[cell] = length;
+				blobBytes += length;
+				break;
+			}
+			}
+		}
+		row++;
+	}
+
+	if (rowCount)
+	{
+		*rowCount = row;
+	}
+	if (blobBytesNeeded)
+	{
+		*blobBytesNeeded = needed;
+	}
+	return result;
+}
+
 int64 UnsafeNativeMethods::sqlite3_last_insert_rowid(SqliteConnectionHandle^ db)
 {
 	return ::sqlite3_last_insert_rowid(db ? db->Handle : nullptr);
@@ -212,7 +948,7 @@ String^ UnsafeNativeMethods::sqlite3_errmsg(SqliteConnectionHandle^ db)
 
 int UnsafeNativeMethods::sqlite3_bind_parameter_index(SqliteStatementHandle^ statement, String^ name)
 {
-	auto name_buffer = convert_to_utf8_buffer(name);
+	utf8_string name_buffer(name);
 	return ::sqlite3_bind_parameter_index(
 		statement ? statement->Handle : nullptr, 
 		name_buffer.data());
@@ -240,11 +976,15 @@ int UnsafeNativeMethods::sqlite3_bind_double(SqliteStatementHandle^ statement, i
 
 int UnsafeNativeMethods::sqlite3_bind_text(SqliteStatementHandle^ statement, int index, String^ value, int length, Object^ dummy)
 {
+	// length counts UTF-16 code units of value; sqlite wants the UTF-8 byte count
+	utf8_string value_buffer(value, length);
+
+	// Use transient here so that the data gets copied by sqlite
 	return ::sqlite3_bind_text(
 		statement ? statement->Handle : nullptr, 
 		index, 
-		to_cstr(value->IsEmpty() ? L"" : value->Data()),
-		length < 0 ? value->Length() * sizeof(char) : length,
+		value_buffer.data(),
+		value_buffer.length(),
 		SQLITE_TRANSIENT);
 }
 
@@ -270,6 +1010,89 @@ int UnsafeNativeMethods::sqlite3_bind_blob(SqliteStatementHandle^ statement, int
 		SQLITE_TRANSIENT);
 }
 
+int UnsafeNativeMethods::sqlite3_bind_array(SqliteStatementHandle^ statement, int index,
+	const Array<int64>^ integers, const Array<double>^ doubles, const Array<String^>^ texts, const Array<uint8>^ nulls)
+{
+	int kind = integers ? SQLITE_INTEGER : doubles ? SQLITE_FLOAT : texts ? SQLITE_TEXT : 0;
+	if (kind == 0)
+	{
+		return SQLITE_MISUSE;
+	}
+	int count = static_cast<int>(kind == SQLITE_INTEGER ? integers->Length : kind == SQLITE_FLOAT ? doubles->Length : texts->Length);
+	if (nulls && static_cast<int>(nulls->Length) < count)
+	{
+		return SQLITE_MISUSE;
+	}
+
+	// The header, then the values, the text offsets and the null flags, each aligned for what it holds
+	size_t textLength = 0;
+	if (kind == SQLITE_TEXT)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			textLength += texts[i] ? texts[i]->Length() : 0;
+		}
+	}
+	size_t valueBytes = kind == SQLITE_TEXT
+		? textLength * sizeof(wchar_t)
+		: count * (kind == SQLITE_INTEGER ? sizeof(int64) : sizeof(double));
+	size_t valueStart = (sizeof(array_values) + 7) & ~size_t(7);
+	size_t offsetStart = (valueStart + valueBytes + 3) & ~size_t(3);
+	size_t offsetBytes = kind == SQLITE_TEXT ? (count + 1) * sizeof(int) : 0;
+	size_t nullStart = offsetStart + offsetBytes;
+	size_t nullBytes = nulls ? count : 0;
+
+	auto block = static_cast<unsigned char*>(::sqlite3_malloc64(nullStart + nullBytes));
+	if (!block)
+	{
+		return SQLITE_NOMEM;
+	}
+
+	auto values = reinterpret_cast<array_values*>(block);
+	memset(values, 0, sizeof(array_values));
+	values->kind = kind;
+	values->count = count;
+	switch (kind)
+	{
+	case SQLITE_INTEGER:
+		memcpy(block + valueStart, integers->Data, valueBytes);
+		values->integers = reinterpret_cast<int64 const*>(block + valueStart);
+		break;
+	case SQLITE_FLOAT:
+		memcpy(block + valueStart, doubles->Data, valueBytes);
+		values->doubles = reinterpret_cast<double const*>(block + valueStart);
+		break;
+	default:
+		{
+			auto text = reinterpret_cast<wchar_t*>(block + valueStart);
+			auto offsets = reinterpret_cast<int*>(block + offsetStart);
+			int position = 0;
+			for (int i = 0; i < count; i++)
+			{
+				offsets[i] = position;
+				if (texts[i])
+				{
+					memcpy(text + position, texts[i]->Data(), texts[i]->Length() * sizeof(wchar_t));
+					position += texts[i]->Length();
+				}
+			}
+			offsets[count] = position;
+			values->texts = text;
+			values->offsets = offsets;
+		}
+		break;
+	}
+	if (nulls)
+	{
+		memcpy(block + nullStart, nulls->Data, nullBytes);
+		values->nulls = block + nullStart;
+	}
+
+	// sqlite frees the block once the parameter is bound to something else or the statement is finalized, even if
+	// the binding fails
+	return ::sqlite3_bind_pointer(statement ? statement->Handle : nullptr, index, block, array_pointer_type, ::sqlite3_free);
+}
+
 int UnsafeNativeMethods::sqlite3_column_count(SqliteStatementHandle^ statement)
 {
 	return ::sqlite3_column_count(statement ? statement->Handle : nullptr);
@@ -307,7 +1130,9 @@ String^ UnsafeNativeMethods::sqlite3_column_text16(SqliteStatementHandle^ statem
 
 String^ UnsafeNativeMethods::sqlite3_column_text(SqliteStatementHandle^ statement, int index)
 {
-	return convert_to_string(::sqlite3_column_text(statement ? statement->Handle : nullptr, index));
+	// sqlite3_column_text must be called before sqlite3_column_bytes so the length matches the returned text
+	auto text = ::sqlite3_column_text(statement ? statement->Handle : nullptr, index);
+	return convert_to_string(text, ::sqlite3_column_bytes(statement ? statement->Handle : nullptr, index));
 }
 
 Array<uint8>^ UnsafeNativeMethods::sqlite3_column_blob(SqliteStatementHandle^ statement, int index)
@@ -329,6 +1154,35 @@ int UnsafeNativeMethods::sqlite3_column_bytes(SqliteStatementHandle^ statement,
 	return ::sqlite3_column_bytes(statement ? statement->Handle : nullptr, index);
 }
 
+SqliteBlobView^ UnsafeNativeMethods::sqlite3_column_blob_view(SqliteStatementHandle^ statement, int index)
+{
+	// sqlite3_column_blob must be called before sqlite3_column_bytes so the length matches the returned pointer
+	auto data = static_cast<uint8 const*>(::sqlite3_column_blob(statement ? statement->Handle : nullptr, index));
+	return ref new SqliteBlobView(data, ::sqlite3_column_bytes(statement ? statement->Handle : nullptr, index));
+}
+
+SqliteBlobView^ UnsafeNativeMethods::sqlite3_column_text_view(SqliteStatementHandle^ statement, int index)
+{
+	// sqlite3_column_text must be called before sqlite3_column_bytes so the length matches the returned text
+	auto text = static_cast<uint8 const*>(::sqlite3_column_text(statement ? statement->Handle : nullptr, index));
+	return ref new SqliteBlobView(text, ::sqlite3_column_bytes(statement ? statement->Handle : nullptr, index));
+}
+
+int UnsafeNativeMethods::sqlite3_column_blob_copy(SqliteStatementHandle^ statement, int index, int sourceOffset, WriteOnlyArray<uint8>^ destination, int destinationOffset, int count)
+{
+	auto data = static_cast<uint8 const*>(::sqlite3_column_blob(statement ? statement->Handle : nullptr, index));
+	int length = ::sqlite3_column_bytes(statement ? statement->Handle : nullptr, index);
+	return copy_blob_range(data, length, sourceOffset, destination, destinationOffset, count);
+}
+
+int UnsafeNativeMethods::sqlite3_column_datetime(SqliteStatementHandle^ statement, int index, int64* ticks)
+{
+	// sqlite3_column_text must be called before sqlite3_column_bytes so the length matches the returned text
+	auto text = reinterpret_cast<char const*>(::sqlite3_column_text(statement ? statement->Handle : nullptr, index));
+	int length = ::sqlite3_column_bytes(statement ? statement->Handle : nullptr, index);
+	return parse_iso8601(text, length, ticks);
+}
+
 void UnsafeNativeMethods::sqlite3_interrupt(SqliteConnectionHandle^ db)
 {
 	::sqlite3_interrupt(db ? db->Handle : nullptr);
@@ -353,7 +1207,7 @@ Platform::String^ UnsafeNativeMethods::sqlite3_value_text16(SqliteValueHandle^ v
 Platform::String^ UnsafeNativeMethods::sqlite3_value_text(SqliteValueHandle^ value)
 {
 	const unsigned char* result = ::sqlite3_value_text(value ? value->Handle : nullptr);
-	return convert_to_string(result);
+	return convert_to_string(result, ::sqlite3_value_bytes(value ? value->Handle : nullptr));
 }
 
 Platform::String^ UnsafeNativeMethods::sqlite3_libversion()
@@ -405,27 +1259,31 @@ void UnsafeNativeMethods::sqlite3_result_text16(SqliteContextHandle^ statement,
 
 void UnsafeNativeMethods::sqlite3_result_error(SqliteContextHandle^ statement, String^ value, int index)
 {
+	utf8_string value_buffer(value, index);
 	::sqlite3_result_error(
 		statement ? statement->Handle : nullptr, 
-		to_cstr(value->IsEmpty() ? L"" : value->Data()),
-		index);
+		value_buffer.data(),
+		value_buffer.length());
 }
 
 void UnsafeNativeMethods::sqlite3_result_text(SqliteContextHandle^ statement, String^ value, int index, Object^ dummy)
 {
+	utf8_string value_buffer(value, index);
 	::sqlite3_result_text(
 		statement ? statement->Handle : nullptr, 
-		to_cstr(value->IsEmpty() ? L"" : value->Data()),
-		index,
+		value_buffer.data(),
+		value_buffer.length(),
 		SQLITE_TRANSIENT);
 }
 
 int UnsafeNativeMethods::sqlite3_exec(SqliteConnectionHandle^ db, String^ query, Platform::String^* errmsg)
 {
+	utf8_string query_buffer(query);
+
 	char* actual_error = nullptr;
 	int result = ::sqlite3_exec(
 		db ? db->Handle : nullptr, 
-		to_cstr(query->IsEmpty() ? L"" : query->Data()), 
+		query_buffer.data(), 
 		nullptr, 
 		nullptr, 
 		&actual_error);
@@ -433,7 +1291,7 @@ int UnsafeNativeMethods::sqlite3_exec(SqliteConnectionHandle^ db, String^ query,
 	if (errmsg)
 	{
 		// If they didn't give us a pointer, the caller has leaked
-		*errmsg = ref new String(reinterpret_cast<wchar_t const*>(actual_error));
+		*errmsg = convert_to_string(actual_error);
 	}
 
 	if (actual_error != nullptr) 
@@ -511,6 +1369,19 @@ Array<uint8>^ UnsafeNativeMethods::sqlite3_value_blob(SqliteValueHandle^ value)
 	return blob;
 }
 
+SqliteBlobView^ UnsafeNativeMethods::sqlite3_value_blob_view(SqliteValueHandle^ value)
+{
+	auto data = static_cast<uint8 const*>(::sqlite3_value_blob(value ? value->Handle : nullptr));
+	return ref new SqliteBlobView(data, ::sqlite3_value_bytes(value ? value->Handle : nullptr));
+}
+
+int UnsafeNativeMethods::sqlite3_value_blob_copy(SqliteValueHandle^ value, int sourceOffset, WriteOnlyArray<uint8>^ destination, int destinationOffset, int count)
+{
+	auto data = static_cast<uint8 const*>(::sqlite3_value_blob(value ? value->Handle : nullptr));
+	int length = ::sqlite3_value_bytes(value ? value->Handle : nullptr);
+	return copy_blob_range(data, length, sourceOffset, destination, destinationOffset, count);
+}
+
 void UnsafeNativeMethods::sqlite3_result_double(SqliteContextHandle^ context, double value)
 {
 	::sqlite3_result_double(context ? context->Handle : nullptr, value);
@@ -536,7 +1407,7 @@ int UnsafeNativeMethods::sqlite3_key(SqliteConnectionHandle^ db, Platform::Strin
 	throw ref new NotImplementedException();
 //	return ::sqlite3_key(
 //		db ? db->Handle : nullptr,
-//		to_cstr(key->IsEmpty() ? L"" : key->Data()),
+//		utf8_string(key).data(),
 //		length);
 }
 
@@ -545,7 +1416,7 @@ int UnsafeNativeMethods::sqlite3_rekey(SqliteConnectionHandle^ db, Platform::Str
 	throw ref new NotImplementedException();
 //	return ::sqlite3_rekey(
 //		db ? db->Handle : nullptr, 
-//		to_cstr(key->IsEmpty() ? L"" : key->Data()),
+//		utf8_string(key).data(),
 //		length);
 }
 
@@ -563,59 +1434,544 @@ int UnsafeNativeMethods::sqlite3_table_column_metadata(SqliteConnectionHandle^ d
 													   String^* dataType, String^* collSeq,
 													   int* notNull, int* primaryKey, int* autoInc)
 {
-	const char* actual_dataType;
-	const char* actual_collSeq;
+	utf8_string dbName_buffer(dbName);
+	utf8_string tableName_buffer(tableName);
+	utf8_string columnName_buffer(columnName);
+
+	const char* actual_dataType = nullptr;
+	const char* actual_collSeq = nullptr;
 	int result = ::sqlite3_table_column_metadata(
 		db ? db->Handle : nullptr, 
-		to_cstr(dbName->IsEmpty() ? L"" : dbName->Data()),
-		to_cstr(tableName->IsEmpty() ? L"" : tableName->Data()),
-		to_cstr(columnName->IsEmpty() ? L"" : columnName->Data()),
+		dbName_buffer.length() == 0 /* search all attached databases */ ? nullptr : dbName_buffer.data(),
+		tableName_buffer.data(),
+		columnName_buffer.data(),
 		&actual_dataType,
 		&actual_collSeq,
 		notNull,
 		primaryKey,
 		autoInc);
 
-	if (dataType) *dataType = ref new String(reinterpret_cast<wchar_t const*>(actual_dataType));
-	if (collSeq) *collSeq = ref new String(reinterpret_cast<wchar_t const*>(actual_collSeq));
+	if (dataType) *dataType = convert_to_string(actual_dataType);
+	if (collSeq) *collSeq = convert_to_string(actual_collSeq);
+
+	return result;
+}
+
+int UnsafeNativeMethods::sqlite3_blob_open(SqliteConnectionHandle^ db, String^ dbName, String^ tableName,
+											String^ columnName, int64 rowid, int flags, SqliteBlobHandle^* blob)
+{
+	utf8_string dbName_buffer(dbName);
+	utf8_string tableName_buffer(tableName);
+	utf8_string columnName_buffer(columnName);
+
+	sqlite3_blob* actual_blob = nullptr;
+	int result = ::sqlite3_blob_open(
+		db ? db->Handle : nullptr,
+		dbName_buffer.length() == 0 ? "main" : dbName_buffer.data(),
+		tableName_buffer.data(),
+		columnName_buffer.data(),
+		rowid,
+		flags,
+		&actual_blob);
+	if (blob)
+	{
+		// If they didn't give us a pointer, the caller has leaked
+		*blob = ref new SqliteBlobHandle(actual_blob);
+	}
+	return result;
+}
+
+int UnsafeNativeMethods::sqlite3_blob_reopen(SqliteBlobHandle^ blob, int64 rowid)
+{
+	return ::sqlite3_blob_reopen(blob ? blob->Handle : nullptr, rowid);
+}
+
+int UnsafeNativeMethods::sqlite3_blob_close(SqliteBlobHandle^ blob)
+{
+	return ::sqlite3_blob_close(blob ? blob->Handle : nullptr);
+}
+
+int UnsafeNativeMethods::sqlite3_blob_bytes(SqliteBlobHandle^ blob)
+{
+	return ::sqlite3_blob_bytes(blob ? blob->Handle : nullptr);
+}
+
+int UnsafeNativeMethods::sqlite3_blob_read(SqliteBlobHandle^ blob, WriteOnlyArray<uint8>^ destination, int destinationOffset, int count, int blobOffset)
+{
+	if (!destination || destinationOffset < 0 || count < 0 || count > static_cast<int>(destination->Length) - destinationOffset)
+	{
+		return SQLITE_RANGE;
+	}
+
+	return ::sqlite3_blob_read(blob ? blob->Handle : nullptr, destination->Data + destinationOffset, count, blobOffset);
+}
+
+int UnsafeNativeMethods::sqlite3_blob_write(SqliteBlobHandle^ blob, const Array<uint8>^ source, int sourceOffset, int count, int blobOffset)
+{
+	if (!source || sourceOffset < 0 || count < 0 || count > static_cast<int>(source->Length) - sourceOffset)
+	{
+		return SQLITE_RANGE;
+	}
+
+	return ::sqlite3_blob_write(blob ? blob->Handle : nullptr, source->Data + sourceOffset, count, blobOffset);
+}
+
+SqliteBackupHandle^ UnsafeNativeMethods::sqlite3_backup_init(SqliteConnectionHandle^ destination, String^ destinationName,
+															 SqliteConnectionHandle^ source, String^ sourceName)
+{
+	utf8_string destinationName_buffer(destinationName);
+	utf8_string sourceName_buffer(sourceName);
+
+	sqlite3_backup* backup = ::sqlite3_backup_init(
+		destination ? destination->Handle : nullptr,
+		destinationName_buffer.length() == 0 ? "main" : destinationName_buffer.data(),
+		source ? source->Handle : nullptr,
+		sourceName_buffer.length() == 0 ? "main" : sourceName_buffer.data());
+	return backup ? ref new SqliteBackupHandle(backup) : nullptr;
+}
+
+int UnsafeNativeMethods::sqlite3_backup_step(SqliteBackupHandle^ backup, int pages)
+{
+	return ::sqlite3_backup_step(backup ? backup->Handle : nullptr, pages);
+}
+
+int UnsafeNativeMethods::sqlite3_backup_finish(SqliteBackupHandle^ backup)
+{
+	return ::sqlite3_backup_finish(backup ? backup->Handle : nullptr);
+}
+
+int UnsafeNativeMethods::sqlite3_backup_remaining(SqliteBackupHandle^ backup)
+{
+	return ::sqlite3_backup_remaining(backup ? backup->Handle : nullptr);
+}
+
+int UnsafeNativeMethods::sqlite3_backup_pagecount(SqliteBackupHandle^ backup)
+{
+	return ::sqlite3_backup_pagecount(backup ? backup->Handle : nullptr);
+}
+
+int UnsafeNativeMethods::sqlite3_config(int option)
+{
+	return ::sqlite3_config(option);
+}
+
+int UnsafeNativeMethods::sqlite3_config_int(int option, int value)
+{
+	return ::sqlite3_config(option, value);
+}
+
+int UnsafeNativeMethods::sqlite3_config_int_int(int option, int value1, int value2)
+{
+	return ::sqlite3_config(option, value1, value2);
+}
+
+int UnsafeNativeMethods::sqlite3_config_int64_int64(int option, int64 value1, int64 value2)
+{
+	return ::sqlite3_config(option, static_cast<sqlite3_int64>(value1), static_cast<sqlite3_int64>(value2));
+}
+
+// The arena given to SQLITE_CONFIG_PAGECACHE, which sqlite may use until the process ends
+static void* page_cache_arena = nullptr;
+
+int UnsafeNativeMethods::sqlite3_config_pagecache(int pageSize, int pageCount)
+{
+	if (pageSize <= 0 || pageCount <= 0)
+	{
+		// Let sqlite allocate the page cache from the heap again
+		return ::sqlite3_config(SQLITE_CONFIG_PAGECACHE, nullptr, 0, 0);
+	}
+
+	void* arena = ::malloc(static_cast<size_t>(pageSize) * static_cast<size_t>(pageCount));
+	if (!arena)
+	{
+		return SQLITE_NOMEM;
+	}
+
+	int result = ::sqlite3_config(SQLITE_CONFIG_PAGECACHE, arena, pageSize, pageCount);
+	if (result != SQLITE_OK)
+	{
+		::free(arena);
+		return result;
+	}
+
+	// sqlite is not initialized yet or it would have refused, so nothing can still be using the old arena
+	::free(page_cache_arena);
+	page_cache_arena = arena;
+	return result;
+}
+
+int UnsafeNativeMethods::sqlite3_db_config_lookaside(SqliteConnectionHandle^ db, int slotSize, int slotCount)
+{
+	// With no buffer, sqlite allocates the slots itself
+	return ::sqlite3_db_config(db ? db->Handle : nullptr, SQLITE_DBCONFIG_LOOKASIDE, nullptr, slotSize, slotCount);
+}
+
+int64 UnsafeNativeMethods::sqlite3_soft_heap_limit64(int64 limit)
+{
+	return ::sqlite3_soft_heap_limit64(limit);
+}
+
+int UnsafeNativeMethods::sqlite3_status64(int op, int64* current, int64* highwater, int resetFlag)
+{
+	sqlite3_int64 actual_current = 0;
+	sqlite3_int64 actual_highwater = 0;
+	int result = ::sqlite3_status64(op, &actual_current, &actual_highwater, resetFlag);
+
+	if (current) *current = actual_current;
+	if (highwater) *highwater = actual_highwater;
 
 	return result;
 }
 
-int UnsafeNativeMethods::sqlite3_config(int option, const Platform::Array<Platform::Object^>^ arguments)
+int UnsafeNativeMethods::sqlite3_db_status(SqliteConnectionHandle^ db, int op, int* current, int* highwater, int resetFlag)
 {
-	return ::sqlite3_config(option, arguments->Data);
+	return ::sqlite3_db_status(db ? db->Handle : nullptr, op, current, highwater, resetFlag);
+}
+
+/*
+The user data sqlite gets for a registered function or collation.  sqlite holds a reference to it until the
+function is replaced or the connection is closed, when destroy_cookie releases it.  The context and argument
+handles are re-pointed at each call rather than allocated, so calling a function costs no allocations per row.
+*/
+ref class SqliteFunctionCookie sealed
+{
+internal:
+	SqliteFunctionCookie() : _context(ref new SqliteContextHandle(nullptr)), _args(ref new Array<SqliteValueHandle^>(0)), _busy(false)
+	{
+	}
+
+	property SQLiteCallback^ Func;
+	property SQLiteCallback^ Step;
+	property SQLiteFinalCallback^ Final;
+	property SQLiteCollation^ Compare;
+
+	void Invoke(SQLiteCallback^ callback, sqlite3_context* context, int argc, sqlite3_value** argv)
+	{
+		// A function that runs a statement calling it again must not have its handles re-pointed under it
+		bool nested = _busy;
+		auto handle = nested ? ref new SqliteContextHandle(context) : _context;
+		auto args = nested ? ref new Array<SqliteValueHandle^>(argc) : _args;
+		if (args->Length < static_cast<unsigned int>(argc))
+		{
+			args = _args = ref new Array<SqliteValueHandle^>(argc);
+		}
+
+		handle->Handle = context;
+		for (int i = 0; i < argc; i++)
+		{
+			if (args[i])
+			{
+				args[i]->Handle = argv[i];
+			}
+			else
+			{
+				args[i] = ref new SqliteValueHandle(argv[i]);
+			}
+		}
+
+		_busy = true;
+		try
+		{
+			callback(handle, argc, args);
+		}
+		catch (Exception^ e)
+		{
+			// Nothing may unwind through sqlite, so the exception fails the statement instead
+			::sqlite3_result_error16(context, e->Message->IsEmpty() ? L"" : e->Message->Data(), -1);
+		}
+		_busy = nested;
+	}
+
+	void Finish(sqlite3_context* context)
+	{
+		bool nested = _busy;
+		auto handle = nested ? ref new SqliteContextHandle(context) : _context;
+
+		handle->Handle = context;
+		_busy = true;
+		try
+		{
+			Final(handle);
+		}
+		catch (Exception^ e)
+		{
+			::sqlite3_result_error16(context, e->Message->IsEmpty() ? L"" : e->Message->Data(), -1);
+		}
+		_busy = nested;
+	}
+
+private:
+	SqliteContextHandle^ _context;
+	Array<SqliteValueHandle^>^ _args;
+	bool _busy;
+};
+
+static void function_callback(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+	auto cookie = reinterpret_cast<SqliteFunctionCookie^>(::sqlite3_user_data(context));
+	cookie->Invoke(cookie->Func, context, argc, argv);
+}
+
+static void step_callback(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+	auto cookie = reinterpret_cast<SqliteFunctionCookie^>(::sqlite3_user_data(context));
+	cookie->Invoke(cookie->Step, context, argc, argv);
+}
+
+static void final_callback(sqlite3_context* context)
+{
+	reinterpret_cast<SqliteFunctionCookie^>(::sqlite3_user_data(context))->Finish(context);
+}
+
+static int collation_callback(void* state, int length1, void const* string1, int length2, void const* string2)
+{
+	auto cookie = reinterpret_cast<SqliteFunctionCookie^>(state);
+	try
+	{
+		// Registered as SQLITE_UTF16, so the lengths are in bytes of native UTF-16
+		return cookie->Compare(
+			nullptr,
+			length1 / 2,
+			ref new String(reinterpret_cast<wchar_t const*>(string1), length1 / 2),
+			length2 / 2,
+			ref new String(reinterpret_cast<wchar_t const*>(string2), length2 / 2));
+	}
+	catch (Exception^)
+	{
+		// A collation has no way to report an error, so the strings compare equal
+		return 0;
+	}
+}
+
+static void* retain_cookie(SqliteFunctionCookie^ cookie)
+{
+	reinterpret_cast<IInspectable*>(cookie)->AddRef();
+	return reinterpret_cast<void*>(cookie);
+}
+
+static void destroy_cookie(void* state)
+{
+	reinterpret_cast<IInspectable*>(state)->Release();
+}
+
+int UnsafeNativeMethods::sqlite3_create_function(SqliteConnectionHandle^ db, String^ name, int nArgs,
+												 SQLiteCallback^ func, SQLiteCallback^ funcstep, SQLiteFinalCallback^ funcfinal)
+{
+	if (!db)
+	{
+		return SQLITE_MISUSE;
+	}
+
+	auto cookie = ref new SqliteFunctionCookie();
+	cookie->Func = func;
+	cookie->Step = funcstep;
+	cookie->Final = funcfinal;
+
+	// sqlite calls destroy_cookie even when the registration fails
+	utf8_string name_buffer(name);
+	return ::sqlite3_create_function_v2(
+		db->Handle,
+		name_buffer.data(),
+		nArgs,
+		SQLITE_UTF8,
+		retain_cookie(cookie),
+		func ? function_callback : nullptr,
+		funcstep ? step_callback : nullptr,
+		funcfinal ? final_callback : nullptr,
+		destroy_cookie);
+}
+
+int UnsafeNativeMethods::sqlite3_create_collation(SqliteConnectionHandle^ db, String^ name, SQLiteCollation^ compare)
+{
+	if (!db)
+	{
+		return SQLITE_MISUSE;
+	}
+
+	if (!compare)
+	{
+		return ::sqlite3_create_collation_v2(db->Handle, utf8_string(name).data(), SQLITE_UTF16, nullptr, nullptr, nullptr);
+	}
+
+	auto cookie = ref new SqliteFunctionCookie();
+	cookie->Compare = compare;
+
+	// Unlike sqlite3_create_function_v2, a failed registration does not call destroy_cookie
+	void* state = retain_cookie(cookie);
+	utf8_string name_buffer(name);
+	int result = ::sqlite3_create_collation_v2(db->Handle, name_buffer.data(), SQLITE_UTF16, state, collation_callback, destroy_cookie);
+	if (result != SQLITE_OK)
+	{
+		destroy_cookie(state);
+	}
+	return result;
+}
+
+static void update_hook_callback(void* state, int operation, char const* dbName, char const* tableName, sqlite3_int64 rowid)
+{
+	auto db = reinterpret_cast<SqliteConnectionHandle^>(state);
+	try
+	{
+		db->UpdateHook(db->UpdateHookState, operation, convert_to_string(dbName), convert_to_string(tableName), rowid);
+	}
+	catch (Exception^)
+	{
+		// Nothing may unwind through sqlite, and the change has already been made
+	}
+}
+
+static int commit_hook_callback(void* state)
+{
+	auto db = reinterpret_cast<SqliteConnectionHandle^>(state);
+	try
+	{
+		return db->CommitHook(db->CommitHookState);
+	}
+	catch (Exception^)
+	{
+		// Turn the commit into a rollback rather than let the exception unwind through sqlite
+		return 1;
+	}
+}
+
+static void rollback_hook_callback(void* state)
+{
+	auto db = reinterpret_cast<SqliteConnectionHandle^>(state);
+	try
+	{
+		db->RollbackHook(db->RollbackHookState);
+	}
+	catch (Exception^)
+	{
+	}
 }
 
 void UnsafeNativeMethods::sqlite3_update_hook(SqliteConnectionHandle^ db, SqliteUpdateHookDelegate^ callback, Object^ userState)
 {
-	throw ref new NotImplementedException();
-	//::sqlite3_update_hook(
-	//	db ? db->Handle : nullptr, 
-	//	callback, // how do I pass my callback?
-	//	reinterpret_cast<void*>(userState)); // is this correct?
+	if (!db)
+	{
+		return;
+	}
+
+	db->UpdateHook = callback;
+	db->UpdateHookState = userState;
+	::sqlite3_update_hook(
+		db->Handle,
+		callback ? update_hook_callback : nullptr,
+		callback ? reinterpret_cast<void*>(db) : nullptr);
 }
 
 void UnsafeNativeMethods::sqlite3_commit_hook(SqliteConnectionHandle^ db, SqliteCommitHookDelegate^ callback, Object^ userState)
 {
-	throw ref new NotImplementedException();
-	//::sqlite3_commit_hook(
-	//	db ? db->Handle : nullptr, 
-	//	callback, // how do I pass my callback?
-	//	reinterpret_cast<void*>(userState)); // is this correct?
+	if (!db)
+	{
+		return;
+	}
+
+	db->CommitHook = callback;
+	db->CommitHookState = userState;
+	::sqlite3_commit_hook(
+		db->Handle,
+		callback ? commit_hook_callback : nullptr,
+		callback ? reinterpret_cast<void*>(db) : nullptr);
 }
 
 void UnsafeNativeMethods::sqlite3_rollback_hook(SqliteConnectionHandle^ db, SqliteRollbackHookDelegate^ callback, Object^ userState)
 {
-	throw ref new NotImplementedException();
-	//::sqlite3_rollback_hook(
-	//	db ? db->Handle : nullptr, 
-	//	callback, // how do I pass my callback?
-	//	reinterpret_cast<void*>(userState)); // is this correct?
+	if (!db)
+	{
+		return;
+	}
+
+	db->RollbackHook = callback;
+	db->RollbackHookState = userState;
+	::sqlite3_rollback_hook(
+		db->Handle,
+		callback ? rollback_hook_callback : nullptr,
+		callback ? reinterpret_cast<void*>(db) : nullptr);
+}
+
+static int wal_hook_callback(void* state, sqlite3* db_handle, const char* dbName, int frames)
+{
+	auto db = reinterpret_cast<SqliteConnectionHandle^>(state);
+	try
+	{
+		return db->WalHook(db->WalHookState, convert_to_string(dbName), frames);
+	}
+	catch (Exception^)
+	{
+		// The transaction has already been committed, so there is nothing to report the exception to
+		return SQLITE_OK;
+	}
 }
 
-SqliteValueHandle^ UnsafeNativeMethods::sqlite3_aggregate_context(SqliteContextHandle^ context, int nBytes)
+void UnsafeNativeMethods::sqlite3_wal_hook(SqliteConnectionHandle^ db, SqliteWalHookDelegate^ callback, Object^ userState)
 {
+	if (!db)
+	{
+		return;
+	}
+
+	db->WalHook = callback;
+	db->WalHookState = userState;
+	::sqlite3_wal_hook(db->Handle, callback ? wal_hook_callback : nullptr, callback ? reinterpret_cast<void*>(db) : nullptr);
+}
+
+int UnsafeNativeMethods::sqlite3_wal_checkpoint_v2(SqliteConnectionHandle^ db, String^ dbName, int mode, int* logFrames, int* checkpointedFrames)
+{
+	utf8_string dbName_buffer(dbName);
+
+	return ::sqlite3_wal_checkpoint_v2(
+		db ? db->Handle : nullptr,
+		dbName_buffer.length() == 0 /* checkpoint all attached databases */ ? nullptr : dbName_buffer.data(),
+		mode,
+		logFrames,
+		checkpointedFrames);
+}
+
+static int trace_callback(unsigned int type, void* state, void* p, void* x)
+{
+	auto db = reinterpret_cast<SqliteConnectionHandle^>(state);
+	try
+	{
+		int64 value = (type == SQLITE_TRACE_PROFILE) ? *reinterpret_cast<sqlite3_int64*>(x) : 0;
+		db->Trace(db->TraceState, type, value);
+	}
+	catch (Exception^)
+	{
+	}
+	return 0;
+}
+
+int UnsafeNativeMethods::sqlite3_trace_v2(SqliteConnectionHandle^ db, unsigned int mask, SqliteTraceDelegate^ callback, Object^ userState)
+{
+	if (!db)
+	{
+		return SQLITE_MISUSE;
+	}
+
+	db->Trace = callback;
+	db->TraceState = userState;
+	return ::sqlite3_trace_v2(
+		db->Handle,
+		callback ? mask : 0,
+		callback ? trace_callback : nullptr,
+		callback ? reinterpret_cast<void*>(db) : nullptr);
+}
+
+int64 UnsafeNativeMethods::sqlite3_aggregate_context(SqliteContextHandle^ context, int nBytes)
+{
+	// The address of the aggregate's memory is the same for every step of a group and unique while it lasts
 	auto result = ::sqlite3_aggregate_context(context ? context->Handle : nullptr, nBytes);
-	return ref new SqliteValueHandle(reinterpret_cast<sqlite3_value*>(result));
+	return reinterpret_cast<int64>(result);
+}
+
+int SqliteBlobView::CopyTo(int64 sourceOffset, WriteOnlyArray<uint8>^ destination, int destinationOffset, int count)
+{
+	// Streams seek with 64-bit positions; an offset past the view copies nothing rather than wrapping around
+	if (destination && (sourceOffset < 0 || sourceOffset >= _length))
+	{
+		return 0;
+	}
+	return copy_blob_range(_data, _length, static_cast<int>(sourceOffset), destination, destinationOffset, count);
 }
@@ -4,6 +4,48 @@
 
 namespace MonoDataSqliteWrapper
 			{
+				/// <summary>
+				/// Called by sqlite when a table it needs is locked by another connection.
+				/// </summary>
+				/// <param name="userState">The state passed when the handler was registered</param>
+				/// <param name="count">The number of times the handler was already called for the same lock</param>
+				/// <returns>Non-zero to have sqlite try again, zero to give up with SQLITE_BUSY</returns>
+				public delegate int SqliteBusyHandlerDelegate(Platform::Object^ userState, int count);
+
+				/// <summary>
+				/// Called by sqlite every so many virtual machine instructions while a statement runs.
+				/// </summary>
+				/// <param name="userState">The state passed when the handler was registered</param>
+				/// <returns>Non-zero to interrupt the statement with SQLITE_INTERRUPT, zero to let it run on</returns>
+				public delegate int SqliteProgressHandlerDelegate(Platform::Object^ userState);
+
+				public delegate void SqliteUpdateHookDelegate(
+					Platform::Object^ userState, 
+					int operationFlag, 
+					Platform::String^ dbName, 
+					Platform::String^ tableName, 
+					int64 rowid);
+
+				public delegate int SqliteCommitHookDelegate(Platform::Object^ userState);
+
+				public delegate void SqliteRollbackHookDelegate(Platform::Object^ userState);
+
+				/// <summary>
+				/// Called by sqlite after a transaction is committed to a database in WAL mode.
+				/// </summary>
+				/// <param name="userState">The state passed when the callback was registered</param>
+				/// <param name="dbName">The database the transaction was written to</param>
+				/// <param name="frames">The number of frames in the write-ahead log</param>
+				public delegate int SqliteWalHookDelegate(Platform::Object^ userState, Platform::String^ dbName, int frames);
+
+				/// <summary>
+				/// Called by sqlite for the events registered with sqlite3_trace_v2.
+				/// </summary>
+				/// <param name="userState">The state passed when the callback was registered</param>
+				/// <param name="type">The SQLITE_TRACE_* event</param>
+				/// <param name="value">The run time of the statement in nanoseconds for SQLITE_TRACE_PROFILE, otherwise 0</param>
+				public delegate void SqliteTraceDelegate(Platform::Object^ userState, unsigned int type, int64 value);
+
 				/*
 				Utility class for wrapping sqlite3 "handles".
 				*/
@@ -22,6 +64,24 @@ namespace MonoDataSqliteWrapper
 						}
 					}
 
+					// The registered busy handler lives with the handle, which is what sqlite gets as the callback argument
+					property SqliteBusyHandlerDelegate^ BusyHandler;
+					property Platform::Object^ BusyHandlerState;
+					property SqliteProgressHandlerDelegate^ ProgressHandler;
+					property Platform::Object^ ProgressHandlerState;
+
+					// Likewise for the hooks, so their trampolines need nothing but the handle
+					property SqliteUpdateHookDelegate^ UpdateHook;
+					property Platform::Object^ UpdateHookState;
+					property SqliteCommitHookDelegate^ CommitHook;
+					property Platform::Object^ CommitHookState;
+					property SqliteRollbackHookDelegate^ RollbackHook;
+					property Platform::Object^ RollbackHookState;
+					property SqliteWalHookDelegate^ WalHook;
+					property Platform::Object^ WalHookState;
+					property SqliteTraceDelegate^ Trace;
+					property Platform::Object^ TraceState;
+
 				private:
 					sqlite3* _handle;
 				};
@@ -36,12 +96,18 @@ namespace MonoDataSqliteWrapper
 					{
 					}
 
+					// Function trampolines re-point the same handle at each argument instead of allocating one per call
 					property sqlite3_value* Handle
 					{ 
 						sqlite3_value* get()
 						{
 							return _handle;
 						}
+
+						void set(sqlite3_value* value)
+						{
+							_handle = value;
+						}
 					}
 
 				private:
@@ -70,6 +136,50 @@ namespace MonoDataSqliteWrapper
 					sqlite3_stmt* _handle;
 				};
 
+				/*
+				Utility class for wrapping sqlite3_blob "handles".
+				*/
+				public ref class SqliteBlobHandle sealed
+				{
+				internal:
+					SqliteBlobHandle(sqlite3_blob* blob) : _handle(blob)
+					{
+					}
+
+					property sqlite3_blob* Handle
+					{ 
+						sqlite3_blob* get()
+						{
+							return _handle;
+						}
+					}
+
+				private:
+					sqlite3_blob* _handle;
+				};
+
+				/*
+				Utility class for wrapping sqlite3_backup "handles".
+				*/
+				public ref class SqliteBackupHandle sealed
+				{
+				internal:
+					SqliteBackupHandle(sqlite3_backup* backup) : _handle(backup)
+					{
+					}
+
+					property sqlite3_backup* Handle
+					{ 
+						sqlite3_backup* get()
+						{
+							return _handle;
+						}
+					}
+
+				private:
+					sqlite3_backup* _handle;
+				};
+
 				/*
 				Utility class for wrapping sqlite3_context "handles".
 				*/
@@ -86,24 +196,54 @@ namespace MonoDataSqliteWrapper
 						{
 							return _handle;
 						}
+
+						void set(sqlite3_context* value)
+						{
+							_handle = value;
+						}
 					}
 
 				private:
 					sqlite3_context* _handle;
 				};
 
-				//public delegate void SQLiteCallback(SqliteContextHandle^ context, int nArgs, const Platform::Array<SqliteValueHandle^>^ args);
+				/*
+				Borrowed, bounded view over blob memory owned by sqlite.
+				The view is only valid until the owning statement is stepped, reset or finalized
+				(or, for values, until the function callback returns); it never copies on its own.
+				*/
+				public ref class SqliteBlobView sealed
+				{
+				internal:
+					SqliteBlobView(uint8 const* data, int length) : _data(data), _length(length < 0 ? 0 : length)
+					{
+					}
 
-				public delegate void SqliteUpdateHookDelegate(
-					Platform::Object^ userState, 
-					int operationFlag, 
-					Platform::String^ dbName, 
-					Platform::String^ tableName, 
-					int64 rowid);
+					property uint8 const* Data
+					{
+						uint8 const* get()
+						{
+							return _data;
+						}
+					}
 
-				public delegate int SqliteCommitHookDelegate(Platform::Object^ userState);
+				public:
+					property int Length
+					{
+						int get()
+						{
+							return _length;
+						}
+					}
 
-				public delegate void SqliteRollbackHookDelegate(Platform::Object^ userState);
+					int CopyTo(int64 sourceOffset, Platform::WriteOnlyArray<uint8>^ destination, int destinationOffset, int count);
+
+				private:
+					uint8 const* _data;
+					int _length;
+				};
+
+				//public delegate void SQLiteCallback(SqliteContextHandle^ context, int nArgs, const Platform::Array<SqliteValueHandle^>^ args);
 
 				/// <summary>
 				/// An internal callback delegate declaration.
@@ -124,9 +264,9 @@ namespace MonoDataSqliteWrapper
 				/// </summary>
 				/// <param name="puser">Not used</param>
 				/// <param name="len1">Length of the string pv1</param>
-				/// <param name="pv1">Pointer to the first string to compare</param>
+				/// <param name="pv1">The first string to compare</param>
 				/// <param name="len2">Length of the string pv2</param>
-				/// <param name="pv2">Pointer to the second string to compare</param>
+				/// <param name="pv2">The second string to compare</param>
 				/// <returns>Returns -1 if the first string is less than the second.  0 if they are equal, or 1 if the first string is greater
 				/// than the second.</returns>
 				public delegate int SQLiteCollation(Platform::Object^ puser, int len1, Platform::String^ pv1, int len2, Platform::String^ pv2);
@@ -143,12 +283,17 @@ namespace MonoDataSqliteWrapper
 					static int sqlite3_open_v2(Platform::String^ filename, SqliteConnectionHandle^* db, int flags, Platform::String^ zVfs);
 					static int sqlite3_close(SqliteConnectionHandle^ db);
 					static int sqlite3_busy_timeout(SqliteConnectionHandle^ db, int miliseconds);
+					static int sqlite3_busy_handler(SqliteConnectionHandle^ db, SqliteBusyHandlerDelegate^ callback, Platform::Object^ userState);
+					// A null callback removes the handler.
+					static int sqlite3_progress_handler(SqliteConnectionHandle^ db, int instructions, SqliteProgressHandlerDelegate^ callback, Platform::Object^ userState);
 					static int sqlite3_changes(SqliteConnectionHandle^ db);
 					static int sqlite3_prepare16(SqliteConnectionHandle^ db, Platform::String^ query, int length, SqliteStatementHandle^* statement, Platform::String^* strRemain);
 					static int sqlite3_prepare_v2(SqliteConnectionHandle^ db, Platform::String^ query, SqliteStatementHandle^* statement);
 					static int sqlite3_step(SqliteStatementHandle^ statement);
 					static int sqlite3_reset(SqliteStatementHandle^ statement);
 					static int sqlite3_finalize(SqliteStatementHandle^ statement);
+					static int sqlite3_clear_bindings(SqliteStatementHandle^ statement);
+					static int sqlite3_stmt_status(SqliteStatementHandle^ statement, int op, int resetFlag);
 					static int64 sqlite3_last_insert_rowid(SqliteConnectionHandle^ db);
 					static Platform::String^ sqlite3_errmsg(SqliteConnectionHandle^ db);
 					static int sqlite3_bind_parameter_index(SqliteStatementHandle^ statement, Platform::String^ name);
@@ -159,6 +304,42 @@ namespace MonoDataSqliteWrapper
 					static int sqlite3_bind_text(SqliteStatementHandle^ statement, int index, Platform::String^ value, int length, Platform::Object^ dummy);
 					static int sqlite3_bind_text16(SqliteStatementHandle^ statement, int index, Platform::String^ value, int length);
 					static int sqlite3_bind_blob(SqliteStatementHandle^ statement, int index, const Platform::Array<uint8>^ value, int length, Platform::Object^ dummy);	
+					/*
+					Binds a copy of the values of whichever of integers, doubles or texts is given as the array the
+					table-valued function array() reads, so that "x IN (SELECT value FROM array(?))" or a join against
+					array(?) takes any number of values with one parameter.  The array table is registered on every
+					connection the sqlite3_open functions open.  nulls, if given, has one flag per value that is NULL.
+					*/
+					static int sqlite3_bind_array(SqliteStatementHandle^ statement, int index, const Platform::Array<int64>^ integers,
+						const Platform::Array<double>^ doubles, const Platform::Array<Platform::String^>^ texts, const Platform::Array<uint8>^ nulls);
+					/*
+					Binds, steps and resets statement once per row in [firstRow, rowCount) without leaving native code.
+					kinds holds one SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT or SQLITE_BLOB per parameter.  The values of
+					the parameters of one kind are concatenated column by column in integers, doubles, texts or blobs,
+					so the value of the k-th parameter of its kind for row r is at [k * rowCount + r]; blobOffsets has one
+					start offset per blob value plus a final end offset.  nulls, if given, has one flag per parameter and
+					row at [parameter * rowCount + r].  Returns the first error, with rowsDone set to the failing row.
+					*/
+					static int sqlite3_step_batch(SqliteStatementHandle^ statement, int firstRow, int rowCount, const Platform::Array<int>^ kinds,
+						const Platform::Array<int64>^ integers, const Platform::Array<double>^ doubles, const Platform::Array<Platform::String^>^ texts,
+						const Platform::Array<uint8>^ blobs, const Platform::Array<int>^ blobOffsets, const Platform::Array<uint8>^ nulls,
+						Platform::WriteOnlyArray<int>^ changes, int* rowsDone);
+					/*
+					Steps statement up to maxRows times and stores each row column by column, so the cell of column c
+					and row r is at [c * stride + r] in every array.  types gets the SQLITE_INTEGER, SQLITE_FLOAT,
+					SQLITE_TEXT, SQLITE_BLOB or SQLITE_NULL type of each cell, and the value goes to integers, doubles
+					or texts; a blob is copied into blobs at blobOffsets[cell] with its length in integers[cell].
+					If pending is non-zero the statement is already on a row that is stored first without stepping.
+					Rows are stored from firstRow on and their blobs from blobStart on, so a block can be continued
+					after a row whose blobs did not fit; rowCount is set to the row after the last one stored.
+					A row whose blobs do not fit into what is left of blobs is not stored: it stays pending on the
+					statement and blobBytesNeeded is set to the size of its blobs.  Returns SQLITE_DONE at the end of
+					the results, SQLITE_ROW if the rows stopped early, or the error of a failed step.
+					*/
+					static int sqlite3_step_block(SqliteStatementHandle^ statement, int pending, int firstRow, int blobStart, int maxRows, int stride,
+						Platform::WriteOnlyArray<uint8>^ types, Platform::WriteOnlyArray<int64>^ integers, Platform::WriteOnlyArray<double>^ doubles,
+						Platform::WriteOnlyArray<Platform::String^>^ texts, Platform::WriteOnlyArray<uint8>^ blobs, Platform::WriteOnlyArray<int>^ blobOffsets,
+						int* rowCount, int* blobBytesNeeded);
 					static int sqlite3_column_count(SqliteStatementHandle^rstatement);
 					static Platform::String^ sqlite3_column_name(SqliteStatementHandle^ statement, int index);
 					static int sqlite3_column_type(SqliteStatementHandle^ statement, int index);
@@ -169,6 +350,13 @@ namespace MonoDataSqliteWrapper
 					static Platform::String^ sqlite3_column_text(SqliteStatementHandle^ statement, int index);
 					static Platform::Array<uint8>^ sqlite3_column_blob(SqliteStatementHandle^, int index);
 					static int sqlite3_column_bytes(SqliteStatementHandle^ statement, int index);
+					static SqliteBlobView^ sqlite3_column_blob_view(SqliteStatementHandle^ statement, int index);
+					// Borrowed view over the UTF-8 column text, for decoding large texts a piece at a time.
+					static SqliteBlobView^ sqlite3_column_text_view(SqliteStatementHandle^ statement, int index);
+					static int sqlite3_column_blob_copy(SqliteStatementHandle^ statement, int index, int sourceOffset, Platform::WriteOnlyArray<uint8>^ destination, int destinationOffset, int count);
+					// Parses an ISO-8601 date from the UTF-8 column text without building a string.  Returns the DateTimeKind
+					// of the value and its ticks, or -1 if the text is not one of the common shapes.
+					static int sqlite3_column_datetime(SqliteStatementHandle^ statement, int index, int64* ticks);
 					static void sqlite3_interrupt(SqliteConnectionHandle^ db);
 					static SqliteStatementHandle^ sqlite3_next_stmt(SqliteConnectionHandle^ db, SqliteStatementHandle^ statement);
 					static Platform::String^ sqlite3_value_text16(SqliteValueHandle^ value);
@@ -195,6 +383,8 @@ namespace MonoDataSqliteWrapper
 					static int64 sqlite3_value_int64(SqliteValueHandle^ value);
 					static int sqlite3_value_type(SqliteValueHandle^ value);
 					static Platform::Array<uint8>^ sqlite3_value_blob(SqliteValueHandle^ value);
+					static SqliteBlobView^ sqlite3_value_blob_view(SqliteValueHandle^ value);
+					static int sqlite3_value_blob_copy(SqliteValueHandle^ value, int sourceOffset, Platform::WriteOnlyArray<uint8>^ destination, int destinationOffset, int count);
 					static void sqlite3_result_double(SqliteContextHandle^ statement, double value);
 					static void sqlite3_result_int(SqliteContextHandle^ statement, int value);
 					static void sqlite3_result_int64(SqliteContextHandle^ statement, int64 value);
@@ -206,10 +396,46 @@ namespace MonoDataSqliteWrapper
 						int* notNull, int* primaryKey, int* autoInc);
 					static int sqlite3_key(SqliteConnectionHandle^ db, Platform::String^ key, int length);
 					static int sqlite3_rekey(SqliteConnectionHandle^ db, Platform::String^ key, int length);
-					static int sqlite3_config(int option, const Platform::Array<Platform::Object^>^ arguments);
+					// sqlite3_config() is variadic, so each shape of arguments gets its own entry point.  Process-wide options
+					// only take effect before sqlite is initialized, that is before the first connection is opened.
+					static int sqlite3_config(int option);
+					static int sqlite3_config_int(int option, int value);
+					static int sqlite3_config_int_int(int option, int value1, int value2);
+					static int sqlite3_config_int64_int64(int option, int64 value1, int64 value2);
+					// Allocates the page cache arena itself and keeps it for the life of the process, as sqlite requires.
+					static int sqlite3_config_pagecache(int pageSize, int pageCount);
+					static int sqlite3_db_config_lookaside(SqliteConnectionHandle^ db, int slotSize, int slotCount);
+					static int64 sqlite3_soft_heap_limit64(int64 limit);
+					static int sqlite3_status64(int op, int64* current, int64* highwater, int resetFlag);
+					static int sqlite3_db_status(SqliteConnectionHandle^ db, int op, int* current, int* highwater, int resetFlag);
+					static int sqlite3_blob_open(SqliteConnectionHandle^ db, Platform::String^ dbName, Platform::String^ tableName,
+						Platform::String^ columnName, int64 rowid, int flags, SqliteBlobHandle^* blob);
+					static int sqlite3_blob_reopen(SqliteBlobHandle^ blob, int64 rowid);
+					static int sqlite3_blob_close(SqliteBlobHandle^ blob);
+					static int sqlite3_blob_bytes(SqliteBlobHandle^ blob);
+					// Read and write straight between the blob and the given range of the caller's array, so a large blob
+					// never has to be held in memory as a whole.  Return SQLITE_RANGE if the range is outside the array.
+					static int sqlite3_blob_read(SqliteBlobHandle^ blob, Platform::WriteOnlyArray<uint8>^ destination, int destinationOffset, int count, int blobOffset);
+					static int sqlite3_blob_write(SqliteBlobHandle^ blob, const Platform::Array<uint8>^ source, int sourceOffset, int count, int blobOffset);
+					// Returns nullptr if the backup cannot be started, with the error left on the destination connection.
+					static SqliteBackupHandle^ sqlite3_backup_init(SqliteConnectionHandle^ destination, Platform::String^ destinationName,
+						SqliteConnectionHandle^ source, Platform::String^ sourceName);
+					static int sqlite3_backup_step(SqliteBackupHandle^ backup, int pages);
+					static int sqlite3_backup_finish(SqliteBackupHandle^ backup);
+					static int sqlite3_backup_remaining(SqliteBackupHandle^ backup);
+					static int sqlite3_backup_pagecount(SqliteBackupHandle^ backup);
 					static void sqlite3_update_hook(SqliteConnectionHandle^ db, SqliteUpdateHookDelegate^ callback, Platform::Object^ userState);
 					static void sqlite3_commit_hook(SqliteConnectionHandle^ db, SqliteCommitHookDelegate^ callback, Platform::Object^ userState);
 					static void sqlite3_rollback_hook(SqliteConnectionHandle^ db, SqliteRollbackHookDelegate^ callback, Platform::Object^ userState);
-					static SqliteValueHandle^ sqlite3_aggregate_context(SqliteContextHandle^ context, int nBytes);
+					// Registering a WAL hook turns off sqlite's own automatic checkpoints on the connection; removing it
+					// does not turn them back on.
+					static void sqlite3_wal_hook(SqliteConnectionHandle^ db, SqliteWalHookDelegate^ callback, Platform::Object^ userState);
+					static int sqlite3_wal_checkpoint_v2(SqliteConnectionHandle^ db, Platform::String^ dbName, int mode, int* logFrames, int* checkpointedFrames);
+					static int sqlite3_trace_v2(SqliteConnectionHandle^ db, unsigned int mask, SqliteTraceDelegate^ callback, Platform::Object^ userState);
+					static int sqlite3_create_function(SqliteConnectionHandle^ db, Platform::String^ name, int nArgs,
+						SQLiteCallback^ func, SQLiteCallback^ funcstep, SQLiteFinalCallback^ funcfinal);
+					static int sqlite3_create_collation(SqliteConnectionHandle^ db, Platform::String^ name, SQLiteCollation^ compare);
+					// Returns a key that identifies the aggregate being computed, the same for every call of one group
+					static int64 sqlite3_aggregate_context(SqliteContextHandle^ context, int nBytes);
 				};
 			}
\ No newline at end of file
@@ -0,0 +1,1961 @@
+﻿// MonoDataSqliteWrapper over the flat C build of the native wrapper (Mono.Data.Sqlite.Wrapper.Native), for the
+// platforms without WinRT.  It has the same surface as the C++/CX wrapper, so the provider builds against either
+// one unchanged.  Every call is a blittable P/Invoke: handles are the raw sqlite pointers, strings cross as UTF-8
+// or UTF-16 pointer and length pairs, and arrays are pinned rather than copied.  The handle objects are only
+// allocated when sqlite hands out a new pointer, and the argument handles of a function are re-pointed at each
+// call instead of allocated.
+
+namespace MonoDataSqliteWrapper
+{
+    using System;
+    using System.Runtime.InteropServices;
+    using System.Security;
+    using System.Text;
+
+    /// <summary>
+    /// An internal callback delegate declaration.
+    /// </summary>
+    /// <param name="context">Raw context pointer for the user function</param>
+    /// <param name="nArgs">Count of arguments to the function</param>
+    /// <param name="argsptr">A pointer to the array of argument pointers</param>
+    public delegate void SQLiteCallback(SqliteContextHandle context, int nArgs, SqliteValueHandle[] argsptr);
+    /// <summary>
+    /// An internal final callback delegate declaration.
+    /// </summary>
+    /// <param name="context">Raw context pointer for the user function</param>
+    public delegate void SQLiteFinalCallback(SqliteContextHandle context);
+    /// <summary>
+    /// Internal callback delegate for implementing collation sequences
+    /// </summary>
+    /// <param name="puser">Not used</param>
+    /// <param name="len1">Length of the string pv1</param>
+    /// <param name="pv1">The first string to compare</param>
+    /// <param name="len2">Length of the string pv2</param>
+    /// <param name="pv2">The second string to compare</param>
+    /// <returns>Returns -1 if the first string is less than the second.  0 if they are equal, or 1 if the first string is greater
+    /// than the second.</returns>
+    public delegate int SQLiteCollation(object puser, int len1, string pv1, int len2, string pv2);
+
+    public delegate void SqliteUpdateHookDelegate(object argument, int b, string c, string d, long e);
+    public delegate int SqliteCommitHookDelegate(object argument);
+    public delegate void SqliteRollbackHookDelegate(object argument);
+    public delegate int SqliteBusyHandlerDelegate(object userState, int count);
+    public delegate int SqliteProgressHandlerDelegate(object userState);
+    public delegate int SqliteWalHookDelegate(object userState, string dbName, int frames);
+    public delegate void SqliteTraceDelegate(object userState, uint type, long value);
+
+    /// <summary>
+    /// Utility class for wrapping sqlite3 "handles".
+    /// </summary>
+    public sealed class SqliteConnectionHandle
+    {
+        internal SqliteConnectionHandle(IntPtr db)
+        {
+            _handle = db;
+        }
+
+        internal IntPtr Handle
+        {
+            get
+            {
+                return _handle;
+            }
+        }
+
+        // The registered busy handler and hooks live with the handle, which is what sqlite gets as the callback argument
+        internal SqliteBusyHandlerDelegate BusyHandler;
+        internal object BusyHandlerState;
+        internal SqliteProgressHandlerDelegate ProgressHandler;
+        internal object ProgressHandlerState;
+        internal SqliteUpdateHookDelegate UpdateHook;
+        internal object UpdateHookState;
+        internal SqliteCommitHookDelegate CommitHook;
+        internal object CommitHookState;
+        internal SqliteRollbackHookDelegate RollbackHook;
+        internal object RollbackHookState;
+        internal SqliteWalHookDelegate WalHook;
+        internal object WalHookState;
+        internal SqliteTraceDelegate Trace;
+        internal object TraceState;
+
+        /// <summary>
+        /// The callback argument that leads back to the handle, which keeps the handle alive until the connection is closed
+        /// </summary>
+        internal IntPtr State
+        {
+            get
+            {
+                if (!_state.IsAllocated)
+                {
+                    _state = GCHandle.Alloc(this);
+                }
+                return GCHandle.ToIntPtr(_state);
+            }
+        }
+
+        internal void ReleaseState()
+        {
+            if (_state.IsAllocated)
+            {
+                _state.Free();
+            }
+        }
+
+        internal static SqliteConnectionHandle FromState(IntPtr state)
+        {
+            return (SqliteConnectionHandle)GCHandle.FromIntPtr(state).Target;
+        }
+
+        private readonly IntPtr _handle;
+        private GCHandle _state;
+    }
+
+    /// <summary>
+    /// Utility class for wrapping sqlite3_value "handles".
+    /// </summary>
+    public sealed class SqliteValueHandle
+    {
+        internal SqliteValueHandle(IntPtr value)
+        {
+            _handle = value;
+        }
+
+        // Function trampolines re-point the same handle at each argument instead of allocating one per call
+        internal IntPtr Handle
+        {
+            get
+            {
+                return _handle;
+            }
+            set
+            {
+                _handle = value;
+            }
+        }
+
+        private IntPtr _handle;
+    }
+
+    /// <summary>
+    /// Utility class for wrapping sqlite3_stmt "handles".
+    /// </summary>
+    public sealed class SqliteStatementHandle
+    {
+        internal SqliteStatementHandle(IntPtr statement)
+        {
+            _handle = statement;
+        }
+
+        internal IntPtr Handle
+        {
+            get
+            {
+                return _handle;
+            }
+        }
+
+        private readonly IntPtr _handle;
+    }
+
+    /// <summary>
+    /// Utility class for wrapping sqlite3_blob "handles".
+    /// </summary>
+    public sealed class SqliteBlobHandle
+    {
+        internal SqliteBlobHandle(IntPtr blob)
+        {
+            _handle = blob;
+        }
+
+        internal IntPtr Handle
+        {
+            get
+            {
+                return _handle;
+            }
+        }
+
+        private readonly IntPtr _handle;
+    }
+
+    /// <summary>
+    /// Utility class for wrapping sqlite3_backup "handles".
+    /// </summary>
+    public sealed class SqliteBackupHandle
+    {
+        internal SqliteBackupHandle(IntPtr backup)
+        {
+            _handle = backup;
+        }
+
+        internal IntPtr Handle
+        {
+            get
+            {
+                return _handle;
+            }
+        }
+
+        private readonly IntPtr _handle;
+    }
+
+    /// <summary>
+    /// Utility class for wrapping sqlite3_context "handles".
+    /// </summary>
+    public sealed class SqliteContextHandle
+    {
+        internal SqliteContextHandle(IntPtr context)
+        {
+            _handle = context;
+        }
+
+        internal IntPtr Handle
+        {
+            get
+            {
+                return _handle;
+            }
+            set
+            {
+                _handle = value;
+            }
+        }
+
+        private IntPtr _handle;
+    }
+
+    /// <summary>
+    /// Borrowed, bounded view over blob memory owned by sqlite.  The view is only valid until the owning statement is
+    /// stepped, reset or finalized (or, for values, until the function callback returns); it never copies on its own.
+    /// </summary>
+    public sealed class SqliteBlobView
+    {
+        internal SqliteBlobView(IntPtr data, int length)
+        {
+            _data = data;
+            _length = length < 0 ? 0 : length;
+        }
+
+        public int Length
+        {
+            get
+            {
+                return _length;
+            }
+        }
+
+        public int CopyTo(long sourceOffset, byte[] destination, int destinationOffset, int count)
+        {
+            // Streams seek with 64-bit positions; an offset past the view copies nothing rather than wrapping around
+            if (destination != null && (sourceOffset < 0 || sourceOffset >= _length))
+            {
+                return 0;
+            }
+            return UnsafeNativeMethods.CopyBlobRange(_data, _length, (int)sourceOffset, destination, destinationOffset, count);
+        }
+
+        private readonly IntPtr _data;
+        private readonly int _length;
+    }
+
+    /// <summary>
+    /// The state sqlite gets for a registered function or collation, through a GCHandle that sqlite releases when it
+    /// no longer needs the function.  The context and argument handles are re-pointed at each call rather than
+    /// allocated, so calling a function costs no allocations per row.
+    /// </summary>
+    internal sealed class FunctionCookie
+    {
+        internal SQLiteCallback Func;
+        internal SQLiteCallback Step;
+        internal SQLiteFinalCallback Final;
+        internal SQLiteCollation Compare;
+
+        private readonly SqliteContextHandle _context = new SqliteContextHandle(IntPtr.Zero);
+        private SqliteValueHandle[] _args = new SqliteValueHandle[0];
+        private bool _busy;
+
+        internal unsafe void Invoke(SQLiteCallback callback, IntPtr context, int argc, IntPtr* argv)
+        {
+            // A function that runs a statement calling it again must not have its handles re-pointed under it
+            bool nested = _busy;
+            SqliteContextHandle handle = nested ? new SqliteContextHandle(context) : _context;
+            SqliteValueHandle[] args = nested ? new SqliteValueHandle[argc] : _args;
+            if (args.Length < argc)
+            {
+                args = _args = new SqliteValueHandle[argc];
+            }
+
+            handle.Handle = context;
+            for (int i = 0; i < argc; i++)
+            {
+                if (args[i] != null)
+                {
+                    args[i].Handle = argv[i];
+                }
+                else
+                {
+                    args[i] = new SqliteValueHandle(argv[i]);
+                }
+            }
+
+            _busy = true;
+            try
+            {
+                callback(handle, argc, args);
+            }
+            catch (Exception e)
+            {
+                // Nothing may unwind through sqlite, so the exception fails the statement instead
+                UnsafeNativeMethods.sqlite3_result_error16(handle, e.Message ?? "", -1);
+            }
+            _busy = nested;
+        }
+
+        internal void Finish(IntPtr context)
+        {
+            bool nested = _busy;
+            SqliteContextHandle handle = nested ? new SqliteContextHandle(context) : _context;
+
+            handle.Handle = context;
+            _busy = true;
+            try
+            {
+                Final(handle);
+            }
+            catch (Exception e)
+            {
+                UnsafeNativeMethods.sqlite3_result_error16(handle, e.Message ?? "", -1);
+            }
+            _busy = nested;
+        }
+
+        internal static FunctionCookie FromState(IntPtr state)
+        {
+            return (FunctionCookie)GCHandle.FromIntPtr(state).Target;
+        }
+    }
+
+    [SuppressUnmanagedCodeSecurity]
+    internal static unsafe class NativeMethods
+    {
+        private const string Library = "MonoDataSqliteWrapperNative";
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate int BusyHandlerCallback(IntPtr state, int count);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate int ProgressHandlerCallback(IntPtr state);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate void UpdateHookCallback(IntPtr state, int operation, IntPtr dbName, IntPtr tableName, long rowid);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate int CommitHookCallback(IntPtr state);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate void RollbackHookCallback(IntPtr state);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate int WalHookCallback(IntPtr state, IntPtr db, IntPtr dbName, int frames);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate int TraceCallback(uint type, IntPtr state, IntPtr p, IntPtr x);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate void FunctionCallback(IntPtr state, IntPtr context, int argc, IntPtr* argv);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate void FinalCallback(IntPtr state, IntPtr context);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate int CollationCallback(IntPtr state, int bytes1, IntPtr string1, int bytes2, IntPtr string2);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate void DestroyCallback(IntPtr state);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_libversion(out IntPtr text, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_free(IntPtr memory);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_open(byte* filename, int filenameBytes, int flags, byte* vfs, int vfsBytes, out IntPtr db);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_open16(char* filename, int filenameBytes, out IntPtr db);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_close(IntPtr db);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_busy_timeout(IntPtr db, int milliseconds);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_busy_handler(IntPtr db, BusyHandlerCallback callback, IntPtr state);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_progress_handler(IntPtr db, int instructions, ProgressHandlerCallback callback, IntPtr state);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_changes(IntPtr db);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern long mdsw_last_insert_rowid(IntPtr db);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_interrupt(IntPtr db);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_errmsg(IntPtr db, out IntPtr text, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_exec(IntPtr db, byte* sql, int sqlBytes, out IntPtr error);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_prepare16(IntPtr db, char* sql, int sqlBytes, int v2, out IntPtr statement, out int tailOffset);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_step(IntPtr statement);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_reset(IntPtr statement);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_finalize(IntPtr statement);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_clear_bindings(IntPtr statement);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_stmt_status(IntPtr statement, int op, int resetFlag);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern IntPtr mdsw_next_stmt(IntPtr db, IntPtr statement);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_bind_parameter_count(IntPtr statement);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_bind_parameter_index(IntPtr statement, byte* name, int nameBytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_bind_parameter_name(IntPtr statement, int index, out IntPtr text, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_bind_null(IntPtr statement, int index);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_bind_int(IntPtr statement, int index, int value);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_bind_int64(IntPtr statement, int index, long value);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_bind_double(IntPtr statement, int index, double value);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_bind_text(IntPtr statement, int index, byte* text, int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_bind_text16(IntPtr statement, int index, char* text, int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_bind_blob(IntPtr statement, int index, byte* data, int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_bind_array(IntPtr statement, int index, int kind, int count, long* integers, double* doubles,
+                                                   char* texts, int* textOffsets, byte* nulls);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_step_batch(IntPtr statement, int firstRow, int rowCount, int* kinds, int parameterCount,
+                                                   long* integers, double* doubles, char* texts, int* textOffsets,
+                                                   byte* blobs, int* blobOffsets, byte* nulls, int* changes, out int rowsDone);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_step_block(IntPtr statement, int pending, int firstRow, int maxRows, int stride,
+                                                   byte* types, long* integers, double* doubles, int* offsets,
+                                                   byte* texts, int textCapacity, byte* blobs, int blobCapacity,
+                                                   out int rowCount, out int textBytesNeeded, out int blobBytesNeeded);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_column_count(IntPtr statement);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_column_type(IntPtr statement, int index);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_column_int(IntPtr statement, int index);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern long mdsw_column_int64(IntPtr statement, int index);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern double mdsw_column_double(IntPtr statement, int index);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_column_bytes(IntPtr statement, int index);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_column_text(IntPtr statement, int index, out IntPtr text, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_column_text16(IntPtr statement, int index, out IntPtr text, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_column_blob(IntPtr statement, int index, out IntPtr data, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_column_datetime(IntPtr statement, int index, out long ticks);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_column_name(IntPtr statement, int index, out IntPtr text, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_column_decltype(IntPtr statement, int index, out IntPtr text, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_column_database_name(IntPtr statement, int index, out IntPtr text, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_column_table_name(IntPtr statement, int index, out IntPtr text, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_column_origin_name(IntPtr statement, int index, out IntPtr text, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_value_type(IntPtr value);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_value_int(IntPtr value);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern long mdsw_value_int64(IntPtr value);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern double mdsw_value_double(IntPtr value);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_value_bytes(IntPtr value);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_value_text(IntPtr value, out IntPtr text, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_value_text16(IntPtr value, out IntPtr text, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_value_blob(IntPtr value, out IntPtr data, out int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_result_null(IntPtr context);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_result_int(IntPtr context, int value);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_result_int64(IntPtr context, long value);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_result_double(IntPtr context, double value);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_result_text(IntPtr context, byte* text, int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_result_text16(IntPtr context, char* text, int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_result_blob(IntPtr context, byte* data, int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_result_error(IntPtr context, byte* text, int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_result_error16(IntPtr context, char* text, int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern long mdsw_aggregate_context(IntPtr context, int bytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_create_function(IntPtr db, byte* name, int nameBytes, int argc, IntPtr state,
+                                                        FunctionCallback func, FunctionCallback step, FinalCallback final,
+                                                        DestroyCallback destroy);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_create_collation(IntPtr db, byte* name, int nameBytes, IntPtr state,
+                                                         CollationCallback compare, DestroyCallback destroy);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_update_hook(IntPtr db, UpdateHookCallback callback, IntPtr state);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_commit_hook(IntPtr db, CommitHookCallback callback, IntPtr state);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_rollback_hook(IntPtr db, RollbackHookCallback callback, IntPtr state);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern void mdsw_wal_hook(IntPtr db, WalHookCallback callback, IntPtr state);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_wal_checkpoint_v2(IntPtr db, byte* dbName, int dbNameBytes, int mode, out int logFrames, out int checkpointedFrames);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_trace_v2(IntPtr db, uint mask, TraceCallback callback, IntPtr state);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_table_column_metadata(IntPtr db, byte* dbName, int dbNameBytes,
+                                                              byte* tableName, int tableNameBytes, byte* columnName, int columnNameBytes,
+                                                              out IntPtr dataType, out int dataTypeBytes, out IntPtr collSeq, out int collSeqBytes,
+                                                              out int notNull, out int primaryKey, out int autoInc);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_blob_open(IntPtr db, byte* dbName, int dbNameBytes, byte* tableName, int tableNameBytes,
+                                                  byte* columnName, int columnNameBytes, long rowid, int flags, out IntPtr blob);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_blob_reopen(IntPtr blob, long rowid);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_blob_close(IntPtr blob);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_blob_bytes(IntPtr blob);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_blob_read(IntPtr blob, byte* destination, int count, int blobOffset);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_blob_write(IntPtr blob, byte* source, int count, int blobOffset);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern IntPtr mdsw_backup_init(IntPtr destination, byte* destinationName, int destinationNameBytes,
+                                                       IntPtr source, byte* sourceName, int sourceNameBytes);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_backup_step(IntPtr backup, int pages);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_backup_finish(IntPtr backup);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_backup_remaining(IntPtr backup);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_backup_pagecount(IntPtr backup);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_config(int option);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_config_int(int option, int value);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_config_int_int(int option, int value1, int value2);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_config_int64_int64(int option, long value1, long value2);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_config_pagecache(int pageSize, int pageCount);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_db_config_lookaside(IntPtr db, int slotSize, int slotCount);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern long mdsw_soft_heap_limit64(long limit);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_status64(int op, out long current, out long highwater, int resetFlag);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        internal static extern int mdsw_db_status(IntPtr db, int op, out int current, out int highwater, int resetFlag);
+    }
+
+    public static unsafe class UnsafeNativeMethods
+    {
+        private const int SQLITE_OK = 0;
+        private const int SQLITE_NOMEM = 7;
+        private const int SQLITE_MISUSE = 21;
+        private const int SQLITE_RANGE = 25;
+        private const int SQLITE_ROW = 100;
+        private const int SQLITE_INTEGER = 1;
+        private const int SQLITE_FLOAT = 2;
+        private const int SQLITE_TEXT = 3;
+        private const int SQLITE_BLOB = 4;
+        private const int SQLITE_OPEN_READWRITE = 0x00000002;
+        private const int SQLITE_OPEN_CREATE = 0x00000004;
+        private const uint SQLITE_TRACE_PROFILE = 0x02;
+
+        // The trampolines sqlite calls back through, kept here so the delegates are never collected
+        private static readonly NativeMethods.BusyHandlerCallback BusyHandlerCallback = OnBusy;
+        private static readonly NativeMethods.ProgressHandlerCallback ProgressHandlerCallback = OnProgress;
+        private static readonly NativeMethods.UpdateHookCallback UpdateHookCallback = OnUpdate;
+        private static readonly NativeMethods.CommitHookCallback CommitHookCallback = OnCommit;
+        private static readonly NativeMethods.RollbackHookCallback RollbackHookCallback = OnRollback;
+        private static readonly NativeMethods.WalHookCallback WalHookCallback = OnWal;
+        private static readonly NativeMethods.TraceCallback TraceCallback = OnTrace;
+        private static readonly NativeMethods.FunctionCallback FunctionCallback = OnFunction;
+        private static readonly NativeMethods.FunctionCallback StepCallback = OnStep;
+        private static readonly NativeMethods.FinalCallback FinalCallback = OnFinal;
+        private static readonly NativeMethods.CollationCallback CollationCallback = OnCompare;
+        private static readonly NativeMethods.DestroyCallback DestroyCallback = OnDestroy;
+
+        // Scratch space for the calls that cannot re-enter managed code before they return
+        [ThreadStatic]
+        private static byte[] _utf8Buffer;
+        [ThreadStatic]
+        private static byte[] _textBuffer;
+        [ThreadStatic]
+        private static char[] _batchTexts;
+        [ThreadStatic]
+        private static int[] _batchTextOffsets;
+
+        public static int sqlite3_open(string filename, out SqliteConnectionHandle db)
+        {
+            return sqlite3_open_v2(filename, out db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, null);
+        }
+
+        public static int sqlite3_open16(string filename, out SqliteConnectionHandle db)
+        {
+            filename = filename ?? "";
+            IntPtr actualDb;
+            int result;
+            fixed (char* text = filename)
+                result = NativeMethods.mdsw_open16(text, filename.Length * 2, out actualDb);
+            db = new SqliteConnectionHandle(actualDb);
+            return result;
+        }
+
+        public static int sqlite3_open_v2(string filename, out SqliteConnectionHandle db, int flags, string zVfs)
+        {
+            byte[] filenameBytes = ToUtf8(filename);
+            byte[] vfsBytes = ToUtf8(zVfs);
+            IntPtr actualDb;
+            int result;
+            fixed (byte* name = filenameBytes)
+            fixed (byte* vfs = vfsBytes)
+                result = NativeMethods.mdsw_open(name, filenameBytes.Length, flags, vfs, vfsBytes.Length, out actualDb);
+            db = new SqliteConnectionHandle(actualDb);
+            return result;
+        }
+
+        public static int sqlite3_close(SqliteConnectionHandle db)
+        {
+            int result = NativeMethods.mdsw_close(Handle(db));
+            if (result == SQLITE_OK && db != null)
+            {
+                // sqlite dropped the hooks with the connection
+                db.ReleaseState();
+            }
+            return result;
+        }
+
+        public static int sqlite3_busy_timeout(SqliteConnectionHandle db, int miliseconds)
+        {
+            return NativeMethods.mdsw_busy_timeout(Handle(db), miliseconds);
+        }
+
+        public static int sqlite3_busy_handler(SqliteConnectionHandle db, SqliteBusyHandlerDelegate callback, object userState)
+        {
+            if (db == null)
+            {
+                return SQLITE_MISUSE;
+            }
+
+            db.BusyHandler = callback;
+            db.BusyHandlerState = userState;
+            return NativeMethods.mdsw_busy_handler(db.Handle, callback != null ? BusyHandlerCallback : null, callback != null ? db.State : IntPtr.Zero);
+        }
+
+        public static int sqlite3_progress_handler(SqliteConnectionHandle db, int instructions, SqliteProgressHandlerDelegate callback, object userState)
+        {
+            if (db == null)
+            {
+                return SQLITE_MISUSE;
+            }
+
+            db.ProgressHandler = callback;
+            db.ProgressHandlerState = userState;
+            return NativeMethods.mdsw_progress_handler(db.Handle, instructions, callback != null ? ProgressHandlerCallback : null, callback != null ? db.State : IntPtr.Zero);
+        }
+
+        public static int sqlite3_changes(SqliteConnectionHandle db)
+        {
+            return NativeMethods.mdsw_changes(Handle(db));
+        }
+
+        public static int sqlite3_prepare16(SqliteConnectionHandle db, string query, int length, out SqliteStatementHandle statement, out string strRemain)
+        {
+            query = query ?? "";
+            IntPtr actualStatement;
+            int tailOffset;
+            int result;
+            fixed (char* sql = query)
+                result = NativeMethods.mdsw_prepare16(Handle(db), sql, query.Length * 2, 0, out actualStatement, out tailOffset);
+            statement = new SqliteStatementHandle(actualStatement);
+            strRemain = query.Substring(Math.Min(tailOffset / 2, query.Length));
+            return result;
+        }
+
+        public static int sqlite3_prepare_v2(SqliteConnectionHandle db, string query, out SqliteStatementHandle statement)
+        {
+            query = query ?? "";
+            IntPtr actualStatement;
+            int tailOffset;
+            int result;
+            fixed (char* sql = query)
+                result = NativeMethods.mdsw_prepare16(Handle(db), sql, query.Length * 2, 1, out actualStatement, out tailOffset);
+            statement = new SqliteStatementHandle(actualStatement);
+            return result;
+        }
+
+        public static int sqlite3_step(SqliteStatementHandle statement)
+        {
+            return NativeMethods.mdsw_step(Handle(statement));
+        }
+
+        public static int sqlite3_reset(SqliteStatementHandle statement)
+        {
+            return NativeMethods.mdsw_reset(Handle(statement));
+        }
+
+        public static int sqlite3_finalize(SqliteStatementHandle statement)
+        {
+            return NativeMethods.mdsw_finalize(Handle(statement));
+        }
+
+        public static int sqlite3_clear_bindings(SqliteStatementHandle statement)
+        {
+            return NativeMethods.mdsw_clear_bindings(Handle(statement));
+        }
+
+        public static int sqlite3_stmt_status(SqliteStatementHandle statement, int op, int resetFlag)
+        {
+            return NativeMethods.mdsw_stmt_status(Handle(statement), op, resetFlag);
+        }
+
+        public static long sqlite3_last_insert_rowid(SqliteConnectionHandle db)
+        {
+            return NativeMethods.mdsw_last_insert_rowid(Handle(db));
+        }
+
+        public static string sqlite3_errmsg(SqliteConnectionHandle db)
+        {
+            IntPtr text;
+            int bytes;
+            NativeMethods.mdsw_errmsg(Handle(db), out text, out bytes);
+            return FromUtf8(text, bytes);
+        }
+
+        public static int sqlite3_bind_parameter_index(SqliteStatementHandle statement, string name)
+        {
+            int bytes;
+            byte[] buffer = ToUtf8Buffer(name, -1, out bytes);
+            fixed (byte* text = buffer)
+                return NativeMethods.mdsw_bind_parameter_index(Handle(statement), text, bytes);
+        }
+
+        public static int sqlite3_bind_null(SqliteStatementHandle statement, int index)
+        {
+            return NativeMethods.mdsw_bind_null(Handle(statement), index);
+        }
+
+        public static int sqlite3_bind_int(SqliteStatementHandle statement, int index, int value)
+        {
+            return NativeMethods.mdsw_bind_int(Handle(statement), index, value);
+        }
+
+        public static int sqlite3_bind_int64(SqliteStatementHandle statement, int index, long value)
+        {
+            return NativeMethods.mdsw_bind_int64(Handle(statement), index, value);
+        }
+
+        public static int sqlite3_bind_double(SqliteStatementHandle statement, int index, double value)
+        {
+            return NativeMethods.mdsw_bind_double(Handle(statement), index, value);
+        }
+
+        public static int sqlite3_bind_text(SqliteStatementHandle statement, int index, string value, int length, object dummy)
+        {
+            // length counts UTF-16 code units of value; sqlite wants the UTF-8 byte count
+            int bytes;
+            byte[] buffer = ToUtf8Buffer(value, length, out bytes);
+            fixed (byte* text = buffer)
+                return NativeMethods.mdsw_bind_text(Handle(statement), index, text, bytes);
+        }
+
+        public static int sqlite3_bind_text16(SqliteStatementHandle statement, int index, string value, int length)
+        {
+            value = value ?? "";
+            fixed (char* text = value)
+                return NativeMethods.mdsw_bind_text16(Handle(statement), index, text, length < 0 ? value.Length * 2 : Math.Min(length, value.Length * 2));
+        }
+
+        public static int sqlite3_bind_blob(SqliteStatementHandle statement, int index, byte[] value, int length, object dummy)
+        {
+            int bytes = value == null ? 0 : (length < 0 ? value.Length : Math.Min(length, value.Length));
+            fixed (byte* data = value)
+                return NativeMethods.mdsw_bind_blob(Handle(statement), index, data, bytes);
+        }
+
+        /// <summary>
+        /// Binds a copy of the values of whichever of integers, doubles or texts is given as the array the
+        /// table-valued function array() reads.  nulls, if given, has one flag per value that is NULL.
+        /// </summary>
+        public static int sqlite3_bind_array(SqliteStatementHandle statement, int index, long[] integers, double[] doubles,
+                                             string[] texts, byte[] nulls)
+        {
+            int kind = integers != null ? SQLITE_INTEGER : doubles != null ? SQLITE_FLOAT : texts != null ? SQLITE_TEXT : 0;
+            if (kind == 0)
+            {
+                return SQLITE_MISUSE;
+            }
+            int count = integers != null ? integers.Length : doubles != null ? doubles.Length : texts.Length;
+            if (nulls != null && nulls.Length < count)
+            {
+                return SQLITE_MISUSE;
+            }
+
+            // The texts go over as one UTF-16 buffer with the offset of each value, as for sqlite3_step_batch
+            char[] textBuffer = null;
+            int[] textOffsets = null;
+            if (kind == SQLITE_TEXT)
+            {
+                int textLength = 0;
+                for (int n = 0; n < count; n++)
+                {
+                    textLength += texts[n] == null ? 0 : texts[n].Length;
+                }
+
+                textBuffer = Reserve(ref _batchTexts, textLength);
+                textOffsets = Reserve(ref _batchTextOffsets, count + 1);
+                int position = 0;
+                for (int n = 0; n < count; n++)
+                {
+                    textOffsets[n] = position;
+                    if (texts[n] != null)
+                    {
+                        texts[n].CopyTo(0, textBuffer, position, texts[n].Length);
+                        position += texts[n].Length;
+                    }
+                }
+                textOffsets[count] = position;
+            }
+
+            fixed (long* pIntegers = integers)
+            fixed (double* pDoubles = doubles)
+            fixed (char* pTexts = textBuffer)
+            fixed (int* pTextOffsets = textOffsets)
+            fixed (byte* pNulls = nulls)
+            {
+                return NativeMethods.mdsw_bind_array(Handle(statement), index, kind, count, pIntegers, pDoubles, pTexts,
+                                                     pTextOffsets, pNulls);
+            }
+        }
+
+        /// <summary>
+        /// Binds, steps and resets statement once per row in [firstRow, rowCount) without leaving native code.
+        /// kinds holds one SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT or SQLITE_BLOB per parameter.  The values of the
+        /// parameters of one kind are concatenated column by column in integers, doubles, texts or blobs, so the value
+        /// of the k-th parameter of its kind for row r is at [k * rowCount + r]; blobOffsets has one start offset per
+        /// blob value plus a final end offset.  nulls, if given, has one flag per parameter and row at
+        /// [parameter * rowCount + r].  Returns the first error, with rowsDone set to the failing row.
+        /// </summary>
+        public static int sqlite3_step_batch(SqliteStatementHandle statement, int firstRow, int rowCount, int[] kinds,
+                                             long[] integers, double[] doubles, string[] texts, byte[] blobs, int[] blobOffsets,
+                                             byte[] nulls, int[] changes, out int rowsDone)
+        {
+            // The texts go over as one UTF-16 buffer with the offset of each value, which sqlite binds without copying
+            int textCells = 0;
+            if (kinds != null && texts != null)
+            {
+                for (int n = 0; n < kinds.Length; n++)
+                {
+                    if (kinds[n] == SQLITE_TEXT)
+                    {
+                        textCells += rowCount;
+                    }
+                }
+                textCells = Math.Min(textCells, texts.Length);
+            }
+
+            int textLength = 0;
+            for (int n = 0; n < textCells; n++)
+            {
+                textLength += texts[n] == null ? 0 : texts[n].Length;
+            }
+
+            char[] textBuffer = Reserve(ref _batchTexts, textLength);
+            int[] textOffsets = Reserve(ref _batchTextOffsets, textCells + 1);
+            int position = 0;
+            for (int n = 0; n < textCells; n++)
+            {
+                textOffsets[n] = position;
+                if (texts[n] != null)
+                {
+                    texts[n].CopyTo(0, textBuffer, position, texts[n].Length);
+                    position += texts[n].Length;
+                }
+            }
+            textOffsets[textCells] = position;
+
+            fixed (int* pKinds = kinds)
+            fixed (long* pIntegers = integers)
+            fixed (double* pDoubles = doubles)
+            fixed (char* pTexts = textBuffer)
+            fixed (int* pTextOffsets = textOffsets)
+            fixed (byte* pBlobs = blobs)
+            fixed (int* pBlobOffsets = blobOffsets)
+            fixed (byte* pNulls = nulls)
+            fixed (int* pChanges = changes)
+            {
+                return NativeMethods.mdsw_step_batch(Handle(statement), firstRow, rowCount, pKinds, kinds == null ? 0 : kinds.Length,
+                                                     pIntegers, pDoubles, pTexts, pTextOffsets, pBlobs, pBlobOffsets,
+                                                     pNulls, pChanges, out rowsDone);
+            }
+        }
+
+        /// <summary>
+        /// Steps statement up to maxRows times and stores each row column by column, so the cell of column c and row r
+        /// is at [c * stride + r] in every array.  types gets the SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB
+        /// or SQLITE_NULL type of each cell, and the value goes to integers, doubles or texts; a blob is copied into
+        /// blobs at blobOffsets[cell] with its length in integers[cell].  If pending is non-zero the statement is
+        /// already on a row that is stored first without stepping.  Rows are stored from firstRow on and their blobs from
+        /// blobStart on, so a block can be continued after a row whose blobs did not fit; rowCount is set to the row after
+        /// the last one stored.  A row whose blobs do not fit into what is left of blobs is not stored: it stays pending
+        /// on the statement and blobBytesNeeded is set to the size of its blobs.
+        /// Returns SQLITE_DONE at the end of the results, SQLITE_ROW if the rows stopped early, or the error of a
+        /// failed step.
+        /// </summary>
+        public static int sqlite3_step_block(SqliteStatementHandle statement, int pending, int firstRow, int blobStart, int maxRows, int stride,
+                                             byte[] types, long[] integers, double[] doubles, string[] texts,
+                                             byte[] blobs, int[] blobOffsets, out int rowCount, out int blobBytesNeeded)
+        {
+            IntPtr stmt = Handle(statement);
+            int columnCount = NativeMethods.mdsw_column_count(stmt);
+            int cells = columnCount * stride;
+            int blobCapacity = blobs == null ? 0 : blobs.Length;
+            rowCount = firstRow;
+            blobBytesNeeded = 0;
+
+            if (maxRows > stride || firstRow < 0 || blobStart < 0 || blobStart > blobCapacity || types == null || integers == null || doubles == null || texts == null || blobOffsets == null
+                || types.Length < cells || integers.Length < cells || doubles.Length < cells || texts.Length < cells
+                || blobOffsets.Length < cells)
+            {
+                return SQLITE_MISUSE;
+            }
+
+            // The texts come back as UTF-8 in a buffer of their own, which is grown and the rows continued whenever a
+            // row's texts do not fit; a row's blobs that do not fit are left for the caller, as they go to its array
+            int blobBytes = blobStart;
+            byte[] textBuffer = Reserve(ref _textBuffer, 4096);
+            int result;
+            while (true)
+            {
+                int rows, textBytesNeeded, blobNeeded;
+                fixed (byte* pTypes = types)
+                fixed (long* pIntegers = integers)
+                fixed (double* pDoubles = doubles)
+                fixed (int* pOffsets = blobOffsets)
+                fixed (byte* pTexts = textBuffer)
+                fixed (byte* pBlobs = blobs)
+                {
+                    result = NativeMethods.mdsw_step_block(stmt, pending, rowCount, maxRows, stride,
+                                                           pTypes, pIntegers, pDoubles, pOffsets,
+                                                           pTexts, textBuffer.Length, pBlobs + blobBytes, blobCapacity - blobBytes,
+                                                           out rows, out textBytesNeeded, out blobNeeded);
+
+                    int blobEnd = blobBytes;
+                    for (int column = 0; column < columnCount; column++)
+                    {
+                        for (int row = rowCount; row < rows; row++)
+                        {
+                            int cell = column * stride + row;
+                            if (types[cell] == SQLITE_TEXT)
+                            {
+                                texts[cell] = FromUtf8((IntPtr)(pTexts + blobOffsets[cell]), (int)integers[cell]);
+                            }
+                            else if (types[cell] == SQLITE_BLOB)
+                            {
+                                blobOffsets[cell] += blobBytes;
+                                blobEnd = Math.Max(blobEnd, blobOffsets[cell] + (int)integers[cell]);
+                            }
+                        }
+                    }
+                    blobBytes = blobEnd;
+                }
+
+                rowCount = rows;
+                if (result != SQLITE_ROW || textBytesNeeded == 0)
+                {
+                    blobBytesNeeded = blobNeeded;
+                    return result;
+                }
+
+                textBuffer = Reserve(ref _textBuffer, Math.Max(textBytesNeeded, textBuffer.Length * 2));
+                pending = 1;
+            }
+        }
+
+        public static int sqlite3_column_count(SqliteStatementHandle rstatement)
+        {
+            return NativeMethods.mdsw_column_count(Handle(rstatement));
+        }
+
+        public static string sqlite3_column_name(SqliteStatementHandle statement, int index)
+        {
+            IntPtr text;
+            int bytes;
+            NativeMethods.mdsw_column_name(Handle(statement), index, out text, out bytes);
+            return FromUtf8(text, bytes);
+        }
+
+        public static int sqlite3_column_type(SqliteStatementHandle statement, int index)
+        {
+            return NativeMethods.mdsw_column_type(Handle(statement), index);
+        }
+
+        public static int sqlite3_column_int(SqliteStatementHandle statement, int index)
+        {
+            return NativeMethods.mdsw_column_int(Handle(statement), index);
+        }
+
+        public static long sqlite3_column_int64(SqliteStatementHandle statement, int index)
+        {
+            return NativeMethods.mdsw_column_int64(Handle(statement), index);
+        }
+
+        public static double sqlite3_column_double(SqliteStatementHandle statement, int index)
+        {
+            return NativeMethods.mdsw_column_double(Handle(statement), index);
+        }
+
+        public static string sqlite3_column_text16(SqliteStatementHandle statement, int index)
+        {
+            IntPtr text;
+            int bytes;
+            NativeMethods.mdsw_column_text16(Handle(statement), index, out text, out bytes);
+            return FromUtf16(text, bytes);
+        }
+
+        public static string sqlite3_column_text(SqliteStatementHandle statement, int index)
+        {
+            IntPtr text;
+            int bytes;
+            NativeMethods.mdsw_column_text(Handle(statement), index, out text, out bytes);
+            return FromUtf8(text, bytes);
+        }
+
+        public static byte[] sqlite3_column_blob(SqliteStatementHandle statement, int index)
+        {
+            IntPtr data;
+            int bytes;
+            NativeMethods.mdsw_column_blob(Handle(statement), index, out data, out bytes);
+            return ToArray(data, bytes);
+        }
+
+        public static int sqlite3_column_bytes(SqliteStatementHandle statement, int index)
+        {
+            return NativeMethods.mdsw_column_bytes(Handle(statement), index);
+        }
+
+        public static SqliteBlobView sqlite3_column_blob_view(SqliteStatementHandle statement, int index)
+        {
+            IntPtr data;
+            int bytes;
+            NativeMethods.mdsw_column_blob(Handle(statement), index, out data, out bytes);
+            return new SqliteBlobView(data, bytes);
+        }
+
+        public static SqliteBlobView sqlite3_column_text_view(SqliteStatementHandle statement, int index)
+        {
+            IntPtr text;
+            int bytes;
+            NativeMethods.mdsw_column_text(Handle(statement), index, out text, out bytes);
+            return new SqliteBlobView(text, bytes);
+        }
+
+        public static int sqlite3_column_blob_copy(SqliteStatementHandle statement, int index, int sourceOffset, byte[] destination, int destinationOffset, int count)
+        {
+            IntPtr data;
+            int bytes;
+            NativeMethods.mdsw_column_blob(Handle(statement), index, out data, out bytes);
+            return CopyBlobRange(data, bytes, sourceOffset, destination, destinationOffset, count);
+        }
+
+        /// <summary>
+        /// Parses an ISO-8601 date from the UTF-8 column text without building a string.  Returns the DateTimeKind of
+        /// the value and its ticks, or -1 if the text is not one of the common shapes.
+        /// </summary>
+        public static int sqlite3_column_datetime(SqliteStatementHandle statement, int index, out long ticks)
+        {
+            return NativeMethods.mdsw_column_datetime(Handle(statement), index, out ticks);
+        }
+
+        public static void sqlite3_interrupt(SqliteConnectionHandle db)
+        {
+            NativeMethods.mdsw_interrupt(Handle(db));
+        }
+
+        public static SqliteStatementHandle sqlite3_next_stmt(SqliteConnectionHandle db, SqliteStatementHandle statement)
+        {
+            IntPtr next = NativeMethods.mdsw_next_stmt(Handle(db), Handle(statement));
+            return next == IntPtr.Zero ? null : new SqliteStatementHandle(next);
+        }
+
+        public static string sqlite3_value_text16(SqliteValueHandle value)
+        {
+            IntPtr text;
+            int bytes;
+            NativeMethods.mdsw_value_text16(Handle(value), out text, out bytes);
+            return FromUtf16(text, bytes);
+        }
+
+        public static string sqlite3_value_text(SqliteValueHandle value)
+        {
+            IntPtr text;
+            int bytes;
+            NativeMethods.mdsw_value_text(Handle(value), out text, out bytes);
+            return FromUtf8(text, bytes);
+        }
+
+        public static string sqlite3_libversion()
+        {
+            IntPtr text;
+            int bytes;
+            NativeMethods.mdsw_libversion(out text, out bytes);
+            return FromUtf8(text, bytes);
+        }
+
+        // The flat build keeps the names in UTF-8 only, which decode to the same strings
+        public static string sqlite3_column_database_name16(SqliteStatementHandle statement, int index)
+        {
+            return sqlite3_column_database_name(statement, index);
+        }
+
+        public static string sqlite3_column_origin_name16(SqliteStatementHandle statement, int index)
+        {
+            return sqlite3_column_origin_name(statement, index);
+        }
+
+        public static string sqlite3_column_name16(SqliteStatementHandle statement, int index)
+        {
+            return sqlite3_column_name(statement, index);
+        }
+
+        public static string sqlite3_column_table_name16(SqliteStatementHandle statement, int index)
+        {
+            return sqlite3_column_table_name(statement, index);
+        }
+
+        public static void sqlite3_result_error16(SqliteContextHandle statement, string value, int index)
+        {
+            value = value ?? "";
+            fixed (char* text = value)
+                NativeMethods.mdsw_result_error16(Handle(statement), text, index < 0 ? value.Length * 2 : Math.Min(index, value.Length * 2));
+        }
+
+        public static void sqlite3_result_text16(SqliteContextHandle statement, string value, int index, object dummy)
+        {
+            value = value ?? "";
+            fixed (char* text = value)
+                NativeMethods.mdsw_result_text16(Handle(statement), text, index < 0 ? value.Length * 2 : Math.Min(index, value.Length * 2));
+        }
+
+        public static void sqlite3_result_error(SqliteContextHandle statement, string value, int index)
+        {
+            int bytes;
+            byte[] buffer = ToUtf8Buffer(value, index, out bytes);
+            fixed (byte* text = buffer)
+                NativeMethods.mdsw_result_error(Handle(statement), text, bytes);
+        }
+
+        public static void sqlite3_result_text(SqliteContextHandle statement, string value, int index, object dummy)
+        {
+            int bytes;
+            byte[] buffer = ToUtf8Buffer(value, index, out bytes);
+            fixed (byte* text = buffer)
+                NativeMethods.mdsw_result_text(Handle(statement), text, bytes);
+        }
+
+        public static int sqlite3_exec(SqliteConnectionHandle db, string query, out string errmsg)
+        {
+            // Not the shared scratch buffer: the statements can call functions that use it
+            byte[] sql = ToUtf8(query);
+            IntPtr error;
+            int result;
+            fixed (byte* text = sql)
+                result = NativeMethods.mdsw_exec(Handle(db), text, sql.Length, out error);
+
+            errmsg = FromUtf8(error, -1);
+            NativeMethods.mdsw_free(error);
+            return result;
+        }
+
+        public static int sqlite3_bind_parameter_count(SqliteStatementHandle statement)
+        {
+            return NativeMethods.mdsw_bind_parameter_count(Handle(statement));
+        }
+
+        public static string sqlite3_bind_parameter_name(SqliteStatementHandle statement, int index)
+        {
+            IntPtr text;
+            int bytes;
+            NativeMethods.mdsw_bind_parameter_name(Handle(statement), index, out text, out bytes);
+            return FromUtf8(text, bytes);
+        }
+
+        public static string sqlite3_column_decltype(SqliteStatementHandle statement, int index)
+        {
+            IntPtr text;
+            int bytes;
+            NativeMethods.mdsw_column_decltype(Handle(statement), index, out text, out bytes);
+            return FromUtf8(text, bytes);
+        }
+
+        public static string sqlite3_column_origin_name(SqliteStatementHandle statement, int index)
+        {
+            IntPtr text;
+            int bytes;
+            NativeMethods.mdsw_column_origin_name(Handle(statement), index, out text, out bytes);
+            return FromUtf8(text, bytes);
+        }
+
+        public static string sqlite3_column_database_name(SqliteStatementHandle statement, int index)
+        {
+            IntPtr text;
+            int bytes;
+            NativeMethods.mdsw_column_database_name(Handle(statement), index, out text, out bytes);
+            return FromUtf8(text, bytes);
+        }
+
+        public static string sqlite3_column_table_name(SqliteStatementHandle statement, int index)
+        {
+            IntPtr text;
+            int bytes;
+            NativeMethods.mdsw_column_table_name(Handle(statement), index, out text, out bytes);
+            return FromUtf8(text, bytes);
+        }
+
+        public static int sqlite3_value_bytes(SqliteValueHandle value)
+        {
+            return NativeMethods.mdsw_value_bytes(Handle(value));
+        }
+
+        public static double sqlite3_value_double(SqliteValueHandle value)
+        {
+            return NativeMethods.mdsw_value_double(Handle(value));
+        }
+
+        public static int sqlite3_value_int(SqliteValueHandle value)
+        {
+            return NativeMethods.mdsw_value_int(Handle(value));
+        }
+
+        public static long sqlite3_value_int64(SqliteValueHandle value)
+        {
+            return NativeMethods.mdsw_value_int64(Handle(value));
+        }
+
+        public static int sqlite3_value_type(SqliteValueHandle value)
+        {
+            return NativeMethods.mdsw_value_type(Handle(value));
+        }
+
+        public static byte[] sqlite3_value_blob(SqliteValueHandle value)
+        {
+            IntPtr data;
+            int bytes;
+            NativeMethods.mdsw_value_blob(Handle(value), out data, out bytes);
+            return ToArray(data, bytes);
+        }
+
+        public static SqliteBlobView sqlite3_value_blob_view(SqliteValueHandle value)
+        {
+            IntPtr data;
+            int bytes;
+            NativeMethods.mdsw_value_blob(Handle(value), out data, out bytes);
+            return new SqliteBlobView(data, bytes);
+        }
+
+        public static int sqlite3_value_blob_copy(SqliteValueHandle value, int sourceOffset, byte[] destination, int destinationOffset, int count)
+        {
+            IntPtr data;
+            int bytes;
+            NativeMethods.mdsw_value_blob(Handle(value), out data, out bytes);
+            return CopyBlobRange(data, bytes, sourceOffset, destination, destinationOffset, count);
+        }
+
+        public static void sqlite3_result_double(SqliteContextHandle statement, double value)
+        {
+            NativeMethods.mdsw_result_double(Handle(statement), value);
+        }
+
+        public static void sqlite3_result_int(SqliteContextHandle statement, int value)
+        {
+            NativeMethods.mdsw_result_int(Handle(statement), value);
+        }
+
+        public static void sqlite3_result_int64(SqliteContextHandle statement, long value)
+        {
+            NativeMethods.mdsw_result_int64(Handle(statement), value);
+        }
+
+        public static void sqlite3_result_null(SqliteContextHandle statement)
+        {
+            NativeMethods.mdsw_result_null(Handle(statement));
+        }
+
+        public static void sqlite3_result_blob(SqliteContextHandle context, byte[] value, int length, object dummy)
+        {
+            int bytes = value == null ? 0 : (length < 0 ? value.Length : Math.Min(length, value.Length));
+            fixed (byte* data = value)
+                NativeMethods.mdsw_result_blob(Handle(context), data, bytes);
+        }
+
+        public static int sqlite3_table_column_metadata(SqliteConnectionHandle db, string dbName, string tableName, string columnName,
+                                                        out string dataType, out string collSeq, out int notNull, out int primaryKey, out int autoInc)
+        {
+            byte[] dbNameBytes = ToUtf8(dbName);
+            byte[] tableNameBytes = ToUtf8(tableName);
+            byte[] columnNameBytes = ToUtf8(columnName);
+            IntPtr actualDataType, actualCollSeq;
+            int dataTypeBytes, collSeqBytes;
+            int result;
+            fixed (byte* pDbName = dbNameBytes)
+            fixed (byte* pTableName = tableNameBytes)
+            fixed (byte* pColumnName = columnNameBytes)
+            {
+                result = NativeMethods.mdsw_table_column_metadata(Handle(db), pDbName, dbNameBytes.Length, pTableName, tableNameBytes.Length,
+                                                                  pColumnName, columnNameBytes.Length,
+                                                                  out actualDataType, out dataTypeBytes, out actualCollSeq, out collSeqBytes,
+                                                                  out notNull, out primaryKey, out autoInc);
+            }
+
+            dataType = FromUtf8(actualDataType, dataTypeBytes);
+            collSeq = FromUtf8(actualCollSeq, collSeqBytes);
+            return result;
+        }
+
+        public static int sqlite3_key(SqliteConnectionHandle db, string key, int length)
+        {
+            throw new NotImplementedException();
+        }
+
+        public static int sqlite3_rekey(SqliteConnectionHandle db, string key, int length)
+        {
+            throw new NotImplementedException();
+        }
+
+        public static int sqlite3_config(int option)
+        {
+            return NativeMethods.mdsw_config(option);
+        }
+
+        public static int sqlite3_config_int(int option, int value)
+        {
+            return NativeMethods.mdsw_config_int(option, value);
+        }
+
+        public static int sqlite3_config_int_int(int option, int value1, int value2)
+        {
+            return NativeMethods.mdsw_config_int_int(option, value1, value2);
+        }
+
+        public static int sqlite3_config_int64_int64(int option, long value1, long value2)
+        {
+            return NativeMethods.mdsw_config_int64_int64(option, value1, value2);
+        }
+
+        public static int sqlite3_config_pagecache(int pageSize, int pageCount)
+        {
+            return NativeMethods.mdsw_config_pagecache(pageSize, pageCount);
+        }
+
+        public static int sqlite3_db_config_lookaside(SqliteConnectionHandle db, int slotSize, int slotCount)
+        {
+            return NativeMethods.mdsw_db_config_lookaside(Handle(db), slotSize, slotCount);
+        }
+
+        public static long sqlite3_soft_heap_limit64(long limit)
+        {
+            return NativeMethods.mdsw_soft_heap_limit64(limit);
+        }
+
+        public static int sqlite3_status64(int op, out long current, out long highwater, int resetFlag)
+        {
+            return NativeMethods.mdsw_status64(op, out current, out highwater, resetFlag);
+        }
+
+        public static int sqlite3_db_status(SqliteConnectionHandle db, int op, out int current, out int highwater, int resetFlag)
+        {
+            return NativeMethods.mdsw_db_status(Handle(db), op, out current, out highwater, resetFlag);
+        }
+
+        public static int sqlite3_blob_open(SqliteConnectionHandle db, string dbName, string tableName, string columnName, long rowid, int flags, out SqliteBlobHandle blob)
+        {
+            byte[] dbNameBytes = ToUtf8(dbName);
+            byte[] tableNameBytes = ToUtf8(tableName);
+            byte[] columnNameBytes = ToUtf8(columnName);
+            IntPtr actualBlob;
+            int result;
+            fixed (byte* pDbName = dbNameBytes)
+            fixed (byte* pTableName = tableNameBytes)
+            fixed (byte* pColumnName = columnNameBytes)
+            {
+                result = NativeMethods.mdsw_blob_open(Handle(db), pDbName, dbNameBytes.Length, pTableName, tableNameBytes.Length,
+                                                      pColumnName, columnNameBytes.Length, rowid, flags, out actualBlob);
+            }
+            blob = new SqliteBlobHandle(actualBlob);
+            return result;
+        }
+
+        public static int sqlite3_blob_reopen(SqliteBlobHandle blob, long rowid)
+        {
+            return NativeMethods.mdsw_blob_reopen(Handle(blob), rowid);
+        }
+
+        public static int sqlite3_blob_close(SqliteBlobHandle blob)
+        {
+            return NativeMethods.mdsw_blob_close(Handle(blob));
+        }
+
+        public static int sqlite3_blob_bytes(SqliteBlobHandle blob)
+        {
+            return NativeMethods.mdsw_blob_bytes(Handle(blob));
+        }
+
+        /// <summary>
+        /// Reads straight from the blob into the given range of the caller's array, so a large blob never has to be
+        /// held in memory as a whole.  Returns SQLITE_RANGE if the range is outside the array.
+        /// </summary>
+        public static int sqlite3_blob_read(SqliteBlobHandle blob, byte[] destination, int destinationOffset, int count, int blobOffset)
+        {
+            if (destination == null || destinationOffset < 0 || count < 0 || count > destination.Length - destinationOffset)
+            {
+                return SQLITE_RANGE;
+            }
+
+            fixed (byte* data = destination)
+                return NativeMethods.mdsw_blob_read(Handle(blob), data + destinationOffset, count, blobOffset);
+        }
+
+        public static int sqlite3_blob_write(SqliteBlobHandle blob, byte[] source, int sourceOffset, int count, int blobOffset)
+        {
+            if (source == null || sourceOffset < 0 || count < 0 || count > source.Length - sourceOffset)
+            {
+                return SQLITE_RANGE;
+            }
+
+            fixed (byte* data = source)
+                return NativeMethods.mdsw_blob_write(Handle(blob), data + sourceOffset, count, blobOffset);
+        }
+
+        /// <summary>
+        /// Returns null if the backup cannot be started, with the error left on the destination connection.
+        /// </summary>
+        public static SqliteBackupHandle sqlite3_backup_init(SqliteConnectionHandle destination, string destinationName, SqliteConnectionHandle source, string sourceName)
+        {
+            byte[] destinationNameBytes = ToUtf8(destinationName);
+            byte[] sourceNameBytes = ToUtf8(sourceName);
+            IntPtr backup;
+            fixed (byte* pDestinationName = destinationNameBytes)
+            fixed (byte* pSourceName = sourceNameBytes)
+            {
+                backup = NativeMethods.mdsw_backup_init(Handle(destination), pDestinationName, destinationNameBytes.Length,
+                                                        Handle(source), pSourceName, sourceNameBytes.Length);
+            }
+            return backup == IntPtr.Zero ? null : new SqliteBackupHandle(backup);
+        }
+
+        public static int sqlite3_backup_step(SqliteBackupHandle backup, int pages)
+        {
+            return NativeMethods.mdsw_backup_step(Handle(backup), pages);
+        }
+
+        public static int sqlite3_backup_finish(SqliteBackupHandle backup)
+        {
+            return NativeMethods.mdsw_backup_finish(Handle(backup));
+        }
+
+        public static int sqlite3_backup_remaining(SqliteBackupHandle backup)
+        {
+            return NativeMethods.mdsw_backup_remaining(Handle(backup));
+        }
+
+        public static int sqlite3_backup_pagecount(SqliteBackupHandle backup)
+        {
+            return NativeMethods.mdsw_backup_pagecount(Handle(backup));
+        }
+
+        public static void sqlite3_update_hook(SqliteConnectionHandle db, SqliteUpdateHookDelegate callback, object userState)
+        {
+            if (db == null)
+            {
+                return;
+            }
+
+            db.UpdateHook = callback;
+            db.UpdateHookState = userState;
+            NativeMethods.mdsw_update_hook(db.Handle, callback != null ? UpdateHookCallback : null, callback != null ? db.State : IntPtr.Zero);
+        }
+
+        public static void sqlite3_commit_hook(SqliteConnectionHandle db, SqliteCommitHookDelegate callback, object userState)
+        {
+            if (db == null)
+            {
+                return;
+            }
+
+            db.CommitHook = callback;
+            db.CommitHookState = userState;
+            NativeMethods.mdsw_commit_hook(db.Handle, callback != null ? CommitHookCallback : null, callback != null ? db.State : IntPtr.Zero);
+        }
+
+        public static void sqlite3_rollback_hook(SqliteConnectionHandle db, SqliteRollbackHookDelegate callback, object userState)
+        {
+            if (db == null)
+            {
+                return;
+            }
+
+            db.RollbackHook = callback;
+            db.RollbackHookState = userState;
+            NativeMethods.mdsw_rollback_hook(db.Handle, callback != null ? RollbackHookCallback : null, callback != null ? db.State : IntPtr.Zero);
+        }
+
+        /// <summary>
+        /// Registering a WAL hook turns off sqlite's own automatic checkpoints on the connection; removing it does not
+        /// turn them back on.
+        /// </summary>
+        public static void sqlite3_wal_hook(SqliteConnectionHandle db, SqliteWalHookDelegate callback, object userState)
+        {
+            if (db == null)
+            {
+                return;
+            }
+
+            db.WalHook = callback;
+            db.WalHookState = userState;
+            NativeMethods.mdsw_wal_hook(db.Handle, callback != null ? WalHookCallback : null, callback != null ? db.State : IntPtr.Zero);
+        }
+
+        public static int sqlite3_wal_checkpoint_v2(SqliteConnectionHandle db, string dbName, int mode, out int logFrames, out int checkpointedFrames)
+        {
+            byte[] dbNameBytes = ToUtf8(dbName);
+            fixed (byte* pDbName = dbNameBytes)
+                return NativeMethods.mdsw_wal_checkpoint_v2(Handle(db), pDbName, dbNameBytes.Length, mode, out logFrames, out checkpointedFrames);
+        }
+
+        public static int sqlite3_trace_v2(SqliteConnectionHandle db, uint mask, SqliteTraceDelegate callback, object userState)
+        {
+            if (db == null)
+            {
+                return SQLITE_MISUSE;
+            }
+
+            db.Trace = callback;
+            db.TraceState = userState;
+            return NativeMethods.mdsw_trace_v2(db.Handle, mask, callback != null ? TraceCallback : null, callback != null ? db.State : IntPtr.Zero);
+        }
+
+        public static int sqlite3_create_function(SqliteConnectionHandle db, string name, int nArgs,
+                                                  SQLiteCallback func, SQLiteCallback funcstep, SQLiteFinalCallback funcfinal)
+        {
+            if (db == null)
+            {
+                return SQLITE_MISUSE;
+            }
+
+            var cookie = new FunctionCookie { Func = func, Step = funcstep, Final = funcfinal };
+
+            // sqlite calls OnDestroy, which frees the GCHandle, even when the registration fails
+            byte[] nameBytes = ToUtf8(name);
+            fixed (byte* pName = nameBytes)
+            {
+                return NativeMethods.mdsw_create_function(db.Handle, pName, nameBytes.Length, nArgs, GCHandle.ToIntPtr(GCHandle.Alloc(cookie)),
+                                                          func != null ? FunctionCallback : null,
+                                                          funcstep != null ? StepCallback : null,
+                                                          funcfinal != null ? FinalCallback : null,
+                                                          DestroyCallback);
+            }
+        }
+
+        public static int sqlite3_create_collation(SqliteConnectionHandle db, string name, SQLiteCollation compare)
+        {
+            if (db == null)
+            {
+                return SQLITE_MISUSE;
+            }
+
+            byte[] nameBytes = ToUtf8(name);
+            fixed (byte* pName = nameBytes)
+            {
+                if (compare == null)
+                {
+                    return NativeMethods.mdsw_create_collation(db.Handle, pName, nameBytes.Length, IntPtr.Zero, null, null);
+                }
+
+                var cookie = new FunctionCookie { Compare = compare };
+                return NativeMethods.mdsw_create_collation(db.Handle, pName, nameBytes.Length, GCHandle.ToIntPtr(GCHandle.Alloc(cookie)),
+                                                           CollationCallback, DestroyCallback);
+            }
+        }
+
+        /// <summary>
+        /// Returns a key that identifies the aggregate being computed, the same for every call of one group
+        /// </summary>
+        public static long sqlite3_aggregate_context(SqliteContextHandle context, int nBytes)
+        {
+            return NativeMethods.mdsw_aggregate_context(Handle(context), nBytes);
+        }
+
+        internal static int CopyBlobRange(IntPtr data, int length, int sourceOffset, byte[] destination, int destinationOffset, int count)
+        {
+            if (length < 0)
+            {
+                length = 0;
+            }
+
+            if (destination == null)
+            {
+                return length;
+            }
+
+            if (sourceOffset < 0 || destinationOffset < 0 || count <= 0 || sourceOffset >= length || destinationOffset >= destination.Length)
+            {
+                return 0;
+            }
+
+            count = Math.Min(count, length - sourceOffset);
+            count = Math.Min(count, destination.Length - destinationOffset);
+
+            Marshal.Copy((IntPtr)((byte*)data + sourceOffset), destination, destinationOffset, count);
+            return count;
+        }
+
+        private static int OnBusy(IntPtr state, int count)
+        {
+            SqliteConnectionHandle db = SqliteConnectionHandle.FromState(state);
+            try
+            {
+                return db.BusyHandler(db.BusyHandlerState, count);
+            }
+            catch (Exception)
+            {
+                // Nothing may unwind through sqlite, so stop waiting and let the caller see SQLITE_BUSY
+                return 0;
+            }
+        }
+
+        private static int OnProgress(IntPtr state)
+        {
+            SqliteConnectionHandle db = SqliteConnectionHandle.FromState(state);
+            try
+            {
+                return db.ProgressHandler(db.ProgressHandlerState);
+            }
+            catch (Exception)
+            {
+                // Nothing may unwind through sqlite, so let the statement run on
+                return 0;
+            }
+        }
+
+        private static void OnUpdate(IntPtr state, int operation, IntPtr dbName, IntPtr tableName, long rowid)
+        {
+            SqliteConnectionHandle db = SqliteConnectionHandle.FromState(state);
+            try
+            {
+                db.UpdateHook(db.UpdateHookState, operation, FromUtf8(dbName, -1), FromUtf8(tableName, -1), rowid);
+            }
+            catch (Exception)
+            {
+                // Nothing may unwind through sqlite, and the change has already been made
+            }
+        }
+
+        private static int OnCommit(IntPtr state)
+        {
+            SqliteConnectionHandle db = SqliteConnectionHandle.FromState(state);
+            try
+            {
+                return db.CommitHook(db.CommitHookState);
+            }
+            catch (Exception)
+            {
+                // Turn the commit into a rollback rather than let the exception unwind through sqlite
+                return 1;
+            }
+        }
+
+        private static void OnRollback(IntPtr state)
+        {
+            SqliteConnectionHandle db = SqliteConnectionHandle.FromState(state);
+            try
+            {
+                db.RollbackHook(db.RollbackHookState);
+            }
+            catch (Exception)
+            {
+            }
+        }
+
+        private static int OnWal(IntPtr state, IntPtr handle, IntPtr dbName, int frames)
+        {
+            SqliteConnectionHandle db = SqliteConnectionHandle.FromState(state);
+            try
+            {
+                return db.WalHook(db.WalHookState, FromUtf8(dbName, -1), frames);
+            }
+            catch (Exception)
+            {
+                // The transaction has already been committed, so there is nothing to report the exception to
+                return SQLITE_OK;
+            }
+        }
+
+        private static int OnTrace(uint type, IntPtr state, IntPtr p, IntPtr x)
+        {
+            SqliteConnectionHandle db = SqliteConnectionHandle.FromState(state);
+            try
+            {
+                long value = type == SQLITE_TRACE_PROFILE ? *(long*)x : 0;
+                db.Trace(db.TraceState, type, value);
+            }
+            catch (Exception)
+            {
+            }
+            return 0;
+        }
+
+        private static void OnFunction(IntPtr state, IntPtr context, int argc, IntPtr* argv)
+        {
+            FunctionCookie cookie = FunctionCookie.FromState(state);
+            cookie.Invoke(cookie.Func, context, argc, argv);
+        }
+
+        private static void OnStep(IntPtr state, IntPtr context, int argc, IntPtr* argv)
+        {
+            FunctionCookie cookie = FunctionCookie.FromState(state);
+            cookie.Invoke(cookie.Step, context, argc, argv);
+        }
+
+        private static void OnFinal(IntPtr state, IntPtr context)
+        {
+            FunctionCookie.FromState(state).Finish(context);
+        }
+
+        private static int OnCompare(IntPtr state, int bytes1, IntPtr string1, int bytes2, IntPtr string2)
+        {
+            FunctionCookie cookie = FunctionCookie.FromState(state);
+            try
+            {
+                // Registered as SQLITE_UTF16, so the lengths are in bytes of native UTF-16
+                return cookie.Compare(null, bytes1 / 2, FromUtf16(string1, bytes1), bytes2 / 2, FromUtf16(string2, bytes2));
+            }
+            catch (Exception)
+            {
+                // A collation has no way to report an error, so the strings compare equal
+                return 0;
+            }
+        }
+
+        private static void OnDestroy(IntPtr state)
+        {
+            GCHandle.FromIntPtr(state).Free();
+        }
+
+        private static IntPtr Handle(SqliteConnectionHandle db)
+        {
+            return db == null ? IntPtr.Zero : db.Handle;
+        }
+
+        private static IntPtr Handle(SqliteStatementHandle statement)
+        {
+            return statement == null ? IntPtr.Zero : statement.Handle;
+        }
+
+        private static IntPtr Handle(SqliteValueHandle value)
+        {
+            return value == null ? IntPtr.Zero : value.Handle;
+        }
+
+        private static IntPtr Handle(SqliteContextHandle context)
+        {
+            return context == null ? IntPtr.Zero : context.Handle;
+        }
+
+        private static IntPtr Handle(SqliteBlobHandle blob)
+        {
+            return blob == null ? IntPtr.Zero : blob.Handle;
+        }
+
+        private static IntPtr Handle(SqliteBackupHandle backup)
+        {
+            return backup == null ? IntPtr.Zero : backup.Handle;
+        }
+
+        private static T[] Reserve<T>(ref T[] buffer, int count)
+        {
+            if (buffer == null || buffer.Length < count)
+            {
+                buffer = new T[Math.Max(count, 256)];
+            }
+            return buffer;
+        }
+
+        private static byte[] ToUtf8(string value)
+        {
+            return String.IsNullOrEmpty(value) ? new byte[0] : Encoding.UTF8.GetBytes(value);
+        }
+
+        // Encodes the first length code units of value (all of them if length is negative) into the shared scratch
+        // buffer, so only callers that return before anything else can run on the thread may use it
+        private static byte[] ToUtf8Buffer(string value, int length, out int bytes)
+        {
+            value = value ?? "";
+            int count = length < 0 ? value.Length : Math.Min(length, value.Length);
+            byte[] buffer = Reserve(ref _utf8Buffer, Encoding.UTF8.GetMaxByteCount(count));
+            fixed (char* chars = value)
+            fixed (byte* target = buffer)
+                bytes = Encoding.UTF8.GetBytes(chars, count, target, buffer.Length);
+            return buffer;
+        }
+
+        private static string FromUtf8(IntPtr text, int bytes)
+        {
+            if (text == IntPtr.Zero)
+            {
+                return String.Empty;
+            }
+
+            if (bytes < 0)
+            {
+                bytes = 0;
+                for (byte* p = (byte*)text; *p != 0; p++)
+                {
+                    bytes++;
+                }
+            }
+            return bytes == 0 ? String.Empty : new string((sbyte*)text, 0, bytes, Encoding.UTF8);
+        }
+
+        private static string FromUtf16(IntPtr text, int bytes)
+        {
+            return text == IntPtr.Zero || bytes <= 0 ? String.Empty : new string((char*)text, 0, bytes / 2);
+        }
+
+        private static byte[] ToArray(IntPtr data, int bytes)
+        {
+            var array = new byte[bytes < 0 ? 0 : bytes];
+            if (bytes > 0)
+            {
+                Marshal.Copy(data, array, 0, bytes);
+            }
+            return array;
+        }
+    }
+}
@@ -38,6 +38,10 @@ namespace MonoDataSqliteWrapper
     public delegate void SqliteUpdateHookDelegate(object argument, int b, string c, string d, long e);
     public delegate int SqliteCommitHookDelegate(object argument);
     public delegate void SqliteRollbackHookDelegate(object argument);
+    public delegate int SqliteBusyHandlerDelegate(object userState, int count);
+    public delegate int SqliteProgressHandlerDelegate(object userState);
+    public delegate int SqliteWalHookDelegate(object userState, string dbName, int frames);
+    public delegate void SqliteTraceDelegate(object userState, uint type, long value);
 
     /// <summary>
     /// Utility class for wrapping sqlite3 "handles".
@@ -76,6 +80,10 @@ internal Community.CsharpSqlite.Sqlite3.Mem Handle
             {
                 return _handle;
             }
+            set
+            {
+                _handle = value;
+            }
         }
 
         private Community.CsharpSqlite.Sqlite3.Mem _handle;
@@ -102,6 +110,37 @@ internal Community.CsharpSqlite.Sqlite3.Vdbe Handle
         private Community.CsharpSqlite.Sqlite3.Vdbe _handle;
     };
 
+    /// <summary>
+    /// Utility class for wrapping sqlite3_backup "handles".
+    /// </summary>
+    public sealed class SqliteBackupHandle
+    {
+        internal SqliteBackupHandle(Community.CsharpSqlite.Sqlite3.sqlite3_backup backup)
+        {
+            _handle = (backup);
+        }
+
+        internal Community.CsharpSqlite.Sqlite3.sqlite3_backup Handle
+        {
+            get
+            {
+                return _handle;
+            }
+        }
+
+        private Community.CsharpSqlite.Sqlite3.sqlite3_backup _handle;
+    };
+
+    /// <summary>
+    /// Stands in for sqlite3_blob "handles", which Community.CsharpSqlite has no way to open.
+    /// </summary>
+    public sealed class SqliteBlobHandle
+    {
+        private SqliteBlobHandle()
+        {
+        }
+    };
+
     /// <summary>
     /// Utility class for wrapping sqlite3_context "handles".
     /// </summary>
@@ -118,39 +157,50 @@ internal Community.CsharpSqlite.Sqlite3.sqlite3_context Handle
             {
                 return _handle;
             }
+            set
+            {
+                _handle = value;
+            }
         }
 
         private Community.CsharpSqlite.Sqlite3.sqlite3_context _handle;
     };
 
-
-    public static class UnsafeNativeMethods
+    /// <summary>
+    /// Bounded view over blob data returned by sqlite.  The view is only valid until the
+    /// owning statement is stepped, reset or finalized.
+    /// </summary>
+    public sealed class SqliteBlobView
     {
-        /// <summary>
-        /// An internal callback delegate declaration.
-        /// </summary>
-        /// <param name="context">Raw context pointer for the user function</param>
-        /// <param name="nArgs">Count of arguments to the function</param>
-        /// <param name="argsptr">A pointer to the array of argument pointers</param>
-        internal delegate void SQLiteCallback(SqliteContextHandle context, int nArgs, SqliteValueHandle[] argsptr);
-        /// <summary>
-        /// An internal final callback delegate declaration.
-        /// </summary>
-        /// <param name="context">Raw context pointer for the user function</param>
-        internal delegate void SQLiteFinalCallback(SqliteContextHandle context);
-        /// <summary>
-        /// Internal callback delegate for implementing collation sequences
-        /// </summary>
-        /// <param name="puser">Not used</param>
-        /// <param name="len1">Length of the string pv1</param>
-        /// <param name="pv1">Pointer to the first string to compare</param>
-        /// <param name="len2">Length of the string pv2</param>
-        /// <param name="pv2">Pointer to the second string to compare</param>
-        /// <returns>Returns -1 if the first string is less than the second.  0 if they are equal, or 1 if the first string is greater
-        /// than the second.</returns>
-        internal delegate int SQLiteCollation(object puser, int len1, string pv1, int len2, string pv2);
+        internal SqliteBlobView(byte[] data)
+        {
+            _data = data;
+        }
+
+        public int Length
+        {
+            get
+            {
+                return _data == null ? 0 : _data.Length;
+            }
+        }
+
+        public int CopyTo(long sourceOffset, byte[] destination, int destinationOffset, int count)
+        {
+            // Streams seek with 64-bit positions; an offset past the view copies nothing rather than wrapping around
+            if (destination != null && (sourceOffset < 0 || sourceOffset >= Length))
+            {
+                return 0;
+            }
+            return UnsafeNativeMethods.CopyBlobRange(_data, (int)sourceOffset, destination, destinationOffset, count);
+        }
+
+        private byte[] _data;
+    }
 
 
+    public static class UnsafeNativeMethods
+    {
         public static void sqlite3_interrupt(SqliteConnectionHandle connection)
         {
             Community.CsharpSqlite.Sqlite3.sqlite3_interrupt(connection.Handle);
@@ -179,6 +229,24 @@ public static int sqlite3_busy_timeout(SqliteConnectionHandle connection, int ti
             return Community.CsharpSqlite.Sqlite3.sqlite3_busy_timeout(connection.Handle, timeout);
         }
 
+        public static int sqlite3_busy_handler(SqliteConnectionHandle connection, SqliteBusyHandlerDelegate callback, object userState)
+        {
+            // Community.CsharpSqlite does not export sqlite3_busy_handler, so a handler can only be cleared.  A busy
+            // timeout of 0 does exactly that.
+            if (callback == null)
+            {
+                return Community.CsharpSqlite.Sqlite3.sqlite3_busy_timeout(connection.Handle, 0);
+            }
+            return Community.CsharpSqlite.Sqlite3.SQLITE_ERROR;
+        }
+
+        public static int sqlite3_progress_handler(SqliteConnectionHandle connection, int instructions, SqliteProgressHandlerDelegate callback, object userState)
+        {
+            Community.CsharpSqlite.Sqlite3.sqlite3_progress_handler(connection.Handle, instructions,
+                callback == null ? null : new Community.CsharpSqlite.Sqlite3.dxProgress((a) => callback(a)), userState);
+            return Community.CsharpSqlite.Sqlite3.SQLITE_OK;
+        }
+
         public static int sqlite3_step(SqliteStatementHandle statement)
         {
             return Community.CsharpSqlite.Sqlite3.sqlite3_step(statement.Handle);
@@ -216,6 +284,13 @@ public static int sqlite3_bind_blob(SqliteStatementHandle statement, int index,
             return Community.CsharpSqlite.Sqlite3.sqlite3_bind_blob(statement.Handle, index, data, dataLength, null);
         }
 
+        public static int sqlite3_bind_array(SqliteStatementHandle statement, int index, long[] integers, double[] doubles,
+                                             string[] texts, byte[] nulls)
+        {
+            // Community.CsharpSqlite predates pointer bindings and eponymous virtual tables, so there is no array table
+            throw new System.NotSupportedException("array parameters need sqlite3_bind_pointer");
+        }
+
         public static int sqlite3_bind_double(SqliteStatementHandle statement, int index, double value)
         {
             return Community.CsharpSqlite.Sqlite3.sqlite3_bind_double(statement.Handle, index, value);
@@ -278,6 +353,34 @@ public static int sqlite3_column_bytes(SqliteStatementHandle statement, int inde
             return Community.CsharpSqlite.Sqlite3.sqlite3_column_bytes(statement.Handle, index);
         }
 
+        public static SqliteBlobView sqlite3_column_blob_view(SqliteStatementHandle statement, int index)
+        {
+            return new SqliteBlobView(Community.CsharpSqlite.Sqlite3.sqlite3_column_blob(statement.Handle, index));
+        }
+
+        public static SqliteBlobView sqlite3_column_text_view(SqliteStatementHandle statement, int index)
+        {
+            return new SqliteBlobView(System.Text.Encoding.UTF8.GetBytes(Community.CsharpSqlite.Sqlite3.sqlite3_column_text(statement.Handle, index) ?? ""));
+        }
+
+        public static int sqlite3_column_blob_copy(SqliteStatementHandle statement, int index, int sourceOffset, byte[] destination, int destinationOffset, int count)
+        {
+            if (destination == null)
+            {
+                return Community.CsharpSqlite.Sqlite3.sqlite3_column_bytes(statement.Handle, index);
+            }
+
+            return CopyBlobRange(Community.CsharpSqlite.Sqlite3.sqlite3_column_blob(statement.Handle, index), sourceOffset, destination, destinationOffset, count);
+        }
+
+        public static int sqlite3_column_datetime(SqliteStatementHandle statement, int index, out long ticks)
+        {
+            // CsharpSqlite already keeps text as .NET strings, so there are no UTF-8 bytes to parse from; returning -1
+            // has the caller parse the string instead.
+            ticks = 0;
+            return -1;
+        }
+
         public static double sqlite3_column_double(SqliteStatementHandle statement, int index)
         {
             return Community.CsharpSqlite.Sqlite3.sqlite3_column_double(statement.Handle, index);
@@ -328,6 +431,42 @@ public static byte[] sqlite3_value_blob(SqliteValueHandle value)
             return Community.CsharpSqlite.Sqlite3.sqlite3_value_blob(value.Handle);
         }
 
+        public static SqliteBlobView sqlite3_value_blob_view(SqliteValueHandle value)
+        {
+            return new SqliteBlobView(Community.CsharpSqlite.Sqlite3.sqlite3_value_blob(value.Handle));
+        }
+
+        public static int sqlite3_value_blob_copy(SqliteValueHandle value, int sourceOffset, byte[] destination, int destinationOffset, int count)
+        {
+            if (destination == null)
+            {
+                return Community.CsharpSqlite.Sqlite3.sqlite3_value_bytes(value.Handle);
+            }
+
+            return CopyBlobRange(Community.CsharpSqlite.Sqlite3.sqlite3_value_blob(value.Handle), sourceOffset, destination, destinationOffset, count);
+        }
+
+        internal static int CopyBlobRange(byte[] data, int sourceOffset, byte[] destination, int destinationOffset, int count)
+        {
+            int length = data == null ? 0 : data.Length;
+
+            if (destination == null)
+            {
+                return length;
+            }
+
+            if (sourceOffset < 0 || destinationOffset < 0 || count <= 0 || sourceOffset >= length || destinationOffset >= destination.Length)
+            {
+                return 0;
+            }
+
+            count = System.Math.Min(count, length - sourceOffset);
+            count = System.Math.Min(count, destination.Length - destinationOffset);
+
+            System.Array.Copy(data, sourceOffset, destination, destinationOffset, count);
+            return count;
+        }
+
         public static int sqlite3_value_bytes(SqliteValueHandle value)
         {
             return Community.CsharpSqlite.Sqlite3.sqlite3_value_bytes(value.Handle);
@@ -423,28 +562,173 @@ public static void sqlite3_result_error(SqliteContextHandle context, string erro
             return result;
         }
 
-        public static SqliteValueHandle sqlite3_aggregate_context(SqliteContextHandle context, int theByte)
+        /// <summary>
+        /// Hands a registered function's calls to its delegates, re-pointing the same context and argument handles
+        /// at each call rather than allocating them per row.
+        /// </summary>
+        private sealed class FunctionCookie
+        {
+            private readonly SqliteContextHandle _context = new SqliteContextHandle(null);
+            private SqliteValueHandle[] _args = new SqliteValueHandle[0];
+            private bool _busy;
+
+            internal SQLiteCallback Func;
+            internal SQLiteCallback Step;
+            internal SQLiteFinalCallback Final;
+
+            internal void OnFunc(Community.CsharpSqlite.Sqlite3.sqlite3_context context, int argc, Community.CsharpSqlite.Sqlite3.Mem[] argv)
+            {
+                Invoke(Func, context, argc, argv);
+            }
+
+            internal void OnStep(Community.CsharpSqlite.Sqlite3.sqlite3_context context, int argc, Community.CsharpSqlite.Sqlite3.Mem[] argv)
+            {
+                Invoke(Step, context, argc, argv);
+            }
+
+            internal void OnFinal(Community.CsharpSqlite.Sqlite3.sqlite3_context context)
+            {
+                // A function that runs a statement calling it again must not have its handles re-pointed under it
+                bool nested = _busy;
+                var handle = nested ? new SqliteContextHandle(context) : _context;
+                handle.Handle = context;
+
+                _busy = true;
+                try
+                {
+                    Final(handle);
+                }
+                catch (System.Exception e)
+                {
+                    Community.CsharpSqlite.Sqlite3.sqlite3_result_error(context, e.Message, -1);
+                }
+                finally
+                {
+                    _busy = nested;
+                }
+            }
+
+            private void Invoke(SQLiteCallback callback, Community.CsharpSqlite.Sqlite3.sqlite3_context context, int argc, Community.CsharpSqlite.Sqlite3.Mem[] argv)
+            {
+                bool nested = _busy;
+                var handle = nested ? new SqliteContextHandle(context) : _context;
+                var args = nested ? new SqliteValueHandle[argc] : _args;
+                if (args.Length < argc)
+                {
+                    args = _args = new SqliteValueHandle[argc];
+                }
+
+                handle.Handle = context;
+                for (int i = 0; i < argc; i++)
+                {
+                    if (args[i] == null)
+                        args[i] = new SqliteValueHandle(argv[i]);
+                    else
+                        args[i].Handle = argv[i];
+                }
+
+                _busy = true;
+                try
+                {
+                    callback(handle, argc, args);
+                }
+                catch (System.Exception e)
+                {
+                    Community.CsharpSqlite.Sqlite3.sqlite3_result_error(context, e.Message, -1);
+                }
+                finally
+                {
+                    _busy = nested;
+                }
+            }
+        }
+
+        public static int sqlite3_create_function(SqliteConnectionHandle connection, string name, int nArgs,
+                                                  SQLiteCallback func, SQLiteCallback funcstep, SQLiteFinalCallback funcfinal)
+        {
+            var cookie = new FunctionCookie { Func = func, Step = funcstep, Final = funcfinal };
+            return Community.CsharpSqlite.Sqlite3.sqlite3_create_function(connection.Handle, name, nArgs,
+                Community.CsharpSqlite.Sqlite3.SQLITE_UTF8, cookie,
+                func == null ? null : new Community.CsharpSqlite.Sqlite3.dxFunc(cookie.OnFunc),
+                funcstep == null ? null : new Community.CsharpSqlite.Sqlite3.dxStep(cookie.OnStep),
+                funcfinal == null ? null : new Community.CsharpSqlite.Sqlite3.dxFinal(cookie.OnFinal));
+        }
+
+        public static int sqlite3_create_collation(SqliteConnectionHandle connection, string name, SQLiteCollation compare)
         {
+            // CsharpSqlite strings are already .NET strings, so the encoding only matters for matching the name
+            return Community.CsharpSqlite.Sqlite3.sqlite3_create_collation(connection.Handle, name,
+                Community.CsharpSqlite.Sqlite3.SQLITE_UTF8, null,
+                compare == null ? null : new Community.CsharpSqlite.Sqlite3.dxCompare((u, l1, s1, l2, s2) =>
+                {
+                    try
+                    {
+                        return compare(u, l1, s1, l2, s2);
+                    }
+                    catch (System.Exception)
+                    {
+                        // A collation has no way to report an error, so the strings compare equal
+                        return 0;
+                    }
+                }));
+        }
+
+        private const int MEM_Agg = 0x2000;
+        private static long _aggregateKey;
+
+        public static long sqlite3_aggregate_context(SqliteContextHandle context, int theByte)
+        {
+            // The aggregate's Mem is the same for every step of a group, but it is a register that can be reused once
+            // the group is finished.  Its integer slot is unused while it holds an aggregate, so it keeps a key that is
+            // numbered when the Mem becomes an aggregate.
+            var mem = context.Handle.pMem;
+            bool first = mem != null && (mem.flags & MEM_Agg) == 0;
+
             var res = Community.CsharpSqlite.Sqlite3.sqlite3_aggregate_context(context.Handle, theByte);
             if (res == null)
-                return null;
-            return new SqliteValueHandle(res);
+                return 0;
+            if (first)
+                res.u.i = System.Threading.Interlocked.Increment(ref _aggregateKey);
+            return res.u.i;
         }
 
 
         public static object sqlite3_update_hook(SqliteConnectionHandle connection, SqliteUpdateHookDelegate callback, object arg)
         {
-            return Community.CsharpSqlite.Sqlite3.sqlite3_update_hook(connection.Handle, (a, b, c, d, e) => callback(a, b, c, d, e), arg);
+            return Community.CsharpSqlite.Sqlite3.sqlite3_update_hook(connection.Handle,
+                callback == null ? null : new Community.CsharpSqlite.Sqlite3.dxUpdateCallback((a, b, c, d, e) => callback(a, b, c, d, e)), arg);
         }
 
         public static object sqlite3_commit_hook(SqliteConnectionHandle connection, SqliteCommitHookDelegate callback, object arg)
         {
-            return Community.CsharpSqlite.Sqlite3.sqlite3_commit_hook(connection.Handle, (a) => callback(a), arg);
+            return Community.CsharpSqlite.Sqlite3.sqlite3_commit_hook(connection.Handle,
+                callback == null ? null : new Community.CsharpSqlite.Sqlite3.dxCommitCallback((a) => callback(a)), arg);
         }
 
         public static object sqlite3_rollback_hook(SqliteConnectionHandle connection, SqliteRollbackHookDelegate callback, object arg)
         {
-            return Community.CsharpSqlite.Sqlite3.sqlite3_rollback_hook(connection.Handle, (a) => callback(a), arg);
+            return Community.CsharpSqlite.Sqlite3.sqlite3_rollback_hook(connection.Handle,
+                callback == null ? null : new Community.CsharpSqlite.Sqlite3.dxRollbackCallback((a) => callback(a)), arg);
+        }
+
+        public static void sqlite3_wal_hook(SqliteConnectionHandle connection, SqliteWalHookDelegate callback, object userState)
+        {
+            // Community.CsharpSqlite is built without WAL support, so no transaction ever reaches a WAL hook
+        }
+
+        public static int sqlite3_wal_checkpoint_v2(SqliteConnectionHandle connection, string dbName, int mode,
+                                                    out int logFrames, out int checkpointedFrames)
+        {
+            // Report what sqlite reports for a database that is not in WAL mode
+            logFrames = -1;
+            checkpointedFrames = -1;
+            return Community.CsharpSqlite.Sqlite3.SQLITE_OK;
+        }
+
+        public static int sqlite3_trace_v2(SqliteConnectionHandle connection, uint mask, SqliteTraceDelegate callback, object userState)
+        {
+            // Community.CsharpSqlite does not export sqlite3_trace or sqlite3_profile, so there is nothing to register
+            return (callback == null) ? Community.CsharpSqlite.Sqlite3.SQLITE_OK : Community.CsharpSqlite.Sqlite3.SQLITE_ERROR;
         }
 
         public static int sqlite3_open(string filename, out SqliteConnectionHandle connection)
@@ -523,6 +807,197 @@ public static int sqlite3_finalize(SqliteStatementHandle statement)
             return Community.CsharpSqlite.Sqlite3.sqlite3_finalize(statement.Handle);
         }
 
+        public static int sqlite3_clear_bindings(SqliteStatementHandle statement)
+        {
+            return Community.CsharpSqlite.Sqlite3.sqlite3_clear_bindings(statement.Handle);
+        }
+
+        public static int sqlite3_stmt_status(SqliteStatementHandle statement, int op, int resetFlag)
+        {
+            // Community.CsharpSqlite only keeps the full scan, sort and automatic index counters
+            if (op < 1 || op > 3)
+            {
+                return 0;
+            }
+            return Community.CsharpSqlite.Sqlite3.sqlite3_stmt_status(statement.Handle, op, resetFlag);
+        }
+
+        /// <summary>
+        /// Binds, steps and resets the statement once per row, see the native wrapper for the layout of the arguments.
+        /// </summary>
+        public static int sqlite3_step_batch(SqliteStatementHandle statement, int firstRow, int rowCount, int[] kinds,
+                                             long[] integers, double[] doubles, string[] texts,
+                                             byte[] blobs, int[] blobOffsets, byte[] nulls,
+                                             int[] changes, out int rowsDone)
+        {
+            var stmt = statement.Handle;
+            var db = Community.CsharpSqlite.Sqlite3.sqlite3_db_handle(stmt);
+            int parameterCount = (kinds != null) ? kinds.Length : 0;
+            int row = firstRow;
+            int result = Community.CsharpSqlite.Sqlite3.SQLITE_OK;
+
+            // The position of each parameter among the parameters of the same kind
+            var slots = new int[parameterCount];
+            var kindCounts = new int[Community.CsharpSqlite.Sqlite3.SQLITE_NULL + 1];
+            for (int parameter = 0; parameter < parameterCount; parameter++)
+            {
+                int kind = kinds[parameter];
+                if (kind < Community.CsharpSqlite.Sqlite3.SQLITE_INTEGER || kind > Community.CsharpSqlite.Sqlite3.SQLITE_BLOB)
+                {
+                    result = Community.CsharpSqlite.Sqlite3.SQLITE_MISUSE;
+                    break;
+                }
+                slots[parameter] = kindCounts[kind]++;
+            }
+
+            while (result == Community.CsharpSqlite.Sqlite3.SQLITE_OK && row < rowCount)
+            {
+                for (int parameter = 0; parameter < parameterCount && result == Community.CsharpSqlite.Sqlite3.SQLITE_OK; parameter++)
+                {
+                    int cell = slots[parameter] * rowCount + row;
+                    if (nulls != null && nulls.Length > 0 && nulls[parameter * rowCount + row] != 0)
+                    {
+                        result = Community.CsharpSqlite.Sqlite3.sqlite3_bind_null(stmt, parameter + 1);
+                        continue;
+                    }
+
+                    switch (kinds[parameter])
+                    {
+                        case Community.CsharpSqlite.Sqlite3.SQLITE_INTEGER:
+                            result = Community.CsharpSqlite.Sqlite3.sqlite3_bind_int64(stmt, parameter + 1, integers[cell]);
+                            break;
+                        case Community.CsharpSqlite.Sqlite3.SQLITE_FLOAT:
+                            result = Community.CsharpSqlite.Sqlite3.sqlite3_bind_double(stmt, parameter + 1, doubles[cell]);
+                            break;
+                        case Community.CsharpSqlite.Sqlite3.SQLITE_TEXT:
+                            result = Community.CsharpSqlite.Sqlite3.sqlite3_bind_text(stmt, parameter + 1, texts[cell] ?? string.Empty, -1, null);
+                            break;
+                        default:
+                            // sqlite3_bind_blob has no offset, so each value needs an array of its own
+                            int length = blobOffsets[cell + 1] - blobOffsets[cell];
+                            var blob = new byte[length];
+                            System.Array.Copy(blobs, blobOffsets[cell], blob, 0, length);
+                            result = Community.CsharpSqlite.Sqlite3.sqlite3_bind_blob(stmt, parameter + 1, blob, length, null);
+                            break;
+                    }
+                }
+                if (result != Community.CsharpSqlite.Sqlite3.SQLITE_OK)
+                {
+                    break;
+                }
+
+                // sqlite3_changes keeps the count of the last INSERT, UPDATE or DELETE, so a step that changed nothing is
+                // told apart by the running total
+                int totalChanges = Community.CsharpSqlite.Sqlite3.sqlite3_total_changes(db);
+                result = Community.CsharpSqlite.Sqlite3.sqlite3_step(stmt);
+                bool stepped = result == Community.CsharpSqlite.Sqlite3.SQLITE_DONE || result == Community.CsharpSqlite.Sqlite3.SQLITE_ROW;
+                if (stepped && changes != null)
+                {
+                    changes[row] = Community.CsharpSqlite.Sqlite3.sqlite3_total_changes(db) != totalChanges
+                        ? Community.CsharpSqlite.Sqlite3.sqlite3_changes(db) : 0;
+                }
+
+                int reset = Community.CsharpSqlite.Sqlite3.sqlite3_reset(stmt);
+                result = stepped ? reset : (reset != Community.CsharpSqlite.Sqlite3.SQLITE_OK ? reset : result);
+                if (result == Community.CsharpSqlite.Sqlite3.SQLITE_OK)
+                {
+                    row++;
+                }
+            }
+
+            Community.CsharpSqlite.Sqlite3.sqlite3_clear_bindings(stmt);
+            rowsDone = row;
+            return result;
+        }
+
+        public static int sqlite3_step_block(SqliteStatementHandle statement, int pending, int firstRow, int blobStart, int maxRows, int stride,
+                                             byte[] types, long[] integers, double[] doubles,
+                                             string[] texts, byte[] blobs, int[] blobOffsets,
+                                             out int rowCount, out int blobBytesNeeded)
+        {
+            var stmt = statement.Handle;
+            int columnCount = Community.CsharpSqlite.Sqlite3.sqlite3_column_count(stmt);
+            int cells = columnCount * stride;
+            int blobCapacity = (blobs != null) ? blobs.Length : 0;
+            int row = firstRow;
+            int blobBytes = blobStart;
+            int result = Community.CsharpSqlite.Sqlite3.SQLITE_ROW;
+            blobBytesNeeded = 0;
+
+            if (maxRows > stride || firstRow < 0 || blobStart < 0 || blobStart > blobCapacity || types == null || integers == null || doubles == null || texts == null || blobOffsets == null
+                || types.Length < cells || integers.Length < cells || doubles.Length < cells || texts.Length < cells || blobOffsets.Length < cells)
+            {
+                result = Community.CsharpSqlite.Sqlite3.SQLITE_MISUSE;
+                maxRows = 0;
+            }
+
+            while (row < maxRows)
+            {
+                if (pending != 0)
+                {
+                    pending = 0;
+                }
+                else
+                {
+                    result = Community.CsharpSqlite.Sqlite3.sqlite3_step(stmt);
+                    if (result != Community.CsharpSqlite.Sqlite3.SQLITE_ROW)
+                    {
+                        break;
+                    }
+                }
+
+                // A row is stored whole or not at all, so measure its blobs before copying anything
+                int rowBytes = 0;
+                for (int column = 0; column < columnCount; column++)
+                {
+                    if (Community.CsharpSqlite.Sqlite3.sqlite3_column_type(stmt, column) == Community.CsharpSqlite.Sqlite3.SQLITE_BLOB)
+                    {
+                        rowBytes += Community.CsharpSqlite.Sqlite3.sqlite3_column_bytes(stmt, column);
+                    }
+                }
+                if (rowBytes > blobCapacity - blobBytes)
+                {
+                    blobBytesNeeded = rowBytes;
+                    result = Community.CsharpSqlite.Sqlite3.SQLITE_ROW;
+                    break;
+                }
+
+                for (int column = 0; column < columnCount; column++)
+                {
+                    int cell = column * stride + row;
+                    int type = Community.CsharpSqlite.Sqlite3.sqlite3_column_type(stmt, column);
+                    types[cell] = (byte)type;
+                    switch (type)
+                    {
+                        case Community.CsharpSqlite.Sqlite3.SQLITE_INTEGER:
+                            integers[cell] = Community.CsharpSqlite.Sqlite3.sqlite3_column_int64(stmt, column);
+                            break;
+                        case Community.CsharpSqlite.Sqlite3.SQLITE_FLOAT:
+                            doubles[cell] = Community.CsharpSqlite.Sqlite3.sqlite3_column_double(stmt, column);
+                            break;
+                        case Community.CsharpSqlite.Sqlite3.SQLITE_TEXT:
+                            texts[cell] = Community.CsharpSqlite.Sqlite3.sqlite3_column_text(stmt, column);
+                            break;
+                        case Community.CsharpSqlite.Sqlite3.SQLITE_BLOB:
+                            var blob = Community.CsharpSqlite.Sqlite3.sqlite3_column_blob(stmt, column);
+                            int length = Community.CsharpSqlite.Sqlite3.sqlite3_column_bytes(stmt, column);
+                            if (blob != null && length > 0)
+                            {
+                                System.Array.Copy(blob, 0, blobs, blobBytes, System.Math.Min(length, blob.Length));
+                            }
+                            blobOffsets[cell] = blobBytes;
+                            integers[cell] = length;
+                            blobBytes += length;
+                            break;
+                    }
+                }
+                row++;
+            }
+
+            rowCount = row;
+            return result;
+        }
+
         public static int sqlite3_close(SqliteConnectionHandle connection)
         {
             return Community.CsharpSqlite.Sqlite3.sqlite3_close(connection.Handle);
@@ -536,9 +1011,127 @@ public static SqliteStatementHandle sqlite3_next_stmt(SqliteConnectionHandle con
             return new SqliteStatementHandle(res);
         }
 
-        public static int sqlite3_config(int option, object[] args)
+        public static int sqlite3_config(int option)
+        {
+            return Community.CsharpSqlite.Sqlite3.sqlite3_config(option, new object[0]);
+        }
+
+        public static int sqlite3_config_int(int option, int value)
+        {
+            return Community.CsharpSqlite.Sqlite3.sqlite3_config(option, new object[] { value });
+        }
+
+        public static int sqlite3_config_int_int(int option, int value1, int value2)
+        {
+            return Community.CsharpSqlite.Sqlite3.sqlite3_config(option, new object[] { value1, value2 });
+        }
+
+        public static int sqlite3_config_int64_int64(int option, long value1, long value2)
+        {
+            // Community.CsharpSqlite predates the options that take 64-bit values, such as SQLITE_CONFIG_MMAP_SIZE
+            return Community.CsharpSqlite.Sqlite3.SQLITE_ERROR;
+        }
+
+        public static int sqlite3_config_pagecache(int pageSize, int pageCount)
+        {
+            // The managed engine allocates its pages on the managed heap; there is no arena to hand it
+            return Community.CsharpSqlite.Sqlite3.SQLITE_ERROR;
+        }
+
+        public static int sqlite3_db_config_lookaside(SqliteConnectionHandle connection, int slotSize, int slotCount)
+        {
+            // Community.CsharpSqlite keeps sqlite3_db_config internal, and has no lookaside allocator to size anyway
+            return Community.CsharpSqlite.Sqlite3.SQLITE_ERROR;
+        }
+
+        public static long sqlite3_soft_heap_limit64(long limit)
+        {
+            // Community.CsharpSqlite keeps sqlite3_soft_heap_limit64 internal, so report that there is no limit
+            return 0;
+        }
+
+        public static int sqlite3_status64(int op, out long current, out long highwater, int resetFlag)
+        {
+            int realCurrent = 0;
+            int realHighwater = 0;
+            var result = Community.CsharpSqlite.Sqlite3.sqlite3_status(op, ref realCurrent, ref realHighwater, resetFlag);
+            current = realCurrent;
+            highwater = realHighwater;
+            return result;
+        }
+
+        public static int sqlite3_db_status(SqliteConnectionHandle connection, int op, out int current, out int highwater,
+                                            int resetFlag)
+        {
+            int realCurrent = 0;
+            int realHighwater = 0;
+            var result = Community.CsharpSqlite.Sqlite3.sqlite3_db_status(connection.Handle, op, ref realCurrent,
+                                                                          ref realHighwater, resetFlag);
+            current = realCurrent;
+            highwater = realHighwater;
+            return result;
+        }
+
+        public static int sqlite3_blob_open(SqliteConnectionHandle connection, string dbName, string tableName,
+                                            string columnName, long rowid, int flags, out SqliteBlobHandle blob)
+        {
+            // Community.CsharpSqlite does not export the incremental blob I/O functions
+            throw new System.NotSupportedException("Incremental blob I/O is not supported on this platform");
+        }
+
+        public static int sqlite3_blob_reopen(SqliteBlobHandle blob, long rowid)
+        {
+            throw new System.NotSupportedException("Incremental blob I/O is not supported on this platform");
+        }
+
+        public static int sqlite3_blob_close(SqliteBlobHandle blob)
+        {
+            throw new System.NotSupportedException("Incremental blob I/O is not supported on this platform");
+        }
+
+        public static int sqlite3_blob_bytes(SqliteBlobHandle blob)
+        {
+            throw new System.NotSupportedException("Incremental blob I/O is not supported on this platform");
+        }
+
+        public static int sqlite3_blob_read(SqliteBlobHandle blob, byte[] destination, int destinationOffset, int count, int blobOffset)
+        {
+            throw new System.NotSupportedException("Incremental blob I/O is not supported on this platform");
+        }
+
+        public static int sqlite3_blob_write(SqliteBlobHandle blob, byte[] source, int sourceOffset, int count, int blobOffset)
+        {
+            throw new System.NotSupportedException("Incremental blob I/O is not supported on this platform");
+        }
+
+        public static SqliteBackupHandle sqlite3_backup_init(SqliteConnectionHandle destination, string destinationName,
+                                                             SqliteConnectionHandle source, string sourceName)
+        {
+            var backup = Community.CsharpSqlite.Sqlite3.sqlite3_backup_init(
+                destination.Handle, string.IsNullOrEmpty(destinationName) ? "main" : destinationName,
+                source.Handle, string.IsNullOrEmpty(sourceName) ? "main" : sourceName);
+            return backup != null ? new SqliteBackupHandle(backup) : null;
+        }
+
+        public static int sqlite3_backup_step(SqliteBackupHandle backup, int pages)
+        {
+            return Community.CsharpSqlite.Sqlite3.sqlite3_backup_step(backup.Handle, pages);
+        }
+
+        public static int sqlite3_backup_finish(SqliteBackupHandle backup)
+        {
+            return Community.CsharpSqlite.Sqlite3.sqlite3_backup_finish(backup.Handle);
+        }
+
+        public static int sqlite3_backup_remaining(SqliteBackupHandle backup)
+        {
+            // Community.CsharpSqlite keeps sqlite3_backup_remaining() internal, so read the field it returns
+            return (int)backup.Handle.nRemaining;
+        }
+
+        public static int sqlite3_backup_pagecount(SqliteBackupHandle backup)
         {
-            return Community.CsharpSqlite.Sqlite3.sqlite3_config(option, args);
+            return (int)backup.Handle.nPagecount;
         }
     }
 }
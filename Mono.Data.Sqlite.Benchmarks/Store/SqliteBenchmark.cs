@@ -0,0 +1,257 @@
+// SqliteBenchmark.cs - Measures the workloads of the Mono.Data.Sqlite benchmarks
+//
+// A benchmark runs an operation a number of times after a warm-up, and reports:
+//  - the operations per second over the whole run
+//  - the bytes allocated per operation, from a separate run short enough not to trigger a collection
+//  - the 50th, 90th and 99th percentile and the maximum of the time one operation took, in microseconds
+//
+// The results of a run are compared with the baseline of the same benchmark: a benchmark regresses when it does fewer
+// operations per second or allocates more per operation than the baseline, by more than the tolerance, and fails
+// when it has no baseline at all, since it would otherwise pass without having been checked.  Baselines are lines in
+// the format of BenchmarkResult.ToString(), the same as the results written by a run, so a run's results can be kept
+// as the next baseline.
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace MonoTests.Mono.Data.Sqlite.Benchmarks
+{
+    public sealed class BenchmarkResult
+    {
+        public string Name;
+        public long Operations;
+        public double OperationsPerSecond;
+        public double BytesPerOperation;
+        public double P50;
+        public double P90;
+        public double P99;
+        public double Max;
+
+        public override string ToString()
+        {
+            return String.Format(CultureInfo.InvariantCulture, "{0} ops={1} ops/s={2:F1} bytes/op={3:F1} p50={4:F1}us p90={5:F1}us p99={6:F1}us max={7:F1}us",
+                                 Name, Operations, OperationsPerSecond, BytesPerOperation, P50, P90, P99, Max);
+        }
+
+        public static BenchmarkResult Parse(string line)
+        {
+            string[] fields = line.Split(new[] { ' ' }, StringSplitOptions.RemoveEmptyEntries);
+            var result = new BenchmarkResult { Name = fields[0] };
+            for (int n = 1; n < fields.Length; n++)
+            {
+                int eq = fields[n].IndexOf('=');
+                string key = fields[n].Substring(0, eq);
+                double value = Double.Parse(fields[n].Substring(eq + 1).Replace("us", ""), CultureInfo.InvariantCulture);
+                switch (key)
+                {
+                    case "ops": result.Operations = (long)value; break;
+                    case "ops/s": result.OperationsPerSecond = value; break;
+                    case "bytes/op": result.BytesPerOperation = value; break;
+                    case "p50": result.P50 = value; break;
+                    case "p90": result.P90 = value; break;
+                    case "p99": result.P99 = value; break;
+                    case "max": result.Max = value; break;
+                }
+            }
+            return result;
+        }
+    }
+
+    public static class SqliteBenchmark
+    {
+        /// <summary>
+        /// How far below the baseline's operations per second, or above its allocations, a result can be
+        /// </summary>
+        public static double Tolerance = 0.2;
+
+        /// <summary>
+        /// Allocations per operation below this many bytes over the baseline are noise
+        /// </summary>
+        public static double AllocationSlack = 16;
+
+        static readonly Dictionary<string, BenchmarkResult> _baseline = new Dictionary<string, BenchmarkResult>();
+        static readonly List<BenchmarkResult> _results = new List<BenchmarkResult>();
+
+        public static void LoadBaseline(IEnumerable<string> lines)
+        {
+            lock (_baseline)
+            {
+                _baseline.Clear();
+                foreach (string line in lines)
+                {
+                    if (line.Trim().Length == 0 || line.StartsWith("#"))
+                        continue;
+                    BenchmarkResult result = BenchmarkResult.Parse(line);
+                    _baseline[result.Name] = result;
+                }
+            }
+        }
+
+        public static IList<BenchmarkResult> Results
+        {
+            get
+            {
+                lock (_results)
+                    return _results.ToArray();
+            }
+        }
+
+        /// <summary>
+        /// Runs a benchmark
+        /// </summary>
+        /// <param name="name">The name of the benchmark</param>
+        /// <param name="iterations">The number of times to run the operation</param>
+        /// <param name="operation">The operation, given the number of the iteration</param>
+        public static BenchmarkResult Run(string name, int iterations, Action<int> operation)
+        {
+            return Run(name, iterations, 1, operation);
+        }
+
+        /// <summary>
+        /// Runs a benchmark whose operation is made of many smaller ones, such as the rows of a scan
+        /// </summary>
+        /// <param name="name">The name of the benchmark</param>
+        /// <param name="iterations">The number of times to run the operation</param>
+        /// <param name="operationsPerIteration">The number of smaller operations one iteration does, which the rate and
+        /// the allocations are reported per</param>
+        /// <param name="operation">The operation, given the number of the iteration</param>
+        public static BenchmarkResult Run(string name, int iterations, int operationsPerIteration, Action<int> operation)
+        {
+            // Warm-up: JIT, statement caches, the database's pages
+            int warmup = Math.Max(1, iterations / 10);
+            for (int i = 0; i < warmup; i++)
+                operation(i);
+
+            double bytesPerIteration = MeasureAllocations(iterations, operation);
+
+            var latencies = new long[iterations];
+            var total = Stopwatch.StartNew();
+            for (int i = 0; i < iterations; i++)
+            {
+                long start = Stopwatch.GetTimestamp();
+                operation(i);
+                latencies[i] = Stopwatch.GetTimestamp() - start;
+            }
+            total.Stop();
+
+            return Record(name, (long)iterations * operationsPerIteration, total.Elapsed, bytesPerIteration / operationsPerIteration, latencies);
+        }
+
+        /// <summary>
+        /// Runs an operation on several threads at the same time
+        /// </summary>
+        /// <param name="name">The name of the benchmark</param>
+        /// <param name="threads">The number of threads</param>
+        /// <param name="iterations">The number of times each thread runs the operation</param>
+        /// <param name="operation">The operation, given the number of the thread and of the iteration</param>
+        public static BenchmarkResult RunConcurrent(string name, int threads, int iterations, Action<int, int> operation)
+        {
+            var latencies = new long[threads * iterations];
+            var total = Stopwatch.StartNew();
+            var tasks = new Task[threads];
+            for (int t = 0; t < threads; t++)
+            {
+                int thread = t;
+                tasks[t] = Task.Factory.StartNew(() =>
+                    {
+                        for (int i = 0; i < iterations; i++)
+                        {
+                            long start = Stopwatch.GetTimestamp();
+                            operation(thread, i);
+                            latencies[thread * iterations + i] = Stopwatch.GetTimestamp() - start;
+                        }
+                    }, TaskCreationOptions.LongRunning);
+            }
+            Task.WaitAll(tasks);
+            total.Stop();
+
+            // Allocations are not measured: the threads' allocations cannot be told apart
+            return Record(name, latencies.Length, total.Elapsed, 0, latencies);
+        }
+
+        /// <summary>
+        /// Returns the baseline of a result, or null if it has none
+        /// </summary>
+        public static BenchmarkResult GetBaseline(BenchmarkResult result)
+        {
+            BenchmarkResult baseline;
+            lock (_baseline)
+                return _baseline.TryGetValue(result.Name, out baseline) ? baseline : null;
+        }
+
+        /// <summary>
+        /// Describes how a result regressed from its baseline, or that it has no baseline, or returns null if it did
+        /// not regress
+        /// </summary>
+        public static string CheckRegression(BenchmarkResult result)
+        {
+            BenchmarkResult baseline = GetBaseline(result);
+            if (baseline == null)
+                return String.Format(CultureInfo.InvariantCulture, "{0}: no baseline to compare with, record one in Baseline.txt. ", result.Name);
+
+            var message = new StringBuilder();
+            if (result.OperationsPerSecond < baseline.OperationsPerSecond * (1 - Tolerance))
+                message.AppendFormat(CultureInfo.InvariantCulture, "{0}: {1:F1} ops/s, baseline {2:F1}. ", result.Name, result.OperationsPerSecond, baseline.OperationsPerSecond);
+            if (result.BytesPerOperation > baseline.BytesPerOperation * (1 + Tolerance) + AllocationSlack)
+                message.AppendFormat(CultureInfo.InvariantCulture, "{0}: {1:F1} bytes/op, baseline {2:F1}. ", result.Name, result.BytesPerOperation, baseline.BytesPerOperation);
+            return message.Length > 0 ? message.ToString() : null;
+        }
+
+        static double MeasureAllocations(int iterations, Action<int> operation)
+        {
+            // A collection during the run would hide what it allocated, so retry with fewer iterations until one
+            // runs between two collections
+            for (int count = Math.Min(iterations, 1000); count > 0; count /= 2)
+            {
+                GC.Collect();
+                GC.WaitForPendingFinalizers();
+                GC.Collect();
+
+                int collections = GC.CollectionCount(0);
+                long before = GC.GetTotalMemory(false);
+                for (int i = 0; i < count; i++)
+                    operation(i);
+                long after = GC.GetTotalMemory(false);
+
+                if (GC.CollectionCount(0) == collections)
+                    return Math.Max(0, after - before) / (double)count;
+            }
+            return Double.NaN;
+        }
+
+        static BenchmarkResult Record(string name, long operations, TimeSpan elapsed, double bytesPerOperation, long[] latencies)
+        {
+            Array.Sort(latencies);
+            var result = new BenchmarkResult
+            {
+                Name = name,
+                Operations = operations,
+                OperationsPerSecond = operations / Math.Max(elapsed.TotalSeconds, 1e-9),
+                BytesPerOperation = bytesPerOperation,
+                P50 = Microseconds(Percentile(latencies, 0.50)),
+                P90 = Microseconds(Percentile(latencies, 0.90)),
+                P99 = Microseconds(Percentile(latencies, 0.99)),
+                Max = Microseconds(latencies[latencies.Length - 1]),
+            };
+
+            lock (_results)
+                _results.Add(result);
+            return result;
+        }
+
+        static long Percentile(long[] sorted, double percentile)
+        {
+            int index = (int)Math.Ceiling(percentile * sorted.Length) - 1;
+            return sorted[Math.Max(0, Math.Min(sorted.Length - 1, index))];
+        }
+
+        static double Microseconds(long ticks)
+        {
+            return ticks * 1000000.0 / Stopwatch.Frequency;
+        }
+    }
+}
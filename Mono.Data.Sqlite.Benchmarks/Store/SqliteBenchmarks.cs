@@ -0,0 +1,458 @@
+// SqliteBenchmarks.cs - Benchmarks of the native wrapper and the managed provider
+//
+// Each test method runs one group of benchmarks and fails if any of them regressed from the baseline in
+// Baseline.txt, or has no line there.  The results of every run are written to benchmark-results.txt in the local folder; copy them over
+// Baseline.txt to make them the new baseline.  Baselines only compare with runs on the same device and build
+// configuration (Release).
+
+using System;
+using System.Collections.Generic;
+using System.Data;
+using System.IO;
+using System.Linq;
+using System.Text;
+using Mono.Data.Sqlite;
+
+#if SILVERLIGHT && !WINDOWS_PHONE
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+#else
+using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
+#endif
+
+namespace MonoTests.Mono.Data.Sqlite.Benchmarks
+{
+    [TestClass]
+    public class SqliteBenchmarks
+    {
+#if NETFX_CORE
+        readonly static string dbRootPath = Windows.Storage.ApplicationData.Current.LocalFolder.Path;
+#else
+        readonly static string dbRootPath = Path.GetTempPath();
+#endif
+        readonly static string _connectionString = "URI=file://" + Path.Combine(dbRootPath, "benchmark.db") + ", Synchronous=Normal";
+
+        [ClassInitialize]
+        static public void FixtureSetUp(TestContext context)
+        {
+            SqliteBenchmark.LoadBaseline(ReadBaseline());
+        }
+
+        [ClassCleanup]
+        static public void FixtureTearDown()
+        {
+            WriteResults(SqliteBenchmark.Results.Select(r => r.ToString()));
+        }
+
+        static void Check(params BenchmarkResult[] results)
+        {
+            string regressions = String.Concat(results.Select(r => SqliteBenchmark.CheckRegression(r)).Where(m => m != null));
+            if (regressions.Length > 0)
+                Assert.Fail(regressions);
+        }
+
+        static SqliteConnection Open(string table, string columns)
+        {
+            var cnn = new SqliteConnection(_connectionString);
+            cnn.Open();
+            Execute(cnn, "DROP TABLE IF EXISTS " + table);
+            Execute(cnn, "CREATE TABLE " + table + " (" + columns + ")");
+            return cnn;
+        }
+
+        static void Execute(SqliteConnection cnn, string sql)
+        {
+            using (var cmd = new SqliteCommand(sql, cnn))
+                cmd.ExecuteNonQuery();
+        }
+
+        static void Fill(SqliteConnection cnn, string table, int rows)
+        {
+            using (var transaction = cnn.BeginTransaction())
+            using (var cmd = new SqliteCommand("INSERT INTO " + table + " (id, a, b, c, d, e, f, g, h, i) VALUES (@id, @id * 2, @id / 3.0, 'text ' || @id, @id % 7, @id * 1.5, 'more text', @id, @id + 1, x'0102030405')", cnn))
+            {
+                var id = cmd.Parameters.Add("@id", DbType.Int64);
+                for (int n = 0; n < rows; n++)
+                {
+                    id.Value = (long)n;
+                    cmd.ExecuteNonQuery();
+                }
+                transaction.Commit();
+            }
+        }
+
+        const string WideColumns = "id INTEGER PRIMARY KEY, a INTEGER, b FLOAT, c TEXT, d INTEGER, e FLOAT, f TEXT, g INTEGER, h INTEGER, i BLOB";
+
+        [TestMethod]
+        public void InsertBenchmarks()
+        {
+            BenchmarkResult autocommit;
+            using (var cnn = Open("bench_insert", "id INTEGER, name TEXT"))
+            using (var cmd = new SqliteCommand("INSERT INTO bench_insert VALUES (@id, @name)", cnn))
+            {
+                var id = cmd.Parameters.Add("@id", DbType.Int64);
+                var name = cmd.Parameters.Add("@name", DbType.String);
+                // Every insert is a transaction of its own, with the journal and sync that takes
+                autocommit = SqliteBenchmark.Run("insert.autocommit", 200, i =>
+                    {
+                        id.Value = (long)i;
+                        name.Value = "name";
+                        cmd.ExecuteNonQuery();
+                    });
+            }
+
+            BenchmarkResult transacted;
+            using (var cnn = Open("bench_insert", "id INTEGER, name TEXT"))
+            using (var cmd = new SqliteCommand("INSERT INTO bench_insert VALUES (@id, @name)", cnn))
+            using (var transaction = cnn.BeginTransaction())
+            {
+                var id = cmd.Parameters.Add("@id", DbType.Int64);
+                var name = cmd.Parameters.Add("@name", DbType.String);
+                transacted = SqliteBenchmark.Run("insert.transaction", 20000, i =>
+                    {
+                        id.Value = (long)i;
+                        name.Value = "name";
+                        cmd.ExecuteNonQuery();
+                    });
+                transaction.Commit();
+            }
+
+            Check(autocommit, transacted);
+        }
+
+        [TestMethod]
+        public void LookupAndScanBenchmarks()
+        {
+            const int rows = 20000;
+            using (var cnn = Open("bench_scan", WideColumns))
+            {
+                Fill(cnn, "bench_scan", rows);
+
+                BenchmarkResult lookup;
+                using (var cmd = new SqliteCommand("SELECT c FROM bench_scan WHERE id = @id", cnn))
+                {
+                    var id = cmd.Parameters.Add("@id", DbType.Int64);
+                    lookup = SqliteBenchmark.Run("lookup.primarykey", 20000, i =>
+                        {
+                            id.Value = (long)(i * 7919 % rows);
+                            cmd.ExecuteScalar();
+                        });
+                }
+
+                BenchmarkResult narrow;
+                using (var cmd = new SqliteCommand("SELECT id FROM bench_scan", cnn))
+                {
+                    narrow = SqliteBenchmark.Run("scan.narrow", 20, rows, i =>
+                        {
+                            using (var reader = cmd.ExecuteReader())
+                                while (reader.Read())
+                                    reader.GetInt64(0);
+                        });
+                }
+
+                BenchmarkResult wide;
+                BenchmarkResult wideValues;
+                using (var cmd = new SqliteCommand("SELECT id, a, b, c, d, e, f, g, h, i FROM bench_scan", cnn))
+                {
+                    wide = SqliteBenchmark.Run("scan.wide.typed", 10, rows, i =>
+                        {
+                            using (var reader = cmd.ExecuteReader())
+                            {
+                                while (reader.Read())
+                                {
+                                    reader.GetInt64(0);
+                                    reader.GetInt64(1);
+                                    reader.GetDouble(2);
+                                    reader.GetString(3);
+                                    reader.GetInt64(4);
+                                    reader.GetDouble(5);
+                                    reader.GetString(6);
+                                    reader.GetInt64(7);
+                                    reader.GetInt64(8);
+                                    reader.GetValue(9);
+                                }
+                            }
+                        });
+
+                    var values = new object[10];
+                    wideValues = SqliteBenchmark.Run("scan.wide.getvalues", 10, rows, i =>
+                        {
+                            using (var reader = cmd.ExecuteReader())
+                                while (reader.Read())
+                                    reader.GetValues(values);
+                        });
+                }
+
+                Check(lookup, narrow, wide, wideValues);
+            }
+        }
+
+        [TestMethod]
+        public void BlobBenchmarks()
+        {
+            var results = new List<BenchmarkResult>();
+            using (var cnn = Open("bench_blob", "id INTEGER PRIMARY KEY, data BLOB"))
+            {
+                foreach (int size in new[] { 1024, 64 * 1024, 1024 * 1024 })
+                {
+                    var data = new byte[size];
+                    new Random(size).NextBytes(data);
+                    int iterations = Math.Max(20, 2000 * 1024 / size);
+
+                    using (var insert = new SqliteCommand("INSERT OR REPLACE INTO bench_blob VALUES (@id, @data)", cnn))
+                    {
+                        var id = insert.Parameters.Add("@id", DbType.Int64);
+                        var blob = insert.Parameters.Add("@data", DbType.Binary);
+                        blob.Value = data;
+                        using (var transaction = cnn.BeginTransaction())
+                        {
+                            results.Add(SqliteBenchmark.Run("blob.write." + size, iterations, i =>
+                                {
+                                    id.Value = (long)(i % 16);
+                                    insert.ExecuteNonQuery();
+                                }));
+                            transaction.Commit();
+                        }
+                    }
+
+                    var buffer = new byte[size];
+                    using (var select = new SqliteCommand("SELECT data FROM bench_blob WHERE id = @id", cnn))
+                    {
+                        var id = select.Parameters.Add("@id", DbType.Int64);
+                        results.Add(SqliteBenchmark.Run("blob.read." + size, iterations, i =>
+                            {
+                                id.Value = (long)(i % 16);
+                                using (var reader = select.ExecuteReader())
+                                {
+                                    reader.Read();
+                                    reader.GetBytes(0, 0, buffer, 0, buffer.Length);
+                                }
+                            }));
+                    }
+
+                    using (var select = new SqliteCommand("SELECT rowid, data FROM bench_blob WHERE id = 0", cnn))
+                    using (var reader = select.ExecuteReader())
+                    {
+                        reader.Read();
+                        using (var stream = reader.GetBlobStream(1, false))
+                        {
+                            results.Add(SqliteBenchmark.Run("blob.stream." + size, iterations, i =>
+                                {
+                                    stream.Position = 0;
+                                    while (stream.Read(buffer, 0, Math.Min(buffer.Length, 16 * 1024)) > 0)
+                                    {
+                                    }
+                                }));
+                        }
+                    }
+                }
+            }
+            Check(results.ToArray());
+        }
+
+        [TestMethod]
+        public void TextAndDateTimeBenchmarks()
+        {
+            const int rows = 5000;
+            using (var cnn = Open("bench_text", "id INTEGER PRIMARY KEY, t TEXT, u TEXT, d DATETIME"))
+            {
+                var text = new StringBuilder();
+                while (text.Length < 1000)
+                    text.Append("Some text with an accent, é, now and then. ");
+                string longText = text.ToString();
+                string unicodeText = "אבג 中文 " + longText.Substring(0, 200);
+                var start = new DateTime(2014, 1, 1, 12, 0, 0);
+
+                BenchmarkResult insert;
+                using (var cmd = new SqliteCommand("INSERT OR REPLACE INTO bench_text VALUES (@id, @t, @u, @d)", cnn))
+                using (var transaction = cnn.BeginTransaction())
+                {
+                    var id = cmd.Parameters.Add("@id", DbType.Int64);
+                    var t = cmd.Parameters.Add("@t", DbType.String);
+                    var u = cmd.Parameters.Add("@u", DbType.String);
+                    var d = cmd.Parameters.Add("@d", DbType.DateTime);
+                    insert = SqliteBenchmark.Run("text.insert", rows, i =>
+                        {
+                            id.Value = (long)i;
+                            t.Value = longText;
+                            u.Value = unicodeText;
+                            d.Value = start.AddSeconds(i);
+                            cmd.ExecuteNonQuery();
+                        });
+                    transaction.Commit();
+                }
+
+                BenchmarkResult readText;
+                using (var cmd = new SqliteCommand("SELECT t, u FROM bench_text", cnn))
+                {
+                    readText = SqliteBenchmark.Run("text.read", 10, rows, i =>
+                        {
+                            using (var reader = cmd.ExecuteReader())
+                            {
+                                while (reader.Read())
+                                {
+                                    reader.GetString(0);
+                                    reader.GetString(1);
+                                }
+                            }
+                        });
+                }
+
+                BenchmarkResult readDates;
+                using (var cmd = new SqliteCommand("SELECT d FROM bench_text", cnn))
+                {
+                    readDates = SqliteBenchmark.Run("datetime.read", 10, rows, i =>
+                        {
+                            using (var reader = cmd.ExecuteReader())
+                                while (reader.Read())
+                                    reader.GetDateTime(0);
+                        });
+                }
+
+                Check(insert, readText, readDates);
+            }
+        }
+
+        [TestMethod]
+        public void ParameterBindingBenchmarks()
+        {
+            using (var cnn = new SqliteConnection(_connectionString))
+            {
+                cnn.Open();
+
+                BenchmarkResult boxed;
+                using (var cmd = new SqliteCommand("SELECT @a, @b, @c, @d, @e", cnn))
+                {
+                    var a = cmd.Parameters.AddWithValue("@a", 0L);
+                    var b = cmd.Parameters.AddWithValue("@b", 0.0);
+                    var c = cmd.Parameters.AddWithValue("@c", "text");
+                    var d = cmd.Parameters.AddWithValue("@d", 0);
+                    var e = cmd.Parameters.AddWithValue("@e", DateTime.Now);
+                    boxed = SqliteBenchmark.Run("bind.object", 20000, i =>
+                        {
+                            a.Value = (long)i;
+                            b.Value = (double)i;
+                            d.Value = i;
+                            cmd.ExecuteNonQuery();
+                        });
+                }
+
+                BenchmarkResult typed;
+                using (var cmd = new SqliteCommand("SELECT @a, @b, @c, @d, @e", cnn))
+                {
+                    var a = cmd.Parameters.AddWithTypedValue("@a", 0L);
+                    var b = cmd.Parameters.AddWithTypedValue("@b", 0.0);
+                    cmd.Parameters.AddWithTypedValue("@c", "text");
+                    var d = cmd.Parameters.AddWithTypedValue("@d", 0);
+                    cmd.Parameters.AddWithTypedValue("@e", DateTime.Now);
+                    typed = SqliteBenchmark.Run("bind.typed", 20000, i =>
+                        {
+                            a.TypedValue = i;
+                            b.TypedValue = i;
+                            d.TypedValue = i;
+                            cmd.ExecuteNonQuery();
+                        });
+                }
+
+                Check(boxed, typed);
+            }
+        }
+
+        [TestMethod]
+        public void OpenCloseBenchmarks()
+        {
+            BenchmarkResult unpooled = SqliteBenchmark.Run("open.unpooled", 500, i =>
+                {
+                    using (var cnn = new SqliteConnection(_connectionString))
+                        cnn.Open();
+                });
+
+            string pooledConnectionString = _connectionString + ", Pooling=True";
+            BenchmarkResult pooled = SqliteBenchmark.Run("open.pooled", 5000, i =>
+                {
+                    using (var cnn = new SqliteConnection(pooledConnectionString))
+                        cnn.Open();
+                });
+            SqliteConnection.ClearAllPools();
+
+            Check(unpooled, pooled);
+        }
+
+        [TestMethod]
+        public void ContentionBenchmarks()
+        {
+            const int threads = 4;
+            string walConnectionString = "URI=file://" + Path.Combine(dbRootPath, "benchmark-wal.db") + ", Journal Mode=WAL, Synchronous=Normal";
+            using (var cnn = new SqliteConnection(walConnectionString))
+            {
+                cnn.Open();
+                Execute(cnn, "DROP TABLE IF EXISTS bench_contention");
+                Execute(cnn, "CREATE TABLE bench_contention (thread INTEGER, n INTEGER)");
+            }
+
+            // Each thread writes on a connection of its own, so they wait on each other's locks
+            var connections = new SqliteConnection[threads];
+            BenchmarkResult writers;
+            try
+            {
+                for (int t = 0; t < threads; t++)
+                {
+                    connections[t] = new SqliteConnection(walConnectionString);
+                    connections[t].Open();
+                }
+                writers = SqliteBenchmark.RunConcurrent("contention.writers", threads, 250, (t, i) =>
+                    {
+                        using (var cmd = new SqliteCommand("INSERT INTO bench_contention VALUES (" + t + ", " + i + ")", connections[t]))
+                            cmd.ExecuteNonQuery();
+                    });
+            }
+            finally
+            {
+                foreach (var cnn in connections)
+                    if (cnn != null)
+                        cnn.Dispose();
+            }
+
+            // The same writes queued to a single writer, with reads on the other threads
+            BenchmarkResult group;
+            using (var connectionGroup = new SqliteConnectionGroup(walConnectionString, threads))
+            {
+                connectionGroup.GroupCommit = true;
+                group = SqliteBenchmark.RunConcurrent("contention.group", threads, 250, (t, i) =>
+                    {
+                        if (t == 0)
+                        {
+                            connectionGroup.Write(c => new SqliteCommand("INSERT INTO bench_contention VALUES (0, " + i + ")", c).ExecuteNonQuery()).Wait();
+                        }
+                        else
+                        {
+                            connectionGroup.Read(c => new SqliteCommand("SELECT count(*) FROM bench_contention WHERE thread = " + t, c).ExecuteScalar());
+                        }
+                    });
+            }
+
+            Check(writers, group);
+        }
+
+        static IEnumerable<string> ReadBaseline()
+        {
+#if NETFX_CORE
+            var file = Windows.Storage.StorageFile.GetFileFromApplicationUriAsync(new Uri("ms-appx:///Baseline.txt")).AsTask().Result;
+            return Windows.Storage.FileIO.ReadLinesAsync(file).AsTask().Result;
+#else
+            string path = Path.Combine(Path.GetDirectoryName(typeof(SqliteBenchmarks).Assembly.Location), "Baseline.txt");
+            return File.Exists(path) ? File.ReadAllLines(path) : new string[0];
+#endif
+        }
+
+        static void WriteResults(IEnumerable<string> lines)
+        {
+#if NETFX_CORE
+            var folder = Windows.Storage.ApplicationData.Current.LocalFolder;
+            var file = folder.CreateFileAsync("benchmark-results.txt", Windows.Storage.CreationCollisionOption.ReplaceExisting).AsTask().Result;
+            Windows.Storage.FileIO.WriteLinesAsync(file, lines).AsTask().Wait();
+#else
+            File.WriteAllLines(Path.Combine(dbRootPath, "benchmark-results.txt"), lines.ToArray());
+#endif
+        }
+    }
+}
@@ -0,0 +1,9 @@
+﻿using System;
+
+namespace Windows.Storage.ApplicationData.Current
+{
+    public static class LocalFolder
+    {
+        public static string Path = AppDomain.CurrentDomain.BaseDirectory;
+    }
+}
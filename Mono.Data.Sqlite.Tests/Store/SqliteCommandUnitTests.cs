@@ -8,9 +8,11 @@
 using System.IO;
 using System.Text;
 using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
 using Mono.Data.Sqlite;
 
-#if SILVERLIGHT && !WINDOWS_PHONE
+#if (SILVERLIGHT && !WINDOWS_PHONE) || DESKTOP
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 #else
 using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
@@ -60,6 +62,13 @@ public void Create()
             {
                 throw;
             }
+#elif DESKTOP
+            _conn.Dispose();
+            // We want to start with a fresh db for each full run
+            if (File.Exists(_uri))
+            {
+                File.Delete(_uri);
+            }
 #else
             using (var store = System.IO.IsolatedStorage.IsolatedStorageFile.GetUserStoreForApplication())
             {
@@ -227,5 +236,492 @@ public void InsertWithFailingTransaction()
                 }
             }
         }
+
+        [TestMethod]
+        public void StatementCacheReusesStatements()
+        {
+            using (var conn = new SqliteConnection(_connectionString + ",Statement Cache Size=2"))
+            {
+                conn.Open();
+                using (var c = new SqliteCommand("CREATE TABLE IF NOT EXISTS t3 (a INTEGER, b TEXT); DELETE FROM t3;", conn))
+                {
+                    c.ExecuteNonQuery();
+                }
+
+                for (int i = 0; i < 3; i++)
+                {
+                    using (var insert = new SqliteCommand("INSERT INTO t3 VALUES (:a, :b)", conn))
+                    {
+                        insert.Parameters.Add(new SqliteParameter("a", i));
+                        insert.Parameters.Add(new SqliteParameter("b", "row " + i));
+                        Assert.AreEqual(1, insert.ExecuteNonQuery());
+                    }
+                }
+                Assert.AreEqual(2L, conn.StatementCacheHits, "#1");
+
+                using (var select = new SqliteCommand("SELECT * FROM t3 ORDER BY a", conn))
+                {
+                    using (var reader = select.ExecuteReader())
+                    {
+                        Assert.AreEqual(2, reader.FieldCount, "#2");
+                    }
+
+                    using (var alter = new SqliteCommand("ALTER TABLE t3 ADD COLUMN c INTEGER", conn))
+                    {
+                        alter.ExecuteNonQuery();
+                    }
+
+                    // the cached statement is re-prepared against the new schema
+                    using (var reader = select.ExecuteReader())
+                    {
+                        Assert.AreEqual(3, reader.FieldCount, "#3");
+                        Assert.IsTrue(reader.Read());
+                        Assert.AreEqual("row 0", reader.GetString(1), "#4");
+                    }
+                }
+            }
+        }
+
+        [TestMethod]
+        public void ExecuteBatchInsertsColumns()
+        {
+            using (var conn = new SqliteConnection(_connectionString))
+            {
+                conn.Open();
+                using (var c = new SqliteCommand("CREATE TABLE IF NOT EXISTS t4 (i INTEGER, f REAL, t TEXT, b BLOB); DELETE FROM t4;", conn))
+                {
+                    c.ExecuteNonQuery();
+                }
+
+                using (var transaction = conn.BeginTransaction())
+                using (var insert = new SqliteCommand("INSERT INTO t4 VALUES (?, ?, ?, ?)", conn, transaction))
+                {
+                    int[] changes = insert.ExecuteBatch(
+                        new long?[] { 1, null, 3 },
+                        new double[] { 0.5, 1.5, 2.5 },
+                        new string[] { "one", null, stringvalue },
+                        new byte[][] { new byte[] { 1 }, null, new byte[] { 3, 3, 3 } });
+                    transaction.Commit();
+
+                    Assert.AreEqual(3, changes.Length, "#1");
+                    Assert.AreEqual(1, changes[2], "#2");
+                }
+
+                using (var select = new SqliteCommand("SELECT i, f, t, b FROM t4 ORDER BY f", conn))
+                using (var reader = select.ExecuteReader())
+                {
+                    Assert.IsTrue(reader.Read());
+                    Assert.AreEqual(1L, reader.GetInt64(0), "#3");
+                    Assert.IsTrue(reader.Read());
+                    Assert.IsTrue(reader.IsDBNull(0), "#4");
+                    Assert.IsTrue(reader.IsDBNull(2), "#5");
+                    Assert.IsTrue(reader.IsDBNull(3), "#6");
+                    Assert.IsTrue(reader.Read());
+                    Assert.AreEqual(stringvalue, reader.GetString(2), "#7");
+                    Assert.AreEqual(3, ((byte[])reader[3]).Length, "#8");
+                }
+
+                using (var update = new SqliteCommand("UPDATE t4 SET i = 0 WHERE f < ?", conn))
+                {
+                    int[] changes = update.ExecuteBatch(new double[] { 1, 3 });
+                    Assert.AreEqual(1, changes[0], "#9");
+                    Assert.AreEqual(3, changes[1], "#10");
+
+                    try
+                    {
+                        update.ExecuteBatch(new double[] { 1 }, new double[] { 2 });
+                        Assert.Fail("#11 the command has a single parameter");
+                    }
+                    catch (ArgumentException) { }
+                }
+
+                using (var select = new SqliteCommand("SELECT count(*) FROM t4 WHERE f > ?", conn))
+                {
+                    int[] changes = select.ExecuteBatch(new double[] { 0, 2 });
+                    Assert.AreEqual(0, changes[0], "#12 a query changes no rows");
+                    Assert.AreEqual(0, changes[1], "#13");
+                }
+            }
+        }
+
+        [SqliteFunction(Name = "twice", Arguments = 1, FuncType = FunctionType.Scalar)]
+        public class TwiceFunction : SqliteFunction
+        {
+            public override object Invoke(object[] args)
+            {
+                if (args[0] is string)
+                    throw new InvalidOperationException("not a number");
+                return (long)args[0] * 2;
+            }
+        }
+
+        [SqliteFunction(Name = "total_length", Arguments = 1, FuncType = FunctionType.Aggregate)]
+        public class TotalLengthFunction : SqliteFunction
+        {
+            public override void Step(object[] args, int stepNumber, ref object contextData)
+            {
+                contextData = (contextData == null ? 0L : (long)contextData) + ((string)args[0]).Length;
+            }
+
+            public override object Final(object contextData)
+            {
+                return contextData ?? 0L;
+            }
+        }
+
+        [SqliteFunction(Name = "DESCENDING", FuncType = FunctionType.Collation)]
+        public class DescendingCollation : SqliteFunction
+        {
+            public override int Compare(string param1, string param2)
+            {
+                return -string.CompareOrdinal(param1, param2);
+            }
+        }
+
+        [TestMethod]
+        public void UserDefinedFunctions()
+        {
+            SqliteFunction.RegisterFunction(typeof(TwiceFunction));
+            SqliteFunction.RegisterFunction(typeof(TotalLengthFunction));
+            SqliteFunction.RegisterFunction(typeof(DescendingCollation));
+
+            using (var conn = new SqliteConnection(_connectionString))
+            {
+                conn.Open();
+                using (var c = new SqliteCommand("CREATE TABLE IF NOT EXISTS t5 (g INTEGER, s TEXT); DELETE FROM t5; " +
+                    "INSERT INTO t5 VALUES (1, 'a'), (1, 'bb'), (2, 'ccc'), (2, 'dddd'), (2, 'e');", conn))
+                {
+                    c.ExecuteNonQuery();
+                }
+
+                using (var c = new SqliteCommand("SELECT sum(twice(g)) FROM t5", conn))
+                {
+                    Assert.AreEqual(16L, c.ExecuteScalar(), "#1");
+                }
+
+                using (var c = new SqliteCommand("SELECT g, total_length(s) FROM t5 GROUP BY g ORDER BY g", conn))
+                using (var reader = c.ExecuteReader())
+                {
+                    Assert.IsTrue(reader.Read());
+                    Assert.AreEqual(3L, reader.GetInt64(1), "#2");
+                    Assert.IsTrue(reader.Read());
+                    Assert.AreEqual(8L, reader.GetInt64(1), "#3");
+                }
+
+                using (var c = new SqliteCommand("SELECT s FROM t5 ORDER BY s COLLATE DESCENDING LIMIT 1", conn))
+                {
+                    Assert.AreEqual("e", c.ExecuteScalar(), "#4");
+                }
+
+                using (var c = new SqliteCommand("SELECT twice(s) FROM t5", conn))
+                {
+                    try
+                    {
+                        c.ExecuteScalar();
+                        Assert.Fail("#5 the function throws for text");
+                    }
+                    catch (SqliteException) { }
+                }
+
+                int updates = 0;
+                conn.Update += (sender, e) => updates++;
+                using (var c = new SqliteCommand("UPDATE t5 SET g = twice(g)", conn))
+                {
+                    c.ExecuteNonQuery();
+                }
+                Assert.AreEqual(5, updates, "#6");
+            }
+        }
+
+        [TestMethod]
+        public void AsyncExecution()
+        {
+            using (var conn = new SqliteConnection(_connectionString))
+            {
+                conn.Open();
+                using (var c = new SqliteCommand("DROP TABLE IF EXISTS t6; CREATE TABLE t6 (x INTEGER);", conn))
+                {
+                    c.ExecuteNonQueryAsync().Wait();
+                }
+
+                using (var c = new SqliteCommand("INSERT INTO t6 VALUES (1), (2), (3)", conn))
+                {
+                    Assert.AreEqual(3, c.ExecuteNonQueryAsync().Result, "#1");
+                }
+
+                using (var c = new SqliteCommand("SELECT sum(x) FROM t6", conn))
+                {
+                    Assert.AreEqual(6L, c.ExecuteScalarAsync().Result, "#2");
+                }
+
+                using (var c = new SqliteCommand("SELECT x FROM t6 ORDER BY x", conn))
+                using (var reader = c.ExecuteReaderAsync().Result)
+                {
+                    long sum = 0;
+                    while (reader.ReadAsync().Result)
+                        sum += reader.GetInt64(0);
+                    Assert.AreEqual(6L, sum, "#3");
+                }
+
+                using (var source = new CancellationTokenSource())
+                using (var c = new SqliteCommand("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n) " +
+                                                 "SELECT count(*) FROM n", conn))
+                {
+                    Task<object> endless = c.ExecuteScalarAsync(source.Token);
+                    Task.Delay(50).Wait();
+                    source.Cancel();
+                    try
+                    {
+                        endless.Wait();
+                        Assert.Fail("#4 the query never ends on its own");
+                    }
+                    catch (AggregateException) { }
+                    Assert.IsTrue(endless.IsCanceled, "#5 cancelling should interrupt the query");
+                }
+
+                using (var c = new SqliteCommand("SELECT count(*) FROM t6", conn))
+                {
+                    Assert.AreEqual(3L, c.ExecuteScalarAsync().Result, "#6 the connection should still work");
+                }
+            }
+        }
+
+        [TestMethod]
+        public void AsyncRetryEndsWhenConnectionCloses()
+        {
+            using (var conn = new SqliteConnection(_connectionString))
+            using (var locker = new SqliteConnection(_connectionString))
+            {
+                conn.Open();
+                locker.Open();
+                using (var c = new SqliteCommand("CREATE TABLE IF NOT EXISTS t7 (x INTEGER)", conn))
+                {
+                    c.ExecuteNonQuery();
+                }
+                using (var c = new SqliteCommand("BEGIN EXCLUSIVE", locker))
+                {
+                    c.ExecuteNonQuery();
+                }
+
+                try
+                {
+                    Task<object> locked;
+                    using (var c = new SqliteCommand("SELECT count(*) FROM t7", conn))
+                    {
+                        locked = c.ExecuteScalarAsync();
+                        Task.Delay(100).Wait();
+                        Assert.IsFalse(locked.IsCompleted, "#1 should be waiting for the lock");
+                        conn.Close();
+                    }
+
+                    try
+                    {
+                        Assert.IsTrue(locked.Wait(5000), "#2 closing the connection should end the retries");
+                    }
+                    catch (AggregateException) { }
+                    Assert.IsTrue(locked.IsFaulted, "#3");
+                }
+                finally
+                {
+                    using (var c = new SqliteCommand("ROLLBACK", locker))
+                    {
+                        c.ExecuteNonQuery();
+                    }
+                }
+            }
+        }
+
+        [TestMethod]
+        public void CommandTimeoutInterruptsQuery()
+        {
+            using (var conn = new SqliteConnection(_connectionString))
+            {
+                conn.Open();
+                using (var c = new SqliteCommand("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n) " +
+                                                 "SELECT count(*) FROM n", conn))
+                {
+                    c.CommandTimeout = 1;
+                    int start = Environment.TickCount;
+                    try
+                    {
+                        c.ExecuteScalar();
+                        Assert.Fail("#1 the query never ends on its own");
+                    }
+                    catch (SqliteException ex)
+                    {
+                        Assert.AreEqual(SQLiteErrorCode.Interrupt, ex.ErrorCode, "#2");
+                    }
+                    Assert.IsTrue(Environment.TickCount - start < 10000, "#3 the timeout should stop the query");
+                }
+
+                using (var c = new SqliteCommand("SELECT 1 + 2", conn))
+                {
+                    Assert.AreEqual(3L, c.ExecuteScalar(), "#4 the connection should still work");
+                }
+            }
+        }
+
+        class BulkRow
+        {
+            public long Id { get; set; }
+            public string Name { get; set; }
+            public double? Score { get; set; }
+        }
+
+        [TestMethod]
+        public void BulkCopyLoadsRows()
+        {
+            using (var conn = new SqliteConnection(_connectionString))
+            {
+                conn.Open();
+                using (var c = new SqliteCommand("CREATE TABLE IF NOT EXISTS t7 (id INTEGER, name TEXT, score REAL); DELETE FROM t7; " +
+                                                 "CREATE INDEX IF NOT EXISTS t7_id ON t7 (id)", conn))
+                {
+                    c.ExecuteNonQuery();
+                }
+
+                var copy = new SqliteBulkCopy(conn) { DestinationTableName = "t7", BatchSize = 100, CommitSize = 1000,
+                                                      DeferIndexes = true, RelaxDurability = true, NotifyAfter = 500 };
+                int notified = 0;
+                copy.Progress += (sender, e) => notified++;
+
+                copy.WriteToServer(Enumerable.Range(0, 2500).Select(
+                    n => new BulkRow { Id = n, Name = "row " + n, Score = (n % 2 == 0) ? n / 2.0 : (double?)null }));
+                Assert.AreEqual(2500L, copy.Rows, "#1");
+                Assert.AreEqual(5, notified, "#2");
+
+                copy.WriteToServer(new StringReader("id,name,score\r\n2500,\"a, \"\"quoted\"\"\r\nname\",1.5\n\n2501,,\n"));
+                Assert.AreEqual(2L, copy.Rows, "#3");
+
+                using (var memory = new SqliteConnection("Data Source=:memory:"))
+                {
+                    memory.Open();
+                    using (var select = new SqliteCommand("SELECT 2502, 'x' UNION ALL SELECT 2503, NULL", memory))
+                    using (var reader = select.ExecuteReader())
+                    {
+                        copy.ColumnNames = new[] { "id", "name" };
+                        copy.WriteToServer(reader);
+                        Assert.AreEqual(2L, copy.Rows, "#4");
+                    }
+                }
+
+                using (var c = new SqliteCommand("SELECT count(*), count(score), sum(id), " +
+                                                 "(SELECT name FROM t7 WHERE id = 2500 LIMIT 1), " +
+                                                 "(SELECT count(*) FROM t7 WHERE name IS NULL) FROM t7", conn))
+                using (var reader = c.ExecuteReader())
+                {
+                    Assert.IsTrue(reader.Read(), "#5");
+                    Assert.AreEqual(2504L, reader.GetInt64(0), "#6");
+                    Assert.AreEqual(1251L, reader.GetInt64(1), "#7");
+                    Assert.AreEqual(2499L * 2500 / 2 + 2500 + 2501 + 2502 + 2503, reader.GetInt64(2), "#8");
+                    Assert.AreEqual("a, \"quoted\"\r\nname", reader.GetString(3), "#9");
+                    Assert.AreEqual(2L, reader.GetInt64(4), "#10");
+                }
+
+                using (var c = new SqliteCommand("SELECT count(*) FROM sqlite_master WHERE name = 't7_id'", conn))
+                {
+                    Assert.AreEqual(1L, c.ExecuteScalar(), "#11 the deferred index should be created again");
+                }
+            }
+        }
+
+        [TestMethod]
+        public void BulkCopyKeepsUniqueIndexes()
+        {
+            using (var conn = new SqliteConnection(_connectionString))
+            {
+                conn.Open();
+                using (var c = new SqliteCommand("DROP TABLE IF EXISTS t9; CREATE TABLE t9 (id INTEGER, name TEXT, score REAL); " +
+                                                 "CREATE UNIQUE INDEX t9_id ON t9 (id); CREATE INDEX t9_name ON t9 (name); " +
+                                                 "INSERT INTO t9 (id, name) VALUES (5, 'first'); PRAGMA synchronous=1", conn))
+                {
+                    c.ExecuteNonQuery();
+                }
+
+                var copy = new SqliteBulkCopy(conn) { DestinationTableName = "t9", BatchSize = 10,
+                                                      DeferIndexes = true, RelaxDurability = true };
+                try
+                {
+                    copy.WriteToServer(Enumerable.Range(0, 20).Select(n => new BulkRow { Id = n, Name = "row " + n }));
+                    Assert.Fail("#1 the duplicate key should fail the copy");
+                }
+                catch (SqliteException ex)
+                {
+                    Assert.AreEqual(SQLiteErrorCode.Constraint, ex.ErrorCode, "#2");
+                }
+
+                using (var c = new SqliteCommand("SELECT count(*) FROM sqlite_master WHERE name IN ('t9_id', 't9_name')", conn))
+                {
+                    Assert.AreEqual(2L, c.ExecuteScalar(), "#3 both indexes should be in place");
+                }
+                using (var c = new SqliteCommand("PRAGMA synchronous", conn))
+                {
+                    Assert.AreEqual(1L, c.ExecuteScalar(), "#4 the durability settings should be restored");
+                }
+            }
+        }
+
+        [TestMethod]
+        public void ArrayParameterFiltersRows()
+        {
+            using (var conn = new SqliteConnection(_connectionString))
+            {
+                conn.Open();
+                using (var c = new SqliteCommand("CREATE TABLE IF NOT EXISTS t8 (id INTEGER PRIMARY KEY, name TEXT); DELETE FROM t8; " +
+                                                 "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 20000) " +
+                                                 "INSERT INTO t8 SELECT i, 'name ' || i FROM n", conn))
+                {
+                    c.ExecuteNonQuery();
+                }
+
+                using (var c = new SqliteCommand("SELECT count(*), sum(id) FROM t8 WHERE id IN (SELECT value FROM array(@ids))", conn))
+                {
+                    c.Parameters.Add(new SqliteParameter("@ids", Enumerable.Range(0, 10000).Select(n => 2L * n + 1).ToArray()));
+                    using (var reader = c.ExecuteReader())
+                    {
+                        Assert.IsTrue(reader.Read(), "#1");
+                        Assert.AreEqual(10000L, reader.GetInt64(0), "#2");
+                        Assert.AreEqual(10000L * 10000, reader.GetInt64(1), "#3");
+                    }
+
+                    c.Parameters["@ids"].Value = new int[] { 3, 5, 5, 40000 };
+                    using (var reader = c.ExecuteReader())
+                    {
+                        Assert.IsTrue(reader.Read(), "#4");
+                        Assert.AreEqual(2L, reader.GetInt64(0), "#5 the command should bind the new array");
+                    }
+                }
+
+                using (var c = new SqliteCommand("SELECT t8.id FROM array(?) AS a JOIN t8 ON t8.name = a.value ORDER BY a.rowid", conn))
+                {
+                    c.Parameters.Add(new SqliteParameter { Value = new string[] { "name 7", null, "none", "name 2" } });
+                    using (var reader = c.ExecuteReader())
+                    {
+                        Assert.IsTrue(reader.Read(), "#6");
+                        Assert.AreEqual(7L, reader.GetInt64(0), "#7");
+                        Assert.IsTrue(reader.Read(), "#8");
+                        Assert.AreEqual(2L, reader.GetInt64(0), "#9");
+                        Assert.IsFalse(reader.Read(), "#10");
+                    }
+                }
+
+                using (var c = new SqliteCommand("SELECT sum(value), count(*) FROM array(?)", conn))
+                {
+                    c.Parameters.Add(new SqliteParameter { Value = new double[] { 0.5, 1.25 } });
+                    using (var reader = c.ExecuteReader())
+                    {
+                        Assert.IsTrue(reader.Read(), "#11");
+                        Assert.AreEqual(1.75, reader.GetDouble(0), "#12");
+                    }
+
+                    c.Parameters[0].Value = new double[0];
+                    using (var reader = c.ExecuteReader())
+                    {
+                        Assert.IsTrue(reader.Read(), "#13");
+                        Assert.AreEqual(0L, reader.GetInt64(1), "#14 an empty array should have no rows");
+                    }
+                }
+            }
+        }
     }
 }
\ No newline at end of file
@@ -32,8 +32,9 @@
 using System.Data;
 using Mono.Data.Sqlite;
 using System.IO;
+using System.Threading.Tasks;
 
-#if SILVERLIGHT && !WINDOWS_PHONE
+#if (SILVERLIGHT && !WINDOWS_PHONE) || DESKTOP
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 #else
 using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
@@ -144,5 +145,403 @@ public void OpenTest()
             }
         }
 
+        [TestMethod]
+        public void BusyStrategyTest()
+        {
+            using (var writer = new SqliteConnection(_connectionString))
+            using (var backoff = new SqliteConnection(_connectionString + ", Default Timeout=1"))
+            using (var none = new SqliteConnection(_connectionString + ", Busy Strategy=None"))
+            {
+                writer.Open();
+                backoff.Open();
+                none.Open();
+
+                using (var cmd = new SqliteCommand("CREATE TABLE IF NOT EXISTS busy (x INTEGER)", writer))
+                {
+                    cmd.ExecuteNonQuery();
+                }
+
+                using (var transaction = writer.BeginTransaction())
+                {
+                    using (var cmd = new SqliteCommand("INSERT INTO busy VALUES (1)", writer, transaction))
+                    {
+                        cmd.ExecuteNonQuery();
+                    }
+
+                    try
+                    {
+                        new SqliteCommand("INSERT INTO busy VALUES (2)", none).ExecuteNonQuery();
+                        Assert.Fail("#1 should have failed on the locked database");
+                    }
+                    catch (SqliteException) { }
+                    Assert.AreEqual(0L, none.BusyRetries, "#2 should not have retried");
+
+                    try
+                    {
+                        new SqliteCommand("INSERT INTO busy VALUES (3)", backoff).ExecuteNonQuery();
+                        Assert.Fail("#3 should have failed once the timeout expired");
+                    }
+                    catch (SqliteException) { }
+                    Assert.IsTrue(backoff.BusyRetries > 0, "#4 should have retried");
+                    Assert.IsTrue(backoff.BusyWaitTime.TotalMilliseconds >= 500, "#5 should have waited for the timeout");
+
+                    transaction.Rollback();
+                }
+            }
+        }
+
+        [TestMethod]
+        public void PoolingTest()
+        {
+            string pooled = _connectionString + ", Pooling=True, Max Pool Size=2, Min Pool Size=1, Default Timeout=1, Statement Cache Size=4";
+            SqliteConnection.ClearAllPools();
+            SqliteConnection.WarmPool(pooled);
+
+            long hits = SqliteConnection.PoolHits;
+            using (var cnn = new SqliteConnection(pooled))
+            {
+                cnn.Open();
+                using (var cmd = new SqliteCommand("SELECT 1", cnn))
+                {
+                    cmd.ExecuteScalar();
+                }
+            }
+            Assert.AreEqual(hits + 1, SqliteConnection.PoolHits, "#1 should have reused the warmed up connection");
+
+            using (var cnn = new SqliteConnection(pooled))
+            {
+                cnn.Open();
+                long cached = cnn.StatementCacheHits;
+                using (var cmd = new SqliteCommand("SELECT 1", cnn))
+                {
+                    cmd.ExecuteScalar();
+                }
+                Assert.AreEqual(cached + 1, cnn.StatementCacheHits, "#2 the pooled connection should keep its prepared statements");
+            }
+
+            using (var first = new SqliteConnection(pooled))
+            using (var second = new SqliteConnection(pooled))
+            {
+                first.Open();
+                second.Open();
+
+                long waits = SqliteConnection.PoolWaits;
+                try
+                {
+                    using (var third = new SqliteConnection(pooled))
+                    {
+                        third.Open();
+                    }
+                    Assert.Fail("#3 should have timed out waiting for a connection");
+                }
+                catch (SqliteException) { }
+                Assert.AreEqual(waits + 1, SqliteConnection.PoolWaits, "#4");
+            }
+
+            SqliteConnection.ClearAllPools();
+        }
+
+        [TestMethod]
+        public void PooledSettingsTest()
+        {
+            string pooled = _connectionString + ", Pooling=True, Max Pool Size=1, Cache Size=1234";
+            SqliteConnection.ClearAllPools();
+
+            using (var cnn = new SqliteConnection(pooled))
+            {
+                cnn.Open();
+                Assert.AreEqual(1234L, new SqliteCommand("PRAGMA cache_size", cnn).ExecuteScalar(), "#1");
+            }
+
+            using (var cnn = new SqliteConnection(pooled))
+            {
+                cnn.Open();
+                Assert.AreEqual(1234L, new SqliteCommand("PRAGMA cache_size", cnn).ExecuteScalar(),
+                                "#2 the pooled connection should keep its settings");
+                new SqliteCommand("PRAGMA cache_size=10", cnn).ExecuteNonQuery();
+            }
+
+            using (var cnn = new SqliteConnection(pooled))
+            {
+                cnn.Open();
+                Assert.AreEqual(1234L, new SqliteCommand("PRAGMA cache_size", cnn).ExecuteScalar(),
+                                "#3 a setting changed on the pooled connection should be set again");
+            }
+
+            SqliteConnection.ClearAllPools();
+        }
+
+        [TestMethod]
+        public void ProfileStatementsTest()
+        {
+            using (var cnn = new SqliteConnection(_connectionString + ", Statement Cache Size=4"))
+            {
+                cnn.Open();
+                new SqliteCommand("CREATE TABLE IF NOT EXISTS profiled (x INTEGER)", cnn).ExecuteNonQuery();
+                new SqliteCommand("DELETE FROM profiled", cnn).ExecuteNonQuery();
+                new SqliteCommand("INSERT INTO profiled VALUES (1); INSERT INTO profiled VALUES (2)", cnn).ExecuteNonQuery();
+                Assert.AreEqual(0, cnn.GetStatementProfiles().Count, "#1 profiling should be off by default");
+
+                cnn.ProfileStatements = true;
+                int completed = 0;
+                cnn.StatementCompleted += (sender, e) => completed++;
+
+                const string sql = "SELECT x FROM profiled ORDER BY x";
+                for (int i = 0; i < 3; i++)
+                {
+                    using (var cmd = new SqliteCommand(sql, cnn))
+                    using (var reader = cmd.ExecuteReader())
+                    {
+                        while (reader.Read()) { }
+                    }
+                }
+
+                var profiles = cnn.GetStatementProfiles();
+                Assert.AreEqual(1, profiles.Count, "#2");
+                Assert.AreEqual(sql, profiles[0].Sql, "#3");
+                Assert.AreEqual(3L, profiles[0].Executions, "#4");
+                Assert.AreEqual(1L, profiles[0].Prepares, "#5 the statement cache should have saved the other prepares");
+                Assert.AreEqual(6L, profiles[0].Rows, "#6");
+                Assert.AreEqual(3, completed, "#7 should have raised one event per execution");
+
+                cnn.ProfileStatements = false;
+                new SqliteCommand(sql, cnn).ExecuteScalar();
+                Assert.AreEqual(0, cnn.GetStatementProfiles().Count, "#8 turning profiling off should discard the profiles");
+                Assert.AreEqual(3, completed, "#9");
+            }
+        }
+
+        [TestMethod]
+        public void BackupDatabaseTest()
+        {
+            using (var cnn = new SqliteConnection(_connectionString))
+            using (var memory = new SqliteConnection("Data Source=:memory:"))
+            {
+                cnn.Open();
+                memory.Open();
+                new SqliteCommand("CREATE TABLE IF NOT EXISTS backedup (x INTEGER, y BLOB)", cnn).ExecuteNonQuery();
+                new SqliteCommand("DELETE FROM backedup", cnn).ExecuteNonQuery();
+                new SqliteCommand("BEGIN", cnn).ExecuteNonQuery();
+                for (int i = 0; i < 100; i++)
+                    new SqliteCommand("INSERT INTO backedup VALUES (" + i + ", randomblob(1000))", cnn).ExecuteNonQuery();
+                new SqliteCommand("COMMIT", cnn).ExecuteNonQuery();
+
+                int steps = 0;
+                int remaining = -1;
+                cnn.BackupDatabase(memory, "main", "main", 4, (source, sourceName, destination, destinationName, pages, remainingPages, totalPages, retry) =>
+                {
+                    steps++;
+                    remaining = remainingPages;
+                    Assert.IsTrue(remainingPages <= totalPages, "#1");
+                    return true;
+                }, 0);
+                Assert.IsTrue(steps > 1, "#2 should have copied the database in several steps");
+                Assert.AreEqual(0, remaining, "#3");
+                Assert.AreEqual(100L, new SqliteCommand("SELECT COUNT(*) FROM backedup", memory).ExecuteScalar(), "#4");
+
+                // and back out of memory again
+                new SqliteCommand("DELETE FROM backedup WHERE x >= 50", memory).ExecuteNonQuery();
+                memory.BackupDatabase(cnn);
+                Assert.AreEqual(50L, new SqliteCommand("SELECT COUNT(*) FROM backedup", cnn).ExecuteScalar(), "#5");
+            }
+        }
+
+        [TestMethod]
+        public void BackupLockedDatabaseTest()
+        {
+            using (var cnn = new SqliteConnection(_connectionString + ", Default Timeout=1"))
+            using (var locker = new SqliteConnection(_connectionString))
+            using (var memory = new SqliteConnection("Data Source=:memory:"))
+            {
+                cnn.Open();
+                locker.Open();
+                memory.Open();
+                using (var cmd = new SqliteCommand("CREATE TABLE IF NOT EXISTS backedup (x INTEGER, y BLOB)", cnn))
+                {
+                    cmd.ExecuteNonQuery();
+                }
+
+                // An exclusive lock keeps readers out, so every step of the backup finds the source locked
+                using (var cmd = new SqliteCommand("BEGIN EXCLUSIVE", locker))
+                {
+                    cmd.ExecuteNonQuery();
+                }
+                try
+                {
+                    int retries = 0;
+                    try
+                    {
+                        cnn.BackupDatabase(memory, "main", "main", -1, (source, sourceName, destination, destinationName, pages, remainingPages, totalPages, retry) =>
+                        {
+                            if (retry)
+                                retries++;
+                            return true;
+                        }, 10);
+                        Assert.Fail("#1 should have given up on the locked database");
+                    }
+                    catch (SqliteException ex)
+                    {
+                        Assert.AreEqual(SQLiteErrorCode.Busy, ex.ErrorCode, "#2");
+                    }
+                    Assert.IsTrue(retries > 1, "#3 should have retried until the timeout");
+                }
+                finally
+                {
+                    using (var cmd = new SqliteCommand("ROLLBACK", locker))
+                    {
+                        cmd.ExecuteNonQuery();
+                    }
+                }
+            }
+        }
+
+        [TestMethod]
+        public void CheckpointTest()
+        {
+            string walConnectionString = "URI=file://" + Path.Combine(dbRootPath, "wal.db") + ", Journal Mode=WAL";
+            using (var checkpointer = new SqliteCheckpointer(walConnectionString))
+            using (var cnn = new SqliteConnection(walConnectionString))
+            {
+                checkpointer.FrameThreshold = 10;
+                cnn.Checkpointer = checkpointer;
+                cnn.Open();
+                using (var cmd = new SqliteCommand("CREATE TABLE IF NOT EXISTS walled (x INTEGER, y BLOB)", cnn))
+                {
+                    cmd.ExecuteNonQuery();
+                }
+                for (int i = 0; i < 50; i++)
+                {
+                    using (var cmd = new SqliteCommand("INSERT INTO walled VALUES (" + i + ", randomblob(2000))", cnn))
+                    {
+                        cmd.ExecuteNonQuery();
+                    }
+                }
+
+                for (int i = 0; i < 100 && checkpointer.Checkpoints == 0; i++)
+                    Task.Delay(20).Wait();
+                Assert.IsTrue(checkpointer.Checkpoints > 0, "#1 the checkpointer should have run in the background");
+                Assert.IsTrue(checkpointer.MaxWalFrames >= 10, "#2");
+                Assert.IsNull(checkpointer.LastError, "#3");
+
+                cnn.Checkpointer = null;
+                checkpointer.Dispose();
+                using (var cmd = new SqliteCommand("PRAGMA wal_autocheckpoint", cnn))
+                {
+                    Assert.AreEqual(1000L, cmd.ExecuteScalar(), "#4 sqlite's own checkpoints should be back");
+                }
+
+                int logFrames;
+                int checkpointedFrames;
+                Assert.IsTrue(cnn.Checkpoint("main", SqliteCheckpointMode.Full, out logFrames, out checkpointedFrames), "#4b");
+                Assert.AreEqual(logFrames, checkpointedFrames, "#4c a full checkpoint should copy the whole log");
+            }
+
+            using (var memory = new SqliteConnection("Data Source=:memory:"))
+            {
+                memory.Open();
+                int logFrames;
+                int checkpointedFrames;
+                Assert.IsTrue(memory.Checkpoint(null, SqliteCheckpointMode.Passive, out logFrames, out checkpointedFrames), "#5");
+                Assert.AreEqual(-1, logFrames, "#6 an in-memory database is not in WAL mode");
+            }
+        }
+
+        [TestMethod]
+        public void MemoryStatusTest()
+        {
+            string tunedConnectionString = "URI=file://" + Path.Combine(dbRootPath, "tuned.db") +
+                                           ", Lookaside Slot Size=128, Lookaside Slot Count=50, Mmap Size=1048576";
+            using (var cnn = new SqliteConnection(tunedConnectionString))
+            {
+                cnn.Open();
+                new SqliteCommand("CREATE TABLE IF NOT EXISTS tuned (x INTEGER)", cnn).ExecuteNonQuery();
+                new SqliteCommand("SELECT count(*) FROM tuned", cnn).ExecuteScalar();
+
+                int current;
+                int highwater;
+                cnn.GetStatus(SqliteConnectionStatus.LookasideUsed, out current, out highwater, false);
+                Assert.IsTrue(highwater <= 50, "#1 the connection has only 50 lookaside slots");
+                cnn.GetStatus(SqliteConnectionStatus.CacheUsed, out current, out highwater, false);
+                Assert.IsTrue(current > 0, "#2");
+
+                long mmapSize = (long)new SqliteCommand("PRAGMA mmap_size", cnn).ExecuteScalar();
+                Assert.IsTrue(mmapSize <= 1048576, "#3 mmap_size is capped by the process-wide maximum");
+
+                // sqlite only takes process-wide settings before the first connection opens
+                try
+                {
+                    SqliteConnection.ConfigureLookaside(64, 10);
+                    Assert.Fail("#4");
+                }
+                catch (SqliteException) { }
+            }
+
+            long memoryUsed;
+            long memoryHighwater;
+            SqliteConnection.GetMemoryStatus(SqliteMemoryStatus.MemoryUsed, out memoryUsed, out memoryHighwater, false);
+            Assert.IsTrue(memoryUsed > 0 && memoryHighwater >= memoryUsed, "#5");
+
+            long limit = SqliteConnection.SoftHeapLimit;
+            SqliteConnection.SoftHeapLimit = 64 * 1024 * 1024;
+            Assert.AreEqual(64L * 1024 * 1024, SqliteConnection.SoftHeapLimit, "#6");
+            SqliteConnection.SoftHeapLimit = limit;
+        }
+
+        [TestMethod]
+        public void ConnectionGroupTest()
+        {
+            string groupConnectionString = "URI=file://" + Path.Combine(dbRootPath, "group.db") + ", Synchronous=Normal";
+            using (var group = new SqliteConnectionGroup(groupConnectionString, 4))
+            {
+                group.Write(cnn =>
+                    {
+                        new SqliteCommand("CREATE TABLE IF NOT EXISTS grouped (x INTEGER)", cnn).ExecuteNonQuery();
+                        new SqliteCommand("DELETE FROM grouped", cnn).ExecuteNonQuery();
+                    }).Wait();
+                Assert.AreEqual("wal", group.Read(cnn => new SqliteCommand("PRAGMA journal_mode", cnn).ExecuteScalar()), "#1");
+
+                group.GroupCommit = true;
+                var writes = new Task[100];
+                for (int i = 0; i < writes.Length; i++)
+                {
+                    int x = i;
+                    writes[i] = group.Write(cnn => new SqliteCommand("INSERT INTO grouped VALUES (" + x + ")", cnn).ExecuteNonQuery());
+                }
+                // A write that fails is rolled back on its own, without the others committed with it
+                Task failed = group.Write(cnn =>
+                    {
+                        new SqliteCommand("INSERT INTO grouped VALUES (-1)", cnn).ExecuteNonQuery();
+                        new SqliteCommand("INSERT INTO nosuchtable VALUES (1)", cnn).ExecuteNonQuery();
+                    });
+                Task.WaitAll(writes);
+                try
+                {
+                    failed.Wait();
+                    Assert.Fail("#2");
+                }
+                catch (AggregateException ex)
+                {
+                    Assert.IsTrue(ex.InnerException is SqliteException, "#3");
+                }
+                Assert.IsTrue(group.Commits <= 101, "#4");
+
+                var reads = new Task<object>[8];
+                for (int i = 0; i < reads.Length; i++)
+                    reads[i] = Task.Factory.StartNew(() => group.Read(cnn => new SqliteCommand("SELECT count(*) FROM grouped WHERE x >= 0", cnn).ExecuteScalar()));
+                foreach (var read in reads)
+                    Assert.AreEqual(100L, read.Result, "#5");
+                Assert.AreEqual(0L, group.Read(cnn => new SqliteCommand("SELECT count(*) FROM grouped WHERE x < 0", cnn).ExecuteScalar()), "#6");
+
+                try
+                {
+                    group.Read(cnn => new SqliteCommand("INSERT INTO grouped VALUES (0)", cnn).ExecuteNonQuery());
+                    Assert.Fail("#7 readers are read-only");
+                }
+                catch (SqliteException) { }
+
+                // The Mono style of comma separated keywords opens the same file as ';' does
+                Assert.AreEqual(Path.Combine(dbRootPath, "group.db"), group.Read(cnn => cnn.DataSource), "#8");
+            }
+        }
     }
 }
\ No newline at end of file
@@ -29,11 +29,13 @@
 
 
 using System;
+using System.Collections.Generic;
 using System.Data;
 using System.IO;
+using System.Text;
 using Mono.Data.Sqlite;
 
-#if SILVERLIGHT && !WINDOWS_PHONE
+#if (SILVERLIGHT && !WINDOWS_PHONE) || DESKTOP
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 #else
 using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
@@ -158,6 +160,41 @@ public void TimestampTest()
             }
         }
 
+        [TestMethod]
+        public void Iso8601DateTimeTest()
+        {
+            _conn.ConnectionString = _connectionString;
+            using (_conn)
+            {
+                _conn.Open();
+                var cmd = (SqliteCommand)_conn.CreateCommand();
+                cmd.CommandText = @"CREATE TABLE IF NOT EXISTS TestIso8601 (d DATETIME); DELETE FROM TestIso8601;
+                    INSERT INTO TestIso8601 VALUES ('2013-01-01T10:20:30Z'), ('2013-01-01 10:20'), ('20130101');";
+                cmd.ExecuteNonQuery();
+
+                var value = new DateTime(2013, 5, 6, 7, 8, 9).AddTicks(1234500);
+                cmd.CommandText = "INSERT INTO TestIso8601 VALUES (:d)";
+                cmd.Parameters.Add(new SqliteParameter(":d", DbType.DateTime) { Value = value });
+                cmd.ExecuteNonQuery();
+
+                cmd = (SqliteCommand)_conn.CreateCommand();
+                cmd.CommandText = "SELECT d, CAST(d AS TEXT) FROM TestIso8601 ORDER BY rowid";
+                using (var reader = cmd.ExecuteReader())
+                {
+                    Assert.IsTrue(reader.Read());
+                    Assert.AreEqual(new DateTime(2013, 1, 1, 10, 20, 30), reader.GetDateTime(0), "#1");
+                    Assert.AreEqual(DateTimeKind.Utc, reader.GetDateTime(0).Kind, "#2");
+                    Assert.IsTrue(reader.Read());
+                    Assert.AreEqual(new DateTime(2013, 1, 1, 10, 20, 0), reader.GetDateTime(0), "#3");
+                    Assert.IsTrue(reader.Read());
+                    Assert.AreEqual(new DateTime(2013, 1, 1), reader.GetDateTime(0), "#4");
+                    Assert.IsTrue(reader.Read());
+                    Assert.AreEqual(value, reader.GetDateTime(0), "#5");
+                    Assert.AreEqual("2013-05-06 07:08:09.12345", reader.GetString(1), "#6");
+                }
+            }
+        }
+
         [TestMethod]
         public void CloseConnectionTest()
         {
@@ -236,5 +273,322 @@ public void TestDataTypes()
                 }
             }
         }
+
+        [TestMethod]
+        public void GetBytesAndStreamTest()
+        {
+            _conn.ConnectionString = _connectionString;
+            using (_conn)
+            {
+                _conn.Open();
+
+                using (var cm = _conn.CreateCommand())
+                {
+                    cm.CommandText = "CREATE TABLE IF NOT EXISTS TestBlob (id INTEGER PRIMARY KEY, data BLOB); DELETE FROM TestBlob; INSERT INTO TestBlob (data) VALUES (X'0102030405'); INSERT INTO TestBlob (data) VALUES (X'0A0B');";
+                    cm.ExecuteNonQuery();
+                }
+
+                using (var cm = _conn.CreateCommand())
+                {
+                    cm.CommandText = "SELECT data FROM TestBlob ORDER BY id";
+                    using (var dr = cm.ExecuteReader())
+                    {
+                        Assert.IsTrue(dr.Read());
+                        Assert.AreEqual(5L, dr.GetBytes(0, 0, null, 0, 0), "#1");
+
+                        var buffer = new byte[8];
+                        Assert.AreEqual(4L, dr.GetBytes(0, 1, buffer, 3, 10), "#2");
+                        Assert.AreEqual(0, buffer[2], "#3");
+                        Assert.AreEqual(2, buffer[3], "#4");
+                        Assert.AreEqual(5, buffer[6], "#5");
+
+                        var stream = dr.GetStream(0);
+                        Assert.AreEqual(5L, stream.Length, "#6");
+                        stream.Position = 3;
+                        Assert.AreEqual(4, stream.ReadByte(), "#7");
+                        Assert.AreEqual(5, stream.ReadByte(), "#8");
+                        Assert.AreEqual(-1, stream.ReadByte(), "#9");
+                        stream.Position = (long)int.MaxValue + 4;
+                        Assert.AreEqual(-1, stream.ReadByte(), "#10");
+
+                        stream.Position = 0;
+                        Assert.AreEqual(5L, dr.GetBytes(0, 0, null, 0, 0), "#11");
+                        Assert.AreEqual(1, stream.ReadByte(), "#12");
+
+                        Assert.IsTrue(dr.Read());
+                        try
+                        {
+                            stream.ReadByte();
+                            Assert.Fail("Expected: InvalidOperationException");
+                        }
+                        catch (InvalidOperationException)
+                        {
+                            // the stream only covers the row it was opened on
+                        }
+
+                        stream = dr.GetStream(0);
+                        Assert.IsNotNull(dr.GetString(0), "#13");
+                        try
+                        {
+                            stream.ReadByte();
+                            Assert.Fail("Expected: InvalidOperationException");
+                        }
+                        catch (InvalidOperationException)
+                        {
+                            // reading the column as text may have freed the memory the stream was reading
+                        }
+                    }
+                }
+            }
+        }
+
+        [TestMethod]
+        public void GetCharsAndTextReaderTest()
+        {
+            _conn.ConnectionString = _connectionString;
+            using (_conn)
+            {
+                _conn.Open();
+
+                // Long enough to be decoded in several pieces, with two byte characters split between them
+                string text = new string('\u00e9', 3000) + "end";
+                using (var cm = _conn.CreateCommand())
+                {
+                    cm.CommandText = "CREATE TABLE IF NOT EXISTS TestText (id INTEGER PRIMARY KEY, s TEXT); DELETE FROM TestText; INSERT INTO TestText (s) VALUES (:s); INSERT INTO TestText (s) VALUES ('');";
+                    cm.Parameters.Add(new SqliteParameter("s", text));
+                    cm.ExecuteNonQuery();
+                }
+
+                using (var cm = _conn.CreateCommand())
+                {
+                    cm.CommandText = "SELECT s FROM TestText ORDER BY id";
+                    using (var dr = cm.ExecuteReader())
+                    {
+                        Assert.IsTrue(dr.Read());
+                        Assert.AreEqual(3003L, dr.GetChars(0, 0, null, 0, 0), "#1");
+
+                        var buffer = new char[1024];
+                        var chunks = new StringBuilder();
+                        long offset = 0, n;
+                        while ((n = dr.GetChars(0, offset, buffer, 0, buffer.Length)) > 0)
+                        {
+                            chunks.Append(buffer, 0, (int)n);
+                            offset += n;
+                        }
+                        Assert.AreEqual(text, chunks.ToString(), "#2");
+
+                        var reader = dr.GetTextReader(0);
+                        Assert.AreEqual('\u00e9', (char)reader.Peek(), "#3");
+                        Assert.AreEqual(text, reader.ReadToEnd(), "#4");
+                        Assert.AreEqual(-1, reader.Read(), "#5");
+
+                        reader = dr.GetTextReader(0);
+                        Assert.AreEqual(text, dr.GetValue(0), "#5a");
+                        try
+                        {
+                            reader.Read();
+                            Assert.Fail("Expected: InvalidOperationException");
+                        }
+                        catch (InvalidOperationException)
+                        {
+                            // reading the column another way may have freed the memory the reader was reading
+                        }
+
+                        Assert.IsTrue(dr.Read());
+                        Assert.AreEqual(0L, dr.GetChars(0, 0, null, 0, 0), "#6");
+                        Assert.AreEqual(-1, dr.GetTextReader(0).Read(), "#7");
+                        try
+                        {
+                            reader.Read();
+                            Assert.Fail("Expected: InvalidOperationException");
+                        }
+                        catch (InvalidOperationException)
+                        {
+                            // the reader only covers the row it was opened on
+                        }
+                    }
+                }
+            }
+        }
+
+        [TestMethod]
+        public void ReadBlockTest()
+        {
+            _conn.ConnectionString = _connectionString;
+            using (_conn)
+            {
+                _conn.Open();
+
+                using (var cm = _conn.CreateCommand())
+                {
+                    cm.CommandText = "CREATE TABLE IF NOT EXISTS TestBlock (id INTEGER PRIMARY KEY, n INTEGER, s TEXT, data BLOB); DELETE FROM TestBlock; "
+                        + "INSERT INTO TestBlock (n, s, data) VALUES (1, 'a', X'01'); INSERT INTO TestBlock (n, s, data) VALUES (NULL, 'b', X'0203'); "
+                        + "INSERT INTO TestBlock (n, s, data) VALUES (3, NULL, NULL); INSERT INTO TestBlock (n, s, data) VALUES (4, 'd', X'04050607');";
+                    cm.ExecuteNonQuery();
+                }
+
+                using (var cm = _conn.CreateCommand())
+                {
+                    cm.CommandText = "SELECT n, s, data FROM TestBlock ORDER BY id";
+                    using (var dr = cm.ExecuteReader())
+                    {
+                        var block = new SqliteRowBlock(3);
+                        Assert.AreEqual(3, dr.ReadBlock(block), "#1");
+                        Assert.AreEqual(3, block.FieldCount, "#2");
+                        Assert.AreEqual(1L, block.GetInt64(0, 0), "#3");
+                        Assert.IsTrue(block.IsDBNull(1, 0), "#4");
+                        Assert.AreEqual("b", block.GetString(1, 1), "#5");
+                        Assert.AreEqual(2, block.GetBytes(1, 2).Length, "#6");
+                        Assert.AreEqual(DBNull.Value, block.GetValue(2, 2), "#7");
+
+                        // Read() carries on after the last row of the block
+                        Assert.IsTrue(dr.Read(), "#8");
+                        Assert.AreEqual(4L, dr.GetInt64(0), "#9");
+                        Assert.AreEqual(0, dr.ReadBlock(block), "#10");
+                        Assert.IsFalse(dr.Read(), "#11");
+                    }
+                }
+            }
+        }
+
+        public enum RecordKind
+        {
+            None,
+            Small,
+            Large
+        }
+
+        public class Record
+        {
+            public long Id { get; set; }
+            public int? N { get; set; }
+            public string S { get; set; }
+            public byte[] Data { get; set; }
+            public RecordKind Kind { get; set; }
+            public double Unmatched { get; set; }
+        }
+
+        [TestMethod]
+        public void GetRecordTest()
+        {
+            _conn.ConnectionString = _connectionString;
+            using (_conn)
+            {
+                _conn.Open();
+
+                using (var cm = _conn.CreateCommand())
+                {
+                    cm.CommandText = "CREATE TABLE IF NOT EXISTS TestRecord (id INTEGER PRIMARY KEY, n INTEGER, s TEXT, data BLOB); DELETE FROM TestRecord; "
+                        + "INSERT INTO TestRecord (n, s, data) VALUES (1, 'a', X'01'); INSERT INTO TestRecord (n, s, data) VALUES (NULL, NULL, NULL);";
+                    cm.ExecuteNonQuery();
+                }
+
+                using (var cm = _conn.CreateCommand())
+                {
+                    cm.CommandText = "SELECT id, n, s, data, n + 1 AS kind FROM TestRecord ORDER BY id";
+                    using (var dr = cm.ExecuteReader())
+                    {
+                        Assert.AreEqual(4, dr.GetOrdinal("Kind"), "#1");
+                        Assert.AreEqual(2, dr.GetOrdinal("S"), "#2");
+
+                        Assert.IsTrue(dr.Read());
+                        Record first = dr.GetRecord<Record>();
+                        Assert.AreEqual(1L, first.Id, "#3");
+                        Assert.AreEqual(1, first.N, "#4");
+                        Assert.AreEqual("a", first.S, "#5");
+                        Assert.AreEqual(1, first.Data.Length, "#6");
+                        Assert.AreEqual(RecordKind.Large, first.Kind, "#7");
+                        Assert.AreEqual(0.0, first.Unmatched, "#8");
+
+                        List<Record> rest = dr.ReadRecords<Record>();
+                        Assert.AreEqual(1, rest.Count, "#9");
+                        Assert.IsNull(rest[0].N, "#10");
+                        Assert.IsNull(rest[0].S, "#11");
+                        Assert.IsNull(rest[0].Data, "#12");
+                        Assert.AreEqual(RecordKind.None, rest[0].Kind, "#13");
+                    }
+
+                    // The mapping kept for the text is used again
+                    List<Record> all = cm.ExecuteQuery<Record>();
+                    Assert.AreEqual(2, all.Count, "#14");
+                    Assert.AreEqual("a", all[0].S, "#15");
+                }
+            }
+        }
+
+        [TestMethod]
+        public void BlobStreamTest()
+        {
+            _conn.ConnectionString = _connectionString;
+            using (_conn)
+            {
+                _conn.Open();
+
+                using (var cm = _conn.CreateCommand())
+                {
+                    cm.CommandText = "CREATE TABLE IF NOT EXISTS TestBlobStream (id INTEGER PRIMARY KEY, data BLOB); DELETE FROM TestBlobStream; INSERT INTO TestBlobStream (id, data) VALUES (1, zeroblob(100000)); INSERT INTO TestBlobStream (id, data) VALUES (2, X'0A0B');";
+                    cm.ExecuteNonQuery();
+                }
+
+                using (var stream = _conn.OpenBlob("TestBlobStream", "data", 1, true))
+                {
+                    Assert.AreEqual(100000L, stream.Length, "#1");
+                    var chunk = new byte[4096];
+                    for (int i = 0; i < chunk.Length; i++)
+                        chunk[i] = (byte)i;
+                    while (stream.Position < stream.Length)
+                        stream.Write(chunk, 0, (int)Math.Min(chunk.Length, stream.Length - stream.Position));
+
+                    try
+                    {
+                        stream.WriteByte(0);
+                        Assert.Fail("Expected: NotSupportedException");
+                    }
+                    catch (NotSupportedException)
+                    {
+                        // a blob cannot grow
+                    }
+
+                    stream.Reopen(2);
+                    Assert.AreEqual(2L, stream.Length, "#2");
+                    Assert.AreEqual(0x0A, stream.ReadByte(), "#3");
+                }
+
+                using (var cm = _conn.CreateCommand())
+                {
+                    cm.CommandText = "SELECT id, data FROM TestBlobStream WHERE id = 1";
+                    using (var dr = cm.ExecuteReader())
+                    {
+                        Assert.IsTrue(dr.Read());
+                        using (var stream = dr.GetBlobStream(1, false))
+                        {
+                            Assert.IsFalse(stream.CanWrite, "#4");
+                            stream.Position = 99999;
+                            Assert.AreEqual(99999 % 4096 % 256, stream.ReadByte(), "#5");
+                            Assert.AreEqual(-1, stream.ReadByte(), "#6");
+                        }
+                    }
+                }
+
+                using (var cm = _conn.CreateCommand())
+                {
+                    cm.CommandText = "CREATE TABLE IF NOT EXISTS TestBlobStreamKey (a INTEGER, b INTEGER, data BLOB, PRIMARY KEY (a, b)); DELETE FROM TestBlobStreamKey; INSERT INTO TestBlobStreamKey VALUES (1, 1, X'0A0B');";
+                    cm.ExecuteNonQuery();
+                    cm.CommandText = "SELECT a, data FROM TestBlobStreamKey";
+                    using (var dr = cm.ExecuteReader())
+                    {
+                        Assert.IsTrue(dr.Read());
+                        try
+                        {
+                            dr.GetBlobStream(1, false);
+                            Assert.Fail("#7 a column of a composite key is not the rowid");
+                        }
+                        catch (InvalidOperationException)
+                        {
+                        }
+                    }
+                }
+            }
+        }
     }
 }
\ No newline at end of file
@@ -9,7 +9,7 @@
 using System.Text;
 using Mono.Data.Sqlite;
 
-#if SILVERLIGHT && !WINDOWS_PHONE
+#if (SILVERLIGHT && !WINDOWS_PHONE) || DESKTOP
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 #else
 using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
@@ -9,7 +9,7 @@
 using System.Text;
 using Mono.Data.Sqlite;
 
-#if SILVERLIGHT && !WINDOWS_PHONE
+#if (SILVERLIGHT && !WINDOWS_PHONE) || DESKTOP
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 #else
 using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
@@ -99,5 +99,82 @@ public void InsertRandomValuesWithParameter()
                 }
             }
         }
+
+        [TestMethod]
+        public void InsertNonAsciiTextWithParameter()
+        {
+            // Mixes ASCII runs with multi-byte UTF-8 and a surrogate pair, so the byte length differs from the char count
+            string textValue = "plain ascii prefix \u00e9\u00e8 \u05D0\u05D1\u05D2 \uD83D\uDE00 suffix";
+
+            SqliteCommand createCommand = new SqliteCommand("CREATE TABLE IF NOT EXISTS t2(t TEXT);", _conn);
+            SqliteCommand insertCmd = new SqliteCommand("DELETE FROM t2; INSERT INTO t2 (t) VALUES(:textP)", _conn);
+            insertCmd.Parameters.Add(new SqliteParameter("textP", textValue));
+            SqliteCommand selectCmd = new SqliteCommand("SELECT t, length(t) from t2", _conn);
+
+            using (_conn)
+            {
+                _conn.Open();
+                createCommand.ExecuteNonQuery();
+                Assert.AreEqual(1, insertCmd.ExecuteNonQuery());
+
+                using (IDataReader reader = selectCmd.ExecuteReader())
+                {
+                    Assert.IsTrue(reader.Read());
+                    Assert.AreEqual(textValue, reader.GetString(0));
+                    // sqlite counts characters, where the surrogate pair is a single one
+                    Assert.AreEqual((long)(textValue.Length - 1), reader.GetInt64(1));
+                }
+            }
+        }
+
+        [TestMethod]
+        public void InsertWithTypedParameters()
+        {
+            SqliteCommand createCommand = new SqliteCommand("CREATE TABLE IF NOT EXISTS t3(i INTEGER, f FLOAT, t TEXT, n INTEGER);", _conn);
+            SqliteCommand insertCmd = new SqliteCommand("INSERT INTO t3 (i, f, t, n) VALUES(:i, $f, @t, :n)", _conn);
+            // Names given without a prefix match whichever one the SQL uses
+            SqliteParameter<long> i = insertCmd.Parameters.AddWithTypedValue("i", 0L);
+            SqliteParameter<double> f = insertCmd.Parameters.AddWithTypedValue("$f", 0.0);
+            SqliteParameter<string> t = insertCmd.Parameters.AddWithTypedValue("t", (string)null);
+            SqliteParameter<int?> n = insertCmd.Parameters.AddWithTypedValue("n", (int?)null);
+            SqliteCommand selectCmd = new SqliteCommand("SELECT i, f, t, n from t3 ORDER BY i", _conn);
+
+            using (_conn)
+            {
+                _conn.Open();
+                createCommand.ExecuteNonQuery();
+                new SqliteCommand("DELETE FROM t3", _conn).ExecuteNonQuery();
+
+                for (int x = 0; x < 3; x++)
+                {
+                    i.TypedValue = x;
+                    f.TypedValue = x / 2.0;
+                    t.TypedValue = "row " + x;
+                    n.TypedValue = x == 1 ? (int?)null : x * 10;
+                    Assert.AreEqual(1, insertCmd.ExecuteNonQuery());
+                }
+
+                // Anything else goes through the usual conversions
+                i.Value = "3";
+                t.Value = DBNull.Value;
+                Assert.AreEqual(1, insertCmd.ExecuteNonQuery());
+
+                using (IDataReader reader = selectCmd.ExecuteReader())
+                {
+                    for (int x = 0; x < 3; x++)
+                    {
+                        Assert.IsTrue(reader.Read());
+                        Assert.AreEqual((long)x, reader.GetInt64(0));
+                        Assert.AreEqual(x / 2.0, reader.GetDouble(1));
+                        Assert.AreEqual("row " + x, reader.GetString(2));
+                        Assert.AreEqual(x == 1, reader.IsDBNull(3));
+                    }
+                    Assert.IsTrue(reader.Read());
+                    Assert.AreEqual(3L, reader.GetInt64(0));
+                    Assert.IsTrue(reader.IsDBNull(2));
+                    Assert.IsFalse(reader.Read());
+                }
+            }
+        }
     }
 }
\ No newline at end of file
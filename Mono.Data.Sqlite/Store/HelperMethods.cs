@@ -21,6 +21,18 @@ public static Type GetUnderlyingSystemType(this Type type)
         {
             return type;
         }
+        public static MethodInfo GetSetMethod(this PropertyInfo property)
+        {
+            return property.SetMethod;
+        }
+        public static MethodInfo GetGetMethod(this PropertyInfo property)
+        {
+            return property.GetMethod;
+        }
+        public static Delegate CreateOpenDelegate(this MethodInfo method, Type delegateType)
+        {
+            return method.CreateDelegate(delegateType);
+        }
 #else
         public static bool IsEnum(this Type type)
         {
@@ -30,6 +42,10 @@ public static Type GetUnderlyingSystemType(this Type type)
         {
             return type.UnderlyingSystemType;
         }
+        public static Delegate CreateOpenDelegate(this MethodInfo method, Type delegateType)
+        {
+            return Delegate.CreateDelegate(delegateType, method);
+        }
 #endif
     }
 }
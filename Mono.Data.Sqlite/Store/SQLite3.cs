@@ -9,6 +9,9 @@ namespace Mono.Data.Sqlite
 {
     using System;
     using System.Data;
+    using System.Globalization;
+    using System.Threading;
+    using System.Threading.Tasks;
     using MonoDataSqliteWrapper;
 #if SILVERLIGHT
 #else
@@ -26,11 +29,54 @@ internal class SQLite3 : SQLiteBase
         protected SqliteConnectionHandle _sql;
 
         protected string _fileName;
-        protected bool _usePool;
+        /// <summary>
+        /// The pool the connection goes back to when closed, or null if it isn't pooled
+        /// </summary>
+        protected SqliteConnectionPool.Pool _pool;
         protected int _poolVersion = 0;
 
+        /// <summary>
+        /// The statements cached on this connection, which stay with the handle while it waits in the pool
+        /// </summary>
+        protected SqliteStatementCache _statementCache;
+
+        /// <summary>
+        /// The PRAGMA commands known to hold on the handle, which also stay with it while it waits in the pool
+        /// </summary>
+        protected string _settings;
+
         private bool _buildingSchema = false;
 
+        /// <summary>
+        /// Whether a WAL hook has replaced sqlite's automatic checkpoints on the handle
+        /// </summary>
+        private bool _walHook;
+
+        /// <summary>
+        /// The automatic checkpoint threshold of the handle before the WAL hook replaced it
+        /// </summary>
+        private long _walAutoCheckpoint;
+
+        /// <summary>
+        /// How to wait when the database is locked, replaced by the connection's own through SetBusyWait()
+        /// </summary>
+        protected SqliteBusyWait _busyWait = new SqliteBusyWait(SqliteBusyStrategy.Backoff);
+
+        /// <summary>
+        /// Interrupts the step in progress once its command's timeout expires or its cancellation token is cancelled
+        /// </summary>
+        private readonly SqliteDeadline _deadline = new SqliteDeadline();
+
+        /// <summary>
+        /// Whether the deadline's progress handler is registered on the handle
+        /// </summary>
+        private bool _progressHandler;
+
+        /// <summary>
+        /// Where the timings and counters of the statements go, or null unless the connection is profiling them
+        /// </summary>
+        protected SqliteProfiler _profiler;
+
         /// <summary>
         /// The user-defined functions registered on this connection
         /// </summary>
@@ -55,18 +101,39 @@ internal override void Close()
         {
             if (_sql != null)
             {
-                if (_usePool)
+                if (_pool != null)
                 {
+                    if (_statementCache != null)
+                    {
+                        _statementCache.Detach();
+                    }
                     ResetConnection(_sql);
-                    SqliteConnectionPool.Add(_fileName, _sql, _poolVersion);
+                    // The hooks call back into this connection, which the next owner of the handle is not
+                    UnsafeNativeMethods.sqlite3_update_hook(_sql, null, null);
+                    UnsafeNativeMethods.sqlite3_commit_hook(_sql, null, null);
+                    UnsafeNativeMethods.sqlite3_rollback_hook(_sql, null, null);
+                    UnsafeNativeMethods.sqlite3_trace_v2(_sql, 0, null, null);
+                    UnsafeNativeMethods.sqlite3_busy_handler(_sql, null, null);
+                    if (_walHook) SetWalHook(null);
+                    if (_progressHandler) UnsafeNativeMethods.sqlite3_progress_handler(_sql, 0, null, null);
+                    SqliteConnectionPool.Add(_pool, _poolVersion, _sql, _statementCache, _settings);
                 }
                 else
                 {
+                    // Cached statements have to be finalized before the handle is closed
+                    if (_statementCache != null)
+                    {
+                        _statementCache.Dispose();
+                    }
                     _sql.Dispose();
                 }
             }
 
             _sql = null;
+            _pool = null;
+            _statementCache = null;
+            _settings = null;
+            _progressHandler = false;
         }
 
         internal override void Cancel()
@@ -89,42 +156,94 @@ internal override int Changes
             get { return UnsafeNativeMethods.sqlite3_changes(_sql); }
         }
 
-        internal override void Open(string strFilename, SQLiteOpenFlagsEnum flags, int maxPoolSize, bool usePool)
+        internal override void Open(string strFilename, SQLiteOpenFlagsEnum flags, SqliteConnectionPool.Options poolOptions)
         {
             if (_sql != null)
             {
                 return;
             }
 
-            _usePool = usePool;
-            if (usePool)
+            _pool = null;
+            if (poolOptions != null)
             {
+                SqliteStatementCache statementCache;
                 _fileName = strFilename;
-                _sql = SqliteConnectionPool.Remove(strFilename, maxPoolSize, out _poolVersion);
+                _sql = SqliteConnectionPool.Remove(strFilename, poolOptions, out _pool, out _poolVersion, out statementCache,
+                                                   out _settings);
+
+                _statementCache = statementCache;
+                if (_statementCache != null)
+                {
+                    _statementCache.Attach(this);
+                }
             }
 
             if (_sql == null)
             {
-                if ((flags & SQLiteOpenFlagsEnum.Create) == 0 && FileExists(strFilename) == false)
+                try
                 {
-                    throw new SqliteException((int)SQLiteErrorCode.CantOpen, strFilename);
-                }
+                    if ((flags & SQLiteOpenFlagsEnum.Create) == 0 && FileExists(strFilename) == false)
+                    {
+                        throw new SqliteException((int)SQLiteErrorCode.CantOpen, strFilename);
+                    }
 
-                SqliteConnectionHandle db;
-                int n = UnsafeNativeMethods.sqlite3_open_v2(ToUTF8(strFilename), out db, (int)flags, string.Empty);
-                if (n > 0)
+                    _sql = OpenHandle(strFilename, flags);
+                }
+                catch
                 {
-                    throw new SqliteException(n, null);
+                    // Give up the place the pool kept for this connection
+                    if (_pool != null)
+                    {
+                        SqliteConnectionPool.Release(_pool);
+                        _pool = null;
+                    }
+                    throw;
                 }
-
-                _sql = db;
             }
             // Bind functions to this connection.  If any previous functions of the same name
             // were already bound, then the new bindings replace the old.
             _functionsArray = SqliteFunction.BindFunctions(this);
+            // This also removes any busy handler left behind by the previous owner of a pooled connection
             SetTimeout(0);
         }
 
+        /// <summary>
+        /// Opens a new connection to the database
+        /// </summary>
+        protected virtual SqliteConnectionHandle OpenHandle(string strFilename, SQLiteOpenFlagsEnum flags)
+        {
+            SqliteConnectionHandle db;
+            int n = UnsafeNativeMethods.sqlite3_open_v2(ToUTF8(strFilename), out db, (int)flags, string.Empty);
+            if (n > 0)
+            {
+                throw new SqliteException(n, null);
+            }
+
+            return db;
+        }
+
+        internal override SqliteStatementCache GetStatementCache(int cacheSize)
+        {
+            if (_statementCache != null && _statementCache.Capacity != cacheSize)
+            {
+                _statementCache.Dispose();
+                _statementCache = null;
+            }
+
+            if (_statementCache == null && cacheSize > 0)
+            {
+                _statementCache = new SqliteStatementCache(this, cacheSize);
+            }
+
+            return _statementCache;
+        }
+
+        internal override string Settings
+        {
+            get { return _settings; }
+            set { _settings = value; }
+        }
+
         internal override void ClearPool()
         {
             SqliteConnectionPool.ClearPool(_fileName);
@@ -136,12 +255,230 @@ internal override void SetTimeout(int timeout)
             if (n > 0) throw new SqliteException(n, SQLiteLastError());
         }
 
+        internal override void SetBusyWait(SqliteBusyWait busyWait)
+        {
+            _busyWait = busyWait;
+
+            if (busyWait.Strategy == SqliteBusyStrategy.Native &&
+                UnsafeNativeMethods.sqlite3_busy_handler(_sql, busyWait.OnBusy, null) > 0)
+            {
+                // Not every wrapper can register a busy handler, in which case the retries happen in Step() and Prepare()
+                busyWait.Strategy = SqliteBusyStrategy.Backoff;
+            }
+        }
+
+        internal override void SetProfiler(SqliteProfiler profiler)
+        {
+            _profiler = profiler;
+
+            // The wrapper may not be able to trace, in which case the profiles have no engine time
+            UnsafeNativeMethods.sqlite3_trace_v2(_sql, 2, // SQLITE_TRACE_PROFILE
+                                                 (profiler != null) ? profiler.TraceCallback : null, null);
+        }
+
         internal override bool Step(SqliteStatement stmt)
         {
-            var rnd = new Random();
+            if (_profiler == null)
+            {
+                return StepStatement(stmt);
+            }
 
-            var starttick = (uint)Environment.TickCount;
-            var timeout = (uint)(stmt._command._commandTimeout * 1000);
+            TimeSpan busyTime = _busyWait.WaitTime;
+            long start = _profiler.Stepping(stmt);
+            bool row = false;
+            try
+            {
+                row = StepStatement(stmt);
+                return row;
+            }
+            finally
+            {
+                _profiler.Stepped(stmt, start, row ? 1 : 0, _busyWait.WaitTime - busyTime);
+            }
+        }
+
+        private bool StepStatement(SqliteStatement stmt)
+        {
+            int attempt = 0;
+            _busyWait.Start((uint)(stmt._command._commandTimeout * 1000));
+            StartDeadline(stmt, CancellationToken.None);
+
+            try
+            {
+                while (true)
+                {
+                    bool row;
+                    int r = TryStepStatement(stmt, out row);
+                    if (r == 0)
+                    {
+                        return row;
+                    }
+
+                    // Keep trying after a short wait, unless the busy strategy says to give up or the command's
+                    // timeout has expired
+                    if (!_busyWait.Wait(attempt++))
+                    {
+                        throw new SqliteException(r, SQLiteLastError());
+                    }
+                }
+            }
+            finally
+            {
+                _deadline.Stop();
+            }
+        }
+
+        /// <summary>
+        /// Starts the clock of the command's timeout for a step.  The progress handler is only registered while steps
+        /// have a timeout or a cancellation token, since sqlite runs a little slower with one.
+        /// </summary>
+        private void StartDeadline(SqliteStatement stmt, CancellationToken cancellationToken)
+        {
+            _deadline.Start((uint)(stmt._command._commandTimeout * 1000), cancellationToken);
+
+            bool armed = _deadline.Armed;
+            if (armed != _progressHandler)
+            {
+                SqliteProgressHandlerDelegate callback = null;
+                if (armed) callback = _deadline.OnProgress;
+                UnsafeNativeMethods.sqlite3_progress_handler(_sql, SqliteDeadline.Interval, callback, null);
+                _progressHandler = armed;
+            }
+        }
+
+        internal override Task<bool> StepAsync(SqliteStatement stmt, SqliteWorker worker, CancellationToken cancellationToken)
+        {
+            var result = new TaskCompletionSource<bool>();
+            StepAsync(stmt, worker, cancellationToken, -1, null, result);
+            return result.Task;
+        }
+
+        /// <summary>
+        /// Makes one attempt at stepping the statement on the worker, then, if the database was locked, waits for the
+        /// next attempt with a timer
+        /// </summary>
+        /// <param name="attempt">The number of retries already made, or -1 for the first attempt</param>
+        /// <param name="execution">What the profiler started counting at the first attempt, if profiling</param>
+        private void StepAsync(SqliteStatement stmt, SqliteWorker worker, CancellationToken cancellationToken, int attempt,
+                               AsyncStep execution, TaskCompletionSource<bool> result)
+        {
+            string lockedError = null;
+            Task<int> step = worker.Run(() =>
+                {
+                    if (attempt < 0)
+                    {
+                        _busyWait.Start((uint)(stmt._command._commandTimeout * 1000));
+                        if (_profiler != null)
+                        {
+                            execution = new AsyncStep();
+                            execution.BusyTime = _busyWait.WaitTime;
+                            execution.Start = _profiler.Stepping(stmt);
+                        }
+                    }
+
+                    bool row = false;
+                    StartDeadline(stmt, cancellationToken);
+                    try
+                    {
+                        int r = TryStepStatement(stmt, out row);
+                        if (r != 0)
+                        {
+                            lockedError = SQLiteLastError();
+                            return r;
+                        }
+                    }
+                    catch (Exception)
+                    {
+                        EndAsyncStep(stmt, execution, 0);
+                        throw;
+                    }
+                    finally
+                    {
+                        _deadline.Stop();
+                    }
+
+                    EndAsyncStep(stmt, execution, row ? 1 : 0);
+                    return row ? 1 : 0;
+                }, cancellationToken);
+
+            step.ContinueWith(t =>
+                {
+                    if (t.IsCanceled)
+                    {
+                        EndAsyncStep(stmt, execution, 0);
+                        result.TrySetCanceled();
+                        return;
+                    }
+                    if (t.IsFaulted)
+                    {
+                        result.TrySetException(t.Exception.InnerExceptions);
+                        return;
+                    }
+                    if (t.Result < 2)
+                    {
+                        result.TrySetResult(t.Result == 1);
+                        return;
+                    }
+
+                    // The database is locked: wait for the next attempt without holding any thread
+                    _busyWait.WaitAsync(attempt + 1, cancellationToken).ContinueWith(w =>
+                        {
+                            if (w.IsCanceled || w.Result == false)
+                            {
+                                EndAsyncStep(stmt, execution, 0);
+                                if (w.IsCanceled)
+                                    result.TrySetCanceled();
+                                else
+                                    result.TrySetException(new SqliteException(t.Result, lockedError));
+                                return;
+                            }
+
+                            // The worker refuses the next attempt once the connection has closed during the wait
+                            try
+                            {
+                                StepAsync(stmt, worker, cancellationToken, attempt + 1, execution, result);
+                            }
+                            catch (Exception ex)
+                            {
+                                EndAsyncStep(stmt, execution, 0);
+                                result.TrySetException(ex);
+                            }
+                        }, TaskContinuationOptions.ExecuteSynchronously);
+                }, TaskContinuationOptions.ExecuteSynchronously);
+        }
+
+        /// <summary>
+        /// What the profiler needs to finish counting an asynchronous step
+        /// </summary>
+        private sealed class AsyncStep
+        {
+            internal long Start;
+            internal TimeSpan BusyTime;
+            internal bool Ended;
+        }
+
+        private void EndAsyncStep(SqliteStatement stmt, AsyncStep execution, int rows)
+        {
+            if (execution != null && execution.Ended == false && _profiler != null)
+            {
+                execution.Ended = true;
+                _profiler.Stepped(stmt, execution.Start, rows, _busyWait.WaitTime - execution.BusyTime);
+            }
+        }
+
+        /// <summary>
+        /// Makes a single attempt at stepping a statement.  A statement whose schema changed is prepared again and
+        /// retried right away; one that found the database locked is reset and left for the caller to retry.
+        /// </summary>
+        /// <param name="stmt">The statement to step</param>
+        /// <param name="row">Set to true if the step returned a row</param>
+        /// <returns>0 if the statement stepped, or SQLITE_BUSY or SQLITE_LOCKED</returns>
+        private int TryStepStatement(SqliteStatement stmt, out bool row)
+        {
+            if (stmt._changesSettings)
+            {
+                _settings = null;
+            }
 
             while (true)
             {
@@ -149,19 +486,23 @@ internal override bool Step(SqliteStatement stmt)
 
                 if (n == 100)
                 {
-                    return true;
+                    row = true;
+                    return 0;
                 }
                 if (n == 101)
                 {
-                    return false;
+                    row = false;
+                    return 0;
                 }
 
                 if (n > 0)
                 {
+                    CheckDeadline(stmt, n);
+
                     // An error occurred, attempt to reset the statement.  If the reset worked because the
                     // schema has changed, re-try the step again.  If it errored our because the database
                     // is locked, then keep retrying until the command timeout occurs.
-                    int r = this.Reset(stmt);
+                    int r = ResetStatement(stmt);
 
                     if (r == 0)
                     {
@@ -170,40 +511,60 @@ internal override bool Step(SqliteStatement stmt)
                     
                     if ((r == 6 || r == 5) && stmt._command != null) // SQLITE_LOCKED || SQLITE_BUSY
                     {
-                        // Keep trying, but if we've exceeded the command's timeout, give up and throw an error
-                        if ((uint)Environment.TickCount - starttick > timeout)
-                        {
-                            throw new SqliteException(r, SQLiteLastError());
-                        }
-                        
-                        // Otherwise sleep for a random amount of time up to 150ms
-                        Sleep(rnd.Next(1, 150));
+                        row = false;
+                        return r;
                     }
                 }
             }
         }
 
+        /// <summary>
+        /// Fails a step that the deadline interrupted with a timeout rather than with the interruption
+        /// </summary>
+        /// <param name="stmt">The statement that failed to step, which is reset</param>
+        /// <param name="n">The error the step returned</param>
+        private void CheckDeadline(SqliteStatement stmt, int n)
+        {
+            if (n == 9 && _deadline.Expired) // SQLITE_INTERRUPT
+            {
+                UnsafeNativeMethods.sqlite3_reset(stmt._sqlite_stmt);
+                throw new SqliteException(n, "The command timeout expired");
+            }
+        }
+
         internal override int Reset(SqliteStatement stmt)
+        {
+            if (stmt._execution == null)
+            {
+                return ResetStatement(stmt);
+            }
+
+            // sqlite reports the run time of a statement that did not step to the end when it is reset
+            if (_profiler != null)
+            {
+                _profiler.Resetting(stmt);
+            }
+            try
+            {
+                return ResetStatement(stmt);
+            }
+            finally
+            {
+                EndExecution(stmt);
+            }
+        }
+
+        private int ResetStatement(SqliteStatement stmt)
         {
             int n = UnsafeNativeMethods.sqlite3_reset(stmt._sqlite_stmt);
 
             // If the schema changed, try and re-prepare it
             if (n == 17) // SQLITE_SCHEMA
             {
-                // Recreate a dummy statement
-                var timeout = (uint)(stmt._command._commandTimeout * 1000);
-                string str;
-                using (SqliteStatement tmp = Prepare(null, stmt._sqlStatement, null, timeout, out str))
-                {
-                    // Finalize the existing statement
-                    stmt._sqlite_stmt.Dispose();
-                    // Reassign a new statement pointer to the old statement and clear the temporary one
-                    stmt._sqlite_stmt = tmp._sqlite_stmt;
-                    tmp._sqlite_stmt = null;
-
-                    // Reapply parameters
-                    stmt.BindParameters();
-                }
+                Reprepare(stmt);
+
+                // Reapply parameters
+                stmt.BindParameters();
 
                 return -1; // Reset was OK, with schema change
             }
@@ -221,6 +582,357 @@ internal override int Reset(SqliteStatement stmt)
             return 0; // We reset OK, no schema changes
         }
 
+        /// <summary>
+        /// Replaces the statement's expired sqlite statement after a schema change.  The new one has no bindings.
+        /// </summary>
+        private void Reprepare(SqliteStatement stmt)
+        {
+            // Recreate a dummy statement
+            var timeout = (uint)(stmt._command._commandTimeout * 1000);
+            string str;
+            using (SqliteStatement tmp = Prepare(null, stmt._sqlStatement, null, timeout, out str))
+            {
+                // Finalize the existing statement
+                stmt._sqlite_stmt.Dispose();
+                // Reassign a new statement pointer to the old statement and clear the temporary one
+                stmt._sqlite_stmt = tmp._sqlite_stmt;
+                tmp._sqlite_stmt = null;
+            }
+        }
+
+        internal override int[] StepBatch(SqliteStatement stmt, Array[] columns, int rowCount)
+        {
+            if (_profiler == null)
+            {
+                return StepBatchRows(stmt, columns, rowCount);
+            }
+
+            TimeSpan busyTime = _busyWait.WaitTime;
+            long start = _profiler.Stepping(stmt);
+            try
+            {
+                return StepBatchRows(stmt, columns, rowCount);
+            }
+            finally
+            {
+                // The wrapper resets the statement after the last row
+                _profiler.Stepped(stmt, start, rowCount, _busyWait.WaitTime - busyTime);
+                EndExecution(stmt);
+            }
+        }
+
+        private int[] StepBatchRows(SqliteStatement stmt, Array[] columns, int rowCount)
+        {
+            // Lay the columns out for sqlite3_step_batch: one array per kind of value, holding the columns of that
+            // kind one after the other, plus a null flag per value
+            var kinds = new int[columns.Length];
+            int[] kindCounts = new int[5];
+            for (int i = 0; i < columns.Length; i++)
+            {
+                Array column = columns[i];
+                if (column == null || column.Length != rowCount)
+                    throw new ArgumentException("All parameter columns must have the same number of rows", "columns");
+
+                if (column is long[] || column is long?[]) kinds[i] = 1; // SQLITE_INTEGER
+                else if (column is double[] || column is double?[]) kinds[i] = 2; // SQLITE_FLOAT
+                else if (column is string[]) kinds[i] = 3; // SQLITE_TEXT
+                else if (column is byte[][]) kinds[i] = 4; // SQLITE_BLOB
+                else
+                    throw new ArgumentException(
+                        String.Format("Unsupported parameter column type {0}", column.GetType()), "columns");
+
+                kindCounts[kinds[i]]++;
+            }
+
+            var integers = (kindCounts[1] > 0) ? new long[kindCounts[1] * rowCount] : null;
+            var doubles = (kindCounts[2] > 0) ? new double[kindCounts[2] * rowCount] : null;
+            var texts = (kindCounts[3] > 0) ? new string[kindCounts[3] * rowCount] : null;
+            var blobOffsets = (kindCounts[4] > 0) ? new int[kindCounts[4] * rowCount + 1] : null;
+            byte[] nulls = null;
+            int integerSlot = 0, doubleSlot = 0, textSlot = 0, blobSlot = 0, blobLength = 0;
+
+            for (int i = 0; i < columns.Length; i++)
+            {
+                int row;
+                switch (kinds[i])
+                {
+                    case 1:
+                        if (columns[i] is long[])
+                        {
+                            Array.Copy(columns[i], 0, integers, integerSlot * rowCount, rowCount);
+                        }
+                        else
+                        {
+                            var values = (long?[])columns[i];
+                            for (row = 0; row < rowCount; row++)
+                            {
+                                if (values[row].HasValue)
+                                    integers[integerSlot * rowCount + row] = values[row].Value;
+                                else
+                                    SetBatchNull(ref nulls, columns.Length, rowCount, i, row);
+                            }
+                        }
+                        integerSlot++;
+                        break;
+                    case 2:
+                        if (columns[i] is double[])
+                        {
+                            Array.Copy(columns[i], 0, doubles, doubleSlot * rowCount, rowCount);
+                        }
+                        else
+                        {
+                            var values = (double?[])columns[i];
+                            for (row = 0; row < rowCount; row++)
+                            {
+                                if (values[row].HasValue)
+                                    doubles[doubleSlot * rowCount + row] = values[row].Value;
+                                else
+                                    SetBatchNull(ref nulls, columns.Length, rowCount, i, row);
+                            }
+                        }
+                        doubleSlot++;
+                        break;
+                    case 3:
+                        var strings = (string[])columns[i];
+                        Array.Copy(strings, 0, texts, textSlot * rowCount, rowCount);
+                        for (row = 0; row < rowCount; row++)
+                        {
+                            if (strings[row] == null)
+                                SetBatchNull(ref nulls, columns.Length, rowCount, i, row);
+                        }
+                        textSlot++;
+                        break;
+                    default:
+                        var arrays = (byte[][])columns[i];
+                        for (row = 0; row < rowCount; row++)
+                        {
+                            blobOffsets[blobSlot * rowCount + row] = blobLength;
+                            if (arrays[row] == null)
+                                SetBatchNull(ref nulls, columns.Length, rowCount, i, row);
+                            else
+                                blobLength += arrays[row].Length;
+                        }
+                        blobSlot++;
+                        break;
+                }
+            }
+
+            byte[] blobs = null;
+            if (blobOffsets != null)
+            {
+                blobOffsets[blobOffsets.Length - 1] = blobLength;
+                blobs = new byte[blobLength];
+                blobSlot = 0;
+                for (int i = 0; i < columns.Length; i++)
+                {
+                    if (kinds[i] != 4) continue;
+
+                    var arrays = (byte[][])columns[i];
+                    for (int row = 0; row < rowCount; row++)
+                    {
+                        if (arrays[row] != null)
+                            Buffer.BlockCopy(arrays[row], 0, blobs, blobOffsets[blobSlot * rowCount + row], arrays[row].Length);
+                    }
+                    blobSlot++;
+                }
+            }
+
+            var changes = new int[rowCount];
+            int firstRow = 0;
+            int attempt = 0;
+            int schemaRetries = 0;
+            _busyWait.Start((uint)(stmt._command._commandTimeout * 1000));
+            StartDeadline(stmt, CancellationToken.None);
+
+            try
+            {
+                while (true)
+                {
+                    int rowsDone;
+                    int n = UnsafeNativeMethods.sqlite3_step_batch(stmt._sqlite_stmt, firstRow, rowCount, kinds,
+                                                                   integers, doubles, texts, blobs, blobOffsets, nulls,
+                                                                   changes, out rowsDone);
+                    if (n == 0)
+                    {
+                        return changes;
+                    }
+
+                    // Carry on from the row that failed, once the cause is out of the way
+                    firstRow = rowsDone;
+                    if (n == 17 && schemaRetries++ < 3) // SQLITE_SCHEMA
+                    {
+                        Reprepare(stmt);
+                        continue;
+                    }
+                    CheckDeadline(stmt, n);
+
+                    // Keep trying a locked database after a short wait, unless the busy strategy says to give up or
+                    // the command's timeout has expired
+                    if ((n != 6 && n != 5) || _busyWait.Wait(attempt++) == false) // SQLITE_LOCKED || SQLITE_BUSY
+                    {
+                        throw new SqliteException(n, SQLiteLastError());
+                    }
+                }
+            }
+            finally
+            {
+                _deadline.Stop();
+            }
+        }
+
+        internal override bool StepBlock(SqliteStatement stmt, SqliteRowBlock block, int maxRows, ref bool pending)
+        {
+            if (_profiler == null)
+            {
+                return StepBlockRows(stmt, block, maxRows, ref pending);
+            }
+
+            // A pending row is counted by the step that leaves it pending, not by the one that stores it
+            int counted = pending ? 1 : 0;
+            TimeSpan busyTime = _busyWait.WaitTime;
+            long start = _profiler.Stepping(stmt);
+            try
+            {
+                return StepBlockRows(stmt, block, maxRows, ref pending);
+            }
+            finally
+            {
+                _profiler.Stepped(stmt, start, block._rowCount - counted + (pending ? 1 : 0), _busyWait.WaitTime - busyTime);
+                _profiler.Marshalled(stmt, BlockBytes(block));
+            }
+        }
+
+        private bool StepBlockRows(SqliteStatement stmt, SqliteRowBlock block, int maxRows, ref bool pending)
+        {
+            int attempt = 0;
+            _busyWait.Start((uint)(stmt._command._commandTimeout * 1000));
+            StartDeadline(stmt, CancellationToken.None);
+            if (stmt._changesSettings)
+            {
+                _settings = null;
+            }
+
+            try
+            {
+                while (true)
+                {
+                    int rows, blobBytesNeeded;
+                    int n = UnsafeNativeMethods.sqlite3_step_block(stmt._sqlite_stmt, pending ? 1 : 0, block._rowCount,
+                                                                   block.BlobBytes(), maxRows, block._capacity,
+                                                                   block._types, block._integers, block._doubles,
+                                                                   block._texts, block._blobs, block._blobOffsets,
+                                                                   out rows, out blobBytesNeeded);
+                    block.Filled(rows);
+
+                    if (n == 100 || n == 101) // SQLITE_ROW || SQLITE_DONE
+                    {
+                        // A row whose blobs did not fit stays on the statement: the buffer grows, keeping the blobs
+                        // of the rows already stored, and the block carries on from that row
+                        pending = blobBytesNeeded > 0;
+                        if (pending && rows < maxRows)
+                        {
+                            block._blobBytesNeeded = block.BlobBytes() + blobBytesNeeded;
+                            block.GrowBlobs();
+                            continue;
+                        }
+                        return n == 100;
+                    }
+
+                    // Same as Step(): reset to find out what went wrong, retrying after a schema change or a lock
+                    pending = false;
+                    CheckDeadline(stmt, n);
+                    int r = ResetStatement(stmt);
+
+                    if (r == 0)
+                    {
+                        throw new SqliteException(n, SQLiteLastError());
+                    }
+
+                    if ((r == 6 || r == 5) && stmt._command != null) // SQLITE_LOCKED || SQLITE_BUSY
+                    {
+                        if (!_busyWait.Wait(attempt++))
+                        {
+                            throw new SqliteException(r, SQLiteLastError());
+                        }
+                    }
+                }
+            }
+            finally
+            {
+                _deadline.Stop();
+            }
+        }
+
+        /// <summary>
+        /// Returns the number of bytes of text and blob values in a block
+        /// </summary>
+        private static long BlockBytes(SqliteRowBlock block)
+        {
+            long bytes = 0;
+            for (int column = 0; column < block._fieldCount; column++)
+            {
+                for (int row = 0; row < block._rowCount; row++)
+                {
+                    int cell = column * block._capacity + row;
+                    if (block._types[cell] == (byte)TypeAffinity.Text)
+                        bytes += (block._texts[cell] != null) ? block._texts[cell].Length * 2 : 0;
+                    else if (block._types[cell] == (byte)TypeAffinity.Blob)
+                        bytes += block._integers[cell];
+                }
+            }
+            return bytes;
+        }
+
+        /// <summary>
+        /// Ends the execution of a statement that was stepped while profiling, reading and zeroing its counters
+        /// </summary>
+        private void EndExecution(SqliteStatement stmt)
+        {
+            if (_profiler == null || stmt._sqlite_stmt == null)
+            {
+                // Profiling was turned off since the statement was stepped
+                stmt._execution = null;
+                return;
+            }
+
+            SqliteStatementHandle hdl = stmt._sqlite_stmt;
+            _profiler.Complete(stmt,
+                UnsafeNativeMethods.sqlite3_stmt_status(hdl, 1, 1), // SQLITE_STMTSTATUS_FULLSCAN_STEP
+                UnsafeNativeMethods.sqlite3_stmt_status(hdl, 2, 1), // SQLITE_STMTSTATUS_SORT
+                UnsafeNativeMethods.sqlite3_stmt_status(hdl, 3, 1), // SQLITE_STMTSTATUS_AUTOINDEX
+                UnsafeNativeMethods.sqlite3_stmt_status(hdl, 4, 1)); // SQLITE_STMTSTATUS_VM_STEP
+        }
+
+        private static void SetBatchNull(ref byte[] nulls, int columnCount, int rowCount, int column, int row)
+        {
+            if (nulls == null)
+                nulls = new byte[columnCount * rowCount];
+
+            nulls[column * rowCount + row] = 1;
+        }
+
+        internal override bool ResetForReuse(SqliteStatement stmt)
+        {
+            // sqlite3_reset repeats the error of the last step, which is of no interest here.  The exception is
+            // SQLITE_SCHEMA: the statement has expired, so let the caller finalize it instead of caching it.
+            if (stmt._execution != null && _profiler != null)
+            {
+                _profiler.Resetting(stmt);
+            }
+            int n = UnsafeNativeMethods.sqlite3_reset(stmt._sqlite_stmt);
+            if (stmt._execution != null)
+            {
+                EndExecution(stmt);
+            }
+            if (n == 17) // SQLITE_SCHEMA
+            {
+                return false;
+            }
+
+            UnsafeNativeMethods.sqlite3_clear_bindings(stmt._sqlite_stmt);
+            return true;
+        }
+
         internal override string SQLiteLastError()
         {
             return SQLiteLastError(_sql);
@@ -236,8 +948,9 @@ internal override string SQLiteLastError()
             int n = 17;
             int retries = 0;
             SqliteStatement cmd = null;
-            var rnd = new Random();
-            var starttick = (uint) Environment.TickCount;
+            int attempt = 0;
+            long start = (_profiler != null) ? SqliteProfiler.Timestamp() : 0;
+            _busyWait.Start(timeout);
 
                 while ((n == 17 || n == 6 || n == 5) && retries < 3)
                 {
@@ -301,16 +1014,12 @@ internal override string SQLiteLastError()
                     }
                     else if (n == 6 || n == 5) // Locked -- delay a small amount before retrying
                     {
-                        // Keep trying, but if we've exceeded the command's timeout, give up and throw an error
-                        if ((uint) Environment.TickCount - starttick > timeout)
+                        // Keep trying, but if the busy strategy says to give up or we've exceeded the command's
+                        // timeout, throw an error
+                        if (!_busyWait.Wait(attempt++))
                         {
                             throw new SqliteException(n, SQLiteLastError());
                         }
-                        else
-                        {
-                            // Otherwise sleep for a random amount of time up to 150ms
-                            Sleep(rnd.Next(1, 150));
-                        }
                     }
                 }
 
@@ -322,6 +1031,10 @@ internal override string SQLiteLastError()
                 if (stmt != null)
                 {
                     cmd = new SqliteStatement(this, hdl, strSql.Substring(0, strSql.Length - strRemain.Length), previous);
+                    if (_profiler != null)
+                    {
+                        _profiler.Prepared(cmd._sqlStatement, start);
+                    }
                 }
 
                 return cmd;
@@ -370,6 +1083,24 @@ internal override void Bind_Null(SqliteStatement stmt, int index)
             if (n > 0) throw new SqliteException(n, SQLiteLastError());
         }
 
+        internal override void Bind_Array(SqliteStatement stmt, int index, long[] integers, double[] doubles, string[] texts)
+        {
+            // A null string is a NULL value, flagged apart from the texts
+            byte[] nulls = null;
+            if (texts != null)
+            {
+                for (int i = 0; i < texts.Length; i++)
+                {
+                    if (texts[i] != null) continue;
+                    if (nulls == null) nulls = new byte[texts.Length];
+                    nulls[i] = 1;
+                }
+            }
+
+            int n = UnsafeNativeMethods.sqlite3_bind_array(stmt._sqlite_stmt, index, integers, doubles, texts, nulls);
+            if (n > 0) throw new SqliteException(n, SQLiteLastError());
+        }
+
         internal override int Bind_ParamCount(SqliteStatement stmt)
         {
             return UnsafeNativeMethods.sqlite3_bind_parameter_count(stmt._sqlite_stmt);
@@ -473,6 +1204,51 @@ internal override string ColumnTableName(SqliteStatement stmt, int index)
             autoIncrement = (nautoInc == 1);
         }
 
+        internal override SqliteBlobHandle OpenBlob(string dataBase, string table, string column, long rowid,
+                                                    bool writable)
+        {
+            SqliteBlobHandle blob;
+            int n = UnsafeNativeMethods.sqlite3_blob_open(_sql, ToUTF8(dataBase ?? "main"), ToUTF8(table),
+                                                          ToUTF8(column), rowid, writable ? 1 : 0, out blob);
+            if (n > 0) throw new SqliteException(n, SQLiteLastError());
+
+            return blob;
+        }
+
+        internal override SqliteBackupHandle InitializeBackup(SQLiteBase destination, string destinationName,
+                                                              string sourceName)
+        {
+            var dest = (SQLite3)destination;
+            SqliteBackupHandle backup = UnsafeNativeMethods.sqlite3_backup_init(dest._sql, ToUTF8(destinationName ?? "main"),
+                                                                                _sql, ToUTF8(sourceName ?? "main"));
+            // The reason the backup could not start is left on the destination connection
+            if (backup == null) throw new SqliteException((int)SQLiteErrorCode.Error, dest.SQLiteLastError());
+
+            return backup;
+        }
+
+        internal override bool StepBackup(SqliteBackupHandle backup, int pages, out bool retry)
+        {
+            int n = UnsafeNativeMethods.sqlite3_backup_step(backup, pages);
+            retry = (n == (int)SQLiteErrorCode.Busy || n == (int)SQLiteErrorCode.Locked);
+            return n == (int)SQLiteErrorCode.Ok || retry;
+        }
+
+        internal override int RemainingBackup(SqliteBackupHandle backup)
+        {
+            return UnsafeNativeMethods.sqlite3_backup_remaining(backup);
+        }
+
+        internal override int PageCountBackup(SqliteBackupHandle backup)
+        {
+            return UnsafeNativeMethods.sqlite3_backup_pagecount(backup);
+        }
+
+        internal override int FinishBackup(SqliteBackupHandle backup)
+        {
+            return UnsafeNativeMethods.sqlite3_backup_finish(backup);
+        }
+
         internal override double GetDouble(SqliteStatement stmt, int index)
         {
             return UnsafeNativeMethods.sqlite3_column_double(stmt._sqlite_stmt, index);
@@ -490,79 +1266,54 @@ internal override long GetInt64(SqliteStatement stmt, int index)
 
         internal override string GetText(SqliteStatement stmt, int index)
         {
-            return UTF8ToString(UnsafeNativeMethods.sqlite3_column_text(stmt._sqlite_stmt, index), -1);
+            string text = UTF8ToString(UnsafeNativeMethods.sqlite3_column_text(stmt._sqlite_stmt, index), -1);
+            if (_profiler != null)
+            {
+                _profiler.Marshalled(stmt, text != null ? text.Length * 2 : 0);
+            }
+            return text;
         }
 
         internal override DateTime GetDateTime(SqliteStatement stmt, int index)
         {
+            if (_datetimeFormat == SQLiteDateFormats.ISO8601)
+            {
+                // The wrapper parses the common shapes straight from the column's UTF-8 text
+                long ticks;
+                int kind = UnsafeNativeMethods.sqlite3_column_datetime(stmt._sqlite_stmt, index, out ticks);
+                if (kind >= 0)
+                {
+                    return new DateTime(ticks, (DateTimeKind)kind);
+                }
+            }
             return ToDateTime(UnsafeNativeMethods.sqlite3_column_text(stmt._sqlite_stmt, index), -1);
         }
 
         internal override long GetBytes(SqliteStatement stmt, int index, int nDataOffset, byte[] bDest, int nStart,
                                         int nLength)
         {
-            int nCopied = nLength;
-            int nlen = UnsafeNativeMethods.sqlite3_column_bytes(stmt._sqlite_stmt, index);
-            var ptr = UnsafeNativeMethods.sqlite3_column_blob(stmt._sqlite_stmt, index);
-
-            if (bDest == null)
-            {
-                return nlen;
-            }
-            
-            if (nCopied + nStart > bDest.Length)
-            {
-                nCopied = bDest.Length - nStart;
-            }
-            if (nCopied + nDataOffset > nlen)
+            // Copies straight from the column memory into the caller's buffer.  A null buffer returns the total length.
+            int n = UnsafeNativeMethods.sqlite3_column_blob_copy(stmt._sqlite_stmt, index, nDataOffset, bDest, nStart, nLength);
+            if (_profiler != null && bDest != null)
             {
-                nCopied = nlen - nDataOffset;
+                _profiler.Marshalled(stmt, n);
             }
-
-            if (nCopied > 0)
-            {
-                Array.Copy(ptr, nStart + nDataOffset, bDest, 0, nCopied);
-            }
-            else
-            {
-                nCopied = 0;
-            }
-
-            return nCopied;
+            return n;
         }
 
-        internal override long GetChars(SqliteStatement stmt, int index, int nDataOffset, char[] bDest, int nStart,
-                                        int nLength)
+        internal override SqliteBlobView GetBlobView(SqliteStatement stmt, int index)
         {
-            int nCopied = nLength;
-
-            string str = GetText(stmt, index);
-            int nlen = str.Length;
-
-            if (bDest == null)
-            {
-                return nlen;
-            }
-
-            if (nCopied + nStart > bDest.Length)
-            {
-                nCopied = bDest.Length - nStart;
-            }
-            if (nCopied + nDataOffset > nlen)
-            {
-                nCopied = nlen - nDataOffset;
-            }
+            return UnsafeNativeMethods.sqlite3_column_blob_view(stmt._sqlite_stmt, index);
+        }
 
-            if (nCopied > 0)
-            {
-                str.CopyTo(nDataOffset, bDest, nStart, nCopied);
-            }
-            else
+        internal override SqliteBlobView GetTextView(SqliteStatement stmt, int index)
+        {
+            SqliteBlobView view = UnsafeNativeMethods.sqlite3_column_text_view(stmt._sqlite_stmt, index);
+            if (_profiler != null)
             {
-                nCopied = 0;
+                _profiler.Marshalled(stmt, view.Length);
             }
-
-            return nCopied;
+            return view;
         }
 
         internal override bool IsNull(SqliteStatement stmt, int index)
@@ -573,84 +1324,45 @@ internal override bool IsNull(SqliteStatement stmt, int index)
         internal override void CreateFunction(string strFunction, int nArgs, bool needCollSeq, SQLiteCallback func,
                                               SQLiteCallback funcstep, SQLiteFinalCallback funcfinal)
         {
-            //int n = UnsafeNativeMethods.sqlite3_create_function(_sql, ToUTF8(strFunction), nArgs, 4, IntPtr.Zero, func,
-            //                                                    funcstep, funcfinal);
-            //if (n == 0)
-            //{
-            //    n = UnsafeNativeMethods.sqlite3_create_function(_sql, ToUTF8(strFunction), nArgs, 1, IntPtr.Zero, func,
-            //                                                    funcstep, funcfinal);
-            //}
-
-            //if (n > 0)
-            //{
-            //    throw new SqliteException(n, SQLiteLastError());
-            //}
-
-            throw new NotImplementedException();
+            int n = UnsafeNativeMethods.sqlite3_create_function(_sql, strFunction, nArgs, func, funcstep, funcfinal);
+            if (n > 0)
+            {
+                throw new SqliteException(n, SQLiteLastError());
+            }
         }
 
         internal override void CreateCollation(string strCollation, SQLiteCollation func, SQLiteCollation func16)
         {
-            //int n = UnsafeNativeMethods.sqlite3_create_collation(_sql, ToUTF8(strCollation), 2, IntPtr.Zero, func16);
-            //if (n == 0)
-            //{
-            //    UnsafeNativeMethods.sqlite3_create_collation(_sql, ToUTF8(strCollation), 1, IntPtr.Zero, func);
-            //}
-
-            //if (n > 0)
-            //{
-            //    throw new SqliteException(n, SQLiteLastError());
-            //}
-
-            throw new NotImplementedException();
+            // The wrapper hands the collation UTF-16 strings whatever the connection's encoding, so one callback does
+            int n = UnsafeNativeMethods.sqlite3_create_collation(_sql, strCollation, func16);
+            if (n > 0)
+            {
+                throw new SqliteException(n, SQLiteLastError());
+            }
         }
 
+        // sqlite does not export the collating sequence of a function call, so SqliteFunctionEx cannot be served
         internal override int ContextCollateCompare(CollationEncodingEnum enc, SqliteContextHandle context, string s1,
                                                     string s2)
         {
-            throw new NotImplementedException();
+            throw new NotSupportedException("The collating sequence of a function call is not available");
         }
 
         internal override int ContextCollateCompare(CollationEncodingEnum enc, SqliteContextHandle context, char[] c1,
                                                     char[] c2)
         {
-            throw new NotImplementedException();
+            throw new NotSupportedException("The collating sequence of a function call is not available");
         }
 
         internal override CollationSequence GetCollationSequence(SqliteFunction func, SqliteContextHandle context)
         {
-            throw new NotImplementedException();
+            throw new NotSupportedException("The collating sequence of a function call is not available");
         }
 
         internal override long GetParamValueBytes(SqliteValueHandle p, int nDataOffset, byte[] bDest, int nStart,
                                                   int nLength)
         {
-            int nCopied = nLength;
-
-            int nlen = UnsafeNativeMethods.sqlite3_value_bytes(p);
-            var ptr = UnsafeNativeMethods.sqlite3_value_blob(p);
-
-            if (bDest == null) return nlen;
-
-            if (nCopied + nStart > bDest.Length)
-            {
-                nCopied = bDest.Length - nStart;
-            }
-            if (nCopied + nDataOffset > nlen)
-            {
-                nCopied = nlen - nDataOffset;
-            }
-
-            if (nCopied > 0)
-            {
-                Array.Copy(ptr, nStart + nDataOffset, bDest, 0, nCopied);
-            }
-            else
-            {
-                nCopied = 0;
-            }
-
-            return nCopied;
+            return UnsafeNativeMethods.sqlite3_value_blob_copy(p, nDataOffset, bDest, nStart, nLength);
         }
 
         internal override double GetParamValueDouble(SqliteValueHandle ptr)
@@ -713,7 +1425,7 @@ internal override void ReturnText(SqliteContextHandle context, string value)
             UnsafeNativeMethods.sqlite3_result_text(context, value, value.Length, null);
         }
 
-        internal override SqliteValueHandle AggregateContext(SqliteContextHandle context)
+        internal override long AggregateContext(SqliteContextHandle context)
         {
             return UnsafeNativeMethods.sqlite3_aggregate_context(context, 1);
         }
@@ -749,6 +1461,60 @@ internal override void SetRollbackHook(SqliteRollbackHookDelegate func)
             UnsafeNativeMethods.sqlite3_rollback_hook(_sql, func, null);
         }
 
+        internal override void SetWalHook(SqliteWalHookDelegate func)
+        {
+            // Removing the hook leaves the handle without automatic checkpoints, so the threshold it had is put back
+            if (func != null && _walHook == false)
+            {
+                _walAutoCheckpoint = Pragma("PRAGMA wal_autocheckpoint");
+            }
+            UnsafeNativeMethods.sqlite3_wal_hook(_sql, func, null);
+            if (func == null && _walHook)
+            {
+                Pragma(String.Format(CultureInfo.InvariantCulture, "PRAGMA wal_autocheckpoint={0}", _walAutoCheckpoint));
+            }
+            _walHook = (func != null);
+        }
+
+        /// <summary>
+        /// Runs a PRAGMA that takes no lock and returns the first column of its result, or 0 if it has none
+        /// </summary>
+        private long Pragma(string sql)
+        {
+            string remain;
+            using (SqliteStatement stmt = Prepare(null, sql, null, 0, out remain))
+            {
+                return UnsafeNativeMethods.sqlite3_step(stmt._sqlite_stmt) == 100 // SQLITE_ROW
+                    ? UnsafeNativeMethods.sqlite3_column_int64(stmt._sqlite_stmt, 0)
+                    : 0;
+            }
+        }
+
+        internal override void SetLookaside(int slotSize, int slotCount)
+        {
+            int n = UnsafeNativeMethods.sqlite3_db_config_lookaside(_sql, slotSize, slotCount);
+            // A handle from the pool is already using the lookaside memory it was first opened with, and keeps it
+            if (n == (int)SQLiteErrorCode.Busy) return;
+            if (n > 0) throw new SqliteException(n, SQLiteLastError());
+        }
+
+        internal override void GetStatus(SqliteConnectionStatus status, out int current, out int highwater, bool reset)
+        {
+            int n = UnsafeNativeMethods.sqlite3_db_status(_sql, (int)status, out current, out highwater, reset ? 1 : 0);
+            if (n > 0) throw new SqliteException(n, SQLiteLastError());
+        }
+
+        internal override bool Checkpoint(string dataBase, SqliteCheckpointMode mode, out int logFrames,
+                                          out int checkpointedFrames)
+        {
+            int n = UnsafeNativeMethods.sqlite3_wal_checkpoint_v2(_sql, ToUTF8(dataBase ?? ""), (int)mode, out logFrames,
+                                                                  out checkpointedFrames);
+            if (n == (int)SQLiteErrorCode.Busy) return false;
+            if (n > 0) throw new SqliteException(n, SQLiteLastError());
+
+            return true;
+        }
+
         /// <summary>
         /// Helper function to retrieve a column of data from an active statement.
         /// </summary>
@@ -822,14 +1588,5 @@ internal override long GetRowIdForCursor(SqliteStatement stmt, int cursor)
             onError = 2;
             collationSequence = "BINARY";
         }
-
-        private static void Sleep(int ms)
-        {
-            var end = Environment.TickCount + ms;
-            while (Environment.TickCount < end)
-            {
-                // just no nothing....
-            }
-        }
     }
 }
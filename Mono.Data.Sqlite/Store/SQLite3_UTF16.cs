@@ -35,33 +35,13 @@ public static string UTF16ToString(string p, int nbytelen)
             return p;
         }
 
-        internal override void Open(string strFilename, SQLiteOpenFlagsEnum flags, int maxPoolSize, bool usePool)
+        protected override SqliteConnectionHandle OpenHandle(string strFilename, SQLiteOpenFlagsEnum flags)
         {
-            if (_sql != null) return;
+            SqliteConnectionHandle db;
+            int n = UnsafeNativeMethods.sqlite3_open16(strFilename, out db);
+            if (n > 0) throw new SqliteException(n, null);
 
-            _usePool = usePool;
-            if (usePool)
-            {
-                _fileName = strFilename;
-                _sql = SqliteConnectionPool.Remove(strFilename, maxPoolSize, out _poolVersion);
-            }
-
-            if (_sql == null)
-            {
-                SqliteConnectionHandle db;
-
-                if ((flags & SQLiteOpenFlagsEnum.Create) == 0 && FileExists(strFilename) == false)
-                {
-                    throw new SqliteException((int) SQLiteErrorCode.CantOpen, strFilename);
-                }
-
-                int n = UnsafeNativeMethods.sqlite3_open16(strFilename, out db);
-                if (n > 0) throw new SqliteException(n, null);
-
-                _sql = db;
-            }
-
-            _functionsArray = SqliteFunction.BindFunctions(this);
+            return db;
         }
 
         internal override void Bind_DateTime(SqliteStatement stmt, int index, DateTime dt)
@@ -87,7 +67,12 @@ internal override string ColumnName(SqliteStatement stmt, int index)
 
         internal override string GetText(SqliteStatement stmt, int index)
         {
-            return UTF16ToString(UnsafeNativeMethods.sqlite3_column_text16(stmt._sqlite_stmt, index), -1);
+            string text = UTF16ToString(UnsafeNativeMethods.sqlite3_column_text16(stmt._sqlite_stmt, index), -1);
+            if (_profiler != null)
+            {
+                _profiler.Marshalled(stmt, text != null ? text.Length * 2 : 0);
+            }
+            return text;
         }
 
         internal override string ColumnOriginalName(SqliteStatement stmt, int index)
@@ -8,6 +8,8 @@
 namespace Mono.Data.Sqlite
 {
     using System;
+    using System.Threading;
+    using System.Threading.Tasks;
     using MonoDataSqliteWrapper;
 #if SILVERLIGHT
 #endif
@@ -45,9 +47,23 @@ internal SQLiteBase(SQLiteDateFormats fmt)
         /// </remarks>
         /// <param name="strFilename">The filename of the database to open.  SQLite automatically creates it if it doesn't exist.</param>
         /// <param name="flags">The open flags to use when creating the connection</param>
-        /// <param name="maxPoolSize">The maximum size of the pool for the given filename</param>
-        /// <param name="usePool">If true, the connection can be pulled from the connection pool</param>
-        internal abstract void Open(string strFilename, SQLiteOpenFlagsEnum flags, int maxPoolSize, bool usePool);
+        /// <param name="poolOptions">The pool settings for the given filename, or null to not use the connection pool</param>
+        internal abstract void Open(string strFilename, SQLiteOpenFlagsEnum flags, SqliteConnectionPool.Options poolOptions);
+
+        /// <summary>
+        /// Returns the statement cache of the open connection, or null if cacheSize is 0.  A connection that came out of
+        /// the pool brings along the statements it had prepared, if its cache has the same size.  Close() finalizes the
+        /// cached statements, or returns them to the pool with the connection.
+        /// </summary>
+        /// <param name="cacheSize">The number of command texts to cache</param>
+        internal abstract SqliteStatementCache GetStatementCache(int cacheSize);
+
+        /// <summary>
+        /// The PRAGMA commands of the connection string run on the open handle, or null if they have not been or a
+        /// statement may have changed what they set.  A connection that came out of the pool brings them along, so that
+        /// Open() can skip running the same commands again.
+        /// </summary>
+        internal abstract string Settings { get; set; }
 
         /// <summary>
         /// Closes the currently-open database.
@@ -64,6 +80,18 @@ internal SQLiteBase(SQLiteDateFormats fmt)
         /// <param name="timeout">The number of milliseconds to wait before returning SQLITE_BUSY</param>
         internal abstract void SetTimeout(int timeout);
 
+        /// <summary>
+        /// Sets how Step() and Prepare() wait when the database is locked, and where they count their retries.
+        /// </summary>
+        /// <param name="busyWait">The strategy and counters of the connection</param>
+        internal abstract void SetBusyWait(SqliteBusyWait busyWait);
+
+        /// <summary>
+        /// Starts reporting the timings and counters of every statement to a profiler, or stops it if null.
+        /// </summary>
+        /// <param name="profiler">The profiler of the connection</param>
+        internal abstract void SetProfiler(SqliteProfiler profiler);
+
         /// <summary>
         /// Returns the text of the last error issued by SQLite
         /// </summary>
@@ -96,6 +124,16 @@ internal SQLiteBase(SQLiteDateFormats fmt)
         /// <returns>True if a row was returned, False if not.</returns>
         internal abstract bool Step(SqliteStatement stmt);
 
+        /// <summary>
+        /// Steps through a prepared statement on the connection's worker, waiting for a locked database with timers
+        /// between the attempts rather than on the worker's thread.
+        /// </summary>
+        /// <param name="stmt">The SqliteStatement to step through</param>
+        /// <param name="worker">The worker of the statement's connection</param>
+        /// <param name="cancellationToken">Cancels the step, interrupting it if it is running</param>
+        /// <returns>A task whose result is true if a row was returned</returns>
+        internal abstract Task<bool> StepAsync(SqliteStatement stmt, SqliteWorker worker, CancellationToken cancellationToken);
+
         /// <summary>
         /// Resets a prepared statement so it can be executed again.  If the error returned is SQLITE_SCHEMA, 
         /// transparently attempt to rebuild the SQL statement and throw an error if that was not possible.
@@ -104,6 +142,36 @@ internal SQLiteBase(SQLiteDateFormats fmt)
         /// <returns>Returns -1 if the schema changed while resetting, 0 if the reset was sucessful or 6 (SQLITE_LOCKED) if the reset failed due to a lock</returns>
         internal abstract int Reset(SqliteStatement stmt);
 
+        /// <summary>
+        /// Resets a statement and clears its bindings so it can be parked in the statement cache.  Errors left over from
+        /// the last step are ignored, since the statement is not being executed.
+        /// </summary>
+        /// <param name="stmt">The statement to reset</param>
+        /// <returns>Returns false if the statement can't be reused and should be finalized instead</returns>
+        internal abstract bool ResetForReuse(SqliteStatement stmt);
+
+        /// <summary>
+        /// Executes a statement once for each row of the given columns, binding column i to parameter i + 1.  The rows
+        /// are bound and stepped inside a single call into the sqlite wrapper.
+        /// </summary>
+        /// <param name="stmt">The statement to execute</param>
+        /// <param name="columns">One long[], long?[], double[], double?[], string[] or byte[][] per parameter</param>
+        /// <param name="rowCount">The number of rows, which every column must have</param>
+        /// <returns>The number of rows changed by each execution</returns>
+        internal abstract int[] StepBatch(SqliteStatement stmt, Array[] columns, int rowCount);
+
+        /// <summary>
+        /// Steps a statement up to maxRows times and stores the rows in a block, inside a single call into the sqlite
+        /// wrapper.
+        /// </summary>
+        /// <param name="stmt">The statement to step through</param>
+        /// <param name="block">The block to fill, already reset for the statement's columns</param>
+        /// <param name="maxRows">The maximum number of rows to read, no more than the block's capacity</param>
+        /// <param name="pending">On entry, true if the statement is already on a row that must be stored first.  On
+        /// return, true if the statement was left on a row that did not fit into the block.</param>
+        /// <returns>False if the end of the results was reached</returns>
+        internal abstract bool StepBlock(SqliteStatement stmt, SqliteRowBlock block, int maxRows, ref bool pending);
+
         internal abstract void Cancel();
 
         internal abstract void Bind_Double(SqliteStatement stmt, int index, double value);
@@ -113,6 +181,11 @@ internal SQLiteBase(SQLiteDateFormats fmt)
         internal abstract void Bind_Blob(SqliteStatement stmt, int index, byte[] blobData);
         internal abstract void Bind_DateTime(SqliteStatement stmt, int index, DateTime dt);
         internal abstract void Bind_Null(SqliteStatement stmt, int index);
+        /// <summary>
+        /// Binds the values of whichever of integers, doubles or texts is given as the table of array(), see
+        /// SqliteParameter.Value
+        /// </summary>
+        internal abstract void Bind_Array(SqliteStatement stmt, int index, long[] integers, double[] doubles, string[] texts);
 
         internal abstract int Bind_ParamCount(SqliteStatement stmt);
         internal abstract string Bind_ParamName(SqliteStatement stmt, int index);
@@ -134,6 +207,45 @@ internal SQLiteBase(SQLiteDateFormats fmt)
         internal abstract void GetIndexColumnExtendedInfo(string database, string index, string column, out int sortMode,
                                                           out int onError, out string collationSequence);
 
+        /// <summary>
+        /// Opens a handle for incremental I/O on the blob stored in a column of a row
+        /// </summary>
+        /// <param name="dataBase">The database the table is in, "main" if null</param>
+        /// <param name="table">The table</param>
+        /// <param name="column">The column holding the blob</param>
+        /// <param name="rowid">The rowid of the row</param>
+        /// <param name="writable">Whether the blob is opened for writing as well as reading</param>
+        internal abstract SqliteBlobHandle OpenBlob(string dataBase, string table, string column, long rowid,
+                                                    bool writable);
+
+        /// <summary>
+        /// Starts copying a database of this connection into a database of another connection
+        /// </summary>
+        /// <param name="destination">The connection to copy into</param>
+        /// <param name="destinationName">The database to overwrite, "main" if null</param>
+        /// <param name="sourceName">The database to copy, "main" if null</param>
+        internal abstract SqliteBackupHandle InitializeBackup(SQLiteBase destination, string destinationName,
+                                                              string sourceName);
+
+        /// <summary>
+        /// Copies the next pages of a backup
+        /// </summary>
+        /// <param name="backup">The backup</param>
+        /// <param name="pages">The number of pages to copy, or a negative number to copy all that remain</param>
+        /// <param name="retry">Set if the database was locked and nothing could be copied</param>
+        /// <returns>False once the backup is complete or has failed, in which case FinishBackup() reports the error</returns>
+        internal abstract bool StepBackup(SqliteBackupHandle backup, int pages, out bool retry);
+
+        internal abstract int RemainingBackup(SqliteBackupHandle backup);
+        internal abstract int PageCountBackup(SqliteBackupHandle backup);
+
+        /// <summary>
+        /// Releases a backup, complete or not
+        /// </summary>
+        /// <returns>The error that stopped the backup, SQLITE_BUSY or SQLITE_LOCKED if it was abandoned while
+        /// retrying, or SQLITE_OK</returns>
+        internal abstract int FinishBackup(SqliteBackupHandle backup);
+
         internal abstract double GetDouble(SqliteStatement stmt, int index);
         internal abstract Int32 GetInt32(SqliteStatement stmt, int index);
         internal abstract Int64 GetInt64(SqliteStatement stmt, int index);
@@ -142,8 +254,49 @@ internal SQLiteBase(SQLiteDateFormats fmt)
         internal abstract long GetBytes(SqliteStatement stmt, int index, int nDataoffset, byte[] bDest, int nStart,
                                         int nLength);
 
-        internal abstract long GetChars(SqliteStatement stmt, int index, int nDataoffset, char[] bDest, int nStart,
-                                        int nLength);
+        /// <summary>
+        /// Returns a borrowed view over the blob data of a column, valid until the statement is stepped or reset.
+        /// </summary>
+        internal abstract SqliteBlobView GetBlobView(SqliteStatement stmt, int index);
+
+        /// <summary>
+        /// Returns a borrowed view over the UTF-8 text of a column, valid until the statement is stepped or reset.
+        /// </summary>
+        internal abstract SqliteBlobView GetTextView(SqliteStatement stmt, int index);
+
+        /// <summary>
+        /// Copies part of a column's text, already read with GetText(), into bDest.  A null bDest returns the length of the text.
+        /// </summary>
+        internal static long GetChars(string str, int nDataOffset, char[] bDest, int nStart, int nLength)
+        {
+            int nCopied = nLength;
+            int nlen = str.Length;
+
+            if (bDest == null)
+            {
+                return nlen;
+            }
+
+            if (nCopied + nStart > bDest.Length)
+            {
+                nCopied = bDest.Length - nStart;
+            }
+            if (nCopied + nDataOffset > nlen)
+            {
+                nCopied = nlen - nDataOffset;
+            }
+
+            if (nCopied > 0)
+            {
+                str.CopyTo(nDataOffset, bDest, nStart, nCopied);
+            }
+            else
+            {
+                nCopied = 0;
+            }
+
+            return nCopied;
+        }
 
         internal abstract DateTime GetDateTime(SqliteStatement stmt, int index);
         internal abstract bool IsNull(SqliteStatement stmt, int index);
@@ -161,7 +314,10 @@ internal SQLiteBase(SQLiteDateFormats fmt)
         internal abstract int ContextCollateCompare(CollationEncodingEnum enc, SqliteContextHandle context, char[] c1,
                                                     char[] c2);
 
-        internal abstract SqliteValueHandle AggregateContext(SqliteContextHandle context);
+        /// <summary>
+        /// Returns a key identifying the aggregate being computed, the same for every step of one group
+        /// </summary>
+        internal abstract long AggregateContext(SqliteContextHandle context);
 
         internal abstract long GetParamValueBytes(SqliteValueHandle ptr, int nDataOffset, byte[] bDest, int nStart,
                                                   int nLength);
@@ -187,6 +343,36 @@ internal SQLiteBase(SQLiteDateFormats fmt)
         internal abstract void SetCommitHook(SqliteCommitHookDelegate func);
         internal abstract void SetRollbackHook(SqliteRollbackHookDelegate func);
 
+        /// <summary>
+        /// Registers a function called after every commit to a database in WAL mode, which replaces sqlite's automatic
+        /// checkpoints, or restores the automatic checkpoints if null.
+        /// </summary>
+        internal abstract void SetWalHook(SqliteWalHookDelegate func);
+
+        /// <summary>
+        /// Sizes the lookaside allocator of the connection, which serves its small allocations without locking the heap.
+        /// Only takes effect while no lookaside memory is in use, in practice right after the connection is opened.
+        /// </summary>
+        /// <param name="slotSize">The size of each slot in bytes</param>
+        /// <param name="slotCount">The number of slots, or 0 to turn the lookaside allocator off</param>
+        internal abstract void SetLookaside(int slotSize, int slotCount);
+
+        /// <summary>
+        /// Reads one of the connection's memory and cache counters
+        /// </summary>
+        internal abstract void GetStatus(SqliteConnectionStatus status, out int current, out int highwater, bool reset);
+
+        /// <summary>
+        /// Copies the frames of the write-ahead log back into the database
+        /// </summary>
+        /// <param name="dataBase">The database to checkpoint, or null for all of them</param>
+        /// <param name="mode">The kind of checkpoint</param>
+        /// <param name="logFrames">The number of frames in the log, or -1 if the database is not in WAL mode</param>
+        /// <param name="checkpointedFrames">The number of frames in the log that are now in the database, or -1</param>
+        /// <returns>False if the checkpoint could not finish because another connection held a lock</returns>
+        internal abstract bool Checkpoint(string dataBase, SqliteCheckpointMode mode, out int logFrames,
+                                          out int checkpointedFrames);
+
         internal abstract int GetCursorForTable(SqliteStatement stmt, int database, int rootPage);
         internal abstract long GetRowIdForCursor(SqliteStatement stmt, int cursor);
 
@@ -285,6 +471,107 @@ public enum SQLiteConfig
         SingleThread = 1,
         MultiThread = 2,
         Serialized = 3,
+        PageCache = 7,
+        MemStatus = 9,
+        Lookaside = 13,
+        Uri = 17,
+        CoveringIndexScan = 20,
+        MmapSize = 22,
+        StatementJournalSpill = 26,
+    }
+
+    /// <summary>
+    /// The process-wide counters of sqlite3_status64(), see http://www.sqlite.org/c3ref/c_status_malloc_count.html
+    /// </summary>
+    public enum SqliteMemoryStatus
+    {
+        /// <summary>
+        /// Bytes of memory allocated by sqlite's allocator
+        /// </summary>
+        MemoryUsed = 0,
+        /// <summary>
+        /// Pages of the page cache arena in use
+        /// </summary>
+        PageCacheUsed = 1,
+        /// <summary>
+        /// Bytes of page cache that did not fit in the arena and came from the heap
+        /// </summary>
+        PageCacheOverflow = 2,
+        /// <summary>
+        /// The largest single allocation requested, in bytes.  Only the high-water mark is meaningful.
+        /// </summary>
+        MallocSize = 5,
+        /// <summary>
+        /// The deepest the parser stack has been.  Only the high-water mark is meaningful.
+        /// </summary>
+        ParserStack = 6,
+        /// <summary>
+        /// The largest page cache allocation requested, in bytes.  Only the high-water mark is meaningful.
+        /// </summary>
+        PageCacheSize = 7,
+        /// <summary>
+        /// The number of separate allocations outstanding
+        /// </summary>
+        MallocCount = 9,
+    }
+
+    /// <summary>
+    /// The per-connection counters of sqlite3_db_status(), see http://www.sqlite.org/c3ref/c_dbstatus_options.html
+    /// </summary>
+    public enum SqliteConnectionStatus
+    {
+        /// <summary>
+        /// Lookaside slots in use
+        /// </summary>
+        LookasideUsed = 0,
+        /// <summary>
+        /// Bytes of heap used by the page cache of the connection
+        /// </summary>
+        CacheUsed = 1,
+        /// <summary>
+        /// Bytes of heap used by the schemas of the connection's databases
+        /// </summary>
+        SchemaUsed = 2,
+        /// <summary>
+        /// Bytes of heap used by the connection's prepared statements
+        /// </summary>
+        StatementUsed = 3,
+        /// <summary>
+        /// Allocations served from the lookaside slots.  Only the high-water mark is meaningful.
+        /// </summary>
+        LookasideHit = 4,
+        /// <summary>
+        /// Allocations too big for a lookaside slot.  Only the high-water mark is meaningful.
+        /// </summary>
+        LookasideMissSize = 5,
+        /// <summary>
+        /// Allocations made from the heap because every lookaside slot was taken.  Only the high-water mark is meaningful.
+        /// </summary>
+        LookasideMissFull = 6,
+        /// <summary>
+        /// Pages found in the page cache
+        /// </summary>
+        CacheHit = 7,
+        /// <summary>
+        /// Pages that had to be read because they were not in the page cache
+        /// </summary>
+        CacheMiss = 8,
+        /// <summary>
+        /// Dirty pages written to the database file
+        /// </summary>
+        CacheWrite = 9,
+        /// <summary>
+        /// Non-zero if deferred foreign key constraints are still unresolved
+        /// </summary>
+        DeferredForeignKeys = 10,
+        /// <summary>
+        /// Like CacheUsed, but with memory shared between connections divided among them
+        /// </summary>
+        CacheUsedShared = 11,
+        /// <summary>
+        /// Dirty pages written to the database file in the middle of a transaction, because the cache was full
+        /// </summary>
+        CacheSpill = 12,
     }
 
     internal static class Disposers
@@ -315,6 +602,11 @@ internal static void Close(this SqliteConnectionHandle connection)
         {
             connection.Dispose();
         }
+
+        internal static void Dispose(this SqliteBlobHandle blob)
+        {
+            UnsafeNativeMethods.sqlite3_blob_close(blob);
+        }
     }
 }
 
@@ -327,17 +619,35 @@ public sealed class SqliteContextHandle { }
     public sealed class SqliteStatementHandle { }
     public sealed class SqliteConnectionHandle { }
     public sealed class SqliteValueHandle { }
+    public sealed class SqliteBlobHandle { }
+    public sealed class SqliteBackupHandle { }
+
+    public sealed class SqliteBlobView
+    {
+        public int Length { get { throw new System.NotImplementedException(); } }
+        public int CopyTo(long sourceOffset, byte[] destination, int destinationOffset, int count) { throw new System.NotImplementedException(); }
+    }
 
     public delegate int SqliteCommitHookDelegate(object argument);
     public delegate void SqliteUpdateHookDelegate(object argument, int b, string c, string d, long e);
     public delegate void SqliteRollbackHookDelegate(object argument);
+    public delegate int SqliteBusyHandlerDelegate(object userState, int count);
+    public delegate int SqliteProgressHandlerDelegate(object userState);
+    public delegate void SqliteTraceDelegate(object userState, uint type, long value);
+    public delegate int SqliteWalHookDelegate(object userState, string dbName, int frames);
     public delegate void SQLiteCallback(SqliteContextHandle context, int nArgs, SqliteValueHandle[] args);
     public delegate void SQLiteFinalCallback(SqliteContextHandle context);
     public delegate int SQLiteCollation(object puser, int len1, string pv1, int len2, string pv2);
 
     public sealed class UnsafeNativeMethods
     {
-        public static SqliteValueHandle sqlite3_aggregate_context(SqliteContextHandle context, int nBytes) { throw new System.NotImplementedException(); }
+        public static long sqlite3_aggregate_context(SqliteContextHandle context, int nBytes) { throw new System.NotImplementedException(); }
+        public static int sqlite3_backup_finish(SqliteBackupHandle backup) { throw new System.NotImplementedException(); }
+        public static SqliteBackupHandle sqlite3_backup_init(SqliteConnectionHandle destination, string destinationName, SqliteConnectionHandle source, string sourceName) { throw new System.NotImplementedException(); }
+        public static int sqlite3_backup_pagecount(SqliteBackupHandle backup) { throw new System.NotImplementedException(); }
+        public static int sqlite3_backup_remaining(SqliteBackupHandle backup) { throw new System.NotImplementedException(); }
+        public static int sqlite3_backup_step(SqliteBackupHandle backup, int pages) { throw new System.NotImplementedException(); }
+        public static int sqlite3_bind_array(SqliteStatementHandle statement, int index, long[] integers, double[] doubles, string[] texts, byte[] nulls) { throw new System.NotImplementedException(); }
         public static int sqlite3_bind_blob(SqliteStatementHandle statement, int index, byte[] value, int length, object dummy) { throw new System.NotImplementedException(); }
         public static int sqlite3_bind_double(SqliteStatementHandle statement, int index, double value) { throw new System.NotImplementedException(); }
         public static int sqlite3_bind_int(SqliteStatementHandle statement, int index, int value) { throw new System.NotImplementedException(); }
@@ -348,12 +658,23 @@ public sealed class UnsafeNativeMethods
         public static string sqlite3_bind_parameter_name(SqliteStatementHandle statement, int index) { throw new System.NotImplementedException(); }
         public static int sqlite3_bind_text(SqliteStatementHandle statement, int index, string value, int length, object dummy) { throw new System.NotImplementedException(); }
         public static int sqlite3_bind_text16(SqliteStatementHandle statement, int index, string value, int length) { throw new System.NotImplementedException(); }
+        public static int sqlite3_blob_bytes(SqliteBlobHandle blob) { throw new System.NotImplementedException(); }
+        public static int sqlite3_blob_close(SqliteBlobHandle blob) { throw new System.NotImplementedException(); }
+        public static int sqlite3_blob_open(SqliteConnectionHandle db, string dbName, string tableName, string columnName, long rowid, int flags, out SqliteBlobHandle blob) { throw new System.NotImplementedException(); }
+        public static int sqlite3_blob_read(SqliteBlobHandle blob, byte[] destination, int destinationOffset, int count, int blobOffset) { throw new System.NotImplementedException(); }
+        public static int sqlite3_blob_reopen(SqliteBlobHandle blob, long rowid) { throw new System.NotImplementedException(); }
+        public static int sqlite3_blob_write(SqliteBlobHandle blob, byte[] source, int sourceOffset, int count, int blobOffset) { throw new System.NotImplementedException(); }
+        public static int sqlite3_busy_handler(SqliteConnectionHandle db, SqliteBusyHandlerDelegate callback, object userState) { throw new System.NotImplementedException(); }
         public static int sqlite3_busy_timeout(SqliteConnectionHandle db, int miliseconds) { throw new System.NotImplementedException(); }
         public static int sqlite3_changes(SqliteConnectionHandle db) { throw new System.NotImplementedException(); }
+        public static int sqlite3_clear_bindings(SqliteStatementHandle statement) { throw new System.NotImplementedException(); }
         public static int sqlite3_close(SqliteConnectionHandle db) { throw new System.NotImplementedException(); }
         public static byte[] sqlite3_column_blob(SqliteStatementHandle __unnamed000, int index) { throw new System.NotImplementedException(); }
+        public static int sqlite3_column_blob_copy(SqliteStatementHandle statement, int index, int sourceOffset, byte[] destination, int destinationOffset, int count) { throw new System.NotImplementedException(); }
+        public static SqliteBlobView sqlite3_column_blob_view(SqliteStatementHandle statement, int index) { throw new System.NotImplementedException(); }
         public static int sqlite3_column_bytes(SqliteStatementHandle statement, int index) { throw new System.NotImplementedException(); }
         public static int sqlite3_column_count(SqliteStatementHandle rstatement) { throw new System.NotImplementedException(); }
+        public static int sqlite3_column_datetime(SqliteStatementHandle statement, int index, out long ticks) { throw new System.NotImplementedException(); }
         public static string sqlite3_column_database_name(SqliteStatementHandle statement, int index) { throw new System.NotImplementedException(); }
         public static string sqlite3_column_database_name16(SqliteStatementHandle statement, int index) { throw new System.NotImplementedException(); }
         public static string sqlite3_column_decltype(SqliteStatementHandle statement, int index) { throw new System.NotImplementedException(); }
@@ -368,9 +689,18 @@ public sealed class UnsafeNativeMethods
         public static string sqlite3_column_table_name16(SqliteStatementHandle statement, int index) { throw new System.NotImplementedException(); }
         public static string sqlite3_column_text(SqliteStatementHandle statement, int index) { throw new System.NotImplementedException(); }
         public static string sqlite3_column_text16(SqliteStatementHandle statement, int index) { throw new System.NotImplementedException(); }
+        public static SqliteBlobView sqlite3_column_text_view(SqliteStatementHandle statement, int index) { throw new System.NotImplementedException(); }
         public static int sqlite3_column_type(SqliteStatementHandle statement, int index) { throw new System.NotImplementedException(); }
         public static void sqlite3_commit_hook(SqliteConnectionHandle db, SqliteCommitHookDelegate callback, object userState) { throw new System.NotImplementedException(); }
-        public static int sqlite3_config(int option, object[] arguments) { throw new System.NotImplementedException(); }
+        public static int sqlite3_config(int option) { throw new System.NotImplementedException(); }
+        public static int sqlite3_config_int(int option, int value) { throw new System.NotImplementedException(); }
+        public static int sqlite3_config_int64_int64(int option, long value1, long value2) { throw new System.NotImplementedException(); }
+        public static int sqlite3_config_int_int(int option, int value1, int value2) { throw new System.NotImplementedException(); }
+        public static int sqlite3_config_pagecache(int pageSize, int pageCount) { throw new System.NotImplementedException(); }
+        public static int sqlite3_create_collation(SqliteConnectionHandle db, string name, SQLiteCollation compare) { throw new System.NotImplementedException(); }
+        public static int sqlite3_create_function(SqliteConnectionHandle db, string name, int nArgs, SQLiteCallback func, SQLiteCallback funcstep, SQLiteFinalCallback funcfinal) { throw new System.NotImplementedException(); }
+        public static int sqlite3_db_config_lookaside(SqliteConnectionHandle db, int slotSize, int slotCount) { throw new System.NotImplementedException(); }
+        public static int sqlite3_db_status(SqliteConnectionHandle db, int op, out int current, out int highwater, int resetFlag) { throw new System.NotImplementedException(); }
         public static string sqlite3_errmsg(SqliteConnectionHandle db) { throw new System.NotImplementedException(); }
         public static int sqlite3_exec(SqliteConnectionHandle db, string query, out string errmsg) { throw new System.NotImplementedException(); }
         public static int sqlite3_finalize(SqliteStatementHandle statement) { throw new System.NotImplementedException(); }
@@ -384,6 +714,7 @@ public sealed class UnsafeNativeMethods
         public static int sqlite3_open16(string filename, out SqliteConnectionHandle db) { throw new System.NotImplementedException(); }
         public static int sqlite3_prepare_v2(SqliteConnectionHandle db, string query, out SqliteStatementHandle statement) { throw new System.NotImplementedException(); }
         public static int sqlite3_prepare16(SqliteConnectionHandle db, string query, int length, out SqliteStatementHandle statement, out string strRemain) { throw new System.NotImplementedException(); }
+        public static int sqlite3_progress_handler(SqliteConnectionHandle db, int instructions, SqliteProgressHandlerDelegate callback, object userState) { throw new System.NotImplementedException(); }
         public static int sqlite3_rekey(SqliteConnectionHandle db, string key, int length) { throw new System.NotImplementedException(); }
         public static int sqlite3_reset(SqliteStatementHandle statement) { throw new System.NotImplementedException(); }
         public static void sqlite3_result_blob(SqliteContextHandle context, byte[] value, int length, object dummy) { throw new System.NotImplementedException(); }
@@ -396,10 +727,18 @@ public sealed class UnsafeNativeMethods
         public static void sqlite3_result_text(SqliteContextHandle statement, string value, int index, object dummy) { throw new System.NotImplementedException(); }
         public static void sqlite3_result_text16(SqliteContextHandle statement, string value, int index, object dummy) { throw new System.NotImplementedException(); }
         public static void sqlite3_rollback_hook(SqliteConnectionHandle db, SqliteRollbackHookDelegate callback, object userState) { throw new System.NotImplementedException(); }
+        public static long sqlite3_soft_heap_limit64(long limit) { throw new System.NotImplementedException(); }
+        public static int sqlite3_status64(int op, out long current, out long highwater, int resetFlag) { throw new System.NotImplementedException(); }
         public static int sqlite3_step(SqliteStatementHandle statement) { throw new System.NotImplementedException(); }
+        public static int sqlite3_step_batch(SqliteStatementHandle statement, int firstRow, int rowCount, int[] kinds, long[] integers, double[] doubles, string[] texts, byte[] blobs, int[] blobOffsets, byte[] nulls, int[] changes, out int rowsDone) { throw new System.NotImplementedException(); }
+        public static int sqlite3_step_block(SqliteStatementHandle statement, int pending, int firstRow, int blobStart, int maxRows, int stride, byte[] types, long[] integers, double[] doubles, string[] texts, byte[] blobs, int[] blobOffsets, out int rowCount, out int blobBytesNeeded) { throw new System.NotImplementedException(); }
+        public static int sqlite3_stmt_status(SqliteStatementHandle statement, int op, int resetFlag) { throw new System.NotImplementedException(); }
         public static int sqlite3_table_column_metadata(SqliteConnectionHandle db, string dbName, string tableName, string columnName, out string dataType, out string collSeq, out int notNull, out int primaryKey, out int autoInc) { throw new System.NotImplementedException(); }
+        public static int sqlite3_trace_v2(SqliteConnectionHandle db, uint mask, SqliteTraceDelegate callback, object userState) { throw new System.NotImplementedException(); }
         public static void sqlite3_update_hook(SqliteConnectionHandle db, SqliteUpdateHookDelegate callback, object userState) { throw new System.NotImplementedException(); }
         public static byte[] sqlite3_value_blob(SqliteValueHandle value) { throw new System.NotImplementedException(); }
+        public static int sqlite3_value_blob_copy(SqliteValueHandle value, int sourceOffset, byte[] destination, int destinationOffset, int count) { throw new System.NotImplementedException(); }
+        public static SqliteBlobView sqlite3_value_blob_view(SqliteValueHandle value) { throw new System.NotImplementedException(); }
         public static int sqlite3_value_bytes(SqliteValueHandle value) { throw new System.NotImplementedException(); }
         public static double sqlite3_value_double(SqliteValueHandle value) { throw new System.NotImplementedException(); }
         public static int sqlite3_value_int(SqliteValueHandle value) { throw new System.NotImplementedException(); }
@@ -407,6 +746,8 @@ public sealed class UnsafeNativeMethods
         public static string sqlite3_value_text(SqliteValueHandle value) { throw new System.NotImplementedException(); }
         public static string sqlite3_value_text16(SqliteValueHandle value) { throw new System.NotImplementedException(); }
         public static int sqlite3_value_type(SqliteValueHandle value) { throw new System.NotImplementedException(); }
+        public static int sqlite3_wal_checkpoint_v2(SqliteConnectionHandle db, string dbName, int mode, out int logFrames, out int checkpointedFrames) { throw new System.NotImplementedException(); }
+        public static void sqlite3_wal_hook(SqliteConnectionHandle db, SqliteWalHookDelegate callback, object userState) { throw new System.NotImplementedException(); }
     }
 }
 
@@ -0,0 +1,190 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ *
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.IO;
+  using MonoDataSqliteWrapper;
+
+  /// <summary>
+  /// Reads and writes a blob stored in the database a piece at a time, with sqlite's incremental blob I/O.
+  /// </summary>
+  /// <remarks>
+  /// Each Read() and Write() copies straight between the blob and the caller's buffer, so a large blob never has to be
+  /// held in memory as a whole.  The size of a blob is fixed: to write a new one, insert or update the row with
+  /// zeroblob(size) first, then open a stream on it and fill it in.  The stream sees the blob of one row; Reopen()
+  /// moves it to another row of the same table and column far more cheaply than opening a new stream.
+  /// If the row is changed or deleted by anything but the stream itself, the stream expires and further reads and
+  /// writes fail with SQLITE_ABORT.  The stream must be disposed before the connection's next write transaction can
+  /// commit; closing the connection disposes any stream still open on it.
+  /// </remarks>
+  public sealed class SqliteBlobStream : Stream
+  {
+    private SqliteConnection _cnn;
+    private SqliteBlobHandle _blob;
+    private readonly bool _writable;
+    private int _length;
+    private long _position;
+
+    internal SqliteBlobStream(SqliteConnection cnn, SqliteBlobHandle blob, bool writable)
+    {
+      _cnn = cnn;
+      _blob = blob;
+      _writable = writable;
+      _length = UnsafeNativeMethods.sqlite3_blob_bytes(blob);
+    }
+
+    public override bool CanRead
+    {
+      get { return _blob != null; }
+    }
+
+    public override bool CanSeek
+    {
+      get { return _blob != null; }
+    }
+
+    public override bool CanWrite
+    {
+      get { return _blob != null && _writable; }
+    }
+
+    public override long Length
+    {
+      get
+      {
+        CheckValid();
+        return _length;
+      }
+    }
+
+    public override long Position
+    {
+      get
+      {
+        CheckValid();
+        return _position;
+      }
+      set
+      {
+        CheckValid();
+        if (value < 0)
+          throw new ArgumentOutOfRangeException("value");
+
+        _position = value;
+      }
+    }
+
+    /// <summary>
+    /// Points the stream at the blob of another row of the same table and column, and rewinds it
+    /// </summary>
+    /// <param name="rowid">The rowid of the row</param>
+    public void Reopen(long rowid)
+    {
+      CheckValid();
+
+      int n = UnsafeNativeMethods.sqlite3_blob_reopen(_blob, rowid);
+      if (n > 0) throw new SqliteException(n, _cnn._sql.SQLiteLastError());
+
+      _length = UnsafeNativeMethods.sqlite3_blob_bytes(_blob);
+      _position = 0;
+    }
+
+    public override int Read(byte[] buffer, int offset, int count)
+    {
+      if (buffer == null)
+        throw new ArgumentNullException("buffer");
+      if (offset < 0 || count < 0 || offset + count > buffer.Length)
+        throw new ArgumentOutOfRangeException("offset");
+
+      CheckValid();
+
+      if (_position >= _length)
+        return 0;
+
+      count = (int)Math.Min(count, _length - _position);
+      int n = UnsafeNativeMethods.sqlite3_blob_read(_blob, buffer, offset, count, (int)_position);
+      if (n > 0) throw new SqliteException(n, _cnn._sql.SQLiteLastError());
+
+      _position += count;
+      return count;
+    }
+
+    public override void Write(byte[] buffer, int offset, int count)
+    {
+      if (buffer == null)
+        throw new ArgumentNullException("buffer");
+      if (offset < 0 || count < 0 || offset + count > buffer.Length)
+        throw new ArgumentOutOfRangeException("offset");
+
+      CheckValid();
+
+      if (_writable == false)
+        throw new NotSupportedException("The blob was opened read-only");
+      if (_position + count > _length)
+        throw new NotSupportedException("A blob cannot grow; write it with zeroblob() at the size it needs first");
+
+      int n = UnsafeNativeMethods.sqlite3_blob_write(_blob, buffer, offset, count, (int)_position);
+      if (n > 0) throw new SqliteException(n, _cnn._sql.SQLiteLastError());
+
+      _position += count;
+    }
+
+    public override long Seek(long offset, SeekOrigin origin)
+    {
+      CheckValid();
+
+      long pos;
+      switch (origin)
+      {
+        case SeekOrigin.Begin:
+          pos = offset;
+          break;
+        case SeekOrigin.Current:
+          pos = _position + offset;
+          break;
+        default:
+          pos = _length + offset;
+          break;
+      }
+
+      if (pos < 0)
+        throw new IOException("An attempt was made to move the position before the beginning of the stream.");
+
+      _position = pos;
+      return _position;
+    }
+
+    public override void Flush()
+    {
+    }
+
+    public override void SetLength(long value)
+    {
+      throw new NotSupportedException("A blob cannot be resized through a stream");
+    }
+
+    protected override void Dispose(bool disposing)
+    {
+      if (_blob != null)
+      {
+        _blob.Dispose();
+        _cnn.RemoveBlobStream(this);
+      }
+      _blob = null;
+      _cnn = null;
+      base.Dispose(disposing);
+    }
+
+    private void CheckValid()
+    {
+      if (_blob == null)
+        throw new ObjectDisposedException("SqliteBlobStream");
+    }
+  }
+}
@@ -0,0 +1,1072 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ *
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.Collections.Generic;
+  using System.Data;
+  using System.Globalization;
+  using System.IO;
+  using System.Reflection;
+  using System.Text;
+  using System.Threading;
+  using System.Threading.Tasks;
+
+  /// <summary>
+  /// Loads large amounts of rows into a table, from a data reader, CSV text or a sequence of objects
+  /// </summary>
+  /// <remarks>
+  /// The copy is a pipeline of two threads.  A worker reads the source and converts its values, BatchSize rows at a
+  /// time, into the column arrays ExecuteBatch() takes, while the calling thread binds and steps them on a single
+  /// INSERT statement, prepared once for the whole copy.  The rows are committed every CommitSize rows, unless the
+  /// connection already has a transaction, which the rows then join.  A copy that fails keeps the rows committed
+  /// before the failure.
+  /// The source must not be used by anything else while the copy runs; a SqliteDataReader must come from another
+  /// connection.  The columns of the source are copied by position into ColumnNames, or into columns of the same
+  /// names.  Values are stored the way parameters of their type are bound; columns typed object are stored as text,
+  /// which the affinity of the destination column converts.
+  /// </remarks>
+  public sealed class SqliteBulkCopy
+  {
+    /// <summary>
+    /// How the values of a column are held in the arrays ExecuteBatch() binds
+    /// </summary>
+    private enum ColumnKind
+    {
+      Integer,
+      Real,
+      Text,
+      Blob,
+    }
+
+    private readonly SqliteConnection _connection;
+    private string _destinationTableName;
+    private IList<string> _columnNames;
+    private int _batchSize = 1000;
+    private int _commitSize = 100000;
+    private char _csvDelimiter = ',';
+    private bool _csvHeader = true;
+    private int _notifyAfter;
+    private long _rows;
+    private double _rowsPerSecond;
+
+    /// <summary>
+    /// Creates a bulk copy into a table of a connection
+    /// </summary>
+    /// <param name="connection">The connection of the destination table, which must be open when the copy starts</param>
+    public SqliteBulkCopy(SqliteConnection connection)
+    {
+      if (connection == null)
+        throw new ArgumentNullException("connection");
+
+      _connection = connection;
+    }
+
+    /// <summary>
+    /// The table the rows are inserted into.  It is written into the INSERT statement as it is, so a name that needs
+    /// quoting must be quoted.
+    /// </summary>
+    public string DestinationTableName
+    {
+      get { return _destinationTableName; }
+      set { _destinationTableName = value; }
+    }
+
+    /// <summary>
+    /// The columns of the destination table that the columns of the source go into, in order, or null to use the
+    /// names of the source's columns.  Must be set for CSV text without a header.
+    /// </summary>
+    public IList<string> ColumnNames
+    {
+      get { return _columnNames; }
+      set { _columnNames = value; }
+    }
+
+    /// <summary>
+    /// The number of rows converted and inserted at a time.  1000 by default.
+    /// </summary>
+    public int BatchSize
+    {
+      get { return _batchSize; }
+      set
+      {
+        if (value < 1)
+          throw new ArgumentOutOfRangeException("value");
+
+        _batchSize = value;
+      }
+    }
+
+    /// <summary>
+    /// The number of rows committed at a time, rounded up to a whole batch, or 0 to copy all the rows in one
+    /// transaction.  100000 by default.
+    /// </summary>
+    public int CommitSize
+    {
+      get { return _commitSize; }
+      set
+      {
+        if (value < 0)
+          throw new ArgumentOutOfRangeException("value");
+
+        _commitSize = value;
+      }
+    }
+
+    /// <summary>
+    /// Whether to drop the indexes of the destination table before the copy and create them again after it, which is
+    /// faster than keeping them up to date row by row.  Off by default.  UNIQUE indexes stay in place, so the rows
+    /// they reject are still rejected as they are inserted.  An index that cannot be created again fails the copy
+    /// with a SqliteException naming its statement, after the others have been created.
+    /// </summary>
+    public bool DeferIndexes { get; set; }
+
+    /// <summary>
+    /// Whether to turn off syncing and keep the rollback journal in memory while the copy runs, restoring both after
+    /// it.  A database in WAL mode keeps its journal mode.  Off by default: a crash or power loss during the copy can
+    /// then corrupt the database, so it is only for loads that can start over from an empty database.
+    /// </summary>
+    public bool RelaxDurability { get; set; }
+
+    /// <summary>
+    /// The character between the fields of CSV text.  A comma by default.
+    /// </summary>
+    public char CsvDelimiter
+    {
+      get { return _csvDelimiter; }
+      set { _csvDelimiter = value; }
+    }
+
+    /// <summary>
+    /// Whether the first record of CSV text holds the names of the columns.  On by default.
+    /// </summary>
+    public bool CsvHeader
+    {
+      get { return _csvHeader; }
+      set { _csvHeader = value; }
+    }
+
+    /// <summary>
+    /// The number of rows between two Progress events, or 0 for none
+    /// </summary>
+    public int NotifyAfter
+    {
+      get { return _notifyAfter; }
+      set
+      {
+        if (value < 0)
+          throw new ArgumentOutOfRangeException("value");
+
+        _notifyAfter = value;
+      }
+    }
+
+    /// <summary>
+    /// The number of rows inserted by the copy in progress, or by the last one
+    /// </summary>
+    public long Rows
+    {
+      get { return _rows; }
+    }
+
+    /// <summary>
+    /// The number of rows inserted per second by the copy in progress, or by the last one
+    /// </summary>
+    public double RowsPerSecond
+    {
+      get { return _rowsPerSecond; }
+    }
+
+    /// <summary>
+    /// Raised on the copying thread every NotifyAfter rows
+    /// </summary>
+    public event SqliteBulkCopyProgressHandler Progress;
+
+    /// <summary>
+    /// Copies the rows of a data reader
+    /// </summary>
+    /// <param name="reader">The rows to copy, read up to their end</param>
+    public void WriteToServer(IDataReader reader)
+    {
+      if (reader == null)
+        throw new ArgumentNullException("reader");
+
+      Copy(new DataReaderSource(this, reader));
+    }
+
+    /// <summary>
+    /// Copies the records of CSV text.  Fields may be quoted with double quotes, which lets them hold the delimiter,
+    /// line breaks and doubled double quotes.  An empty field that is not quoted is NULL; blank lines are skipped.
+    /// </summary>
+    /// <param name="csv">The CSV text, read up to its end</param>
+    public void WriteToServer(TextReader csv)
+    {
+      if (csv == null)
+        throw new ArgumentNullException("csv");
+
+      Copy(new CsvSource(this, csv));
+    }
+
+    /// <summary>
+    /// Copies a sequence of objects, one row per object.  Each column is read from the public property of the same
+    /// name, ignoring case; without ColumnNames, every public readable property is copied.
+    /// </summary>
+    /// <param name="rows">The objects to copy</param>
+    public void WriteToServer<T>(IEnumerable<T> rows) where T : class
+    {
+      if (rows == null)
+        throw new ArgumentNullException("rows");
+
+      Copy(new ObjectSource<T>(this, rows));
+    }
+
+    private void Copy(Source source)
+    {
+      using (source)
+      {
+        if (_connection.State != ConnectionState.Open)
+          throw new InvalidOperationException("The connection must be open to copy rows into it");
+        if (String.IsNullOrEmpty(_destinationTableName))
+          throw new InvalidOperationException("DestinationTableName must be set");
+        if (source.Names.Length == 0)
+          throw new InvalidOperationException("The source has no columns to copy");
+
+        _rows = 0;
+        _rowsPerSecond = 0;
+        int starttick = Environment.TickCount;
+
+        // Both are filled as the settings change and the indexes go, so a failure halfway undoes what was done
+        var restore = new StringBuilder();
+        var indexes = new List<string>();
+        Exception failure = null;
+        try
+        {
+          if (RelaxDurability)
+            Relax(restore);
+          if (DeferIndexes)
+            DropIndexes(indexes);
+          Load(source, starttick);
+        }
+        catch (Exception ex)
+        {
+          failure = ex;
+          throw;
+        }
+        finally
+        {
+          string failed;
+          try
+          {
+            failed = CreateIndexes(indexes);
+          }
+          finally
+          {
+            if (restore.Length > 0)
+              Execute(restore.ToString());
+          }
+
+          if (failed != null)
+            throw new SqliteException(failed, failure);
+        }
+      }
+    }
+
+    /// <summary>
+    /// Writes the batches the pipeline's worker converts, committing every CommitSize rows
+    /// </summary>
+    private void Load(Source source, int starttick)
+    {
+      var sql = new StringBuilder("INSERT INTO ");
+      sql.Append(_destinationTableName).Append(" (");
+      for (int n = 0; n < source.Names.Length; n++)
+        sql.Append((n > 0) ? ", " : "").Append(Quote(source.Names[n]));
+      sql.Append(") VALUES (");
+      for (int n = 0; n < source.Names.Length; n++)
+        sql.Append((n > 0) ? ", ?" : "?");
+      sql.Append(")");
+
+      bool ownTransaction = _connection._transactionLevel == 0;
+      SqliteTransaction transaction = null;
+      long uncommitted = 0;
+
+      var pipeline = new Pipeline(source, _batchSize);
+      try
+      {
+        using (SqliteCommand cmd = _connection.CreateCommand())
+        {
+          cmd.CommandText = sql.ToString();
+
+          Array[] batch;
+          while ((batch = pipeline.Take()) != null)
+          {
+            if (ownTransaction && transaction == null)
+              transaction = _connection.BeginTransaction();
+
+            int rows = batch[0].Length;
+            cmd.ExecuteBatch(batch);
+            pipeline.Return(batch);
+
+            _rows += rows;
+            uncommitted += rows;
+            if (transaction != null && _commitSize > 0 && uncommitted >= _commitSize)
+            {
+              transaction.Commit();
+              transaction = null;
+              uncommitted = 0;
+            }
+
+            uint elapsed = (uint)Environment.TickCount - (uint)starttick;
+            _rowsPerSecond = _rows * 1000.0 / Math.Max(1, elapsed);
+            if (_notifyAfter > 0 && Progress != null && _rows / _notifyAfter != (_rows - rows) / _notifyAfter)
+              Progress(this, new SqliteBulkCopyProgressEventArgs(_rows, _rowsPerSecond));
+          }
+
+          if (transaction != null)
+          {
+            transaction.Commit();
+            transaction = null;
+          }
+        }
+      }
+      finally
+      {
+        // The source is the caller's again once the copy returns
+        pipeline.Stop();
+        if (transaction != null)
+          transaction.Dispose();
+      }
+    }
+
+    /// <summary>
+    /// Turns syncing off and moves the journal to memory
+    /// </summary>
+    /// <param name="restore">Receives the commands that restore the settings</param>
+    private void Relax(StringBuilder restore)
+    {
+      // Neither setting can change inside a transaction
+      if (_connection._transactionLevel > 0)
+        throw new InvalidOperationException("RelaxDurability cannot be used while the connection has a transaction");
+
+      long synchronous = Convert.ToInt64(Scalar("PRAGMA synchronous"), CultureInfo.InvariantCulture);
+      var journalMode = (string)Scalar("PRAGMA journal_mode");
+
+      restore.AppendFormat(CultureInfo.InvariantCulture, "PRAGMA synchronous={0};", synchronous);
+      Execute("PRAGMA synchronous=OFF");
+
+      // Leaving WAL mode needs the database to itself, and the WAL is cheap to write without syncs anyway
+      if (String.Compare(journalMode, "wal", StringComparison.OrdinalIgnoreCase) != 0)
+      {
+        restore.AppendFormat(CultureInfo.InvariantCulture, "PRAGMA journal_mode={0};", journalMode);
+        Execute("PRAGMA journal_mode=MEMORY");
+      }
+    }
+
+    /// <summary>
+    /// Drops the indexes of the destination table that were created with CREATE INDEX, except UNIQUE ones
+    /// </summary>
+    /// <param name="indexes">Receives the statements that create the dropped indexes again</param>
+    private void DropIndexes(List<string> indexes)
+    {
+      var names = new List<string>();
+      var sql = new List<string>();
+      using (var cmd = new SqliteCommand(
+        "SELECT name, sql FROM sqlite_master WHERE type = 'index' AND tbl_name = :table COLLATE NOCASE AND sql IS NOT NULL " +
+        "AND sql NOT LIKE 'CREATE UNIQUE %'",
+        _connection))
+      {
+        cmd.Parameters.Add(new SqliteParameter("table", _destinationTableName.Trim('"', '[', ']', '`')));
+        using (SqliteDataReader reader = cmd.ExecuteReader())
+        {
+          while (reader.Read())
+          {
+            names.Add(reader.GetString(0));
+            sql.Add(reader.GetString(1));
+          }
+        }
+      }
+
+      for (int n = 0; n < names.Count; n++)
+      {
+        Execute("DROP INDEX " + Quote(names[n]));
+        indexes.Add(sql[n]);
+      }
+    }
+
+    /// <summary>
+    /// Creates the dropped indexes again, going on past the ones that fail
+    /// </summary>
+    /// <returns>A message naming the statements that failed and why, or null if none did</returns>
+    private string CreateIndexes(List<string> indexes)
+    {
+      StringBuilder failed = null;
+      foreach (string index in indexes)
+      {
+        try
+        {
+          Execute(index);
+        }
+        catch (SqliteException ex)
+        {
+          if (failed == null)
+            failed = new StringBuilder("The copy could not create these indexes again:");
+          failed.AppendLine().Append(index).Append(": ").Append(ex.Message);
+        }
+      }
+      return (failed != null) ? failed.ToString() : null;
+    }
+
+    private void Execute(string sql)
+    {
+      using (var cmd = new SqliteCommand(sql, _connection))
+        cmd.ExecuteNonQuery();
+    }
+
+    private object Scalar(string sql)
+    {
+      using (var cmd = new SqliteCommand(sql, _connection))
+        return cmd.ExecuteScalar();
+    }
+
+    private static string Quote(string name)
+    {
+      return "\"" + name.Replace("\"", "\"\"") + "\"";
+    }
+
+    /// <summary>
+    /// Hands batches of converted rows from the worker reading the source to the thread inserting them
+    /// </summary>
+    /// <remarks>
+    /// At most MaxBatches batches exist at a time, so a source read faster than it is written does not fill memory.
+    /// The writer gives the batches it is done with back to be filled again.
+    /// </remarks>
+    private sealed class Pipeline
+    {
+      private const int MaxBatches = 4;
+
+      private readonly Source _source;
+      private readonly int _batchSize;
+      private readonly Queue<Array[]> _full = new Queue<Array[]>();
+      private readonly Stack<Array[]> _free = new Stack<Array[]>();
+      private int _batches;
+      private bool _done;
+      private bool _stopping;
+      private Exception _error;
+      private readonly Task _task;
+
+      internal Pipeline(Source source, int batchSize)
+      {
+        _source = source;
+        _batchSize = batchSize;
+        _task = Task.Factory.StartNew(Run, TaskCreationOptions.LongRunning);
+      }
+
+      /// <summary>
+      /// Waits for the next batch
+      /// </summary>
+      /// <returns>The column arrays of the batch, or null once the source is read to its end</returns>
+      internal Array[] Take()
+      {
+        lock (_full)
+        {
+          while (_full.Count == 0 && _done == false)
+            Monitor.Wait(_full);
+
+          if (_full.Count > 0)
+            return _full.Dequeue();
+          if (_error != null)
+            throw _error;
+          return null;
+        }
+      }
+
+      /// <summary>
+      /// Gives back a batch that has been inserted
+      /// </summary>
+      internal void Return(Array[] batch)
+      {
+        // The last batch is cut to the rows it holds
+        if (batch[0].Length != _batchSize)
+          return;
+
+        lock (_full)
+        {
+          _free.Push(batch);
+          Monitor.PulseAll(_full);
+        }
+      }
+
+      /// <summary>
+      /// Stops the worker, and waits for it to be done with the source
+      /// </summary>
+      internal void Stop()
+      {
+        lock (_full)
+        {
+          _stopping = true;
+          Monitor.PulseAll(_full);
+        }
+        _task.Wait();
+      }
+
+      private void Run()
+      {
+        try
+        {
+          while (true)
+          {
+            Array[] batch = null;
+            lock (_full)
+            {
+              while (_free.Count == 0 && _batches >= MaxBatches && _stopping == false)
+                Monitor.Wait(_full);
+
+              if (_stopping)
+                return;
+
+              if (_free.Count > 0)
+                batch = _free.Pop();
+              else
+                _batches++;
+            }
+
+            if (batch == null)
+              batch = _source.NewBatch(_batchSize);
+            else
+              Clear(batch);
+
+            int rows = _source.Read(batch);
+            if (rows == 0)
+              return;
+
+            if (rows < _batchSize)
+              batch = Cut(batch, rows);
+
+            lock (_full)
+            {
+              _full.Enqueue(batch);
+              Monitor.PulseAll(_full);
+            }
+
+            if (rows < _batchSize)
+              return;
+          }
+        }
+        catch (Exception ex)
+        {
+          lock (_full)
+            _error = ex;
+        }
+        finally
+        {
+          lock (_full)
+          {
+            _done = true;
+            Monitor.PulseAll(_full);
+          }
+        }
+      }
+
+      private static void Clear(Array[] batch)
+      {
+        foreach (Array column in batch)
+          Array.Clear(column, 0, column.Length);
+      }
+
+      private static Array[] Cut(Array[] batch, int rows)
+      {
+        var cut = new Array[batch.Length];
+        for (int n = 0; n < batch.Length; n++)
+        {
+          cut[n] = Array.CreateInstance(batch[n].GetType().GetElementType(), rows);
+          Array.Copy(batch[n], cut[n], rows);
+        }
+        return cut;
+      }
+    }
+
+    /// <summary>
+    /// Reads rows from where they are copied from, and converts their values for ExecuteBatch()
+    /// </summary>
+    private abstract class Source : IDisposable
+    {
+      private readonly SQLiteBase _sql;
+      private readonly bool _binaryGuid;
+
+      /// <summary>
+      /// The destination columns
+      /// </summary>
+      internal string[] Names;
+      internal ColumnKind[] Kinds;
+
+      protected Source(SqliteBulkCopy copy)
+      {
+        _sql = copy._connection._sql;
+        _binaryGuid = copy._connection._binaryGuid;
+      }
+
+      /// <summary>
+      /// Reads rows into the arrays of a batch, which are empty
+      /// </summary>
+      /// <returns>The number of rows read, fewer than the batch holds only at the end of the source</returns>
+      internal abstract int Read(Array[] batch);
+
+      public virtual void Dispose()
+      {
+      }
+
+      internal Array[] NewBatch(int rows)
+      {
+        var batch = new Array[Kinds.Length];
+        for (int n = 0; n < batch.Length; n++)
+        {
+          switch (Kinds[n])
+          {
+            case ColumnKind.Integer:
+              batch[n] = new long?[rows];
+              break;
+            case ColumnKind.Real:
+              batch[n] = new double?[rows];
+              break;
+            case ColumnKind.Blob:
+              batch[n] = new byte[rows][];
+              break;
+            default:
+              batch[n] = new string[rows];
+              break;
+          }
+        }
+        return batch;
+      }
+
+      /// <summary>
+      /// Picks the arrays for a column of the given type, as parameters of the type are bound
+      /// </summary>
+      protected ColumnKind KindOf(Type type)
+      {
+        type = Nullable.GetUnderlyingType(type) ?? type;
+
+        switch (SqliteConvert.TypeToDbType(type))
+        {
+          case DbType.Boolean:
+          case DbType.SByte:
+          case DbType.Byte:
+          case DbType.Int16:
+          case DbType.UInt16:
+          case DbType.Int32:
+          case DbType.UInt32:
+          case DbType.Int64:
+          case DbType.UInt64:
+            return ColumnKind.Integer;
+          case DbType.Single:
+          case DbType.Double:
+          case DbType.Currency:
+            return ColumnKind.Real;
+          case DbType.Binary:
+            return ColumnKind.Blob;
+          case DbType.Guid:
+            return _binaryGuid ? ColumnKind.Blob : ColumnKind.Text;
+          default:
+            return ColumnKind.Text;
+        }
+      }
+
+      /// <summary>
+      /// Stores a value of any type in a batch
+      /// </summary>
+      protected void Store(Array[] batch, int column, int row, object value)
+      {
+        if (value == null || value is DBNull)
+          return;
+
+        switch (Kinds[column])
+        {
+          case ColumnKind.Integer:
+            ((long?[])batch[column])[row] = Convert.ToInt64(value, CultureInfo.CurrentCulture);
+            break;
+          case ColumnKind.Real:
+            ((double?[])batch[column])[row] = Convert.ToDouble(value, CultureInfo.CurrentCulture);
+            break;
+          case ColumnKind.Blob:
+            ((byte[][])batch[column])[row] = (value is Guid) ? ((Guid)value).ToByteArray() : (byte[])value;
+            break;
+          default:
+            ((string[])batch[column])[row] = ToText(value);
+            break;
+        }
+      }
+
+      private string ToText(object value)
+      {
+        var s = value as string;
+        if (s != null)
+          return s;
+
+        if (value is DateTime)
+          return _sql.ToString((DateTime)value);
+        // Dont store decimal as double ... loses precision
+        if (value is decimal)
+          return ((decimal)value).ToString(CultureInfo.InvariantCulture);
+        return value.ToString();
+      }
+    }
+
+    private sealed class DataReaderSource : Source
+    {
+      private readonly IDataReader _reader;
+
+      internal DataReaderSource(SqliteBulkCopy copy, IDataReader reader)
+        : base(copy)
+      {
+        _reader = reader;
+
+        int count = reader.FieldCount;
+        if (copy._columnNames != null && copy._columnNames.Count != count)
+          throw new InvalidOperationException(String.Format(CultureInfo.CurrentCulture,
+            "The reader has {0} columns, but ColumnNames has {1}", count, copy._columnNames.Count));
+
+        Names = new string[count];
+        Kinds = new ColumnKind[count];
+        for (int n = 0; n < count; n++)
+        {
+          Names[n] = (copy._columnNames != null) ? copy._columnNames[n] : reader.GetName(n);
+          Kinds[n] = KindOf(reader.GetFieldType(n));
+        }
+      }
+
+      internal override int Read(Array[] batch)
+      {
+        int rows = batch[0].Length;
+        int row = 0;
+        while (row < rows && _reader.Read())
+        {
+          for (int n = 0; n < batch.Length; n++)
+            Store(batch, n, row, _reader.GetValue(n));
+          row++;
+        }
+        return row;
+      }
+    }
+
+    private sealed class CsvSource : Source
+    {
+      private const int BufferSize = 65536;
+
+      private readonly TextReader _reader;
+      private readonly char _delimiter;
+      private readonly char[] _buffer = new char[BufferSize];
+      private int _position;
+      private int _length;
+      private readonly StringBuilder _field = new StringBuilder();
+      private readonly List<string> _fields = new List<string>();
+      private long _record;
+
+      internal CsvSource(SqliteBulkCopy copy, TextReader reader)
+        : base(copy)
+      {
+        _reader = reader;
+        _delimiter = copy._csvDelimiter;
+
+        if (copy._csvHeader && ReadRecord())
+          Names = _fields.ToArray();
+        if (copy._columnNames != null)
+          Names = new List<string>(copy._columnNames).ToArray();
+        if (Names == null)
+          throw new InvalidOperationException("ColumnNames must be set to copy CSV text without a header");
+
+        // The affinity of the destination columns converts the text
+        Kinds = new ColumnKind[Names.Length];
+        for (int n = 0; n < Kinds.Length; n++)
+          Kinds[n] = ColumnKind.Text;
+      }
+
+      internal override int Read(Array[] batch)
+      {
+        int rows = batch[0].Length;
+        int row = 0;
+        while (row < rows && ReadRecord())
+        {
+          if (_fields.Count != batch.Length)
+            throw new FormatException(String.Format(CultureInfo.CurrentCulture,
+              "Record {0} of the CSV text has {1} fields instead of {2}", _record, _fields.Count, batch.Length));
+
+          for (int n = 0; n < batch.Length; n++)
+            ((string[])batch[n])[row] = _fields[n];
+          row++;
+        }
+        return row;
+      }
+
+      /// <summary>
+      /// Reads the fields of the next record that is not a blank line
+      /// </summary>
+      /// <returns>False at the end of the text</returns>
+      private bool ReadRecord()
+      {
+        _fields.Clear();
+        while (true)
+        {
+          int ch = Peek();
+          if (ch == -1)
+            return false;
+          if (ch != '\r' && ch != '\n')
+            break;
+          _position++;
+        }
+        _record++;
+
+        while (true)
+        {
+          _fields.Add((Peek() == '"') ? ReadQuoted() : ReadUnquoted());
+
+          int ch = Peek();
+          if (ch == _delimiter)
+          {
+            _position++;
+            continue;
+          }
+
+          if (ch == '\r' || ch == '\n')
+          {
+            _position++;
+            if (ch == '\r' && Peek() == '\n')
+              _position++;
+          }
+          return true;
+        }
+      }
+
+      private string ReadUnquoted()
+      {
+        _field.Length = 0;
+        while (_position < _length || Fill())
+        {
+          int start = _position;
+          while (_position < _length)
+          {
+            char c = _buffer[_position];
+            if (c == _delimiter || c == '\r' || c == '\n')
+              break;
+            _position++;
+          }
+
+          // Most fields end in the buffer they start in, and need no builder
+          if (_position < _length && _field.Length == 0)
+            return (_position > start) ? new string(_buffer, start, _position - start) : null;
+
+          _field.Append(_buffer, start, _position - start);
+          if (_position < _length)
+            break;
+        }
+        return (_field.Length > 0) ? _field.ToString() : null;
+      }
+
+      private string ReadQuoted()
+      {
+        _position++;
+        _field.Length = 0;
+        while (true)
+        {
+          if (_position == _length && Fill() == false)
+            throw new FormatException(String.Format(CultureInfo.CurrentCulture,
+              "Record {0} of the CSV text ends inside a quoted field", _record));
+
+          int start = _position;
+          while (_position < _length && _buffer[_position] != '"')
+            _position++;
+          _field.Append(_buffer, start, _position - start);
+          if (_position == _length)
+            continue;
+
+          // A doubled quote stands for one
+          _position++;
+          if (Peek() != '"')
+            break;
+          _field.Append('"');
+          _position++;
+        }
+
+        int ch = Peek();
+        if (ch != -1 && ch != _delimiter && ch != '\r' && ch != '\n')
+          throw new FormatException(String.Format(CultureInfo.CurrentCulture,
+            "Record {0} of the CSV text has characters after the closing quote of a field", _record));
+        return _field.ToString();
+      }
+
+      private int Peek()
+      {
+        if (_position == _length && Fill() == false)
+          return -1;
+        return _buffer[_position];
+      }
+
+      private bool Fill()
+      {
+        _length = _reader.Read(_buffer, 0, _buffer.Length);
+        _position = 0;
+        return _length > 0;
+      }
+    }
+
+    private sealed class ObjectSource<T> : Source where T : class
+    {
+      private readonly IEnumerator<T> _rows;
+      private readonly Action<T, Array[], int>[] _stores;
+
+      internal ObjectSource(SqliteBulkCopy copy, IEnumerable<T> rows)
+        : base(copy)
+      {
+        var properties = new Dictionary<string, PropertyInfo>(StringComparer.OrdinalIgnoreCase);
+        var names = new List<string>();
+        foreach (PropertyInfo property in typeof(T).GetProperties())
+        {
+          MethodInfo getter = property.GetGetMethod();
+          if (getter == null || getter.IsPublic == false || getter.IsStatic || property.GetIndexParameters().Length != 0)
+            continue;
+          properties[property.Name] = property;
+          names.Add(property.Name);
+        }
+
+        if (copy._columnNames != null)
+          names = new List<string>(copy._columnNames);
+
+        Names = names.ToArray();
+        Kinds = new ColumnKind[Names.Length];
+        _stores = new Action<T, Array[], int>[Names.Length];
+        for (int n = 0; n < Names.Length; n++)
+        {
+          PropertyInfo property;
+          if (properties.TryGetValue(Names[n], out property) == false)
+            throw new InvalidOperationException(String.Format(CultureInfo.CurrentCulture,
+              "{0} has no public property named {1}", typeof(T).Name, Names[n]));
+
+          Kinds[n] = KindOf(property.PropertyType);
+          _stores[n] = CreateStore(property, n);
+        }
+
+        _rows = rows.GetEnumerator();
+      }
+
+      internal override int Read(Array[] batch)
+      {
+        int rows = batch[0].Length;
+        int row = 0;
+        while (row < rows && _rows.MoveNext())
+        {
+          T obj = _rows.Current;
+          if (obj == null)
+            throw new InvalidOperationException("The rows to copy cannot hold null");
+
+          for (int n = 0; n < _stores.Length; n++)
+            _stores[n](obj, batch, row);
+          row++;
+        }
+        return row;
+      }
+
+      public override void Dispose()
+      {
+        _rows.Dispose();
+      }
+
+      /// <summary>
+      /// Returns the function that stores a property in its column.  The properties of the most common types are
+      /// read with a typed delegate, without boxing.
+      /// </summary>
+      private Action<T, Array[], int> CreateStore(PropertyInfo property, int column)
+      {
+        Type type = property.PropertyType;
+
+        if (type == typeof(long)) return Integer(Getter<long>(property), column);
+        if (type == typeof(int)) return Integer(Getter<int>(property), column);
+        if (type == typeof(bool)) return Integer(Getter<bool>(property), column);
+        if (type == typeof(double)) return Real(Getter<double>(property), column);
+        if (type == typeof(long?)) return Integer(Getter<long?>(property), column);
+        if (type == typeof(int?)) return Integer(Getter<int?>(property), column);
+        if (type == typeof(double?)) return Real(Getter<double?>(property), column);
+        if (type == typeof(string)) return Reference(Getter<string>(property), column);
+        if (type == typeof(byte[])) return Reference(Getter<byte[]>(property), column);
+
+        return (obj, batch, row) => Store(batch, column, row, property.GetValue(obj, null));
+      }
+
+      private static Func<T, V> Getter<V>(PropertyInfo property)
+      {
+        return (Func<T, V>)property.GetGetMethod().CreateOpenDelegate(typeof(Func<T, V>));
+      }
+
+      private static Action<T, Array[], int> Integer(Func<T, long> get, int column)
+      {
+        return (obj, batch, row) => ((long?[])batch[column])[row] = get(obj);
+      }
+
+      private static Action<T, Array[], int> Integer(Func<T, int> get, int column)
+      {
+        return (obj, batch, row) => ((long?[])batch[column])[row] = get(obj);
+      }
+
+      private static Action<T, Array[], int> Integer(Func<T, bool> get, int column)
+      {
+        return (obj, batch, row) => ((long?[])batch[column])[row] = get(obj) ? 1 : 0;
+      }
+
+      private static Action<T, Array[], int> Integer(Func<T, long?> get, int column)
+      {
+        return (obj, batch, row) => ((long?[])batch[column])[row] = get(obj);
+      }
+
+      private static Action<T, Array[], int> Integer(Func<T, int?> get, int column)
+      {
+        return (obj, batch, row) => ((long?[])batch[column])[row] = get(obj);
+      }
+
+      private static Action<T, Array[], int> Real(Func<T, double> get, int column)
+      {
+        return (obj, batch, row) => ((double?[])batch[column])[row] = get(obj);
+      }
+
+      private static Action<T, Array[], int> Real(Func<T, double?> get, int column)
+      {
+        return (obj, batch, row) => ((double?[])batch[column])[row] = get(obj);
+      }
+
+      private static Action<T, Array[], int> Reference<V>(Func<T, V> get, int column) where V : class
+      {
+        return (obj, batch, row) => ((V[])batch[column])[row] = get(obj);
+      }
+    }
+  }
+
+  /// <summary>
+  /// Raised every NotifyAfter rows of a bulk copy
+  /// </summary>
+  /// <param name="sender">The SqliteBulkCopy</param>
+  /// <param name="e">How far the copy is</param>
+  public delegate void SqliteBulkCopyProgressHandler(object sender, SqliteBulkCopyProgressEventArgs e);
+
+  /// <summary>
+  /// Passed to the Progress event of a bulk copy
+  /// </summary>
+  public class SqliteBulkCopyProgressEventArgs : EventArgs
+  {
+    /// <summary>
+    /// The number of rows inserted so far
+    /// </summary>
+    public readonly long Rows;
+
+    /// <summary>
+    /// The number of rows inserted per second since the copy started
+    /// </summary>
+    public readonly double RowsPerSecond;
+
+    internal SqliteBulkCopyProgressEventArgs(long rows, double rowsPerSecond)
+    {
+      Rows = rows;
+      RowsPerSecond = rowsPerSecond;
+    }
+  }
+}
@@ -0,0 +1,231 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ *
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.Threading;
+  using System.Threading.Tasks;
+
+  /// <summary>
+  /// How a connection waits when the database is locked by another connection
+  /// </summary>
+  public enum SqliteBusyStrategy
+  {
+    /// <summary>
+    /// Reset the statement and retry it after an exponentially growing, randomized delay until the command timeout
+    /// expires.  This is the default.
+    /// </summary>
+    Backoff = 0,
+    /// <summary>
+    /// Register a busy handler so that sqlite waits inside the call itself, using the same delays, instead of failing
+    /// the statement and having it reset and retried.  Behaves like Backoff if the platform's sqlite wrapper cannot
+    /// register a busy handler.
+    /// </summary>
+    Native = 1,
+    /// <summary>
+    /// Fail with SQLITE_BUSY or SQLITE_LOCKED as soon as the database is locked
+    /// </summary>
+    None = 2,
+  }
+
+  /// <summary>
+  /// Waits between the retries of a statement that found the database locked, and keeps count of the retries and the
+  /// time spent waiting for a connection.
+  /// </summary>
+  /// <remarks>
+  /// The delay starts at 1ms and doubles with each retry up to 100ms.  Half of each delay is random, so that
+  /// connections contending for the same lock do not keep waking up at the same moment.  Wait() blocks the thread
+  /// rather than spinning on the processor; WaitAsync() holds no thread at all, it completes from a timer.
+  /// </remarks>
+  internal sealed class SqliteBusyWait
+  {
+    private const int MinDelay = 1;
+    private const int MaxDelay = 100;
+
+    /// <summary>
+    /// Never signalled.  Waiting on it with a timeout is the one blocking sleep available on every platform.
+    /// </summary>
+    private static readonly ManualResetEvent _never = new ManualResetEvent(false);
+
+    /// <summary>
+    /// Connections opened at the same moment must not share a time based seed, or their delays would line up again
+    /// </summary>
+    private static int _seed = Environment.TickCount;
+
+    private readonly Random _random;
+    private uint _starttick;
+    private uint _timeout;
+    private long _retries;
+    private long _waitTime;
+
+    /// <summary>
+    /// The timer of the WaitAsync() in progress, referenced here so it is not collected before it fires
+    /// </summary>
+    private Timer _timer;
+
+    /// <summary>
+    /// The strategy in effect for the connection
+    /// </summary>
+    internal SqliteBusyStrategy Strategy;
+
+    internal SqliteBusyWait(SqliteBusyStrategy strategy)
+    {
+      Strategy = strategy;
+      _random = new Random(Interlocked.Increment(ref _seed));
+    }
+
+    /// <summary>
+    /// The number of times a statement was retried because the database was locked
+    /// </summary>
+    internal long Retries
+    {
+      get { return Interlocked.CompareExchange(ref _retries, 0, 0); }
+    }
+
+    /// <summary>
+    /// The total time spent waiting for locks to be released
+    /// </summary>
+    internal TimeSpan WaitTime
+    {
+      get { return TimeSpan.FromMilliseconds(Interlocked.CompareExchange(ref _waitTime, 0, 0)); }
+    }
+
+    /// <summary>
+    /// Starts the clock for a call that may have to wait.  Called before every step and prepare, since with the
+    /// Native strategy sqlite asks OnBusy() whether to keep waiting from inside the call.
+    /// </summary>
+    /// <param name="timeout">The number of milliseconds after which to give up</param>
+    internal void Start(uint timeout)
+    {
+      _starttick = (uint)Environment.TickCount;
+      _timeout = timeout;
+    }
+
+    /// <summary>
+    /// Blocks the calling thread until the next retry is due.
+    /// </summary>
+    /// <param name="attempt">The number of retries already made since Start()</param>
+    /// <returns>False if the caller should give up because of the strategy or the timeout</returns>
+    internal bool Wait(int attempt)
+    {
+      int delay = NextDelay(attempt);
+      if (delay < 0)
+      {
+        return false;
+      }
+
+      Sleep(delay);
+      return true;
+    }
+
+    /// <summary>
+    /// Like Wait(), but returns a task that completes when the next retry is due instead of blocking a thread.
+    /// </summary>
+    /// <param name="attempt">The number of retries already made since Start()</param>
+    /// <param name="cancellationToken">Cancels the wait</param>
+    /// <returns>A task whose result is false if the caller should give up</returns>
+    internal Task<bool> WaitAsync(int attempt, CancellationToken cancellationToken)
+    {
+      var source = new TaskCompletionSource<bool>();
+      int delay = NextDelay(attempt);
+      if (delay < 0)
+      {
+        source.SetResult(false);
+        return source.Task;
+      }
+
+      var starttick = (uint)Environment.TickCount;
+      CancellationTokenRegistration registration = default(CancellationTokenRegistration);
+      Timer timer = null;
+      timer = new Timer(state =>
+        {
+          timer.Dispose();
+          registration.Dispose();
+          Interlocked.Increment(ref _retries);
+          Interlocked.Add(ref _waitTime, (uint)Environment.TickCount - starttick);
+          source.TrySetResult(true);
+        }, null, Timeout.Infinite, Timeout.Infinite);
+      _timer = timer;
+
+      registration = cancellationToken.Register(() =>
+        {
+          timer.Dispose();
+          source.TrySetCanceled();
+        });
+      try
+      {
+        timer.Change(delay, Timeout.Infinite);
+      }
+      catch (ObjectDisposedException)
+      {
+        // Cancelled before the timer could be started
+      }
+
+      return source.Task;
+    }
+
+    /// <summary>
+    /// The busy handler registered with sqlite for the Native strategy
+    /// </summary>
+    /// <param name="userState">Not used</param>
+    /// <param name="count">The number of times sqlite already called the handler for the same lock</param>
+    /// <returns>Non-zero to have sqlite try again</returns>
+    internal int OnBusy(object userState, int count)
+    {
+      return Wait(count) ? 1 : 0;
+    }
+
+    /// <summary>
+    /// Returns the number of milliseconds to wait before the given retry, or -1 to give up
+    /// </summary>
+    private int NextDelay(int attempt)
+    {
+      if (Strategy == SqliteBusyStrategy.None)
+      {
+        return -1;
+      }
+
+      uint elapsed = (uint)Environment.TickCount - _starttick;
+      if (elapsed >= _timeout)
+      {
+        return -1;
+      }
+
+      int ceiling = (attempt < 7) ? (MinDelay << attempt) : MaxDelay;
+      if (ceiling > MaxDelay)
+      {
+        ceiling = MaxDelay;
+      }
+
+      int delay;
+      lock (_random)
+      {
+        delay = ceiling - _random.Next(ceiling / 2 + 1);
+      }
+
+      return (int)Math.Min((uint)delay, _timeout - elapsed);
+    }
+
+    /// <summary>
+    /// Blocks the thread for the given number of milliseconds, without counting it as a retry
+    /// </summary>
+    internal static void Delay(int milliseconds)
+    {
+      _never.WaitOne(milliseconds);
+    }
+
+    private void Sleep(int delay)
+    {
+      var starttick = (uint)Environment.TickCount;
+      _never.WaitOne(delay);
+
+      Interlocked.Increment(ref _retries);
+      Interlocked.Add(ref _waitTime, (uint)Environment.TickCount - starttick);
+    }
+  }
+}
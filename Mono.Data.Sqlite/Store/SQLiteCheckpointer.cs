@@ -0,0 +1,312 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ *
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.Threading;
+  using System.Threading.Tasks;
+
+  /// <summary>
+  /// How much of the write-ahead log a checkpoint copies back into the database, and what it waits for
+  /// </summary>
+  public enum SqliteCheckpointMode
+  {
+    /// <summary>
+    /// Copy as many frames as possible without waiting for readers or writers to finish
+    /// </summary>
+    Passive = 0,
+    /// <summary>
+    /// Wait for writers to finish, then copy every frame, waiting for readers of the old frames with the busy handler
+    /// </summary>
+    Full = 1,
+    /// <summary>
+    /// Like Full, then also wait for all readers to finish with the log, so the next writer starts it from the beginning
+    /// </summary>
+    Restart = 2,
+    /// <summary>
+    /// Like Restart, then also truncate the log file to zero bytes
+    /// </summary>
+    Truncate = 3,
+  }
+
+  /// <summary>
+  /// Runs the checkpoints of a database in WAL mode on a background thread, so that they stop landing on whichever
+  /// commit happens to push the write-ahead log past sqlite's automatic checkpoint threshold.
+  /// </summary>
+  /// <remarks>
+  /// The checkpointer checkpoints the database its connection string opens, over a connection of its own.  Set it as
+  /// the Checkpointer of the connections that write to the database: that turns off their automatic checkpoints and
+  /// has them tell the checkpointer how big the log is after every commit.  A checkpoint runs as soon as the log holds
+  /// FrameThreshold frames that have not been checkpointed, and, if Interval is set, whenever that long has passed
+  /// since the last one and something has been committed since.  The checkpointer runs from construction until it is
+  /// disposed.
+  /// Durations are measured with Environment.TickCount, so they have its resolution of about 10-16ms.
+  /// </remarks>
+  public sealed class SqliteCheckpointer : IDisposable
+  {
+    private readonly string _connectionString;
+    private readonly object _lock = new object();
+    private readonly AutoResetEvent _wake = new AutoResetEvent(false);
+    private readonly Task _task;
+    private volatile bool _stopping;
+
+    private SqliteCheckpointMode _mode = SqliteCheckpointMode.Passive;
+    private int _frameThreshold = 1000;
+    private int _interval;
+
+    private bool _committed;
+    private int _walFrames;
+    private int _maxWalFrames;
+    private int _checkpointedFrames;
+    private long _checkpoints;
+    private long _incompleteCheckpoints;
+    private long _checkpointTime;
+    private long _maxCheckpointTime;
+    private Exception _lastError;
+
+    /// <summary>
+    /// Starts a checkpointer for a database
+    /// </summary>
+    /// <param name="connectionString">The connection string the checkpointer opens its connection with</param>
+    public SqliteCheckpointer(string connectionString)
+    {
+      if (connectionString == null)
+        throw new ArgumentNullException("connectionString");
+
+      _connectionString = connectionString;
+      _task = Task.Factory.StartNew(Run, TaskCreationOptions.LongRunning);
+    }
+
+    /// <summary>
+    /// The kind of checkpoint to run.  Passive by default, which never blocks the connections using the database.
+    /// </summary>
+    public SqliteCheckpointMode Mode
+    {
+      get { lock (_lock) return _mode; }
+      set { lock (_lock) _mode = value; }
+    }
+
+    /// <summary>
+    /// The number of frames not yet checkpointed in the write-ahead log that triggers a checkpoint.  1000 by default,
+    /// like sqlite's own automatic checkpoints.
+    /// </summary>
+    public int FrameThreshold
+    {
+      get { lock (_lock) return _frameThreshold; }
+      set
+      {
+        if (value < 1)
+          throw new ArgumentOutOfRangeException("value");
+
+        lock (_lock) _frameThreshold = value;
+      }
+    }
+
+    /// <summary>
+    /// The longest time in milliseconds that committed frames wait for a checkpoint, or 0 to only checkpoint when the
+    /// log reaches FrameThreshold frames.  0 by default.
+    /// </summary>
+    public int Interval
+    {
+      get { lock (_lock) return _interval; }
+      set
+      {
+        if (value < 0)
+          throw new ArgumentOutOfRangeException("value");
+
+        lock (_lock) _interval = value;
+        _wake.Set();
+      }
+    }
+
+    /// <summary>
+    /// The number of frames in the write-ahead log, as of the last commit or checkpoint
+    /// </summary>
+    public int WalFrames
+    {
+      get { lock (_lock) return _walFrames; }
+    }
+
+    /// <summary>
+    /// The largest number of frames the write-ahead log has held
+    /// </summary>
+    public int MaxWalFrames
+    {
+      get { lock (_lock) return _maxWalFrames; }
+    }
+
+    /// <summary>
+    /// The number of frames at the start of the write-ahead log that have been copied into the database
+    /// </summary>
+    public int CheckpointedFrames
+    {
+      get { lock (_lock) return _checkpointedFrames; }
+    }
+
+    /// <summary>
+    /// The number of checkpoints run
+    /// </summary>
+    public long Checkpoints
+    {
+      get { lock (_lock) return _checkpoints; }
+    }
+
+    /// <summary>
+    /// The number of checkpoints that found the database locked, or could not copy every frame because of readers
+    /// </summary>
+    public long IncompleteCheckpoints
+    {
+      get { lock (_lock) return _incompleteCheckpoints; }
+    }
+
+    /// <summary>
+    /// The time spent in checkpoints altogether
+    /// </summary>
+    public TimeSpan CheckpointTime
+    {
+      get { lock (_lock) return TimeSpan.FromMilliseconds(_checkpointTime); }
+    }
+
+    /// <summary>
+    /// The time taken by the longest checkpoint
+    /// </summary>
+    public TimeSpan MaxCheckpointTime
+    {
+      get { lock (_lock) return TimeSpan.FromMilliseconds(_maxCheckpointTime); }
+    }
+
+    /// <summary>
+    /// The exception that made the last checkpoint fail, or null if it succeeded
+    /// </summary>
+    public Exception LastError
+    {
+      get { lock (_lock) return _lastError; }
+    }
+
+    /// <summary>
+    /// Has the checkpointer run a checkpoint now, whatever the size of the log
+    /// </summary>
+    public void CheckpointNow()
+    {
+      lock (_lock) _committed = true;
+      _wake.Set();
+    }
+
+    /// <summary>
+    /// Stops the checkpointer, waiting for a checkpoint in progress to finish, and closes its connection
+    /// </summary>
+    public void Dispose()
+    {
+      if (_stopping)
+        return;
+
+      _stopping = true;
+      _wake.Set();
+      _task.Wait();
+    }
+
+    /// <summary>
+    /// Called by the WAL hook of the connections the checkpointer is set on, after every commit
+    /// </summary>
+    internal void OnCommit(string database, int frames)
+    {
+      bool due;
+      lock (_lock)
+      {
+        _committed = true;
+        _walFrames = frames;
+        if (frames > _maxWalFrames)
+          _maxWalFrames = frames;
+
+        // A log smaller than what was checkpointed has been started over by a writer, from the first frame
+        if (frames < _checkpointedFrames)
+          _checkpointedFrames = 0;
+
+        // Writers only start the log over once a checkpoint has caught up with it between two of their transactions,
+        // so under steady writes it keeps growing and only the frames not yet checkpointed call for another one
+        due = frames - _checkpointedFrames >= _frameThreshold;
+      }
+
+      if (due)
+        _wake.Set();
+    }
+
+    private void Run()
+    {
+      SqliteConnection cnn = null;
+      try
+      {
+        while (true)
+        {
+          int interval = Interval;
+          _wake.WaitOne(interval > 0 ? interval : Timeout.Infinite);
+          if (_stopping)
+            break;
+
+          lock (_lock)
+          {
+            // Nothing was committed since the last checkpoint, so the interval has nothing to do
+            if (_committed == false)
+              continue;
+            _committed = false;
+          }
+
+          try
+          {
+            if (cnn == null)
+            {
+              cnn = new SqliteConnection(_connectionString);
+              cnn.Open();
+            }
+            Checkpoint(cnn);
+          }
+          catch (Exception ex)
+          {
+            lock (_lock) _lastError = ex;
+            if (cnn != null)
+            {
+              cnn.Dispose();
+              cnn = null;
+            }
+          }
+        }
+      }
+      finally
+      {
+        if (cnn != null)
+          cnn.Dispose();
+      }
+    }
+
+    private void Checkpoint(SqliteConnection cnn)
+    {
+      int logFrames;
+      int checkpointedFrames;
+      var starttick = (uint)Environment.TickCount;
+      bool complete = cnn.Checkpoint(null, Mode, out logFrames, out checkpointedFrames);
+      var elapsed = (uint)Environment.TickCount - starttick;
+
+      lock (_lock)
+      {
+        _checkpoints++;
+        if (complete == false || checkpointedFrames < logFrames)
+          _incompleteCheckpoints++;
+        _checkpointTime += elapsed;
+        if (elapsed > _maxCheckpointTime)
+          _maxCheckpointTime = elapsed;
+
+        if (logFrames >= 0)
+        {
+          _walFrames = logFrames;
+          _checkpointedFrames = checkpointedFrames;
+        }
+        _lastError = null;
+      }
+    }
+  }
+}
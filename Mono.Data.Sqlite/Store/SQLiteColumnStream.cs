@@ -0,0 +1,162 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ * 
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.IO;
+  using MonoDataSqliteWrapper;
+
+  /// <summary>
+  /// Read-only stream over a blob column of the current row of a SqliteDataReader.
+  /// </summary>
+  /// <remarks>
+  /// The stream reads straight out of the column memory owned by SQLite, so each Read() is a single copy into
+  /// the caller's buffer.  It becomes invalid as soon as the reader moves to another row or is closed, or the column
+  /// is read as text, since SQLite may convert the value and free the memory in doing so.
+  /// </remarks>
+  internal sealed class SqliteColumnStream : Stream
+  {
+    private SqliteDataReader _reader;
+    private SqliteBlobView _view;
+    private int _stepCount;
+    private int _ordinal;
+    private int _conversions;
+    private long _position;
+
+    internal SqliteColumnStream(SqliteDataReader reader, int ordinal, SqliteBlobView view)
+    {
+      _reader = reader;
+      _view = view;
+      _stepCount = reader._stepCount;
+      _ordinal = ordinal;
+      _conversions = reader.TrackConversions(ordinal);
+    }
+
+    public override bool CanRead
+    {
+      get { return _view != null; }
+    }
+
+    public override bool CanSeek
+    {
+      get { return _view != null; }
+    }
+
+    public override bool CanWrite
+    {
+      get { return false; }
+    }
+
+    public override long Length
+    {
+      get
+      {
+        CheckValid();
+        return _view.Length;
+      }
+    }
+
+    public override long Position
+    {
+      get
+      {
+        CheckValid();
+        return _position;
+      }
+      set
+      {
+        CheckValid();
+        if (value < 0)
+          throw new ArgumentOutOfRangeException("value");
+
+        _position = value;
+      }
+    }
+
+    public override int Read(byte[] buffer, int offset, int count)
+    {
+      if (buffer == null)
+        throw new ArgumentNullException("buffer");
+      if (offset < 0 || count < 0 || offset + count > buffer.Length)
+        throw new ArgumentOutOfRangeException("offset");
+
+      CheckValid();
+
+      if (_position >= _view.Length)
+        return 0;
+
+      int n = _view.CopyTo(_position, buffer, offset, count);
+      _position += n;
+      return n;
+    }
+
+    public override long Seek(long offset, SeekOrigin origin)
+    {
+      CheckValid();
+
+      long pos;
+      switch (origin)
+      {
+        case SeekOrigin.Begin:
+          pos = offset;
+          break;
+        case SeekOrigin.Current:
+          pos = _position + offset;
+          break;
+        default:
+          pos = _view.Length + offset;
+          break;
+      }
+
+      if (pos < 0)
+        throw new IOException("An attempt was made to move the position before the beginning of the stream.");
+
+      _position = pos;
+      return _position;
+    }
+
+    public override void Flush()
+    {
+    }
+
+    public override void SetLength(long value)
+    {
+      throw new NotSupportedException();
+    }
+
+    public override void Write(byte[] buffer, int offset, int count)
+    {
+      throw new NotSupportedException();
+    }
+
+    protected override void Dispose(bool disposing)
+    {
+      _view = null;
+      _reader = null;
+      base.Dispose(disposing);
+    }
+
+    /// <summary>
+    /// The view borrows SQLite's memory for the current row only, so refuse to touch it once the reader has moved on,
+    /// or once the column has been read in a way that can make SQLite convert it and free that memory.
+    /// </summary>
+    private void CheckValid()
+    {
+      if (_view == null)
+        throw new ObjectDisposedException("SqliteColumnStream");
+
+      _reader.CheckClosed();
+
+      if (_reader._stepCount != _stepCount)
+        throw new InvalidOperationException("The data reader has moved past the row this stream was opened on");
+
+      if (_reader._conversions[_ordinal] != _conversions)
+        throw new InvalidOperationException("The column this stream was opened on has since been read as another type");
+    }
+  }
+}
@@ -0,0 +1,133 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ *
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.IO;
+  using System.Text;
+  using MonoDataSqliteWrapper;
+
+  /// <summary>
+  /// TextReader over a text column of the current row of a SqliteDataReader.
+  /// </summary>
+  /// <remarks>
+  /// The reader decodes the UTF-8 text owned by SQLite a buffer at a time, so a large text is never held in memory as
+  /// a string.  It becomes invalid as soon as the data reader moves to another row or is closed, or the column is read
+  /// another way, since SQLite may convert the value and free the memory in doing so.
+  /// </remarks>
+  internal sealed class SqliteColumnTextReader : TextReader
+  {
+    private const int BufferSize = 4096;
+
+    private SqliteDataReader _reader;
+    private SqliteBlobView _view;
+    private int _stepCount;
+    private int _ordinal;
+    private int _conversions;
+    private int _bytePosition;
+    private bool _flushed;
+
+    private readonly Decoder _decoder = Encoding.UTF8.GetDecoder();
+    private readonly byte[] _bytes = new byte[BufferSize];
+    private readonly char[] _chars = new char[Encoding.UTF8.GetMaxCharCount(BufferSize)];
+    private int _charPosition;
+    private int _charLength;
+
+    internal SqliteColumnTextReader(SqliteDataReader reader, int ordinal, SqliteBlobView view)
+    {
+      _reader = reader;
+      _view = view;
+      _stepCount = reader._stepCount;
+      _ordinal = ordinal;
+      _conversions = reader.TrackConversions(ordinal);
+    }
+
+    public override int Peek()
+    {
+      if (FillBuffer() == false)
+        return -1;
+
+      return _chars[_charPosition];
+    }
+
+    public override int Read()
+    {
+      if (FillBuffer() == false)
+        return -1;
+
+      return _chars[_charPosition++];
+    }
+
+    public override int Read(char[] buffer, int index, int count)
+    {
+      if (buffer == null)
+        throw new ArgumentNullException("buffer");
+      if (index < 0 || count < 0 || index + count > buffer.Length)
+        throw new ArgumentOutOfRangeException("index");
+
+      int read = 0;
+      while (read < count && FillBuffer())
+      {
+        int n = Math.Min(count - read, _charLength - _charPosition);
+        Array.Copy(_chars, _charPosition, buffer, index + read, n);
+        _charPosition += n;
+        read += n;
+      }
+      return read;
+    }
+
+    protected override void Dispose(bool disposing)
+    {
+      _view = null;
+      _reader = null;
+      base.Dispose(disposing);
+    }
+
+    /// <summary>
+    /// Decodes the next piece of the column once the characters already decoded are used up
+    /// </summary>
+    /// <returns>False at the end of the text</returns>
+    private bool FillBuffer()
+    {
+      CheckValid();
+
+      while (_charPosition == _charLength)
+      {
+        if (_flushed)
+          return false;
+
+        int n = _view.CopyTo(_bytePosition, _bytes, 0, _bytes.Length);
+        _bytePosition += n;
+
+        // The decoder keeps a sequence split across two pieces until the next one completes it
+        _flushed = _bytePosition >= _view.Length;
+        _charLength = _decoder.GetChars(_bytes, 0, n, _chars, 0, _flushed);
+        _charPosition = 0;
+      }
+      return true;
+    }
+
+    /// <summary>
+    /// The view borrows SQLite's memory for the current row only, so refuse to touch it once the reader has moved on,
+    /// or once the column has been read in a way that can make SQLite convert it and free that memory.
+    /// </summary>
+    private void CheckValid()
+    {
+      if (_view == null)
+        throw new ObjectDisposedException("SqliteColumnTextReader");
+
+      _reader.CheckClosed();
+
+      if (_reader._stepCount != _stepCount)
+        throw new InvalidOperationException("The data reader has moved past the row this reader was opened on");
+
+      if (_reader._conversions[_ordinal] != _conversions)
+        throw new InvalidOperationException("The column this reader was opened on has since been read as another type");
+    }
+  }
+}
@@ -12,6 +12,9 @@ namespace Mono.Data.Sqlite
   using System.Data.Common;
   using System.Collections.Generic;
   using System.ComponentModel;
+  using System.Globalization;
+  using System.Threading;
+  using System.Threading.Tasks;
 
   /// <summary>
   /// SQLite implementation of DbCommand.
@@ -145,8 +148,17 @@ public SqliteCommand(string commandText, SqliteConnection connection, SqliteTran
     /// <summary>
     /// Disposes of the command and clears all member variables
     /// </summary>
+#if DESKTOP
+    protected override void Dispose(bool disposing)
+    {
+        base.Dispose(disposing);
+        if (!disposing)
+          return;
+
+#else
     public override void Dispose()
     {
+#endif
         // If a reader is active on this command, don't destroy the command, instead let the reader do it
         SqliteDataReader reader = null;
         if (_activeReader != null)
@@ -196,9 +208,14 @@ internal void ClearCommands()
 
       if (_statementList == null) return;
 
-      int x = _statementList.Count;
-      for (int n = 0; n < x; n++)
-        _statementList[n].Dispose();
+      // Hand the prepared statements to the connection's cache so the next command with this text can reuse them
+      SqliteStatementCache cache = (_cnn != null) ? _cnn._statementCache : null;
+      if (cache == null || cache.Add(_commandText, _statementList, _remainingText) == false)
+      {
+        int x = _statementList.Count;
+        for (int n = 0; n < x; n++)
+          _statementList[n].Dispose();
+      }
 
       _statementList = null;
 
@@ -208,14 +225,21 @@ internal void ClearCommands()
     /// <summary>
     /// Builds an array of prepared statements for each complete SQL statement in the command text
     /// </summary>
-    internal SqliteStatement BuildNextCommand()
+    /// <param name="bindParameters">False to leave binding the parameters to the caller</param>
+    internal SqliteStatement BuildNextCommand(bool bindParameters)
     {
       SqliteStatement stmt = null;
 
       try
       {
         if (_statementList == null)
+        {
+          stmt = TakeCachedStatements(bindParameters);
+          if (stmt != null)
+            return stmt;
+
           _remainingText = _commandText;
+        }
 
         stmt = _cnn._sql.Prepare(_cnn, _remainingText, (_statementList == null) ? null : _statementList[_statementList.Count - 1], (uint)(_commandTimeout * 1000), out _remainingText);
         if (stmt != null)
@@ -227,7 +251,8 @@ internal SqliteStatement BuildNextCommand()
           _statementList.Add(stmt);
 
           _parameterCollection.MapParameters(stmt);
-          stmt.BindParameters();
+          if (bindParameters)
+            stmt.BindParameters();
         }        
         return stmt;
       }
@@ -248,15 +273,44 @@ internal SqliteStatement BuildNextCommand()
       }
     }
 
+    /// <summary>
+    /// Adopts the statements the connection's statement cache holds for this command text, if any
+    /// </summary>
+    /// <param name="bindParameters">False to leave binding the parameters to the caller</param>
+    /// <returns>The first statement, mapped and bound, or null on a cache miss</returns>
+    private SqliteStatement TakeCachedStatements(bool bindParameters)
+    {
+      SqliteStatementCache cache = _cnn._statementCache;
+      List<SqliteStatement> statements;
+      string remainingText;
+
+      if (cache == null || cache.TryTake(_commandText, out statements, out remainingText) == false)
+        return null;
+
+      _statementList = statements;
+      _remainingText = remainingText;
+
+      // Map each statement individually, exactly as BuildNextCommand() did when they were first prepared
+      for (int n = 0; n < _statementList.Count; n++)
+      {
+        _statementList[n]._command = this;
+        _parameterCollection.MapParameters(_statementList[n]);
+      }
+
+      if (bindParameters)
+        _statementList[0].BindParameters();
+      return _statementList[0];
+    }
+
     internal SqliteStatement GetStatement(int index)
     {
       // Haven't built any statements yet
-      if (_statementList == null) return BuildNextCommand();
+      if (_statementList == null) return BuildNextCommand(true);
 
       // If we're at the last built statement and want the next unbuilt statement, then build it
       if (index == _statementList.Count)
       {
-        if (String.IsNullOrWhiteSpace(_remainingText) == false) return BuildNextCommand();
+        if (String.IsNullOrWhiteSpace(_remainingText) == false) return BuildNextCommand(true);
         else return null; // No more commands
       }
 
@@ -340,6 +394,24 @@ public override CommandType CommandType
       }
     }
 
+#if DESKTOP
+    /// <summary>
+    /// Whether the command shows up in the designer's component tray
+    /// </summary>
+    [DefaultValue(true)]
+    public override bool DesignTimeVisible
+    {
+      get
+      {
+        return _designTimeVisible;
+      }
+      set
+      {
+        _designTimeVisible = value;
+      }
+    }
+#endif
+
     /// <summary>
     /// Forwards to the local CreateParameter() function
     /// </summary>
@@ -548,6 +620,37 @@ public override int ExecuteNonQuery()
       }
     }
 
+    /// <summary>
+    /// Executes the command once for each row of the given parameter values.  The rows are bound and executed inside a
+    /// single call into the sqlite wrapper, which is much faster than executing the command repeatedly.
+    /// </summary>
+    /// <remarks>
+    /// The command text must hold a single statement.  The Parameters collection is not used: column i supplies the
+    /// value of the i-th parameter in the statement.  Rows executed before a failing row stay applied, unless the
+    /// batch runs inside a transaction, which also makes it faster.
+    /// </remarks>
+    /// <param name="columns">One array per parameter: long[], long?[], double[], double?[], string[] or byte[][].
+    /// All arrays must have the same length, which is the number of rows.  Null elements are bound as NULL.</param>
+    /// <returns>The number of rows inserted, updated or deleted by each row of the batch</returns>
+    public int[] ExecuteBatch(params Array[] columns)
+    {
+      if (columns == null || columns.Length == 0 || columns[0] == null)
+        throw new ArgumentException("At least one parameter column is required", "columns");
+
+      InitializeForReader();
+
+      SqliteStatement stmt = (_statementList == null) ? BuildNextCommand(false) : _statementList[0];
+      if (stmt == null || _statementList.Count > 1 || String.IsNullOrWhiteSpace(_remainingText) == false)
+        throw new InvalidOperationException("ExecuteBatch requires a command with exactly one statement");
+
+      int parameterCount = (stmt._paramNames != null) ? stmt._paramNames.Length : 0;
+      if (columns.Length != parameterCount)
+        throw new ArgumentException(String.Format(CultureInfo.CurrentCulture,
+          "The command has {0} parameters, but {1} columns were supplied", parameterCount, columns.Length), "columns");
+
+      return _cnn._sql.StepBatch(stmt, columns, columns[0].Length);
+    }
+
     /// <summary>
     /// Execute the command and return the first column of the first row of the resultset
     /// (if present), or null if no resultset was returned.
@@ -563,6 +666,176 @@ public override object ExecuteScalar()
       return null;
     }
 
+    /// <summary>
+    /// Executes the command and builds an object of type T from each row of its first resultset, as
+    /// SqliteDataReader.GetRecord() does
+    /// </summary>
+    /// <typeparam name="T">The type of the objects</typeparam>
+    /// <returns>The objects, one per row</returns>
+    public List<T> ExecuteQuery<T>() where T : class, new()
+    {
+      using (SqliteDataReader reader = ExecuteReader(CommandBehavior.SingleResult))
+        return reader.ReadRecords<T>();
+    }
+
+    /// <summary>
+    /// Asynchronously executes the command and returns a reader on its first resultset
+    /// </summary>
+    /// <returns>A task with the SqliteDataReader</returns>
+    public Task<SqliteDataReader> ExecuteReaderAsync()
+    {
+      return ExecuteReaderAsync(CommandBehavior.Default, CancellationToken.None);
+    }
+
+    /// <summary>
+    /// Asynchronously executes the command and returns a reader on its first resultset
+    /// </summary>
+    /// <param name="cancellationToken">Cancels the execution, interrupting the statement running, if any</param>
+    /// <returns>A task with the SqliteDataReader</returns>
+    public Task<SqliteDataReader> ExecuteReaderAsync(CancellationToken cancellationToken)
+    {
+      return ExecuteReaderAsync(CommandBehavior.Default, cancellationToken);
+    }
+
+    /// <summary>
+    /// Asynchronously executes the command and returns a reader on its first resultset.  The statements are prepared
+    /// and stepped on the connection's worker thread, and a locked database is waited for without blocking any
+    /// thread.  Use the reader's ReadAsync() and NextResultAsync() to go on the same way.
+    /// </summary>
+    /// <param name="behavior">The flags to be associated with the reader</param>
+    /// <param name="cancellationToken">Cancels the execution, interrupting the statement running, if any</param>
+    /// <returns>A task with the SqliteDataReader</returns>
+    public Task<SqliteDataReader> ExecuteReaderAsync(CommandBehavior behavior, CancellationToken cancellationToken)
+    {
+      InitializeForReader();
+
+      var rd = new SqliteDataReader(this, behavior, false);
+      _activeReader = new WeakReference(rd, false);
+
+      var result = new TaskCompletionSource<SqliteDataReader>();
+      rd.NextResultAsync(cancellationToken).ContinueWith(t =>
+        {
+          if (t.IsCanceled || t.IsFaulted)
+            ClearDataReader();
+
+          if (t.IsCanceled)
+            result.TrySetCanceled();
+          else if (t.IsFaulted)
+            result.TrySetException(t.Exception.InnerExceptions);
+          else
+            result.TrySetResult(rd);
+        }, TaskContinuationOptions.ExecuteSynchronously);
+      return result.Task;
+    }
+
+    /// <summary>
+    /// Asynchronously executes the command and returns the number of rows inserted/updated affected by it
+    /// </summary>
+    /// <returns>A task with the number of rows affected</returns>
+    public Task<int> ExecuteNonQueryAsync()
+    {
+      return ExecuteNonQueryAsync(CancellationToken.None);
+    }
+
+    /// <summary>
+    /// Asynchronously executes the command and returns the number of rows inserted/updated affected by it.  See
+    /// ExecuteReaderAsync().
+    /// </summary>
+    /// <param name="cancellationToken">Cancels the execution, interrupting the statement running, if any</param>
+    /// <returns>A task with the number of rows affected</returns>
+    public Task<int> ExecuteNonQueryAsync(CancellationToken cancellationToken)
+    {
+      Task<SqliteDataReader> execute = ExecuteReaderAsync(CommandBehavior.SingleRow | CommandBehavior.SingleResult,
+                                                          cancellationToken);
+      return SqliteWorker.Then(execute, reader => UsingReaderAsync(reader, rd =>
+        SqliteWorker.Then(NextResultsAsync(rd, cancellationToken), done => SqliteWorker.FromResult(rd.RecordsAffected))));
+    }
+
+    /// <summary>
+    /// Asynchronously executes the command and returns the first column of the first row of the resultset
+    /// </summary>
+    /// <returns>A task with the value, or null if no resultset was returned</returns>
+    public Task<object> ExecuteScalarAsync()
+    {
+      return ExecuteScalarAsync(CancellationToken.None);
+    }
+
+    /// <summary>
+    /// Asynchronously executes the command and returns the first column of the first row of the resultset.  See
+    /// ExecuteReaderAsync().
+    /// </summary>
+    /// <param name="cancellationToken">Cancels the execution, interrupting the statement running, if any</param>
+    /// <returns>A task with the value, or null if no resultset was returned</returns>
+    public Task<object> ExecuteScalarAsync(CancellationToken cancellationToken)
+    {
+      Task<SqliteDataReader> execute = ExecuteReaderAsync(CommandBehavior.SingleRow | CommandBehavior.SingleResult,
+                                                          cancellationToken);
+      return SqliteWorker.Then(execute, reader => UsingReaderAsync(reader, rd =>
+        SqliteWorker.Then(rd.ReadAsync(cancellationToken), row =>
+          row ? _cnn.Worker.Run(() => rd[0], cancellationToken) : SqliteWorker.FromResult<object>(null))));
+    }
+
+    /// <summary>
+    /// Moves a reader through all of its remaining resultsets
+    /// </summary>
+    private static Task<bool> NextResultsAsync(SqliteDataReader reader, CancellationToken cancellationToken)
+    {
+      return SqliteWorker.Then(reader.NextResultAsync(cancellationToken), more =>
+        more ? NextResultsAsync(reader, cancellationToken) : SqliteWorker.FromResult(false));
+    }
+
+    /// <summary>
+    /// Runs an asynchronous operation on a reader, then closes the reader on the connection's worker whether the
+    /// operation succeeded or not, like a using block would
+    /// </summary>
+    private Task<T> UsingReaderAsync<T>(SqliteDataReader reader, Func<SqliteDataReader, Task<T>> operation)
+    {
+      var result = new TaskCompletionSource<T>();
+      Task<T> task;
+      try
+      {
+        task = operation(reader);
+      }
+      catch (Exception ex)
+      {
+        var failed = new TaskCompletionSource<T>();
+        failed.SetException(ex);
+        task = failed.Task;
+      }
+
+      task.ContinueWith(t =>
+        {
+          Task<bool> closed;
+          try
+          {
+            closed = _cnn.Worker.Run(() =>
+              {
+                reader.Dispose();
+                return true;
+              }, CancellationToken.None);
+          }
+          catch (InvalidOperationException)
+          {
+            // The connection was closed meanwhile, so there is no worker left to close the reader on
+            reader.Dispose();
+            closed = SqliteWorker.FromResult(true);
+          }
+
+          closed.ContinueWith(c =>
+            {
+              if (t.IsCanceled)
+                result.TrySetCanceled();
+              else if (t.IsFaulted)
+                result.TrySetException(t.Exception.InnerExceptions);
+              else if (c.IsFaulted)
+                result.TrySetException(c.Exception.InnerExceptions);
+              else
+                result.TrySetResult(t.Result);
+            }, TaskContinuationOptions.ExecuteSynchronously);
+        }, TaskContinuationOptions.ExecuteSynchronously);
+      return result.Task;
+    }
+
     /// <summary>
     /// Does nothing.  Commands are prepared as they are executed the first time, and kept in prepared state afterwards.
     /// </summary>
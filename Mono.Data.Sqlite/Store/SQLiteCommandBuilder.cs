@@ -8,6 +8,9 @@
 namespace Mono.Data.Sqlite
 {
   using System;
+#if DESKTOP
+  using System.Data;
+#endif
   using System.Data.Common;
   using System.Globalization;
   using System.ComponentModel;
@@ -55,6 +58,23 @@ protected override string GetParameterPlaceholder(int parameterOrdinal)
     {
       return GetParameterName(parameterOrdinal);
     }
+
+#if DESKTOP
+    /// <summary>
+    /// The parameters keep the types they were created with
+    /// </summary>
+    protected override void ApplyParameterInfo(DbParameter parameter, DataRow row, StatementType statementType, bool whereClause)
+    {
+    }
+
+    /// <summary>
+    /// There is no SQLite data adapter to generate commands for
+    /// </summary>
+    protected override void SetRowUpdatingHandler(DbDataAdapter adapter)
+    {
+      throw new NotSupportedException("SqliteCommandBuilder does not support data adapters");
+    }
+#endif
       
     /// <summary>
     /// Overridden to hide its property from the designer
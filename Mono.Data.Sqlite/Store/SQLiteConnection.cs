@@ -136,11 +136,59 @@ namespace Mono.Data.Sqlite
     /// </item>
     /// <item>
     /// <description>Max Pool Size</description>
-    /// <description>The maximum number of connections for the given connection string that can be in the connection pool</description>
+    /// <description>The maximum number of pooled connections to the database file, idle or in use.  Once reached, opening a connection waits up to Default Timeout seconds for another one to be closed</description>
     /// <description>N</description>
     /// <description>100</description>
     /// </item>
     /// <item>
+    /// <description>Min Pool Size</description>
+    /// <description>The number of pooled connections that are kept open however long they are idle.  See WarmPool()</description>
+    /// <description>N</description>
+    /// <description>0</description>
+    /// </item>
+    /// <item>
+    /// <description>Pool Idle Timeout</description>
+    /// <description>The number of seconds a connection can be idle in the pool before it is closed.  0 keeps idle connections open</description>
+    /// <description>N</description>
+    /// <description>300</description>
+    /// </item>
+    /// <item>
+    /// <description>Statement Cache Size</description>
+    /// <description>The number of distinct command texts whose prepared statements are kept for reuse on the connection.  0 disables the cache</description>
+    /// <description>N</description>
+    /// <description>0</description>
+    /// </item>
+    /// <item>
+    /// <description>Busy Strategy</description>
+    /// <description><b>Backoff</b> - Retry a locked statement after a growing, randomized delay<br/><b>Native</b> - Have SQLite wait for the lock inside the call<br/><b>None</b> - Fail as soon as the database is locked</description>
+    /// <description>N</description>
+    /// <description>Backoff</description>
+    /// </item>
+    /// <item>
+    /// <description>Lookaside Slot Size</description>
+    /// <description>The size in bytes of the slots of the connection's lookaside memory, the arena sqlite takes its small allocations from.  0 keeps the default</description>
+    /// <description>N</description>
+    /// <description>0</description>
+    /// </item>
+    /// <item>
+    /// <description>Lookaside Slot Count</description>
+    /// <description>The number of lookaside slots of the connection.  0 disables lookaside memory, -1 keeps the default.  A pooled connection keeps the lookaside memory it was first opened with</description>
+    /// <description>N</description>
+    /// <description>-1</description>
+    /// </item>
+    /// <item>
+    /// <description>Mmap Size</description>
+    /// <description>The number of bytes of the database file to read through memory-mapped I/O, up to the limit set with ConfigureMmapSize().  0 disables it</description>
+    /// <description>N</description>
+    /// <description>0</description>
+    /// </item>
+    /// <item>
+    /// <description>Soft Heap Limit</description>
+    /// <description>The number of bytes of heap sqlite tries to stay under by giving back cache memory.  Applies to the whole process.  0 means no limit</description>
+    /// <description>N</description>
+    /// <description>0</description>
+    /// </item>
+    /// <item>
     /// <description>Default IsolationLevel</description>
     /// <description>The default transaciton isolation level</description>
     /// <description>N</description>
@@ -180,6 +228,16 @@ public sealed class SqliteConnection : DbConnection, ICloneable
         /// </summary>
         internal SQLiteBase _sql;
 
+        /// <summary>
+        /// Prepared statements kept for reuse by commands on this connection, or null if statement caching is disabled
+        /// </summary>
+        internal SqliteStatementCache _statementCache;
+
+        /// <summary>
+        /// How commands wait for a locked database, along with the retry counters
+        /// </summary>
+        private SqliteBusyWait _busyWait;
+
         /// <summary>
         /// The database filename minus path and extension
         /// </summary>
@@ -203,10 +261,31 @@ public sealed class SqliteConnection : DbConnection, ICloneable
         private event SQLiteCommitHandler _commitHandler;
         private event EventHandler _rollbackHandler;
 
+        /// <summary>
+        /// Collects the statement profiles while ProfileStatements is on, across closing and reopening the connection
+        /// </summary>
+        private SqliteProfiler _profiler;
+
+        /// <summary>
+        /// The blob streams opened on the connection and not yet disposed, which have to be closed before the handle is
+        /// </summary>
+        private List<SqliteBlobStream> _blobStreams;
+
+        /// <summary>
+        /// Runs the connection's asynchronous operations, from the first of them until the connection is closed
+        /// </summary>
+        private SqliteWorker _worker;
+
         private SqliteUpdateHookDelegate _updateCallback;
         private SqliteCommitHookDelegate _commitCallback;
         private SqliteRollbackHookDelegate _rollbackCallback;
 
+        /// <summary>
+        /// Runs the checkpoints of the connection's database in place of sqlite's automatic ones, if set
+        /// </summary>
+        private SqliteCheckpointer _checkpointer;
+        private SqliteWalHookDelegate _walCallback;
+
         /// <summary>
         /// This event is raised whenever the database is opened or closed.
         /// </summary>
@@ -268,12 +347,22 @@ public object Clone()
         /// <summary>
         /// Disposes of the SqliteConnection, closing it if it is active.
         /// </summary>
+#if DESKTOP
+        protected override void Dispose(bool disposing)
+        {
+            base.Dispose(disposing);
+
+            if (disposing)
+                Close();
+        }
+#else
         public override void Dispose()
         {
             base.Dispose();
 
             Close();
         }
+#endif
 
         /// <summary>
         /// Raises the state change event when the state of the connection changes
@@ -382,8 +471,26 @@ public override void ChangeDatabase(string databaseName)
         /// </summary>
         public override void Close()
         {
+            if (_worker != null)
+            {
+                // The asynchronous operations already queued finish before the handle goes away
+                _worker.Stop();
+                _worker = null;
+            }
+
+            if (_blobStreams != null)
+            {
+                // Each stream takes itself out of the list as it is disposed
+                while (_blobStreams.Count > 0)
+                    _blobStreams[_blobStreams.Count - 1].Dispose();
+                _blobStreams = null;
+            }
+
             if (_sql != null)
             {
+                // _sql finalizes the cached statements, or keeps them with the handle in the pool
+                _statementCache = null;
+
                 if (_enlistment != null)
                 {
                     // If the connection is enlisted in a transaction scope and the scope is still active,
@@ -432,6 +539,72 @@ public static void ClearAllPools()
             SqliteConnectionPool.ClearAllPools();
         }
 
+        /// <summary>
+        /// Opens "Min Pool Size" connections with the given connection string and returns them to the pool, so the first
+        /// connections opened afterwards don't pay for opening the database.  Does nothing unless pooling is enabled.
+        /// </summary>
+        /// <param name="connectionString">The connection string of the connections to pool</param>
+        public static void WarmPool(string connectionString)
+        {
+            SqliteConnectionPool.Options poolOptions = SqliteConnectionOptions.Get(connectionString).PoolOptions;
+            if (poolOptions == null)
+            {
+                return;
+            }
+
+            int minPoolSize = poolOptions.MinPoolSize;
+            var connections = new List<SqliteConnection>(minPoolSize);
+            try
+            {
+                // All of them have to be open at once, or they would all be the same pooled connection
+                for (int n = 0; n < minPoolSize; n++)
+                {
+                    var cnn = new SqliteConnection(connectionString);
+                    connections.Add(cnn);
+                    cnn.Open();
+                }
+            }
+            finally
+            {
+                foreach (SqliteConnection cnn in connections)
+                {
+                    cnn.Close();
+                }
+            }
+        }
+
+        /// <summary>
+        /// The number of times a pooled connection was opened by taking an idle connection from the pool
+        /// </summary>
+        public static long PoolHits
+        {
+            get { return SqliteConnectionPool.Hits; }
+        }
+
+        /// <summary>
+        /// The number of times a pooled connection had to open the database because the pool had no idle connection
+        /// </summary>
+        public static long PoolMisses
+        {
+            get { return SqliteConnectionPool.Misses; }
+        }
+
+        /// <summary>
+        /// The number of times opening a pooled connection had to wait because "Max Pool Size" connections were open
+        /// </summary>
+        public static long PoolWaits
+        {
+            get { return SqliteConnectionPool.Waits; }
+        }
+
+        /// <summary>
+        /// The number of idle connections the pools closed because they exceeded the "Pool Idle Timeout"
+        /// </summary>
+        public static long PoolEvictions
+        {
+            get { return SqliteConnectionPool.Evictions; }
+        }
+
         /// <summary>
         /// The connection string containing the parameters for the connection
         /// </summary>
@@ -547,11 +720,59 @@ public static void ClearAllPools()
         /// </item>
         /// <item>
         /// <description>Max Pool Size</description>
-        /// <description>The maximum number of connections for the given connection string that can be in the connection pool</description>
+        /// <description>The maximum number of pooled connections to the database file, idle or in use.  Once reached, opening a connection waits up to Default Timeout seconds for another one to be closed</description>
         /// <description>N</description>
         /// <description>100</description>
         /// </item>
         /// <item>
+        /// <description>Min Pool Size</description>
+        /// <description>The number of pooled connections that are kept open however long they are idle.  See WarmPool()</description>
+        /// <description>N</description>
+        /// <description>0</description>
+        /// </item>
+        /// <item>
+        /// <description>Pool Idle Timeout</description>
+        /// <description>The number of seconds a connection can be idle in the pool before it is closed.  0 keeps idle connections open</description>
+        /// <description>N</description>
+        /// <description>300</description>
+        /// </item>
+        /// <item>
+        /// <description>Statement Cache Size</description>
+        /// <description>The number of distinct command texts whose prepared statements are kept for reuse on the connection.  0 disables the cache</description>
+        /// <description>N</description>
+        /// <description>0</description>
+        /// </item>
+        /// <item>
+        /// <description>Busy Strategy</description>
+        /// <description><b>Backoff</b> - Retry a locked statement after a growing, randomized delay<br/><b>Native</b> - Have SQLite wait for the lock inside the call<br/><b>None</b> - Fail as soon as the database is locked</description>
+        /// <description>N</description>
+        /// <description>Backoff</description>
+        /// </item>
+        /// <item>
+        /// <description>Lookaside Slot Size</description>
+        /// <description>The size in bytes of the slots of the connection's lookaside memory, the arena sqlite takes its small allocations from.  0 keeps the default</description>
+        /// <description>N</description>
+        /// <description>0</description>
+        /// </item>
+        /// <item>
+        /// <description>Lookaside Slot Count</description>
+        /// <description>The number of lookaside slots of the connection.  0 disables lookaside memory, -1 keeps the default.  A pooled connection keeps the lookaside memory it was first opened with</description>
+        /// <description>N</description>
+        /// <description>-1</description>
+        /// </item>
+        /// <item>
+        /// <description>Mmap Size</description>
+        /// <description>The number of bytes of the database file to read through memory-mapped I/O, up to the limit set with ConfigureMmapSize().  0 disables it</description>
+        /// <description>N</description>
+        /// <description>0</description>
+        /// </item>
+        /// <item>
+        /// <description>Soft Heap Limit</description>
+        /// <description>The number of bytes of heap sqlite tries to stay under by giving back cache memory.  Applies to the whole process.  0 means no limit</description>
+        /// <description>N</description>
+        /// <description>0</description>
+        /// </item>
+        /// <item>
         /// <description>Default IsolationLevel</description>
         /// <description>The default transaciton isolation level</description>
         /// <description>N</description>
@@ -730,98 +951,45 @@ public override void Open()
 
             Close();
 
-            Dictionary<string, string> opts = ParseConnectionString(_connectionString);
-
-            if (Convert.ToInt32(FindKey(opts, "Version", "3"), CultureInfo.InvariantCulture) != 3)
-            {
-                throw new NotSupportedException("Only SQLite Version 3 is supported at this time");
-            }
+            SqliteConnectionOptions options = SqliteConnectionOptions.Get(_connectionString);
 
-            string fileName = FindKey(opts, "Data Source", "");
-            if (String.IsNullOrEmpty(fileName))
-            {
-                fileName = FindKey(opts, "Uri", "");
-                if (String.IsNullOrEmpty(fileName))
-                {
-                    throw new ArgumentException("Data Source cannot be empty.  Use :memory: to open an in-memory database");
-                }
-
-                fileName = MapUriPath(fileName);
-            }
-            if (String.Compare(fileName, ":MEMORY:", StringComparison.OrdinalIgnoreCase) == 0)
-            {
-                fileName = ":memory:";
-            }
-            else
+            string fileName = options.FileName;
+            if (fileName != ":memory:")
             {
                 fileName = this.ExpandFileName(fileName);
             }
 
             try
             {
-                bool usePooling = SqliteConvert.ToBoolean(FindKey(opts, "Pooling", Boolean.FalseString));
-                bool bUTF16 = SqliteConvert.ToBoolean(FindKey(opts, "UseUTF16Encoding", Boolean.FalseString));
-                int maxPoolSize = Convert.ToInt32(FindKey(opts, "Max Pool Size", "100"));
-
-                _defaultTimeout = Convert.ToInt32(FindKey(opts, "Default Timeout", "30"), CultureInfo.CurrentCulture);
-
-                _defaultIsolation =
-                    (IsolationLevel)
-                    Enum.Parse(typeof (IsolationLevel), FindKey(opts, "Default IsolationLevel", "Serializable"), true);
-                if (_defaultIsolation != IsolationLevel.Serializable &&
-                    _defaultIsolation != IsolationLevel.ReadCommitted)
-                {
-                    throw new NotSupportedException("Invalid Default IsolationLevel specified");
-                }
-
-                var dateFormat =
-                    (SQLiteDateFormats)
-                    Enum.Parse(typeof(SQLiteDateFormats), FindKey(opts, "DateTimeFormat", "ISO8601"), true);
-                //string temp = FindKey(opts, "DateTimeFormat", "ISO8601");
-                //if (String.Compare(temp, "ticks", true, CultureInfo.InvariantCulture) == 0) dateFormat = SQLiteDateFormats.Ticks;
-                //else if (String.Compare(temp, "julianday", true, CultureInfo.InvariantCulture) == 0) dateFormat = SQLiteDateFormats.JulianDay;
+                _defaultTimeout = options.DefaultTimeout;
+                _defaultIsolation = options.DefaultIsolation;
 
                 // SQLite automatically sets the encoding of the database to UTF16 if called from sqlite3_open16()
-                this._sql = bUTF16 ? new SQLite3_UTF16(dateFormat) : new SQLite3(dateFormat);
+                this._sql = options.UseUTF16 ? new SQLite3_UTF16(options.DateFormat) : new SQLite3(options.DateFormat);
 
-                SQLiteOpenFlagsEnum flags = SQLiteOpenFlagsEnum.None;
-                if (SqliteConvert.ToBoolean(FindKey(opts, "Read Only", Boolean.FalseString)))
-                {
-                    flags |= SQLiteOpenFlagsEnum.ReadOnly;
-                }
-                else
-                {
-                    flags |= SQLiteOpenFlagsEnum.ReadWrite;
-                    if (SqliteConvert.ToBoolean(FindKey(opts, "FailIfMissing", Boolean.FalseString)) == false)
-                    {
-                        flags |= SQLiteOpenFlagsEnum.Create;
-                    }
-                }
-                if (SqliteConvert.ToBoolean(FindKey(opts, "FileProtectionComplete", Boolean.FalseString)))
-                {
-                    flags |= SQLiteOpenFlagsEnum.FileProtectionComplete;
-                }
-                if (SqliteConvert.ToBoolean(FindKey(opts, "FileProtectionCompleteUnlessOpen", Boolean.FalseString)))
-                {
-                    flags |= SQLiteOpenFlagsEnum.FileProtectionCompleteUnlessOpen;
-                }
-                if (SqliteConvert.ToBoolean(FindKey(opts, "FileProtectionCompleteUntilFirstUserAuthentication", Boolean.FalseString)))
+                _sql.Open(fileName, options.Flags, options.PoolOptions);
+
+                if (options.LookasideSlotSize > 0 || options.LookasideSlotCount >= 0)
                 {
-                    flags |= SQLiteOpenFlagsEnum.FileProtectionCompleteUntilFirstUserAuthentication;
+                    // sqlite takes 0 or a negative value to mean its default for either number
+                    _sql.SetLookaside(options.LookasideSlotSize, options.LookasideSlotCount);
                 }
-                if (SqliteConvert.ToBoolean(FindKey(opts, "FileProtectionNone", Boolean.FalseString)))
+
+                if (options.SoftHeapLimit != null)
                 {
-                    flags |= SQLiteOpenFlagsEnum.FileProtectionNone;
+                    SoftHeapLimit = options.SoftHeapLimit.Value;
                 }
 
-                _sql.Open(fileName, flags, maxPoolSize, usePooling);
+                _statementCache = _sql.GetStatementCache(options.StatementCacheSize);
+
+                _busyWait = new SqliteBusyWait(options.BusyStrategy);
+                _sql.SetBusyWait(_busyWait);
 
-                _binaryGuid = SqliteConvert.ToBoolean(FindKey(opts, "BinaryGUID", Boolean.TrueString));
+                _binaryGuid = options.BinaryGuid;
 
-                string password = FindKey(opts, "Password", null);
-                if (String.IsNullOrEmpty(password) == false)
+                if (options.Password != null)
                 {
-                    _sql.SetPassword(password);
+                    _sql.SetPassword(options.Password);
                 }
                 else if (_password != null)
                 {
@@ -835,55 +1003,15 @@ public override void Open()
                 OnStateChange(ConnectionState.Open);
                 _version++;
 
-                using (SqliteCommand cmd = CreateCommand())
+                // A connection that came out of the pool has them already, unless something changed them since
+                if (_sql.Settings != options.Pragmas)
                 {
-                    string defValue;
-
-                    if (fileName != ":memory:")
-                    {
-                        defValue = FindKey(opts, "Page Size", "1024");
-                        if (Convert.ToInt32(defValue, CultureInfo.InvariantCulture) != 1024)
-                        {
-                            cmd.CommandText = String.Format(CultureInfo.InvariantCulture, "PRAGMA page_size={0}",
-                                                            defValue);
-                            cmd.ExecuteNonQuery();
-                        }
-                    }
-
-                    defValue = FindKey(opts, "Max Page Count", "0");
-                    if (Convert.ToInt32(defValue, CultureInfo.InvariantCulture) != 0)
-                    {
-                        cmd.CommandText = String.Format(CultureInfo.InvariantCulture, "PRAGMA max_page_count={0}",
-                                                        defValue);
-                        cmd.ExecuteNonQuery();
-                    }
-
-                    defValue = FindKey(opts, "Legacy Format", Boolean.FalseString);
-                    cmd.CommandText = String.Format(CultureInfo.InvariantCulture, "PRAGMA legacy_file_format={0}",
-                                                    SqliteConvert.ToBoolean(defValue) ? "ON" : "OFF");
-                    cmd.ExecuteNonQuery();
-
-                    defValue = FindKey(opts, "Synchronous", "Normal");
-                    if (String.Compare(defValue, "Full", StringComparison.OrdinalIgnoreCase) != 0)
-                    {
-                        cmd.CommandText = String.Format(CultureInfo.InvariantCulture, "PRAGMA synchronous={0}", defValue);
-                        cmd.ExecuteNonQuery();
-                    }
-
-                    defValue = FindKey(opts, "Cache Size", "2000");
-                    if (Convert.ToInt32(defValue, CultureInfo.InvariantCulture) != 2000)
-                    {
-                        cmd.CommandText = String.Format(CultureInfo.InvariantCulture, "PRAGMA cache_size={0}", defValue);
-                        cmd.ExecuteNonQuery();
-                    }
-
-                    defValue = FindKey(opts, "Journal Mode", "Delete");
-                    if (String.Compare(defValue, "Default", StringComparison.OrdinalIgnoreCase) != 0)
+                    using (SqliteCommand cmd = CreateCommand())
                     {
-                        cmd.CommandText = String.Format(CultureInfo.InvariantCulture, "PRAGMA journal_mode={0}",
-                                                        defValue);
+                        cmd.CommandText = options.Pragmas;
                         cmd.ExecuteNonQuery();
                     }
+                    _sql.Settings = options.Pragmas;
                 }
 
                 if (_commitHandler != null)
@@ -901,8 +1029,17 @@ public override void Open()
                     _sql.SetRollbackHook(_rollbackCallback);
                 }
 
-                if (global::System.Transactions.Transaction.Current != null && 
-                    SqliteConvert.ToBoolean(FindKey(opts, "Enlist", Boolean.TrueString)))
+                if (_profiler != null)
+                {
+                    _sql.SetProfiler(_profiler);
+                }
+
+                if (_checkpointer != null)
+                {
+                    _sql.SetWalHook(_walCallback);
+                }
+
+                if (global::System.Transactions.Transaction.Current != null && options.Enlist)
                     EnlistTransaction(global::System.Transactions.Transaction.Current);
             }
             catch (SqliteException)
@@ -924,6 +1061,109 @@ public int DefaultTimeout
             set { _defaultTimeout = value; }
         }
 
+        /// <summary>
+        /// The number of times a command found its prepared statements in the statement cache since the connection was
+        /// last opened, or for a pooled connection since it was first opened.  Always 0 unless "Statement Cache Size" is
+        /// set in the ConnectionString.
+        /// </summary>
+        public long StatementCacheHits
+        {
+            get { return (_statementCache != null) ? _statementCache.Hits : 0; }
+        }
+
+        /// <summary>
+        /// The number of times a command had to prepare its statements because they were not in the statement cache,
+        /// since the connection was last opened.
+        /// </summary>
+        public long StatementCacheMisses
+        {
+            get { return (_statementCache != null) ? _statementCache.Misses : 0; }
+        }
+
+        /// <summary>
+        /// The number of times a statement was retried because the database was locked by another connection, since
+        /// the connection was last opened.
+        /// </summary>
+        public long BusyRetries
+        {
+            get { return (_busyWait != null) ? _busyWait.Retries : 0; }
+        }
+
+        /// <summary>
+        /// The total time commands spent waiting for another connection to release a lock, since the connection was
+        /// last opened.
+        /// </summary>
+        public TimeSpan BusyWaitTime
+        {
+            get { return (_busyWait != null) ? _busyWait.WaitTime : TimeSpan.Zero; }
+        }
+
+        /// <summary>
+        /// Turns the profiling of statements on or off.  While it is on, the connection times every prepare, step and
+        /// reset, reads sqlite's counters of each statement when its execution ends, and sums them up per statement
+        /// text.  Turning it off discards the profiles collected so far.
+        /// </summary>
+        /// <remarks>
+        /// Profiling is off by default, and costs nothing but a null check per call while it is off.
+        /// </remarks>
+        public bool ProfileStatements
+        {
+            get { return _profiler != null; }
+            set
+            {
+                if (value == (_profiler != null))
+                    return;
+
+                if (value)
+                {
+                    _profiler = new SqliteProfiler();
+                    _profiler.Completed = OnStatementCompleted;
+                }
+                else
+                {
+                    _profiler = null;
+                }
+
+                if (_sql != null) _sql.SetProfiler(_profiler);
+            }
+        }
+
+        /// <summary>
+        /// Returns a snapshot of the profile of every statement text executed since ProfileStatements was turned on
+        /// or ClearStatementProfiles() was called.  Empty if ProfileStatements is off.
+        /// </summary>
+        public IList<SqliteStatementProfile> GetStatementProfiles()
+        {
+            if (_profiler == null)
+                return new List<SqliteStatementProfile>();
+
+            return _profiler.GetProfiles();
+        }
+
+        /// <summary>
+        /// Discards the profiles collected so far, leaving ProfileStatements on
+        /// </summary>
+        public void ClearStatementProfiles()
+        {
+            if (_profiler != null)
+                _profiler.Clear();
+        }
+
+        /// <summary>
+        /// This event is raised each time the execution of a statement ends while ProfileStatements is on, with the
+        /// timings and counters of that execution.
+        /// </summary>
+        public event SqliteStatementCompletedHandler StatementCompleted;
+
+        private void OnStatementCompleted(SqliteStatementProfile execution)
+        {
+            SqliteStatementCompletedHandler handler = StatementCompleted;
+            if (handler != null)
+            {
+                handler(this, new SqliteStatementCompletedEventArgs(execution));
+            }
+        }
+
         /// <summary>
         /// Returns the version of the underlying SQLite database engine
         /// </summary>
@@ -954,6 +1194,190 @@ public override ConnectionState State
             get { return _connectionState; }
         }
 
+        /// <summary>
+        /// Opens a stream for incremental I/O on the blob stored in a column of a row of a table in the main database
+        /// </summary>
+        /// <param name="table">The table</param>
+        /// <param name="column">The column holding the blob</param>
+        /// <param name="rowid">The rowid of the row</param>
+        /// <param name="writable">Whether the stream can write to the blob as well as read it</param>
+        /// <returns>A stream over the blob, which must be disposed before the connection commits a write transaction</returns>
+        public SqliteBlobStream OpenBlob(string table, string column, long rowid, bool writable)
+        {
+            return OpenBlob(null, table, column, rowid, writable);
+        }
+
+        /// <summary>
+        /// Opens a stream for incremental I/O on the blob stored in a column of a row
+        /// </summary>
+        /// <param name="database">The database the table is in, such as "main" or the name of an attached database</param>
+        /// <param name="table">The table</param>
+        /// <param name="column">The column holding the blob</param>
+        /// <param name="rowid">The rowid of the row</param>
+        /// <param name="writable">Whether the stream can write to the blob as well as read it</param>
+        /// <returns>A stream over the blob, which must be disposed before the connection commits a write transaction</returns>
+        public SqliteBlobStream OpenBlob(string database, string table, string column, long rowid, bool writable)
+        {
+            if (_connectionState != ConnectionState.Open)
+                throw new InvalidOperationException("Database must be opened before opening a blob.");
+            if (table == null)
+                throw new ArgumentNullException("table");
+            if (column == null)
+                throw new ArgumentNullException("column");
+
+            var stream = new SqliteBlobStream(this, _sql.OpenBlob(database, table, column, rowid, writable), writable);
+            if (_blobStreams == null)
+                _blobStreams = new List<SqliteBlobStream>();
+            _blobStreams.Add(stream);
+            return stream;
+        }
+
+        internal void RemoveBlobStream(SqliteBlobStream stream)
+        {
+            if (_blobStreams != null)
+                _blobStreams.Remove(stream);
+        }
+
+        /// <summary>
+        /// Copies the main database of this connection over the main database of another, in a single step
+        /// </summary>
+        /// <param name="destination">The open connection to copy into, which may be an in-memory database</param>
+        public void BackupDatabase(SqliteConnection destination)
+        {
+            BackupDatabase(destination, "main", "main", -1, null, 0);
+        }
+
+        /// <summary>
+        /// Takes a consistent snapshot of a database of this connection, while it stays in use, by copying it page by
+        /// page over a database of another connection.
+        /// </summary>
+        /// <param name="destination">The open connection to copy into.  Either connection may be an in-memory database.</param>
+        /// <param name="destinationName">The database to overwrite, such as "main" or the name of an attached database</param>
+        /// <param name="sourceName">The database to copy</param>
+        /// <param name="pages">The number of pages to copy per step, or a negative number to copy everything in one step</param>
+        /// <param name="callback">Called after each step with the progress of the backup; returning false abandons it.
+        /// Can be null.</param>
+        /// <param name="sleepMilliseconds">How long to wait after each step, and before retrying one that found the
+        /// source database locked, so that the connections writing to it keep their latency while the backup runs</param>
+        /// <remarks>
+        /// The source is only locked while a step copies its pages.  If another connection writes to it between two
+        /// steps, sqlite restarts the backup from the first page on the next step, and the callback sees the remaining
+        /// and total page counts go back up; a source that never pauses long enough for the copy to catch up keeps it
+        /// restarting, so pick a page count and sleep that let it finish.  Writes made through this connection are
+        /// applied to the copy as they happen, without a restart.  The destination is locked for the whole backup.
+        /// A source that stays locked for longer than DefaultTimeout fails the backup with SQLITE_BUSY.
+        /// </remarks>
+        public void BackupDatabase(SqliteConnection destination, string destinationName, string sourceName, int pages,
+                                   SqliteBackupCallback callback, int sleepMilliseconds)
+        {
+            if (_connectionState != ConnectionState.Open)
+                throw new InvalidOperationException("Source database is not open.");
+            if (destination == null)
+                throw new ArgumentNullException("destination");
+            if (destination._connectionState != ConnectionState.Open)
+                throw new ArgumentException("Destination database is not open.", "destination");
+            if (pages == 0)
+                throw new ArgumentOutOfRangeException("pages", "Must copy at least one page per step");
+            if (sleepMilliseconds < 0)
+                throw new ArgumentOutOfRangeException("sleepMilliseconds");
+
+            SqliteBackupHandle backup = _sql.InitializeBackup(destination._sql, destinationName, sourceName);
+            bool retry = false;
+            bool abandoned = false;
+            bool finished = false;
+            uint timeout = (uint)Math.Max(0, _defaultTimeout) * 1000;
+            uint lockedtick = 0;
+            try
+            {
+                while (true)
+                {
+                    bool more = _sql.StepBackup(backup, pages, out retry);
+
+                    if (callback != null &&
+                        callback(this, sourceName, destination, destinationName, pages, _sql.RemainingBackup(backup),
+                                 _sql.PageCountBackup(backup), retry) == false)
+                    {
+                        abandoned = true;
+                        break;
+                    }
+
+                    if (more == false)
+                        break;
+
+                    // The retries of a locked source are bounded by DefaultTimeout, counted from the first step
+                    // that found it locked
+                    if (retry == false)
+                        lockedtick = 0;
+                    else if (lockedtick == 0)
+                        lockedtick = (uint)Environment.TickCount | 1;
+                    else if ((uint)Environment.TickCount - lockedtick >= timeout)
+                        throw new SqliteException((int)SQLiteErrorCode.Busy, "The source database stayed locked for longer than DefaultTimeout");
+
+                    // A locked database is retried after at least a millisecond, rather than spinning
+                    int sleep = retry ? Math.Max(sleepMilliseconds, 1) : sleepMilliseconds;
+                    if (sleep > 0)
+                        SqliteBusyWait.Delay(sleep);
+                }
+                finished = true;
+            }
+            finally
+            {
+                // An exception already on its way out is not replaced by the error of the backup
+                int n = _sql.FinishBackup(backup);
+                if (finished && n > 0 && (abandoned && retry) == false)
+                    throw new SqliteException(n, destination._sql.SQLiteLastError());
+            }
+        }
+
+        /// <summary>
+        /// Checkpoints every database of the connection that is in WAL mode
+        /// </summary>
+        /// <param name="mode">The kind of checkpoint to run</param>
+        /// <returns>False if the checkpoint could not finish because another connection held a lock</returns>
+        public bool Checkpoint(SqliteCheckpointMode mode)
+        {
+            int logFrames;
+            int checkpointedFrames;
+            return Checkpoint(null, mode, out logFrames, out checkpointedFrames);
+        }
+
+        /// <summary>
+        /// Copies the frames of a database's write-ahead log back into the database
+        /// </summary>
+        /// <param name="database">The database to checkpoint, such as "main", or null for every database of the
+        /// connection</param>
+        /// <param name="mode">The kind of checkpoint to run</param>
+        /// <param name="logFrames">The number of frames in the log, or -1 if the database is not in WAL mode</param>
+        /// <param name="checkpointedFrames">The number of frames of the log now copied into the database, or -1 if the
+        /// database is not in WAL mode</param>
+        /// <returns>False if the checkpoint could not finish because another connection held a lock</returns>
+        public bool Checkpoint(string database, SqliteCheckpointMode mode, out int logFrames, out int checkpointedFrames)
+        {
+            if (_connectionState != ConnectionState.Open)
+                throw new InvalidOperationException("Database must be opened before running a checkpoint.");
+
+            return _sql.Checkpoint(database, mode, out logFrames, out checkpointedFrames);
+        }
+
+        /// <summary>
+        /// The checkpointer that runs the checkpoints of the database in the background, or null to leave them to sqlite,
+        /// which runs them on the commit that takes the write-ahead log past 1000 frames.  Can be set before or after the
+        /// connection is opened; connections from different threads can share a checkpointer.
+        /// </summary>
+        public SqliteCheckpointer Checkpointer
+        {
+            get { return _checkpointer; }
+            set
+            {
+                if (value == _checkpointer)
+                    return;
+
+                _checkpointer = value;
+                _walCallback = (value != null) ? new SqliteWalHookDelegate(WalCallback) : null;
+                if (_sql != null) _sql.SetWalHook(_walCallback);
+            }
+        }
+
         /// <summary>
         /// Change the password (or assign a password) to an open database.
         /// </summary>
@@ -1096,9 +1520,138 @@ private void RollbackCallback(object parg)
             _rollbackHandler(this, EventArgs.Empty);
         }
 
+        private int WalCallback(object parg, string database, int frames)
+        {
+            SqliteCheckpointer checkpointer = _checkpointer;
+            if (checkpointer != null)
+                checkpointer.OnCommit(database, frames);
+            return 0;
+        }
+
+        /// <summary>
+        /// The worker that runs the asynchronous operations of the open connection
+        /// </summary>
+        internal SqliteWorker Worker
+        {
+            get
+            {
+                if (_connectionState != ConnectionState.Open)
+                    throw new InvalidOperationException("Database is not open");
+
+                if (_worker == null)
+                    _worker = new SqliteWorker(this);
+                return _worker;
+            }
+        }
+
+        /// <summary>
+        /// Reads one of the connection's memory and cache counters
+        /// </summary>
+        /// <param name="status">The counter to read</param>
+        /// <param name="current">The current value of the counter</param>
+        /// <param name="highwater">The highest value of the counter, where sqlite keeps one</param>
+        /// <param name="reset">Whether to reset the high-water mark, or the counter itself for the cache counters</param>
+        public void GetStatus(SqliteConnectionStatus status, out int current, out int highwater, bool reset)
+        {
+            if (_connectionState != ConnectionState.Open)
+                throw new InvalidOperationException("Database must be opened before reading its status.");
+
+            _sql.GetStatus(status, out current, out highwater, reset);
+        }
+
+        /// <summary>
+        /// Reads one of sqlite's process-wide memory counters
+        /// </summary>
+        /// <param name="status">The counter to read</param>
+        /// <param name="current">The current value of the counter</param>
+        /// <param name="highwater">The highest value of the counter</param>
+        /// <param name="reset">Whether to reset the high-water mark</param>
+        public static void GetMemoryStatus(SqliteMemoryStatus status, out long current, out long highwater, bool reset)
+        {
+            int n = UnsafeNativeMethods.sqlite3_status64((int)status, out current, out highwater, reset ? 1 : 0);
+            if (n > 0) throw new SqliteException(n, null);
+        }
+
+        /// <summary>
+        /// The number of bytes of heap sqlite tries to stay under by giving back cache memory, or 0 for no limit.
+        /// Applies to the whole process; the Soft Heap Limit connection string key sets it too.
+        /// </summary>
+        public static long SoftHeapLimit
+        {
+            get { return UnsafeNativeMethods.sqlite3_soft_heap_limit64(-1); }
+            set
+            {
+                if (value < 0)
+                    throw new ArgumentOutOfRangeException("value");
+
+                UnsafeNativeMethods.sqlite3_soft_heap_limit64(value);
+            }
+        }
+
+        /// <summary>
+        /// Gives sqlite a page cache arena of its own, so that the page caches of every connection are carved out of
+        /// one allocation instead of the heap.  Like the other process-wide settings, this must be made before the
+        /// first connection is opened.
+        /// </summary>
+        /// <param name="pageSize">The size of a slot, which must hold a page plus sqlite's per-page header of a few
+        /// hundred bytes</param>
+        /// <param name="pageCount">The number of slots, or 0 to go back to allocating pages from the heap</param>
+        public static void ConfigurePageCache(int pageSize, int pageCount)
+        {
+            SetConfig(SQLiteConfig.PageCache, pageSize, pageCount);
+        }
+
+        /// <summary>
+        /// Sets the default lookaside memory of new connections, the per-connection arena sqlite takes its small
+        /// allocations from.  Must be made before the first connection is opened; the Lookaside Slot Size and Lookaside
+        /// Slot Count connection string keys override it for one connection.
+        /// </summary>
+        /// <param name="slotSize">The size of a slot in bytes</param>
+        /// <param name="slotCount">The number of slots of each connection, or 0 to disable lookaside memory</param>
+        public static void ConfigureLookaside(int slotSize, int slotCount)
+        {
+            SetConfig(SQLiteConfig.Lookaside, slotSize, slotCount);
+        }
+
+        /// <summary>
+        /// Sets how much of a database file is memory-mapped by default, and the most a connection can ask for with the
+        /// Mmap Size connection string key.  Must be made before the first connection is opened.
+        /// </summary>
+        /// <param name="defaultSize">The number of bytes mapped by default</param>
+        /// <param name="maxSize">The most bytes any connection can map</param>
+        public static void ConfigureMmapSize(long defaultSize, long maxSize)
+        {
+            SetConfig(SQLiteConfig.MmapSize, defaultSize, maxSize);
+        }
+
+        /// <summary>
+        /// Changes one of sqlite's process-wide settings.  sqlite only accepts them before it is initialized, which is
+        /// when the first connection is opened, and fails with SQLITE_MISUSE after that.
+        /// </summary>
+        /// <param name="config">The setting to change</param>
+        /// <param name="args">The values of the setting: none, one or two ints, or two longs</param>
         public static void SetConfig(SQLiteConfig config, params object[] args)
         {
-            int n = UnsafeNativeMethods.sqlite3_config((int)config, args);
+            if (args == null)
+                args = new object[0];
+
+            int n;
+            if (args.Length == 0)
+                n = UnsafeNativeMethods.sqlite3_config((int)config);
+            else if (args.Length == 1 && args[0] is int)
+                n = UnsafeNativeMethods.sqlite3_config_int((int)config, (int)args[0]);
+            else if (args.Length == 2 && args[0] is int && args[1] is int)
+            {
+                if (config == SQLiteConfig.PageCache)
+                    n = UnsafeNativeMethods.sqlite3_config_pagecache((int)args[0], (int)args[1]);
+                else
+                    n = UnsafeNativeMethods.sqlite3_config_int_int((int)config, (int)args[0], (int)args[1]);
+            }
+            else if (args.Length == 2 && args[0] is long && args[1] is long)
+                n = UnsafeNativeMethods.sqlite3_config_int64_int64((int)config, (long)args[0], (long)args[1]);
+            else
+                throw new ArgumentException("SetConfig takes no value, one or two ints, or two longs", "args");
+
             if (n > 0) throw new SqliteException(n, null);
         }
     }
@@ -1139,6 +1692,22 @@ public enum SynchronizationModes
     /// <param name="e">The event parameters which triggered the event</param>
     public delegate void SQLiteUpdateEventHandler(object sender, UpdateEventArgs e);
 
+    /// <summary>
+    /// Reports the progress of SqliteConnection.BackupDatabase() after each step
+    /// </summary>
+    /// <param name="source">The connection being copied</param>
+    /// <param name="sourceName">The database being copied</param>
+    /// <param name="destination">The connection being copied into</param>
+    /// <param name="destinationName">The database being overwritten</param>
+    /// <param name="pages">The number of pages copied per step</param>
+    /// <param name="remainingPages">The number of pages still to copy</param>
+    /// <param name="totalPages">The number of pages of the source database</param>
+    /// <param name="retry">True if the step found the source database locked and copied nothing</param>
+    /// <returns>True to carry on with the backup, false to abandon it</returns>
+    public delegate bool SqliteBackupCallback(SqliteConnection source, string sourceName, SqliteConnection destination,
+                                              string destinationName, int pages, int remainingPages, int totalPages,
+                                              bool retry);
+
     /// <summary>
     /// Whenever an update event is triggered on a connection, this enum will indicate
     /// exactly what type of operation is being performed.
@@ -0,0 +1,424 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ *
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.Collections.Generic;
+  using System.Threading;
+  using System.Threading.Tasks;
+
+  /// <summary>
+  /// Shares a database in WAL mode between many threads: reads run in parallel on a set of read-only connections,
+  /// and writes are queued to a single writer connection, which runs them one after the other.
+  /// </summary>
+  /// <remarks>
+  /// In WAL mode readers do not block the writer nor each other, so only writes need to be serialized, and a queue
+  /// serializes them without the SQLITE_BUSY retries of connections that compete for the write lock.  The writer is
+  /// opened by the constructor, which switches the database to WAL mode; up to ReaderCount read-only connections are
+  /// opened as readers first need them, and kept for the life of the group.  The database has to be a file: an
+  /// in-memory database is private to the connection that opens it.
+  /// With GroupCommit set, the writer runs every write waiting in the queue, up to MaxBatchSize of them, in a single
+  /// transaction, so that many small writes from many threads share the cost of a commit.  Each write runs under a
+  /// savepoint of its own, so one that fails is rolled back on its own and the others are still committed; a write's
+  /// task only completes once the transaction holding it is committed.  Writes must not commit or roll back the
+  /// transaction they run in.
+  /// </remarks>
+  public sealed class SqliteConnectionGroup : IDisposable
+  {
+    /// <summary>
+    /// A write waiting in the queue
+    /// </summary>
+    private abstract class WriteUnit
+    {
+      internal bool Failed;
+
+      internal abstract void Execute(SqliteConnection cnn);
+      internal abstract void Complete();
+      internal abstract void Fail(Exception error);
+    }
+
+    private sealed class WriteUnit<T> : WriteUnit
+    {
+      private readonly Func<SqliteConnection, T> _work;
+      private readonly TaskCompletionSource<T> _source = new TaskCompletionSource<T>();
+      private T _result;
+
+      internal WriteUnit(Func<SqliteConnection, T> work)
+      {
+        _work = work;
+      }
+
+      internal Task<T> Task
+      {
+        get { return _source.Task; }
+      }
+
+      internal override void Execute(SqliteConnection cnn)
+      {
+        _result = _work(cnn);
+      }
+
+      internal override void Complete()
+      {
+        SqliteWorker.Complete(_source, _result, null, false);
+      }
+
+      internal override void Fail(Exception error)
+      {
+        Failed = true;
+        SqliteWorker.Complete(_source, default(T), error, false);
+      }
+    }
+
+    private readonly string _readerConnectionString;
+    private readonly int _readerCount;
+    private readonly SqliteConnection _writer;
+    private readonly Task _task;
+
+    private readonly Queue<WriteUnit> _queue = new Queue<WriteUnit>();
+    private bool _stopping;
+    private bool _groupCommit;
+    private int _maxBatchSize = 100;
+    private long _writes;
+    private long _commits;
+
+    private readonly Stack<SqliteConnection> _idleReaders = new Stack<SqliteConnection>();
+    private int _openReaders;
+    private bool _disposed;
+
+    /// <summary>
+    /// Opens a group on a database
+    /// </summary>
+    /// <param name="connectionString">The connection string of the database.  The group opens its connections with
+    /// pooling off, and sets the journal mode itself.</param>
+    /// <param name="readerCount">The most read-only connections the group opens, which is the most reads that run at
+    /// the same time</param>
+    public SqliteConnectionGroup(string connectionString, int readerCount)
+    {
+      if (connectionString == null)
+        throw new ArgumentNullException("connectionString");
+      if (readerCount < 1)
+        throw new ArgumentOutOfRangeException("readerCount");
+
+      // Parsed the way the connections will parse it, which also takes the Mono style of comma separated keywords
+      var builder = new SqliteConnectionStringBuilder();
+      foreach (KeyValuePair<string, string> pair in SqliteConnection.ParseConnectionString(connectionString))
+        builder[pair.Key] = pair.Value;
+      builder.Pooling = false;
+      builder["journal mode"] = "WAL";
+      string writerConnectionString = builder.ConnectionString;
+
+      // The readers find the database in WAL mode already, and could not change it anyway
+      builder["journal mode"] = "Default";
+      builder.ReadOnly = true;
+      _readerConnectionString = builder.ConnectionString;
+      _readerCount = readerCount;
+
+      _writer = new SqliteConnection(writerConnectionString);
+      _writer.Open();
+      _task = Task.Factory.StartNew(Run, TaskCreationOptions.LongRunning);
+    }
+
+    /// <summary>
+    /// The most read-only connections the group opens
+    /// </summary>
+    public int ReaderCount
+    {
+      get { return _readerCount; }
+    }
+
+    /// <summary>
+    /// Whether the writer commits the writes waiting in the queue together, in one transaction.  Off by default, which
+    /// gives each write a transaction of its own.
+    /// </summary>
+    public bool GroupCommit
+    {
+      get { lock (_queue) return _groupCommit; }
+      set { lock (_queue) _groupCommit = value; }
+    }
+
+    /// <summary>
+    /// The most writes committed together when GroupCommit is set.  100 by default.
+    /// </summary>
+    public int MaxBatchSize
+    {
+      get { lock (_queue) return _maxBatchSize; }
+      set
+      {
+        if (value < 1)
+          throw new ArgumentOutOfRangeException("value");
+
+        lock (_queue) _maxBatchSize = value;
+      }
+    }
+
+    /// <summary>
+    /// The number of writes committed
+    /// </summary>
+    public long Writes
+    {
+      get { lock (_queue) return _writes; }
+    }
+
+    /// <summary>
+    /// The number of transactions the writer committed
+    /// </summary>
+    public long Commits
+    {
+      get { lock (_queue) return _commits; }
+    }
+
+    /// <summary>
+    /// Runs a read on one of the read-only connections, waiting for one to be free if ReaderCount reads are running
+    /// </summary>
+    /// <param name="work">The read, which must not keep the connection past its return</param>
+    /// <returns>The result of the read</returns>
+    public T Read<T>(Func<SqliteConnection, T> work)
+    {
+      if (work == null)
+        throw new ArgumentNullException("work");
+
+      SqliteConnection cnn = AcquireReader();
+      try
+      {
+        return work(cnn);
+      }
+      finally
+      {
+        ReleaseReader(cnn);
+      }
+    }
+
+    /// <summary>
+    /// Queues a write for the writer connection
+    /// </summary>
+    /// <param name="work">The write, which runs on the writer's thread inside a transaction</param>
+    /// <returns>A task with the result of the write, which completes once the write is committed</returns>
+    public Task<T> Write<T>(Func<SqliteConnection, T> work)
+    {
+      if (work == null)
+        throw new ArgumentNullException("work");
+
+      var unit = new WriteUnit<T>(work);
+      lock (_queue)
+      {
+        if (_stopping)
+          throw new ObjectDisposedException("SqliteConnectionGroup");
+
+        _queue.Enqueue(unit);
+        Monitor.Pulse(_queue);
+      }
+      return unit.Task;
+    }
+
+    /// <summary>
+    /// Queues a write for the writer connection
+    /// </summary>
+    /// <param name="work">The write, which runs on the writer's thread inside a transaction</param>
+    /// <returns>A task that completes once the write is committed</returns>
+    public Task Write(Action<SqliteConnection> work)
+    {
+      if (work == null)
+        throw new ArgumentNullException("work");
+
+      return Write<object>(cnn =>
+        {
+          work(cnn);
+          return null;
+        });
+    }
+
+    /// <summary>
+    /// Runs the writes already queued, then closes the group's connections.  Readers still in use are closed as their
+    /// reads return.
+    /// </summary>
+    public void Dispose()
+    {
+      lock (_queue)
+      {
+        if (_stopping)
+          return;
+
+        _stopping = true;
+        Monitor.Pulse(_queue);
+      }
+      _task.Wait();
+      _writer.Dispose();
+
+      lock (_idleReaders)
+      {
+        _disposed = true;
+        while (_idleReaders.Count > 0)
+        {
+          _idleReaders.Pop().Dispose();
+          _openReaders--;
+        }
+        Monitor.PulseAll(_idleReaders);
+      }
+    }
+
+    private SqliteConnection AcquireReader()
+    {
+      lock (_idleReaders)
+      {
+        while (true)
+        {
+          if (_disposed)
+            throw new ObjectDisposedException("SqliteConnectionGroup");
+
+          if (_idleReaders.Count > 0)
+            return _idleReaders.Pop();
+
+          if (_openReaders < _readerCount)
+          {
+            _openReaders++;
+            break;
+          }
+
+          Monitor.Wait(_idleReaders);
+        }
+      }
+
+      // Opened outside the lock, so the other readers are not held up by it
+      var cnn = new SqliteConnection(_readerConnectionString);
+      try
+      {
+        cnn.Open();
+      }
+      catch
+      {
+        cnn.Dispose();
+        lock (_idleReaders)
+        {
+          _openReaders--;
+          Monitor.Pulse(_idleReaders);
+        }
+        throw;
+      }
+      return cnn;
+    }
+
+    private void ReleaseReader(SqliteConnection cnn)
+    {
+      lock (_idleReaders)
+      {
+        if (_disposed)
+        {
+          cnn.Dispose();
+          _openReaders--;
+          return;
+        }
+
+        _idleReaders.Push(cnn);
+        Monitor.Pulse(_idleReaders);
+      }
+    }
+
+    private void Run()
+    {
+      var batch = new List<WriteUnit>();
+      while (true)
+      {
+        lock (_queue)
+        {
+          while (_queue.Count == 0 && _stopping == false)
+            Monitor.Wait(_queue);
+
+          if (_queue.Count == 0)
+            break;
+
+          int max = _groupCommit ? _maxBatchSize : 1;
+          while (_queue.Count > 0 && batch.Count < max)
+            batch.Add(_queue.Dequeue());
+        }
+
+        RunBatch(batch);
+        batch.Clear();
+      }
+    }
+
+    private void RunBatch(List<WriteUnit> batch)
+    {
+      SqliteTransaction transaction = null;
+      try
+      {
+        transaction = _writer.BeginTransaction();
+
+        if (batch.Count == 1)
+        {
+          batch[0].Execute(_writer);
+        }
+        else
+        {
+          foreach (WriteUnit unit in batch)
+          {
+            Execute("SAVEPOINT batch_unit");
+            try
+            {
+              unit.Execute(_writer);
+            }
+            catch (Exception ex)
+            {
+              Execute("ROLLBACK TO batch_unit");
+              unit.Fail(ex);
+            }
+            Execute("RELEASE batch_unit");
+          }
+        }
+
+        transaction.Commit();
+      }
+      catch (Exception ex)
+      {
+        // Nothing the batch wrote was kept
+        if (transaction != null)
+        {
+          try
+          {
+            transaction.Dispose();
+          }
+          catch (SqliteException)
+          {
+          }
+        }
+
+        foreach (WriteUnit unit in batch)
+        {
+          if (unit.Failed == false)
+            unit.Fail(ex);
+        }
+        return;
+      }
+
+      int written = 0;
+      foreach (WriteUnit unit in batch)
+      {
+        if (unit.Failed == false)
+        {
+          unit.Complete();
+          written++;
+        }
+      }
+
+      lock (_queue)
+      {
+        _writes += written;
+        _commits++;
+      }
+    }
+
+    private void Execute(string sql)
+    {
+      using (SqliteCommand cmd = _writer.CreateCommand())
+      {
+        cmd.CommandText = sql;
+        cmd.ExecuteNonQuery();
+      }
+    }
+  }
+}
@@ -0,0 +1,283 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ *
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.Collections.Generic;
+  using System.Data;
+  using System.Globalization;
+  using System.Text;
+
+  /// <summary>
+  /// The settings of a connection string, parsed once and shared by every connection opened with it
+  /// </summary>
+  /// <remarks>
+  /// Connections are usually opened again and again with the same few connection strings, so the parsed settings are
+  /// cached by connection string.  The PRAGMA commands the settings call for are kept as a single command text, which
+  /// a pooled handle remembers once they have been run on it, so that it does not run them again each time it is
+  /// taken from the pool.
+  /// </remarks>
+  internal sealed class SqliteConnectionOptions
+  {
+    /// <summary>
+    /// The most connection strings cached.  The cache starts over when it is full, which only happens when connection
+    /// strings are built on the fly.
+    /// </summary>
+    private const int MaxCached = 100;
+
+    private static readonly Dictionary<string, SqliteConnectionOptions> _cache =
+      new Dictionary<string, SqliteConnectionOptions>(StringComparer.Ordinal);
+
+    /// <summary>
+    /// The pragmas the connection string sets.  A statement changing one of them leaves a pooled handle with settings
+    /// that no longer match its connection string.
+    /// </summary>
+    private static readonly string[] _pragmas =
+      {
+        "page_size", "max_page_count", "legacy_file_format", "synchronous", "cache_size", "mmap_size", "journal_mode"
+      };
+
+    /// <summary>
+    /// A PRAGMA takes its value after an equals sign, or between parentheses
+    /// </summary>
+    private static readonly char[] _assignment = { '=', '(' };
+
+    /// <summary>
+    /// The database file, ":memory:" for an in-memory database
+    /// </summary>
+    internal readonly string FileName;
+    internal readonly bool UseUTF16;
+    /// <summary>
+    /// The pool settings, or null if the connection string turns pooling off
+    /// </summary>
+    internal readonly SqliteConnectionPool.Options PoolOptions;
+    internal readonly int DefaultTimeout;
+    internal readonly IsolationLevel DefaultIsolation;
+    internal readonly SQLiteDateFormats DateFormat;
+    internal readonly SQLiteOpenFlagsEnum Flags;
+    internal readonly int LookasideSlotSize;
+    internal readonly int LookasideSlotCount;
+    /// <summary>
+    /// The soft heap limit to set, or null to leave it alone
+    /// </summary>
+    internal readonly long? SoftHeapLimit;
+    internal readonly int StatementCacheSize;
+    internal readonly SqliteBusyStrategy BusyStrategy;
+    internal readonly bool BinaryGuid;
+    internal readonly string Password;
+    internal readonly bool Enlist;
+    /// <summary>
+    /// The PRAGMA commands to run on a newly opened handle, as a single command text
+    /// </summary>
+    internal readonly string Pragmas;
+
+    /// <summary>
+    /// Returns the parsed settings of a connection string
+    /// </summary>
+    /// <param name="connectionString">The connection string to parse</param>
+    internal static SqliteConnectionOptions Get(string connectionString)
+    {
+      SqliteConnectionOptions options;
+      lock (_cache)
+      {
+        if (_cache.TryGetValue(connectionString, out options))
+          return options;
+      }
+
+      options = new SqliteConnectionOptions(SqliteConnection.ParseConnectionString(connectionString));
+
+      // A password would otherwise stay in memory for the life of the process
+      if (options.Password == null)
+      {
+        lock (_cache)
+        {
+          if (_cache.Count >= MaxCached)
+            _cache.Clear();
+          _cache[connectionString] = options;
+        }
+      }
+      return options;
+    }
+
+    /// <summary>
+    /// Whether a statement is a PRAGMA that may change one of the settings the connection string makes.  Reading a
+    /// setting, which takes no value, does not count.
+    /// </summary>
+    /// <param name="sql">The text of the statement</param>
+    internal static bool ChangesSettings(string sql)
+    {
+      string s = sql.TrimStart();
+      if (s.StartsWith("PRAGMA", StringComparison.OrdinalIgnoreCase) == false || s.IndexOfAny(_assignment) < 0)
+        return false;
+
+      foreach (string pragma in _pragmas)
+      {
+        if (s.IndexOf(pragma, StringComparison.OrdinalIgnoreCase) >= 0)
+          return true;
+      }
+      return false;
+    }
+
+    private SqliteConnectionOptions(Dictionary<string, string> opts)
+    {
+      if (Convert.ToInt32(FindKey(opts, "Version", "3"), CultureInfo.InvariantCulture) != 3)
+      {
+        throw new NotSupportedException("Only SQLite Version 3 is supported at this time");
+      }
+
+      string fileName = FindKey(opts, "Data Source", "");
+      if (String.IsNullOrEmpty(fileName))
+      {
+        fileName = FindKey(opts, "Uri", "");
+        if (String.IsNullOrEmpty(fileName))
+        {
+          throw new ArgumentException("Data Source cannot be empty.  Use :memory: to open an in-memory database");
+        }
+
+        fileName = SqliteConnection.MapUriPath(fileName);
+      }
+      if (String.Compare(fileName, ":MEMORY:", StringComparison.OrdinalIgnoreCase) == 0)
+      {
+        fileName = ":memory:";
+      }
+      FileName = fileName;
+
+      UseUTF16 = SqliteConvert.ToBoolean(FindKey(opts, "UseUTF16Encoding", Boolean.FalseString));
+      DefaultTimeout = Convert.ToInt32(FindKey(opts, "Default Timeout", "30"), CultureInfo.CurrentCulture);
+
+      if (SqliteConvert.ToBoolean(FindKey(opts, "Pooling", Boolean.FalseString)))
+      {
+        PoolOptions = new SqliteConnectionPool.Options(
+          Convert.ToInt32(FindKey(opts, "Min Pool Size", "0"), CultureInfo.InvariantCulture),
+          Convert.ToInt32(FindKey(opts, "Max Pool Size", "100")),
+          Convert.ToInt32(FindKey(opts, "Pool Idle Timeout", "300"), CultureInfo.InvariantCulture),
+          DefaultTimeout);
+      }
+
+      DefaultIsolation = (IsolationLevel)Enum.Parse(typeof(IsolationLevel),
+                                                    FindKey(opts, "Default IsolationLevel", "Serializable"), true);
+      if (DefaultIsolation != IsolationLevel.Serializable && DefaultIsolation != IsolationLevel.ReadCommitted)
+      {
+        throw new NotSupportedException("Invalid Default IsolationLevel specified");
+      }
+
+      DateFormat =
+        (SQLiteDateFormats)Enum.Parse(typeof(SQLiteDateFormats), FindKey(opts, "DateTimeFormat", "ISO8601"), true);
+
+      if (SqliteConvert.ToBoolean(FindKey(opts, "Read Only", Boolean.FalseString)))
+      {
+        Flags |= SQLiteOpenFlagsEnum.ReadOnly;
+      }
+      else
+      {
+        Flags |= SQLiteOpenFlagsEnum.ReadWrite;
+        if (SqliteConvert.ToBoolean(FindKey(opts, "FailIfMissing", Boolean.FalseString)) == false)
+        {
+          Flags |= SQLiteOpenFlagsEnum.Create;
+        }
+      }
+      if (SqliteConvert.ToBoolean(FindKey(opts, "FileProtectionComplete", Boolean.FalseString)))
+      {
+        Flags |= SQLiteOpenFlagsEnum.FileProtectionComplete;
+      }
+      if (SqliteConvert.ToBoolean(FindKey(opts, "FileProtectionCompleteUnlessOpen", Boolean.FalseString)))
+      {
+        Flags |= SQLiteOpenFlagsEnum.FileProtectionCompleteUnlessOpen;
+      }
+      if (SqliteConvert.ToBoolean(FindKey(opts, "FileProtectionCompleteUntilFirstUserAuthentication",
+                                          Boolean.FalseString)))
+      {
+        Flags |= SQLiteOpenFlagsEnum.FileProtectionCompleteUntilFirstUserAuthentication;
+      }
+      if (SqliteConvert.ToBoolean(FindKey(opts, "FileProtectionNone", Boolean.FalseString)))
+      {
+        Flags |= SQLiteOpenFlagsEnum.FileProtectionNone;
+      }
+
+      LookasideSlotSize = Convert.ToInt32(FindKey(opts, "Lookaside Slot Size", "0"), CultureInfo.InvariantCulture);
+      LookasideSlotCount = Convert.ToInt32(FindKey(opts, "Lookaside Slot Count", "-1"), CultureInfo.InvariantCulture);
+
+      string softHeapLimit = FindKey(opts, "Soft Heap Limit", null);
+      if (softHeapLimit != null)
+      {
+        SoftHeapLimit = Convert.ToInt64(softHeapLimit, CultureInfo.InvariantCulture);
+      }
+
+      StatementCacheSize = Convert.ToInt32(FindKey(opts, "Statement Cache Size", "0"), CultureInfo.InvariantCulture);
+      BusyStrategy =
+        (SqliteBusyStrategy)Enum.Parse(typeof(SqliteBusyStrategy), FindKey(opts, "Busy Strategy", "Backoff"), true);
+      BinaryGuid = SqliteConvert.ToBoolean(FindKey(opts, "BinaryGUID", Boolean.TrueString));
+
+      string password = FindKey(opts, "Password", null);
+      if (String.IsNullOrEmpty(password) == false)
+      {
+        Password = password;
+      }
+
+      Enlist = SqliteConvert.ToBoolean(FindKey(opts, "Enlist", Boolean.TrueString));
+      Pragmas = BuildPragmas(opts, fileName);
+    }
+
+    private static string BuildPragmas(Dictionary<string, string> opts, string fileName)
+    {
+      var pragmas = new StringBuilder();
+      string defValue;
+
+      if (fileName != ":memory:")
+      {
+        defValue = FindKey(opts, "Page Size", "1024");
+        if (Convert.ToInt32(defValue, CultureInfo.InvariantCulture) != 1024)
+        {
+          pragmas.AppendFormat(CultureInfo.InvariantCulture, "PRAGMA page_size={0};", defValue);
+        }
+      }
+
+      defValue = FindKey(opts, "Max Page Count", "0");
+      if (Convert.ToInt32(defValue, CultureInfo.InvariantCulture) != 0)
+      {
+        pragmas.AppendFormat(CultureInfo.InvariantCulture, "PRAGMA max_page_count={0};", defValue);
+      }
+
+      defValue = FindKey(opts, "Legacy Format", Boolean.FalseString);
+      pragmas.AppendFormat(CultureInfo.InvariantCulture, "PRAGMA legacy_file_format={0};",
+                           SqliteConvert.ToBoolean(defValue) ? "ON" : "OFF");
+
+      defValue = FindKey(opts, "Synchronous", "Normal");
+      if (String.Compare(defValue, "Full", StringComparison.OrdinalIgnoreCase) != 0)
+      {
+        pragmas.AppendFormat(CultureInfo.InvariantCulture, "PRAGMA synchronous={0};", defValue);
+      }
+
+      defValue = FindKey(opts, "Cache Size", "2000");
+      if (Convert.ToInt32(defValue, CultureInfo.InvariantCulture) != 2000)
+      {
+        pragmas.AppendFormat(CultureInfo.InvariantCulture, "PRAGMA cache_size={0};", defValue);
+      }
+
+      defValue = FindKey(opts, "Mmap Size", null);
+      if (defValue != null)
+      {
+        pragmas.AppendFormat(CultureInfo.InvariantCulture, "PRAGMA mmap_size={0};",
+                             Convert.ToInt64(defValue, CultureInfo.InvariantCulture));
+      }
+
+      defValue = FindKey(opts, "Journal Mode", "Delete");
+      if (String.Compare(defValue, "Default", StringComparison.OrdinalIgnoreCase) != 0)
+      {
+        pragmas.AppendFormat(CultureInfo.InvariantCulture, "PRAGMA journal_mode={0};", defValue);
+      }
+
+      return pragmas.ToString();
+    }
+
+    private static string FindKey(Dictionary<string, string> items, string key, string defValue)
+    {
+      return SqliteConnection.FindKey(items, key, defValue);
+    }
+  }
+}
@@ -1,7 +1,7 @@
 /********************************************************
  * ADO.NET 2.0 Data Provider for SQLite Version 3.X
  * Written by Robert Simpson (robert@blackcastlesoft.com)
- * 
+ *
  * Released to the public domain, use at your own risk!
  ********************************************************/
 
@@ -9,24 +9,75 @@ namespace Mono.Data.Sqlite
 {
   using System;
   using System.Collections.Generic;
+  using System.Threading;
   using MonoDataSqliteWrapper;
 
   internal static class SqliteConnectionPool
   {
+    /// <summary>
+    /// The pool settings of a connection string
+    /// </summary>
+    internal sealed class Options
+    {
+      internal readonly int MinPoolSize;
+      internal readonly int MaxPoolSize;
+      /// <summary>
+      /// Milliseconds a connection can sit idle in the pool before it is closed, or 0 to keep it indefinitely
+      /// </summary>
+      internal readonly uint IdleTimeout;
+      /// <summary>
+      /// Milliseconds to wait for a connection when MaxPoolSize connections are already open
+      /// </summary>
+      internal readonly uint WaitTimeout;
+
+      internal Options(int minPoolSize, int maxPoolSize, int idleTimeoutSeconds, int waitTimeoutSeconds)
+      {
+        if (minPoolSize < 0 || maxPoolSize < 1 || minPoolSize > maxPoolSize)
+          throw new ArgumentException("Min Pool Size must be between 0 and Max Pool Size, and Max Pool Size at least 1");
+
+        MinPoolSize = minPoolSize;
+        MaxPoolSize = maxPoolSize;
+        IdleTimeout = (uint)Math.Max(0, idleTimeoutSeconds) * 1000;
+        WaitTimeout = (uint)Math.Max(0, waitTimeoutSeconds) * 1000;
+      }
+    }
+
+    /// <summary>
+    /// A connection waiting in the pool, together with the statements it had prepared
+    /// </summary>
+    internal sealed class IdleConnection
+    {
+      internal SqliteConnectionHandle Handle;
+      internal SqliteStatementCache StatementCache;
+      /// <summary>
+      /// The PRAGMA commands of the connection string last run on the handle, or null if they are not known to hold
+      /// </summary>
+      internal string Settings;
+      internal uint Since;
+    }
+
     /// <summary>
     /// Keeps track of connections made on a specified file.  The PoolVersion dictates whether old objects get
-    /// returned to the pool or discarded when no longer in use.
+    /// returned to the pool or discarded when no longer in use.  Each pool is its own lock, so connections to
+    /// different files never contend.
     /// </summary>
-    internal class Pool
+    internal sealed class Pool
     {
-      internal readonly Queue<WeakReference> Queue = new Queue<WeakReference>();
+      /// <summary>
+      /// Idle connections, most recently returned last.  Connections are taken from the end, where they are still
+      /// warm, and evicted from the front, where they have been idle longest.
+      /// </summary>
+      internal readonly List<IdleConnection> Idle = new List<IdleConnection>();
       internal int PoolVersion;
-      internal int MaxPoolSize;
+      /// <summary>
+      /// The number of connections that belong to the pool, idle or in use
+      /// </summary>
+      internal int Count;
+      internal Options Options;
 
-      internal Pool(int version, int maxSize)
+      internal Pool(Options options)
       {
-        PoolVersion = version;
-        MaxPoolSize = maxSize;
+        Options = options;
       }
     }
 
@@ -36,86 +87,158 @@ internal Pool(int version, int maxSize)
     private static Dictionary<string, Pool> _connections = new Dictionary<string, Pool>(StringComparer.OrdinalIgnoreCase);
 
     /// <summary>
-    /// The default version number new pools will get
+    /// How often the pools nobody is using get checked for idle connections, in milliseconds
     /// </summary>
-    private static int _poolVersion = 1;
+    private const uint SweepInterval = 10000;
+    private static int _lastSweep = Environment.TickCount;
+
+    private static long _hits;
+    private static long _misses;
+    private static long _waits;
+    private static long _evictions;
 
     /// <summary>
-    /// Attempt to pull a pooled connection out of the queue for active duty
+    /// The number of connections opened by taking an idle connection from a pool
+    /// </summary>
+    internal static long Hits
+    {
+      get { return Interlocked.CompareExchange(ref _hits, 0, 0); }
+    }
+
+    /// <summary>
+    /// The number of connections opened from scratch, because their pool had no idle connection
+    /// </summary>
+    internal static long Misses
+    {
+      get { return Interlocked.CompareExchange(ref _misses, 0, 0); }
+    }
+
+    /// <summary>
+    /// The number of times a connection had to wait because Max Pool Size connections were already open
+    /// </summary>
+    internal static long Waits
+    {
+      get { return Interlocked.CompareExchange(ref _waits, 0, 0); }
+    }
+
+    /// <summary>
+    /// The number of idle connections closed because they exceeded the Pool Idle Timeout
+    /// </summary>
+    internal static long Evictions
+    {
+      get { return Interlocked.CompareExchange(ref _evictions, 0, 0); }
+    }
+
+    /// <summary>
+    /// Attempt to pull a pooled connection out of the pool for active duty.  If there is none and the pool is full,
+    /// waits for another connection to be returned.
     /// </summary>
     /// <param name="fileName">The filename for a desired connection</param>
-    /// <param name="maxPoolSize">The maximum size the connection pool for the filename can be</param>
+    /// <param name="options">The pool settings of the connection</param>
+    /// <param name="pool">The pool the returned connection, or the one the caller opens, belongs to</param>
     /// <param name="version">The pool version the returned connection will belong to</param>
-    /// <returns>Returns NULL if no connections were available.  Even if none are, the poolversion will still be a valid pool version</returns>
-    internal static SqliteConnectionHandle Remove(string fileName, int maxPoolSize, out int version)
+    /// <param name="statementCache">The statements the pooled connection had prepared, if any</param>
+    /// <param name="settings">The PRAGMA commands already run on the pooled connection, if any</param>
+    /// <returns>Returns NULL if no connections were available, in which case the caller opens one and must give it to
+    /// Add(), or call Release() if opening fails</returns>
+    internal static SqliteConnectionHandle Remove(string fileName, Options options, out Pool pool, out int version,
+                                                  out SqliteStatementCache statementCache, out string settings)
     {
+      SweepIfDue();
+
       lock (_connections)
       {
-        Pool queue;
-
-        // Default to the highest pool version
-        version = _poolVersion;
-
-        // If we didn't find a pool for this file, create one even though it will be empty.
-        // We have to do this here because otherwise calling ClearPool() on the file will not work for active connections
-        // that have never seen the pool yet.
-        if (_connections.TryGetValue(fileName, out queue) == false)
+        // We have to create the pool even though it will be empty, because otherwise calling ClearPool() on the file
+        // will not work for active connections that have never seen the pool yet.
+        if (_connections.TryGetValue(fileName, out pool) == false)
         {
-          queue = new Pool(_poolVersion, maxPoolSize);
-          _connections.Add(fileName, queue);
-
-          return null;
+          pool = new Pool(options);
+          _connections.Add(fileName, pool);
         }
+      }
 
-        // We found a pool for this file, so use its version number
-        version = queue.PoolVersion;
-        queue.MaxPoolSize = maxPoolSize;
+      List<IdleConnection> evicted;
+      IdleConnection idle = null;
+      bool timedOut = false;
 
-        ResizePool(queue, false);
+      lock (pool)
+      {
+        pool.Options = options;
+        evicted = Evict(pool);
 
-        // Try and get a pooled connection from the queue
-        while (queue.Queue.Count > 0)
+        var starttick = (uint)Environment.TickCount;
+        bool waited = false;
+        while (true)
         {
-          WeakReference cnn = queue.Queue.Dequeue();
-          SqliteConnectionHandle hdl = cnn.Target as SqliteConnectionHandle;
-          if (hdl != null)
+          if (pool.Idle.Count > 0)
+          {
+            idle = pool.Idle[pool.Idle.Count - 1];
+            pool.Idle.RemoveAt(pool.Idle.Count - 1);
+            Interlocked.Increment(ref _hits);
+            break;
+          }
+
+          if (pool.Count < options.MaxPoolSize)
+          {
+            pool.Count++;
+            Interlocked.Increment(ref _misses);
+            break;
+          }
+
+          if (waited == false)
+          {
+            waited = true;
+            Interlocked.Increment(ref _waits);
+          }
+
+          uint elapsed = (uint)Environment.TickCount - starttick;
+          if (elapsed >= options.WaitTimeout)
           {
-            return hdl;
+            timedOut = true;
+            break;
           }
+
+          Monitor.Wait(pool, (int)(options.WaitTimeout - elapsed));
         }
+
+        version = pool.PoolVersion;
+      }
+
+      Dispose(evicted);
+
+      if (timedOut)
+      {
+        throw new SqliteException((int)SQLiteErrorCode.Busy,
+          "Timed out waiting for a pooled connection: all " + options.MaxPoolSize + " connections are in use");
+      }
+
+      if (idle == null)
+      {
+        statementCache = null;
+        settings = null;
         return null;
       }
+
+      statementCache = idle.StatementCache;
+      settings = idle.Settings;
+      return idle.Handle;
     }
 
     /// <summary>
-    /// Clears out all pooled connections and rev's up the default pool version to force all old active objects
+    /// Clears out all pooled connections and rev's up the pool versions to force all old active objects
     /// not in the pool to get discarded rather than returned to their pools.
     /// </summary>
     internal static void ClearAllPools()
     {
+      List<Pool> pools;
       lock (_connections)
       {
-        foreach (KeyValuePair<string, Pool> pair in _connections)
-        {
-          while (pair.Value.Queue.Count > 0)
-          {
-            WeakReference cnn = pair.Value.Queue.Dequeue();
-            SqliteConnectionHandle hdl = cnn.Target as SqliteConnectionHandle;
-            if (hdl != null)
-            {
-              hdl.Dispose();
-            }
-          }
-          
-          // Keep track of the highest revision so we can go one higher when we're finished
-          if (_poolVersion <= pair.Value.PoolVersion)
-            _poolVersion = pair.Value.PoolVersion + 1;
-        }
-        // All pools are cleared and we have a new highest version number to force all old version active items to get discarded
-        // instead of going back to the queue when they are closed.
-        // We can get away with this because we're pumped up the _poolVersion out of range of all active connections, so they
-        // will all get discarded when they try to put themselves back in their pool.
-        _connections.Clear();
+        pools = new List<Pool>(_connections.Values);
+      }
+
+      foreach (Pool pool in pools)
+      {
+        Clear(pool);
       }
     }
 
@@ -126,67 +249,165 @@ internal static void ClearAllPools()
     /// <param name="fileName">The filename of the pool to clear</param>
     internal static void ClearPool(string fileName)
     {
+      Pool pool;
       lock (_connections)
       {
-        Pool queue;
-        if (_connections.TryGetValue(fileName, out queue) == true)
-        {
-          queue.PoolVersion++;
-          while (queue.Queue.Count > 0)
-          {
-            WeakReference cnn = queue.Queue.Dequeue();
-            SqliteConnectionHandle hdl = cnn.Target as SqliteConnectionHandle;
-            if (hdl != null)
-            {
-              hdl.Dispose();
-            }
-          }
-        }
+        if (_connections.TryGetValue(fileName, out pool) == false)
+          return;
       }
+
+      Clear(pool);
     }
 
     /// <summary>
     /// Return a connection to the pool for someone else to use.
     /// </summary>
-    /// <param name="fileName">The filename of the pool to use</param>
-    /// <param name="hdl">The connection handle to pool</param>
+    /// <param name="pool">The pool the connection was taken from</param>
     /// <param name="version">The pool version the handle was created under</param>
+    /// <param name="hdl">The connection handle to pool</param>
+    /// <param name="statementCache">The statements the connection has prepared, kept with it in the pool</param>
+    /// <param name="settings">The PRAGMA commands run on the connection, or null if they are not known to hold</param>
     /// <remarks>
-    /// If the version numbers don't match between the connection and the pool, then the handle is discarded.
+    /// If the version numbers don't match between the connection and the pool, or the pool has more connections than
+    /// its Max Pool Size allows, then the handle is discarded.
     /// </remarks>
-    internal static void Add(string fileName, SqliteConnectionHandle hdl, int version)
+    internal static void Add(Pool pool, int version, SqliteConnectionHandle hdl, SqliteStatementCache statementCache,
+                             string settings)
     {
-      lock (_connections)
+      List<IdleConnection> evicted;
+      bool keep;
+
+      lock (pool)
       {
-        // If the queue doesn't exist in the pool, then it must've been cleared sometime after the connection was created.
-        Pool queue;
-        if (_connections.TryGetValue(fileName, out queue) == true && version == queue.PoolVersion)
+        keep = version == pool.PoolVersion && pool.Count <= pool.Options.MaxPoolSize;
+        if (keep)
         {
-          ResizePool(queue, true);
-          queue.Queue.Enqueue(new WeakReference(hdl, false));
-          GC.KeepAlive(hdl);
+          var idle = new IdleConnection();
+          idle.Handle = hdl;
+          idle.StatementCache = statementCache;
+          idle.Settings = settings;
+          idle.Since = (uint)Environment.TickCount;
+          pool.Idle.Add(idle);
         }
         else
         {
-          hdl.Dispose();
+          pool.Count--;
         }
+
+        Monitor.Pulse(pool);
+        evicted = Evict(pool);
       }
+
+      if (keep == false)
+      {
+        Dispose(statementCache, hdl);
+      }
+      Dispose(evicted);
+      SweepIfDue();
     }
 
-    private static void ResizePool(Pool queue, bool forAdding)
+    /// <summary>
+    /// Gives up the place in the pool that Remove() reserved for a connection that then failed to open
+    /// </summary>
+    internal static void Release(Pool pool)
     {
-      int target = queue.MaxPoolSize;
+      lock (pool)
+      {
+        pool.Count--;
+        Monitor.Pulse(pool);
+      }
+    }
 
-      if (forAdding && target > 0) target--;
+    private static void Clear(Pool pool)
+    {
+      List<IdleConnection> idle;
+      lock (pool)
+      {
+        pool.PoolVersion++;
+        pool.Count -= pool.Idle.Count;
+        idle = new List<IdleConnection>(pool.Idle);
+        pool.Idle.Clear();
+
+        // Waiters can open new connections in place of the ones discarded
+        Monitor.PulseAll(pool);
+      }
 
-      while (queue.Queue.Count > target)
+      Dispose(idle);
+    }
+
+    /// <summary>
+    /// Removes the connections that have been idle longer than the pool's idle timeout, keeping at least
+    /// Min Pool Size connections.  Must be called with the pool locked; the caller disposes what is returned.
+    /// </summary>
+    private static List<IdleConnection> Evict(Pool pool)
+    {
+      uint timeout = pool.Options.IdleTimeout;
+      if (timeout == 0)
+        return null;
+
+      var now = (uint)Environment.TickCount;
+      int n = 0;
+      while (n < pool.Idle.Count && pool.Count - n > pool.Options.MinPoolSize && now - pool.Idle[n].Since >= timeout)
+        n++;
+
+      if (n == 0)
+        return null;
+
+      List<IdleConnection> evicted = pool.Idle.GetRange(0, n);
+      pool.Idle.RemoveRange(0, n);
+      pool.Count -= n;
+      Interlocked.Add(ref _evictions, n);
+      return evicted;
+    }
+
+    /// <summary>
+    /// Every so often, also evicts idle connections from the pools of files that are no longer being opened
+    /// </summary>
+    private static void SweepIfDue()
+    {
+      int last = _lastSweep;
+      int now = Environment.TickCount;
+      if ((uint)(now - last) < SweepInterval || Interlocked.CompareExchange(ref _lastSweep, now, last) != last)
+        return;
+
+      List<Pool> pools;
+      lock (_connections)
+      {
+        pools = new List<Pool>(_connections.Values);
+      }
+
+      foreach (Pool pool in pools)
       {
-        WeakReference cnn = queue.Queue.Dequeue();
-        SqliteConnectionHandle hdl = cnn.Target as SqliteConnectionHandle;
-        if (hdl != null)
+        List<IdleConnection> evicted;
+        lock (pool)
         {
-          hdl.Dispose();
+          evicted = Evict(pool);
         }
+        Dispose(evicted);
+      }
+    }
+
+    private static void Dispose(List<IdleConnection> idle)
+    {
+      if (idle == null)
+        return;
+
+      foreach (IdleConnection item in idle)
+      {
+        Dispose(item.StatementCache, item.Handle);
+      }
+    }
+
+    private static void Dispose(SqliteStatementCache statementCache, SqliteConnectionHandle hdl)
+    {
+      // Cached statements have to be finalized before the handle is closed
+      if (statementCache != null)
+      {
+        statementCache.Dispose();
+      }
+      if (hdl != null)
+      {
+        hdl.Dispose();
       }
     }
   }
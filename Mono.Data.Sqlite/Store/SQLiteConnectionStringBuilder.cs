@@ -55,6 +55,10 @@ public SqliteConnectionStringBuilder(string connectionString)
     private void Initialize(string cnnString)
     {
       _properties = new Dictionary<string, PropertyInfo>(StringComparer.OrdinalIgnoreCase);
+#if DESKTOP
+      // The desktop base fills a Hashtable of PropertyDescriptors instead
+      FallbackGetProperties(_properties);
+#else
       try
       {
         base.GetProperties(_properties);
@@ -63,6 +67,7 @@ private void Initialize(string cnnString)
       {
         FallbackGetProperties(_properties);
       }
+#endif
 
       if (String.IsNullOrEmpty(cnnString) == false)
         ConnectionString = cnnString;
@@ -145,6 +150,61 @@ public bool Pooling
       }
     }
 
+    /// <summary>
+    /// Gets/Sets the number of pooled connections that are kept open however long they are idle.  The default is 0
+    /// </summary>
+    [DefaultValue(0)]
+    public int MinPoolSize
+    {
+      get
+      {
+        object value;
+        TryGetValue("min pool size", out value);
+        return Convert.ToInt32(value, CultureInfo.InvariantCulture);
+      }
+      set
+      {
+        this["min pool size"] = value;
+      }
+    }
+
+    /// <summary>
+    /// Gets/Sets the maximum number of pooled connections to the database, idle or in use.  The default is 100
+    /// </summary>
+    [DefaultValue(100)]
+    public int MaxPoolSize
+    {
+      get
+      {
+        object value;
+        TryGetValue("max pool size", out value);
+        return Convert.ToInt32(value, CultureInfo.InvariantCulture);
+      }
+      set
+      {
+        this["max pool size"] = value;
+      }
+    }
+
+    /// <summary>
+    /// Gets/Sets the number of seconds a connection can be idle in the pool before it is closed, or 0 to keep idle
+    /// connections open.  The default is 300
+    /// </summary>
+    [DefaultValue(300)]
+    public int PoolIdleTimeout
+    {
+      get
+      {
+        object value;
+        TryGetValue("pool idle timeout", out value);
+        return Convert.ToInt32(value, CultureInfo.InvariantCulture);
+      }
+      set
+      {
+        this["pool idle timeout"] = value;
+      }
+    }
+
     /// <summary>
     /// Gets/Sets whethor not to store GUID's in binary format.  The default is True
     /// which saves space in the database.
@@ -365,6 +425,117 @@ public int CacheSize
       }
     }
 
+    /// <summary>
+    /// Gets/Sets the number of distinct command texts whose prepared statements are cached on the connection.
+    /// 0 disables statement caching.
+    /// </summary>
+    [DefaultValue(0)]
+    public int StatementCacheSize
+    {
+      get
+      {
+        object value;
+        TryGetValue("statement cache size", out value);
+        return Convert.ToInt32(value, CultureInfo.CurrentCulture);
+      }
+      set
+      {
+        this["statement cache size"] = value;
+      }
+    }
+
+    /// <summary>
+    /// Gets/Sets how commands wait when the database is locked by another connection.  Default is "Backoff".
+    /// </summary>
+    [DefaultValue(SqliteBusyStrategy.Backoff)]
+    public SqliteBusyStrategy BusyStrategy
+    {
+      get
+      {
+        object value;
+        TryGetValue("busy strategy", out value);
+        if (value is string)
+          return (SqliteBusyStrategy)Convert.ChangeType(value, typeof(SqliteBusyStrategy), CultureInfo.InvariantCulture);
+        else return (SqliteBusyStrategy)value;
+      }
+      set
+      {
+        this["busy strategy"] = value;
+      }
+    }
+
+    /// <summary>
+    /// Gets/Sets the size in bytes of the slots of the connection's lookaside memory.  0 keeps sqlite's default.
+    /// </summary>
+    [DefaultValue(0)]
+    public int LookasideSlotSize
+    {
+      get
+      {
+        object value;
+        TryGetValue("lookaside slot size", out value);
+        return Convert.ToInt32(value, CultureInfo.CurrentCulture);
+      }
+      set
+      {
+        this["lookaside slot size"] = value;
+      }
+    }
+
+    /// <summary>
+    /// Gets/Sets the number of slots of the connection's lookaside memory.  0 disables it, -1 keeps sqlite's default.
+    /// </summary>
+    [DefaultValue(-1)]
+    public int LookasideSlotCount
+    {
+      get
+      {
+        object value;
+        TryGetValue("lookaside slot count", out value);
+        return Convert.ToInt32(value, CultureInfo.CurrentCulture);
+      }
+      set
+      {
+        this["lookaside slot count"] = value;
+      }
+    }
+
+    /// <summary>
+    /// Gets/Sets the number of bytes of the database file the connection memory-maps.  0 disables memory-mapped I/O.
+    /// </summary>
+    [DefaultValue(0L)]
+    public long MmapSize
+    {
+      get
+      {
+        object value;
+        TryGetValue("mmap size", out value);
+        return Convert.ToInt64(value, CultureInfo.CurrentCulture);
+      }
+      set
+      {
+        this["mmap size"] = value;
+      }
+    }
+
+    /// <summary>
+    /// Gets/Sets the number of bytes of heap sqlite tries to stay under, for the whole process.  0 means no limit.
+    /// </summary>
+    [DefaultValue(0L)]
+    public long SoftHeapLimit
+    {
+      get
+      {
+        object value;
+        TryGetValue("soft heap limit", out value);
+        return Convert.ToInt64(value, CultureInfo.CurrentCulture);
+      }
+      set
+      {
+        this["soft heap limit"] = value;
+      }
+    }
+
     /// <summary>
     /// Gets/Sets the datetime format for the connection.
     /// </summary>
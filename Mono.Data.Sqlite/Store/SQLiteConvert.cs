@@ -57,6 +57,10 @@ public abstract class SqliteConvert
     /// </summary>
     internal SQLiteDateFormats _datetimeFormat;
     /// <summary>
+    /// Scratch space for formatting ISO8601 dates, so the only allocation is the resulting string
+    /// </summary>
+    private char[] _dateBuffer;
+    /// <summary>
     /// Initializes the conversion class
     /// </summary>
     /// <param name="fmt">The default date/time format to use for this instance</param>
@@ -147,6 +151,8 @@ public static string UTF8ToString(IntPtr nativestring, int nativestringlen)
     ///   yyyyMMdd
     ///   HH:mm:ss
     ///   THHmmss
+    /// The yyyy-MM-dd shapes, with an optional time and a trailing Z for UTC values, are parsed without calling
+    /// DateTime.ParseExact().
     /// </remarks>
     /// <param name="dateText">The string containing either a Tick value, a JulianDay double, or an ISO8601-format string</param>
     /// <returns>A DateTime value</returns>
@@ -161,10 +167,104 @@ public DateTime ToDateTime(string dateText)
         case SQLiteDateFormats.UnixEpoch:
           return UnixEpoch.AddSeconds(Convert.ToInt32(dateText, CultureInfo.InvariantCulture));
         default:
+          DateTime value;
+          if (TryParseISO8601(dateText, out value))
+            return value;
           return DateTime.ParseExact(dateText, _datetimeFormats, DateTimeFormatInfo.InvariantInfo, DateTimeStyles.None);
       }
     }
 
+    /// <summary>
+    /// Parses the shapes dates are almost always stored in: yyyy-MM-dd, optionally followed by a space or a T and
+    /// HH:mm, HH:mm:ss or HH:mm:ss.FFFFFFF, optionally followed by Z.
+    /// </summary>
+    /// <param name="text">The text to parse</param>
+    /// <param name="result">The parsed value.  Values ending in Z are DateTimeKind.Utc.</param>
+    /// <returns>False if the text has any other shape, in which case the caller falls back to DateTime.ParseExact()</returns>
+    internal static bool TryParseISO8601(string text, out DateTime result)
+    {
+      result = DateTime.MinValue;
+
+      int length = text.Length;
+      int year, month, day;
+      if (length < 10 || text[4] != '-' || text[7] != '-'
+        || TryParseDigits(text, 0, 4, out year) == false
+        || TryParseDigits(text, 5, 2, out month) == false
+        || TryParseDigits(text, 8, 2, out day) == false)
+        return false;
+
+      if (year < 1 || month < 1 || month > 12 || day < 1 || day > DateTime.DaysInMonth(year, month))
+        return false;
+
+      long ticks = new DateTime(year, month, day).Ticks;
+      DateTimeKind kind = DateTimeKind.Unspecified;
+      int pos = 10;
+
+      if (pos < length)
+      {
+        int hour, minute, second = 0;
+        if ((text[pos] != ' ' && text[pos] != 'T') || length < pos + 6 || text[pos + 3] != ':'
+          || TryParseDigits(text, pos + 1, 2, out hour) == false
+          || TryParseDigits(text, pos + 4, 2, out minute) == false
+          || hour > 23 || minute > 59)
+          return false;
+        pos += 6;
+
+        if (pos < length && text[pos] == ':')
+        {
+          if (length < pos + 3 || TryParseDigits(text, pos + 1, 2, out second) == false || second > 59)
+            return false;
+          pos += 3;
+
+          if (pos < length && text[pos] == '.')
+          {
+            pos++;
+            int digits = 0;
+            long fraction = 0;
+            while (pos < length && digits < 7 && text[pos] >= '0' && text[pos] <= '9')
+            {
+              fraction = fraction * 10 + (text[pos] - '0');
+              digits++;
+              pos++;
+            }
+            if (digits == 0)
+              return false;
+
+            for (; digits < 7; digits++)
+              fraction *= 10;
+            ticks += fraction;
+          }
+        }
+
+        ticks += hour * TimeSpan.TicksPerHour + minute * TimeSpan.TicksPerMinute + second * TimeSpan.TicksPerSecond;
+
+        if (pos < length && text[pos] == 'Z')
+        {
+          kind = DateTimeKind.Utc;
+          pos++;
+        }
+      }
+
+      if (pos != length)
+        return false;
+
+      result = new DateTime(ticks, kind);
+      return true;
+    }
+
+    private static bool TryParseDigits(string text, int start, int count, out int value)
+    {
+      value = 0;
+      for (int n = start; n < start + count; n++)
+      {
+        char c = text[n];
+        if (c < '0' || c > '9')
+          return false;
+        value = value * 10 + (c - '0');
+      }
+      return true;
+    }
+
     /// <summary>
     /// Converts a julianday value into a DateTime
     /// </summary>
@@ -242,7 +342,52 @@ public string ToString(DateTime dateValue)
         case SQLiteDateFormats.UnixEpoch:
           return ((long)(dateValue.Subtract(UnixEpoch).Ticks / TimeSpan.TicksPerSecond)).ToString();
         default:
-          return dateValue.ToString(_datetimeFormats[7], CultureInfo.InvariantCulture);
+          return ToISO8601(dateValue);
+      }
+    }
+
+    /// <summary>
+    /// Formats a DateTime as yyyy-MM-dd HH:mm:ss.FFFFFFF, which is what DateTime.ToString() would produce for
+    /// the same format string: trailing zeros of the fraction are dropped, and so is the dot if nothing is left.
+    /// </summary>
+    private string ToISO8601(DateTime value)
+    {
+      if (_dateBuffer == null)
+        _dateBuffer = new char[27];
+
+      char[] buffer = _dateBuffer;
+      WriteDigits(buffer, 0, 4, value.Year);
+      buffer[4] = '-';
+      WriteDigits(buffer, 5, 2, value.Month);
+      buffer[7] = '-';
+      WriteDigits(buffer, 8, 2, value.Day);
+      buffer[10] = ' ';
+      WriteDigits(buffer, 11, 2, value.Hour);
+      buffer[13] = ':';
+      WriteDigits(buffer, 14, 2, value.Minute);
+      buffer[16] = ':';
+      WriteDigits(buffer, 17, 2, value.Second);
+
+      int length = 19;
+      int fraction = (int)(value.Ticks % TimeSpan.TicksPerSecond);
+      if (fraction != 0)
+      {
+        buffer[19] = '.';
+        WriteDigits(buffer, 20, 7, fraction);
+        length = 27;
+        while (buffer[length - 1] == '0')
+          length--;
+      }
+
+      return new string(buffer, 0, length);
+    }
+
+    private static void WriteDigits(char[] buffer, int start, int count, int value)
+    {
+      for (int n = start + count - 1; n >= start; n--)
+      {
+        buffer[n] = (char)('0' + value % 10);
+        value /= 10;
       }
     }
 
@@ -12,7 +12,10 @@ namespace Mono.Data.Sqlite
   using System.Data.Common;
   using System.Collections.Generic;
   using System.Globalization;
+  using System.IO;
   using System.Reflection;
+  using System.Threading;
+  using System.Threading.Tasks;
 
   /// <summary>
   /// SQLite implementation of DbDataReader.
@@ -30,7 +33,7 @@ public sealed class SqliteDataReader : DbDataReader
     /// <summary>
     /// Current statement being Read()
     /// </summary>
-    private SqliteStatement _activeStatement;
+    internal SqliteStatement _activeStatement;
     /// <summary>
     /// State of the current statement being processed.
     /// -1 = First Step() executed, so the first Read() will be ignored
@@ -63,18 +66,58 @@ public sealed class SqliteDataReader : DbDataReader
     internal bool _disposeCommand;
 
     /// <summary>
-    /// An array of rowid's for the active statement if CommandBehavior.KeyInfo is specified
+    /// The names of the columns of the active statement, as SQLite returns them.  Lookups by name go through _ordinals
+    /// and the materializers, which compare case-insensitively, so the names are not case-folded.
     /// </summary>
-    private List<string> _columns;
+    private string[] _columns;
+    /// <summary>
+    /// The index of each column name, built by the first GetOrdinal() call on the active statement
+    /// </summary>
+    private Dictionary<string, int> _ordinals;
+    /// <summary>
+    /// The SqliteMaterializer last used by GetRecord(), and the statement it was for
+    /// </summary>
+    private object _materializer;
+    private SqliteStatement _materializerStatement;
 
     internal long _version; // Matches the version of the connection
 
+    /// <summary>
+    /// Bumped every time the reader moves off the current row, so borrowed column views can detect they are stale
+    /// </summary>
+    internal int _stepCount;
+
+    /// <summary>
+    /// Bumped per column by every accessor that can make SQLite convert the column's text or blob, which frees the memory
+    /// a view opened by GetStream() or GetTextReader() is reading.  Only allocated once such a view is opened.
+    /// </summary>
+    internal int[] _conversions;
+
+    /// <summary>
+    /// The text of the column last read by GetChars(), which reads a column a chunk at a time
+    /// </summary>
+    private string _charsText;
+    private int _charsOrdinal = -1;
+    private int _charsStepCount;
+
     /// <summary>
     /// Internal constructor, initializes the datareader and sets up to begin executing statements
     /// </summary>
     /// <param name="cmd">The SqliteCommand this data reader is for</param>
     /// <param name="behave">The expected behavior of the data reader</param>
     internal SqliteDataReader(SqliteCommand cmd, CommandBehavior behave)
+      : this(cmd, behave, true)
+    {
+    }
+
+    /// <summary>
+    /// Internal constructor, initializes the datareader
+    /// </summary>
+    /// <param name="cmd">The SqliteCommand this data reader is for</param>
+    /// <param name="behave">The expected behavior of the data reader</param>
+    /// <param name="execute">False to leave executing the first statement to the caller, as ExecuteReaderAsync() does
+    /// with NextResultAsync()</param>
+    internal SqliteDataReader(SqliteCommand cmd, CommandBehavior behave, bool execute)
     {
       _command = cmd;
       _version = _command.Connection._version;
@@ -85,7 +128,7 @@ internal SqliteDataReader(SqliteCommand cmd, CommandBehavior behave)
       _rowsAffected = -1;
       _fieldCount = 0;
 
-      if (_command != null)
+      if (execute && _command != null)
         NextResult();
     }
 
@@ -143,12 +186,13 @@ public override void Close()
         _command = null;
         _activeStatement = null;
         _fieldTypeArray = null;
+        _charsText = null;
     }
 
     /// <summary>
     /// Throw an error if the datareader is closed
     /// </summary>
-    private void CheckClosed()
+    internal void CheckClosed()
     {
       if (_command == null)
         throw new InvalidOperationException("DataReader has been closed");
@@ -311,6 +355,114 @@ public override long GetBytes(int i, long fieldOffset, byte[] buffer, int buffer
       return _activeStatement._sql.GetBytes(_activeStatement, i, (int)fieldOffset, buffer, bufferoffset, length);
     }
 
+    /// <summary>
+    /// Retrieves a blob column as a read-only stream
+    /// </summary>
+    /// <param name="i">The index of the column to retrieve</param>
+    /// <returns>A stream that reads the column data directly, without materializing it into an array first</returns>
+    /// <remarks>
+    /// The stream is only valid for the current row.  Calling Read(), NextResult() or Close() on the reader invalidates it,
+    /// and so does reading the same column as text, with GetString(), GetChars(), GetValue() or the like.
+    /// </remarks>
+    public Stream GetStream(int i)
+    {
+      VerifyType(i, DbType.Binary);
+      return new SqliteColumnStream(this, i, _activeStatement._sql.GetBlobView(_activeStatement, i));
+    }
+
+    /// <summary>
+    /// Opens a stream for incremental I/O on the blob the column of the current row was read from
+    /// </summary>
+    /// <param name="i">The index of the column, which must come straight from a table column</param>
+    /// <param name="writable">Whether the stream can write to the blob as well as read it</param>
+    /// <returns>A stream over the blob in the table, which stays valid after the reader moves on</returns>
+    /// <remarks>
+    /// The row is found from a rowid, oid or _rowid_ column of the same table in the result, or else from its
+    /// INTEGER PRIMARY KEY column.  Select rowid explicitly if the table's primary key spans several columns.
+    /// Unlike GetStream(), the blob is not copied out of the row; it is read a piece at a time as the stream is.
+    /// </remarks>
+    public SqliteBlobStream GetBlobStream(int i, bool writable)
+    {
+      CheckClosed();
+      CheckValidRow();
+      if (i < 0 || i >= _fieldCount)
+        throw new IndexOutOfRangeException();
+
+      SQLiteBase sql = _activeStatement._sql;
+      string database = sql.ColumnDatabaseName(_activeStatement, i);
+      string table = sql.ColumnTableName(_activeStatement, i);
+      string column = sql.ColumnOriginalName(_activeStatement, i);
+      if (String.IsNullOrEmpty(table) || String.IsNullOrEmpty(column))
+        throw new InvalidOperationException("The column does not come from a table column");
+
+      int rowidColumn = -1;
+      for (int n = 0; n < _fieldCount && rowidColumn == -1; n++)
+      {
+        if (IsColumnOf(n, database, table) == false)
+          continue;
+
+        string name = sql.ColumnOriginalName(_activeStatement, n);
+        if (String.Compare(name, "rowid", StringComparison.OrdinalIgnoreCase) == 0 ||
+            String.Compare(name, "oid", StringComparison.OrdinalIgnoreCase) == 0 ||
+            String.Compare(name, "_rowid_", StringComparison.OrdinalIgnoreCase) == 0)
+          rowidColumn = n;
+      }
+      for (int n = 0; n < _fieldCount && rowidColumn == -1; n++)
+      {
+        if (IsColumnOf(n, database, table) == false)
+          continue;
+
+        string dataType;
+        string collSeq;
+        bool notNull;
+        bool primaryKey;
+        bool autoIncrement;
+        sql.ColumnMetaData(database, table, sql.ColumnOriginalName(_activeStatement, n), out dataType, out collSeq,
+          out notNull, out primaryKey, out autoIncrement);
+        if (primaryKey && String.Compare(dataType, "INTEGER", StringComparison.OrdinalIgnoreCase) == 0 &&
+            IsRowidAlias(database, table, sql.ColumnOriginalName(_activeStatement, n)))
+          rowidColumn = n;
+      }
+      if (rowidColumn == -1)
+        throw new InvalidOperationException("The result has no rowid or INTEGER PRIMARY KEY column of table " + table);
+
+      return _command.Connection.OpenBlob(database, table, column, sql.GetInt64(_activeStatement, rowidColumn), writable);
+    }
+
+    /// <summary>
+    /// Returns true if the column is the whole primary key of the table.  An INTEGER column that is only part of a
+    /// composite primary key is not an alias of the rowid.
+    /// </summary>
+    private bool IsRowidAlias(string database, string table, string column)
+    {
+      int keys = 0;
+      bool isKey = false;
+      using (SqliteCommand cmd = _command.Connection.CreateCommand())
+      {
+        cmd.CommandText = String.Format(CultureInfo.InvariantCulture, "PRAGMA \"{0}\".table_info(\"{1}\")",
+          database.Replace("\"", "\"\""), table.Replace("\"", "\"\""));
+        using (SqliteDataReader reader = cmd.ExecuteReader())
+        {
+          while (reader.Read())
+          {
+            if (reader.GetInt64(5) == 0)
+              continue;
+
+            keys++;
+            isKey |= String.Compare(reader.GetString(1), column, StringComparison.OrdinalIgnoreCase) == 0;
+          }
+        }
+      }
+      return keys == 1 && isKey;
+    }
+
+    private bool IsColumnOf(int i, string database, string table)
+    {
+      SQLiteBase sql = _activeStatement._sql;
+      return String.Compare(sql.ColumnTableName(_activeStatement, i), table, StringComparison.OrdinalIgnoreCase) == 0 &&
+             String.Compare(sql.ColumnDatabaseName(_activeStatement, i), database, StringComparison.OrdinalIgnoreCase) == 0;
+    }
+
     /// <summary>
     /// Returns the column as a single character
     /// </summary>
@@ -337,7 +489,52 @@ public override char GetChar(int i)
     public override long GetChars(int i, long fieldoffset, char[] buffer, int bufferoffset, int length)
     {
       VerifyType(i, DbType.String);
-      return _activeStatement._sql.GetChars(_activeStatement, i, (int)fieldoffset, buffer, bufferoffset, length);
+
+      // Convert the column once per row, not once per chunk
+      if (_charsText == null || _charsOrdinal != i || _charsStepCount != _stepCount)
+      {
+        Converting(i);
+        _charsText = _activeStatement._sql.GetText(_activeStatement, i);
+        _charsOrdinal = i;
+        _charsStepCount = _stepCount;
+      }
+      return SQLiteBase.GetChars(_charsText, (int)fieldoffset, buffer, bufferoffset, length);
+    }
+
+    /// <summary>
+    /// Retrieves a text column as a TextReader
+    /// </summary>
+    /// <param name="i">The index of the column to retrieve</param>
+    /// <returns>A reader that decodes the column text as it is read, without materializing it into a string first</returns>
+    /// <remarks>
+    /// The reader is only valid for the current row.  Calling Read(), NextResult() or Close() on the data reader invalidates it,
+    /// and so does reading the same column another way, with GetString(), GetStream(), GetValue() or the like.
+    /// </remarks>
+    public TextReader GetTextReader(int i)
+    {
+      VerifyType(i, DbType.String);
+      Converting(i);
+      return new SqliteColumnTextReader(this, i, _activeStatement._sql.GetTextView(_activeStatement, i));
+    }
+
+    /// <summary>
+    /// Starts tracking conversions of column i for a view that is about to be opened on it
+    /// </summary>
+    /// <returns>The conversion count the view must see unchanged to stay valid</returns>
+    internal int TrackConversions(int i)
+    {
+      if (_conversions == null || _conversions.Length < _fieldCount)
+        _conversions = new int[_fieldCount];
+      return _conversions[i];
+    }
+
+    /// <summary>
+    /// Invalidates the views open on column i, before reading it in a way that can make SQLite convert its value
+    /// </summary>
+    private void Converting(int i)
+    {
+      if (_conversions != null && i >= 0 && i < _conversions.Length)
+        _conversions[i]++;
     }
 
     /// <summary>
@@ -360,6 +557,7 @@ public override string GetDataTypeName(int i)
     public override DateTime GetDateTime(int i)
     {
       VerifyType(i, DbType.DateTime);
+      Converting(i);
       return _activeStatement._sql.GetDateTime(_activeStatement, i);
     }
 
@@ -371,6 +569,7 @@ public override DateTime GetDateTime(int i)
     public override decimal GetDecimal(int i)
     {
       VerifyType(i, DbType.Decimal);
+      Converting(i);
       return Decimal.Parse(_activeStatement._sql.GetText(_activeStatement, i), NumberStyles.AllowDecimalPoint | NumberStyles.AllowExponent  | NumberStyles.AllowLeadingSign, CultureInfo.InvariantCulture);
     }
 
@@ -421,7 +620,10 @@ public override Guid GetGuid(int i)
         return new Guid(buffer);
       }
       else
+      {
+        Converting(i);
         return new Guid(_activeStatement._sql.GetText(_activeStatement, i));
+      }
     }
 
     /// <summary>
@@ -474,10 +676,21 @@ public override string GetName(int i)
     /// <returns>The int i of the column</returns>
     public override int GetOrdinal(string name)
     {
-            var index = _columns.IndexOf(name.ToUpperInvariant());
-            if (index == -1)
-                throw new ArgumentException("Column does not exist.");
-            return index;
+      if (_ordinals == null)
+      {
+        _ordinals = new Dictionary<string, int>(_columns.Length, StringComparer.OrdinalIgnoreCase);
+        for (int n = 0; n < _columns.Length; n++)
+        {
+          // Where names repeat, the first column has the name
+          if (_ordinals.ContainsKey(_columns[n]) == false)
+            _ordinals.Add(_columns[n], n);
+        }
+      }
+
+      int index;
+      if (_ordinals.TryGetValue(name, out index) == false)
+        throw new ArgumentException("Column does not exist.");
+      return index;
     }
 
     /// <summary>
@@ -488,6 +701,7 @@ public override int GetOrdinal(string name)
     public override string GetString(int i)
     {
       VerifyType(i, DbType.String);
+      Converting(i);
       return _activeStatement._sql.GetText(_activeStatement, i);
     }
 
@@ -500,6 +714,7 @@ public override object GetValue(int i)
     {
       SQLiteType typ = GetSQLiteType(i);
 
+      Converting(i);
       return _activeStatement._sql.GetValue(_activeStatement, i, typ);
     }
 
@@ -521,6 +736,48 @@ public override int GetValues(object[] values)
       return nMax;
     }
 
+    /// <summary>
+    /// Builds an object from the current row, setting each of its public properties that has the name of a column
+    /// from that column.  The mapping of columns to properties is worked out on first use and kept for the SQL text,
+    /// and values are read with the typed column accessors rather than GetValue(), without boxing them.
+    /// </summary>
+    /// <typeparam name="T">The type of the object</typeparam>
+    /// <returns>The object</returns>
+    public T GetRecord<T>() where T : class, new()
+    {
+      CheckClosed();
+      CheckValidRow();
+
+      var materializer = _materializer as SqliteMaterializer<T>;
+      if (materializer == null || _materializerStatement != _activeStatement)
+      {
+        materializer = SqliteMaterializer<T>.Get(_activeStatement._sqlStatement, _columns);
+        _materializer = materializer;
+        _materializerStatement = _activeStatement;
+      }
+
+      // The materializer reads the columns straight from the statement
+      if (_conversions != null)
+      {
+        for (int n = 0; n < _conversions.Length; n++)
+          _conversions[n]++;
+      }
+      return materializer.Materialize(this);
+    }
+
+    /// <summary>
+    /// Reads the remaining rows of the resultset into objects, as GetRecord() builds them
+    /// </summary>
+    /// <typeparam name="T">The type of the objects</typeparam>
+    /// <returns>The objects, one per row</returns>
+    public List<T> ReadRecords<T>() where T : class, new()
+    {
+      var records = new List<T>();
+      while (Read())
+        records.Add(GetRecord<T>());
+      return records;
+    }
+
     /// <summary>
     /// Returns True if the resultset has rows that can be fetched
     /// </summary>
@@ -558,6 +815,7 @@ public override bool IsDBNull(int i)
     public override bool NextResult()
     {
       CheckClosed();
+      _stepCount++;
 
       SqliteStatement stmt = null;
       int fieldCount;
@@ -627,22 +885,159 @@ public override bool NextResult()
         }
 
         // Ahh, we found a row-returning resultset eligible to be returned!
-        _activeStatement = stmt;
-        _fieldCount = fieldCount;
-        _fieldTypeArray = null;
+        return ActivateStatement(stmt);
+      }
+    }
+
+    /// <summary>
+    /// Asynchronously moves to the next resultset, with the statements stepped on the connection's worker
+    /// </summary>
+    /// <returns>A task whose result is true if a new resultset is available</returns>
+    public Task<bool> NextResultAsync()
+    {
+      return NextResultAsync(CancellationToken.None);
+    }
+
+    /// <summary>
+    /// Asynchronously moves to the next resultset, with the statements stepped on the connection's worker.  Does the
+    /// same as NextResult(), except that a locked database is waited for without blocking any thread.
+    /// </summary>
+    /// <param name="cancellationToken">Cancels the operation, interrupting the statement running, if any</param>
+    /// <returns>A task whose result is true if a new resultset is available</returns>
+    public Task<bool> NextResultAsync(CancellationToken cancellationToken)
+    {
+      CheckClosed();
+      _stepCount++;
+
+      SqliteWorker worker = _command.Connection.Worker;
+      Task<bool> reset = worker.Run(() =>
+        {
+          if (_activeStatement == null)
+            return false;
+
+          // Reset the previously-executed statement
+          _activeStatement._sql.Reset(_activeStatement);
+          return (_commandBehavior & CommandBehavior.SingleResult) != 0;
+        }, cancellationToken);
+
+      return SqliteWorker.Then(reset, singleResult => singleResult ? SkipResultsAsync(worker, cancellationToken) :
+                                                                     NextStatementAsync(worker, cancellationToken));
+    }
+
+    /// <summary>
+    /// The asynchronous NextResult() loop: executes statements until one returns a resultset
+    /// </summary>
+    private Task<bool> NextStatementAsync(SqliteWorker worker, CancellationToken cancellationToken)
+    {
+      int fieldCount = 0;
+      Task<SqliteStatement> next = worker.Run(() =>
+        {
+          // Get the next statement to execute
+          SqliteStatement stmt = _command.GetStatement(_activeStatementIndex + 1);
+          if (stmt == null)
+            return null;
+
+          if (_readingState < 1)
+            _readingState = 1;
+
+          _activeStatementIndex++;
+          fieldCount = stmt._sql.ColumnCount(stmt);
+          return stmt;
+        }, cancellationToken);
+
+      return SqliteWorker.Then(next, stmt =>
+        {
+          // If we've reached the end of the statements, return false, no more resultsets
+          if (stmt == null)
+            return SqliteWorker.FromResult(false);
+
+          if ((_commandBehavior & CommandBehavior.SchemaOnly) != 0 && fieldCount != 0)
+            return worker.Run(() => ActivateStatement(stmt), cancellationToken);
+
+          return SqliteWorker.Then(stmt._sql.StepAsync(stmt, worker, cancellationToken), row =>
+            {
+              if (row)
+              {
+                _readingState = -1;
+              }
+              else if (fieldCount == 0)
+              {
+                // Not a row-returning resultset, skip to the next statement
+                Task<bool> skipped = worker.Run(() =>
+                  {
+                    if (_rowsAffected == -1) _rowsAffected = 0;
+                    _rowsAffected += stmt._sql.Changes;
+                    stmt._sql.Reset(stmt);
+                    return true;
+                  }, cancellationToken);
+                return SqliteWorker.Then(skipped, ok => NextStatementAsync(worker, cancellationToken));
+              }
+              else
+              {
+                _readingState = 1;
+              }
+              return worker.Run(() => ActivateStatement(stmt), cancellationToken);
+            });
+        });
+    }
+
+    /// <summary>
+    /// The asynchronous SingleResult loop of NextResult(): steps through all remaining statements once
+    /// </summary>
+    private Task<bool> SkipResultsAsync(SqliteWorker worker, CancellationToken cancellationToken)
+    {
+      Task<SqliteStatement> next = worker.Run(() =>
+        {
+          SqliteStatement stmt = _command.GetStatement(_activeStatementIndex + 1);
+          if (stmt != null)
+            _activeStatementIndex++;
+          return stmt;
+        }, cancellationToken);
 
-                var cols = new string[_fieldCount];
+      return SqliteWorker.Then(next, stmt =>
+        {
+          if (stmt == null)
+            return SqliteWorker.FromResult(false);
 
-                // load column names
-                for (int i = 0; i < _fieldCount; i++)
+          Task<bool> stepped = SqliteWorker.Then(stmt._sql.StepAsync(stmt, worker, cancellationToken), row =>
+            worker.Run(() =>
+              {
+                if (stmt._sql.ColumnCount(stmt) == 0)
                 {
-                    cols[i] = _activeStatement._sql.ColumnName(_activeStatement, i).ToUpperInvariant();
+                  if (_rowsAffected == -1) _rowsAffected = 0;
+                  _rowsAffected += stmt._sql.Changes;
                 }
+                stmt._sql.Reset(stmt); // Gotta reset after every step to release any locks and such!
+                return true;
+              }, cancellationToken));
+          return SqliteWorker.Then(stepped, ok => SkipResultsAsync(worker, cancellationToken));
+        });
+    }
 
-                _columns = new List<string>(cols);
+    /// <summary>
+    /// Makes a statement that returned a resultset the active one
+    /// </summary>
+    private bool ActivateStatement(SqliteStatement stmt)
+    {
+      // The first step re-prepares the statement if the schema changed since it was prepared (or cached), so
+      // the column count has to be read again.
+      _activeStatement = stmt;
+      _fieldCount = stmt._sql.ColumnCount(stmt);
+      _fieldTypeArray = null;
 
-        return true;
+      var cols = new string[_fieldCount];
+
+      // load column names
+      for (int i = 0; i < _fieldCount; i++)
+      {
+        cols[i] = _activeStatement._sql.ColumnName(_activeStatement, i);
       }
+
+      _columns = cols;
+      _ordinals = null;
+      _materializer = null;
+
+      return true;
     }
 
     /// <summary>
@@ -680,6 +1075,7 @@ private SQLiteType GetSQLiteType(int i)
     public override bool Read()
     {
       CheckClosed();
+      _stepCount++;
 
       if (_readingState == -1) // First step was already done at the NextResult() level, so don't step again, just return true.
       {
@@ -703,6 +1099,87 @@ public override bool Read()
       return false;
     }
 
+    /// <summary>
+    /// Asynchronously reads the next row from the resultset, stepping the statement on the connection's worker
+    /// </summary>
+    /// <returns>A task whose result is true if a new row was loaded</returns>
+    public Task<bool> ReadAsync()
+    {
+      return ReadAsync(CancellationToken.None);
+    }
+
+    /// <summary>
+    /// Asynchronously reads the next row from the resultset, stepping the statement on the connection's worker.  A
+    /// locked database is waited for without blocking any thread.
+    /// </summary>
+    /// <param name="cancellationToken">Cancels the read, interrupting the statement if it is running</param>
+    /// <returns>A task whose result is true if a new row was loaded</returns>
+    public Task<bool> ReadAsync(CancellationToken cancellationToken)
+    {
+      CheckClosed();
+      _stepCount++;
+
+      if (_readingState == -1) // First step was already done at the NextResult() level, so don't step again
+      {
+        _readingState = 0;
+        return SqliteWorker.FromResult(true);
+      }
+
+      if (_readingState != 0)
+        return SqliteWorker.FromResult(false);
+
+      // Don't read a new row if the command behavior dictates SingleRow.  We've already read the first row.
+      if ((_commandBehavior & CommandBehavior.SingleRow) != 0)
+      {
+        _readingState = 1; // Finished reading rows
+        return SqliteWorker.FromResult(false);
+      }
+
+      Task<bool> step = _activeStatement._sql.StepAsync(_activeStatement, _command.Connection.Worker, cancellationToken);
+      return SqliteWorker.Then(step, row =>
+        {
+          if (row == false)
+            _readingState = 1; // Finished reading rows
+          return SqliteWorker.FromResult(row);
+        });
+    }
+
+    /// <summary>
+    /// Reads the next rows of the resultset into a block, stepping through all of them inside a single call into the
+    /// sqlite wrapper instead of making a call per row and per column.  Read() and ReadBlock() can be mixed; each
+    /// picks up from the row after the last one the other returned.  The values of the rows are in the block, not in
+    /// the reader's Get...() methods.
+    /// </summary>
+    /// <param name="block">The block to read the rows into.  Its previous rows are discarded.</param>
+    /// <returns>The number of rows read, which is 0 once all rows have been read</returns>
+    public int ReadBlock(SqliteRowBlock block)
+    {
+      CheckClosed();
+      if (block == null)
+        throw new ArgumentNullException("block");
+
+      _stepCount++;
+      block.Reset(_fieldCount);
+
+      // As with Read(), SingleRow stops after the first row
+      bool singleRow = (_commandBehavior & CommandBehavior.SingleRow) != 0;
+      if (_readingState == 1 || _activeStatement == null || (singleRow && _readingState == 0))
+      {
+        _readingState = 1;
+        return 0;
+      }
+
+      bool pending = (_readingState == -1); // First step was already done at the NextResult() level
+      bool more = _activeStatement._sql.StepBlock(_activeStatement, block, singleRow ? 1 : block.Capacity, ref pending);
+
+      if (pending)
+        _readingState = -1;
+      else
+        _readingState = (more && !singleRow) ? 0 : 1;
+
+      return block.RowCount;
+    }
+
     /// <summary>
     /// Retrieve the count of records affected by an update/insert command.  Only valid once the data reader is closed!
     /// </summary>
@@ -0,0 +1,93 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ *
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.Threading;
+
+  /// <summary>
+  /// Interrupts a statement that runs past its command's timeout, or whose cancellation token is cancelled, from
+  /// sqlite's progress handler.
+  /// </summary>
+  /// <remarks>
+  /// sqlite calls OnProgress() every Interval virtual machine instructions of a step, on the thread doing the step,
+  /// and abandons the step with SQLITE_INTERRUPT as soon as it returns non-zero.  A statement that holds the lock and
+  /// never returns a row is stopped as well as one that waits for it, without another thread having to call
+  /// sqlite3_interrupt.  The timeout bounds each step, like the busy waits do.
+  /// </remarks>
+  internal sealed class SqliteDeadline
+  {
+    /// <summary>
+    /// The number of virtual machine instructions between two checks of the deadline
+    /// </summary>
+    internal const int Interval = 1000;
+
+    private uint _starttick;
+    private uint _timeout;
+    private CancellationToken _cancellationToken;
+    private bool _expired;
+
+    /// <summary>
+    /// Whether the current step was interrupted because its timeout expired
+    /// </summary>
+    internal bool Expired
+    {
+      get { return _expired; }
+    }
+
+    /// <summary>
+    /// Whether the current step has a timeout or a cancellation token to watch, and so needs the progress handler
+    /// </summary>
+    internal bool Armed
+    {
+      get { return _timeout > 0 || _cancellationToken.CanBeCanceled; }
+    }
+
+    /// <summary>
+    /// Starts the clock for a step
+    /// </summary>
+    /// <param name="timeout">The number of milliseconds after which to interrupt the step, or 0 for no limit</param>
+    /// <param name="cancellationToken">Interrupts the step when cancelled</param>
+    internal void Start(uint timeout, CancellationToken cancellationToken)
+    {
+      _starttick = (uint)Environment.TickCount;
+      _timeout = timeout;
+      _cancellationToken = cancellationToken;
+      _expired = false;
+    }
+
+    /// <summary>
+    /// Stops watching the step, so that sqlite calls made outside of one are never interrupted
+    /// </summary>
+    internal void Stop()
+    {
+      _timeout = 0;
+      _cancellationToken = CancellationToken.None;
+    }
+
+    /// <summary>
+    /// The progress handler
+    /// </summary>
+    /// <returns>Non-zero to interrupt the step</returns>
+    internal int OnProgress(object userState)
+    {
+      if (_cancellationToken.IsCancellationRequested)
+      {
+        return 1;
+      }
+
+      if (_timeout > 0 && (uint)Environment.TickCount - _starttick > _timeout)
+      {
+        _expired = true;
+        return 1;
+      }
+
+      return 0;
+    }
+  }
+}
@@ -46,7 +46,7 @@ private class AggregateData
     /// <summary>
     /// Internal array used to keep track of aggregate function context data
     /// </summary>
-    private Dictionary<SqliteValueHandle, AggregateData> _contextDataList;
+    private Dictionary<long, AggregateData> _contextDataList;
 
     /// <summary>
     /// Holds a reference to the callback function for user functions
@@ -82,7 +82,7 @@ private class AggregateData
     /// </summary>
     protected SqliteFunction()
     {
-      _contextDataList = new Dictionary<SqliteValueHandle, AggregateData>();
+      _contextDataList = new Dictionary<long, AggregateData>();
     }
 
     /// <summary>
@@ -173,38 +173,38 @@ public virtual int Compare(string param1, string param2)
     internal object[] ConvertParams(int nArgs, SqliteValueHandle[] argsptr)
     {
       object[] parms = new object[nArgs];
-      SqliteValueHandle[] argint = new SqliteValueHandle[nArgs];
-      Array.Copy(argsptr, argint, nArgs);
 
       for (int n = 0; n < nArgs; n++)
       {
-        switch (_base.GetParamValueType((SqliteValueHandle)argint[n]))
+        // The handles are only valid during the callback; the wrapper re-points them for the next call
+        SqliteValueHandle arg = argsptr[n];
+        switch (_base.GetParamValueType(arg))
         {
           case TypeAffinity.Null:
             parms[n] = DBNull.Value;
             break;
           case TypeAffinity.Int64:
-            parms[n] = _base.GetParamValueInt64((SqliteValueHandle)argint[n]);
+            parms[n] = _base.GetParamValueInt64(arg);
             break;
           case TypeAffinity.Double:
-            parms[n] = _base.GetParamValueDouble((SqliteValueHandle)argint[n]);
+            parms[n] = _base.GetParamValueDouble(arg);
             break;
           case TypeAffinity.Text:
-            parms[n] = _base.GetParamValueText((SqliteValueHandle)argint[n]);
+            parms[n] = _base.GetParamValueText(arg);
             break;
           case TypeAffinity.Blob:
             {
               int x;
               byte[] blob;
 
-              x = (int)_base.GetParamValueBytes((SqliteValueHandle)argint[n], 0, null, 0, 0);
+              x = (int)_base.GetParamValueBytes(arg, 0, null, 0, 0);
               blob = new byte[x];
-              _base.GetParamValueBytes((SqliteValueHandle)argint[n], 0, blob, 0, x);
+              _base.GetParamValueBytes(arg, 0, blob, 0, x);
               parms[n] = blob;
             }
             break;
           case TypeAffinity.DateTime: // Never happens here but what the heck, maybe it will one day.
-            parms[n] = _base.ToDateTime(_base.GetParamValueText((SqliteValueHandle)argint[n]));
+            parms[n] = _base.ToDateTime(_base.GetParamValueText(arg));
             break;
         }
       }
@@ -306,10 +306,10 @@ internal int CompareCallback16(object ptr, int len1, string ptr1, int len2, stri
     /// <param name="argsptr">A pointer to the array of arguments</param>
     internal void StepCallback(SqliteContextHandle context, int nArgs, SqliteValueHandle[] argsptr)
     {
-      SqliteValueHandle nAux;
+      long nAux;
       AggregateData data;
 
-      nAux = (SqliteValueHandle)_base.AggregateContext(context);
+      nAux = _base.AggregateContext(context);
       if (_contextDataList.TryGetValue(nAux, out data) == false)
       {
         data = new AggregateData();
@@ -333,12 +333,13 @@ internal void StepCallback(SqliteContextHandle context, int nArgs, SqliteValueHa
     /// <param name="context">A raw context pointer</param>
     internal void FinalCallback(SqliteContextHandle context)
     {
-      SqliteValueHandle n = (SqliteValueHandle)_base.AggregateContext(context);
+      long n = _base.AggregateContext(context);
       object obj = null;
+      AggregateData data;
 
-      if (_contextDataList.ContainsKey(n))
+      if (_contextDataList.TryGetValue(n, out data))
       {
-        obj = _contextDataList[n]._data;
+        obj = data._data;
         _contextDataList.Remove(n);
       }
 
@@ -359,7 +360,7 @@ protected virtual void Dispose(bool disposing)
       {
         IDisposable disp;
 
-        foreach (KeyValuePair<SqliteValueHandle, AggregateData> kv in _contextDataList)
+        foreach (KeyValuePair<long, AggregateData> kv in _contextDataList)
         {
           disp = kv.Value._data as IDisposable;
           if (disp != null)
@@ -454,6 +455,8 @@ internal static SqliteFunction[] BindFunctions(SQLiteBase sqlbase)
   /// </summary>
   /// <remarks>
   /// User-defined functions can call the GetCollationSequence() method in this class and use it to compare strings and char arrays.
+  /// The sqlite library used by this provider does not expose the collating sequence of a call, so GetCollationSequence() throws
+  /// NotSupportedException.
   /// </remarks>
   public class SqliteFunctionEx : SqliteFunction
   {
@@ -0,0 +1,229 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ *
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.Collections.Generic;
+  using System.Globalization;
+  using System.Reflection;
+
+  /// <summary>
+  /// Builds objects of type T from the rows of a resultset.
+  /// </summary>
+  /// <remarks>
+  /// Every public settable property of T whose name matches a column, ignoring case, is set from that column.  The
+  /// matching is worked out once per SQL text and set of columns, and kept, so that a row costs one typed call into
+  /// sqlite per property: properties of type long, int, short, byte, bool, double, float, DateTime, string and byte[],
+  /// and their Nullable counterparts, are read with the column accessors for their type, without going through
+  /// GetValue() and boxing.  sqlite converts values stored with another type the way its sqlite3_column_*() functions
+  /// do, NULL becoming 0 for the numeric types; Nullable properties, strings, byte arrays and dates are left at null or
+  /// their default for a NULL.  Properties of any other type are set from GetValue(), converted to their type.
+  /// </remarks>
+  internal sealed class SqliteMaterializer<T> where T : class, new()
+  {
+    /// <summary>
+    /// The materializers built for T, by the SQL text of the statement they were built for
+    /// </summary>
+    private static readonly Dictionary<string, SqliteMaterializer<T>> _cache = new Dictionary<string, SqliteMaterializer<T>>();
+    private const int MaxCached = 256;
+
+    private readonly string[] _columns;
+    private readonly int[] _ordinals;
+    private readonly Action<SqliteDataReader, int, T>[] _setters;
+
+    private static readonly Func<SqliteStatement, int, long> _int64 = (stmt, i) => stmt._sql.GetInt64(stmt, i);
+    private static readonly Func<SqliteStatement, int, int> _int32 = (stmt, i) => stmt._sql.GetInt32(stmt, i);
+    private static readonly Func<SqliteStatement, int, short> _int16 = (stmt, i) => (short)stmt._sql.GetInt32(stmt, i);
+    private static readonly Func<SqliteStatement, int, byte> _byte = (stmt, i) => (byte)stmt._sql.GetInt32(stmt, i);
+    private static readonly Func<SqliteStatement, int, bool> _boolean = (stmt, i) => stmt._sql.GetInt64(stmt, i) != 0;
+    private static readonly Func<SqliteStatement, int, double> _double = (stmt, i) => stmt._sql.GetDouble(stmt, i);
+    private static readonly Func<SqliteStatement, int, float> _single = (stmt, i) => (float)stmt._sql.GetDouble(stmt, i);
+    private static readonly Func<SqliteStatement, int, DateTime> _dateTime = (stmt, i) => stmt._sql.GetDateTime(stmt, i);
+    private static readonly Func<SqliteStatement, int, string> _text = (stmt, i) => stmt._sql.GetText(stmt, i);
+    private static readonly Func<SqliteStatement, int, byte[]> _blob = (stmt, i) =>
+      {
+        var n = (int)stmt._sql.GetBytes(stmt, i, 0, null, 0, 0);
+        var b = new byte[n];
+        stmt._sql.GetBytes(stmt, i, 0, b, 0, n);
+        return b;
+      };
+
+    private SqliteMaterializer(string[] columns)
+    {
+      _columns = columns;
+
+      var properties = new Dictionary<string, PropertyInfo>(StringComparer.OrdinalIgnoreCase);
+      foreach (PropertyInfo property in typeof(T).GetProperties())
+      {
+        MethodInfo setter = property.GetSetMethod();
+        if (setter == null || setter.IsPublic == false || setter.IsStatic || property.GetIndexParameters().Length != 0)
+          continue;
+        properties[property.Name] = property;
+      }
+
+      var ordinals = new List<int>();
+      var setters = new List<Action<SqliteDataReader, int, T>>();
+      for (int n = 0; n < columns.Length; n++)
+      {
+        PropertyInfo property;
+        // A column name that repeats sets the property from its first column only
+        if (properties.TryGetValue(columns[n], out property) == false)
+          continue;
+        properties.Remove(columns[n]);
+
+        ordinals.Add(n);
+        setters.Add(CreateSetter(property));
+      }
+      _ordinals = ordinals.ToArray();
+      _setters = setters.ToArray();
+    }
+
+    /// <summary>
+    /// Returns the materializer for a statement's columns, building it on first use
+    /// </summary>
+    /// <param name="sql">The SQL text of the statement</param>
+    /// <param name="columns">The names of the statement's columns</param>
+    internal static SqliteMaterializer<T> Get(string sql, string[] columns)
+    {
+      SqliteMaterializer<T> materializer;
+      lock (_cache)
+      {
+        // The same text can return other columns once the schema changes
+        if (_cache.TryGetValue(sql, out materializer) && materializer.Matches(columns))
+          return materializer;
+      }
+
+      materializer = new SqliteMaterializer<T>(columns);
+      lock (_cache)
+      {
+        if (_cache.Count >= MaxCached)
+          _cache.Clear();
+        _cache[sql] = materializer;
+      }
+      return materializer;
+    }
+
+    /// <summary>
+    /// Builds an object from the current row of a reader
+    /// </summary>
+    internal T Materialize(SqliteDataReader reader)
+    {
+      T obj = new T();
+      for (int n = 0; n < _setters.Length; n++)
+        _setters[n](reader, _ordinals[n], obj);
+      return obj;
+    }
+
+    private bool Matches(string[] columns)
+    {
+      if (columns.Length != _columns.Length)
+        return false;
+
+      for (int n = 0; n < columns.Length; n++)
+      {
+        if (String.Equals(columns[n], _columns[n], StringComparison.OrdinalIgnoreCase) == false)
+          return false;
+      }
+      return true;
+    }
+
+    private static Action<SqliteDataReader, int, T> CreateSetter(PropertyInfo property)
+    {
+      Type type = property.PropertyType;
+
+      if (type == typeof(long)) return Value(property, _int64);
+      if (type == typeof(int)) return Value(property, _int32);
+      if (type == typeof(short)) return Value(property, _int16);
+      if (type == typeof(byte)) return Value(property, _byte);
+      if (type == typeof(bool)) return Value(property, _boolean);
+      if (type == typeof(double)) return Value(property, _double);
+      if (type == typeof(float)) return Value(property, _single);
+      if (type == typeof(DateTime)) return NotNull(property, _dateTime);
+      if (type == typeof(string)) return NotNull(property, _text);
+      if (type == typeof(byte[])) return NotNull(property, _blob);
+
+      if (type == typeof(long?)) return NullableValue(property, _int64);
+      if (type == typeof(int?)) return NullableValue(property, _int32);
+      if (type == typeof(short?)) return NullableValue(property, _int16);
+      if (type == typeof(byte?)) return NullableValue(property, _byte);
+      if (type == typeof(bool?)) return NullableValue(property, _boolean);
+      if (type == typeof(double?)) return NullableValue(property, _double);
+      if (type == typeof(float?)) return NullableValue(property, _single);
+      if (type == typeof(DateTime?)) return NullableValue(property, _dateTime);
+
+      return Converted(property);
+    }
+
+    private static Action<T, V> Setter<V>(PropertyInfo property)
+    {
+      return (Action<T, V>)property.GetSetMethod().CreateOpenDelegate(typeof(Action<T, V>));
+    }
+
+    /// <summary>
+    /// Sets a property from a column whatever it holds, as sqlite converts NULL to a number
+    /// </summary>
+    private static Action<SqliteDataReader, int, T> Value<V>(PropertyInfo property, Func<SqliteStatement, int, V> get)
+    {
+      Action<T, V> set = Setter<V>(property);
+      return (reader, i, obj) => set(obj, get(reader._activeStatement, i));
+    }
+
+    /// <summary>
+    /// Sets a property from a column that is not NULL
+    /// </summary>
+    private static Action<SqliteDataReader, int, T> NotNull<V>(PropertyInfo property, Func<SqliteStatement, int, V> get)
+    {
+      Action<T, V> set = Setter<V>(property);
+      return (reader, i, obj) =>
+        {
+          SqliteStatement stmt = reader._activeStatement;
+          if (stmt._sql.IsNull(stmt, i) == false)
+            set(obj, get(stmt, i));
+        };
+    }
+
+    private static Action<SqliteDataReader, int, T> NullableValue<V>(PropertyInfo property, Func<SqliteStatement, int, V> get) where V : struct
+    {
+      Action<T, V?> set = Setter<V?>(property);
+      return (reader, i, obj) =>
+        {
+          SqliteStatement stmt = reader._activeStatement;
+          if (stmt._sql.IsNull(stmt, i) == false)
+            set(obj, get(stmt, i));
+        };
+    }
+
+    /// <summary>
+    /// Sets a property of any other type from the column's value, converted to the type of the property
+    /// </summary>
+    private static Action<SqliteDataReader, int, T> Converted(PropertyInfo property)
+    {
+      Type type = Nullable.GetUnderlyingType(property.PropertyType) ?? property.PropertyType;
+      return (reader, i, obj) =>
+        {
+          object value = reader.GetValue(i);
+          if (value == DBNull.Value)
+            return;
+
+          if (type != typeof(object) && value.GetType() != type)
+          {
+            if (type.IsEnum())
+              value = Enum.ToObject(type, value);
+            else if (type == typeof(Guid) && value is string)
+              value = new Guid((string)value);
+            else if (type == typeof(Guid) && value is byte[])
+              value = new Guid((byte[])value);
+            else
+              value = Convert.ChangeType(value, type, CultureInfo.InvariantCulture);
+          }
+
+          property.SetValue(obj, value, null);
+        };
+    }
+  }
+}
@@ -15,7 +15,7 @@ namespace Mono.Data.Sqlite
   /// <summary>
   /// SQLite implementation of DbParameter.
   /// </summary>
-  public sealed class SqliteParameter : DbParameter, ICloneable
+  public class SqliteParameter : DbParameter, ICloneable
   {
     /// <summary>
     /// The data type of the parameter
@@ -45,6 +45,13 @@ public sealed class SqliteParameter : DbParameter, ICloneable
     private bool           _nullable;
     private bool           _nullMapping;
 
+    /// <summary>
+    /// Binds the value to a statement, for as long as the type of the value and the DbType it was chosen for stay the same
+    /// </summary>
+    private Action<SqliteStatement, int, object> _binder;
+    private Type           _binderType;
+    private DbType         _binderDbType;
+
     /// <summary>
     /// Default constructor
     /// </summary>
@@ -190,7 +197,7 @@ public SqliteParameter(string parameterName, DbType parameterType, int parameter
       _nullable = true;
     }
 
-    private SqliteParameter(SqliteParameter source)
+    internal SqliteParameter(SqliteParameter source)
       : this(source.ParameterName, (DbType)source._dbType, 0, source.Direction, source.IsNullable, 0, 0, source.SourceColumn, source.SourceVersion, source.Value)
     {
       _nullMapping = source._nullMapping;
@@ -298,9 +305,10 @@ public override DbType DbType
       {
         if (_dbType == -1)
         {
-          if (_objValue != null && _objValue != DBNull.Value)
+          object value = Value;
+          if (value != null && value != DBNull.Value)
           {
-            return SqliteConvert.TypeToDbType(_objValue.GetType());
+            return SqliteConvert.TypeToDbType(value.GetType());
           }
           return DbType.String; // Unassigned default value is String
         }
@@ -416,6 +424,13 @@ public DataRowVersion SourceVersion
     /// <summary>
     /// Gets and sets the parameter value.  If no datatype was specified, the datatype will assume the type from the value given.
     /// </summary>
+    /// <remarks>
+    /// A long[], int[], double[] or string[] value is bound as the table of the array() table-valued function, whose
+    /// value column holds the elements in order, so that a filter by any number of values is one constant command text:
+    /// <code>SELECT * FROM t WHERE id IN (SELECT value FROM array(@ids))</code>
+    /// The elements are copied when the command executes.  Null strings are NULL values.  Executing such a command on
+    /// Windows Phone, whose SQLite has no sqlite3_bind_pointer, throws NotSupportedException.
+    /// </remarks>
     public override object Value
     {
       get
@@ -440,6 +455,228 @@ public object Clone()
 
       return newparam;
     }
+
+    /// <summary>
+    /// Binds the value of the parameter to a statement
+    /// </summary>
+    /// <param name="stmt">The statement</param>
+    /// <param name="index">The index of the parameter in the statement</param>
+    internal virtual void Bind(SqliteStatement stmt, int index)
+    {
+      object obj = _objValue;
+      if (obj == DBNull.Value || obj == null)
+      {
+        stmt._sql.Bind_Null(stmt, index);
+        return;
+      }
+
+      Type type = obj.GetType();
+      DbType objType = DbType;
+      if (_binder == null || _binderType != type || _binderDbType != objType)
+      {
+        _binder = SqliteStatement.GetBinder(type, objType);
+        _binderType = type;
+        _binderDbType = objType;
+      }
+      _binder(stmt, index, obj);
+    }
+  }
+
+  /// <summary>
+  /// A parameter that holds its value as a T, and binds it to the statement without boxing it.
+  /// </summary>
+  /// <remarks>
+  /// The DbType of the parameter is the one for T, or for the underlying type of a Nullable T.  Values of T bind
+  /// straight from TypedValue when the DbType is left at that; a different DbType, or a Value that is not a T such as
+  /// DBNull.Value, is bound with the conversions of SqliteParameter.
+  /// </remarks>
+  /// <typeparam name="T">The type of the value</typeparam>
+  public sealed class SqliteParameter<T> : SqliteParameter, ICloneable
+  {
+    private static readonly DbType _naturalDbType = SqliteConvert.TypeToDbType(Nullable.GetUnderlyingType(typeof(T)) ?? typeof(T));
+
+    private T    _typedValue;
+    /// <summary>
+    /// Whether the value is _typedValue, rather than the one held by the base class
+    /// </summary>
+    private bool _typed;
+
+    /// <summary>
+    /// Default constructor
+    /// </summary>
+    public SqliteParameter()
+      : base(null, _naturalDbType)
+    {
+    }
+
+    /// <summary>
+    /// Constructs a named parameter given the specified parameter name
+    /// </summary>
+    /// <param name="parameterName">The parameter name</param>
+    public SqliteParameter(string parameterName)
+      : base(parameterName, _naturalDbType)
+    {
+    }
+
+    /// <summary>
+    /// Constructs a named parameter given the specified parameter name and initial value
+    /// </summary>
+    /// <param name="parameterName">The parameter name</param>
+    /// <param name="value">The initial value of the parameter</param>
+    public SqliteParameter(string parameterName, T value)
+      : base(parameterName, _naturalDbType)
+    {
+      TypedValue = value;
+    }
+
+    private SqliteParameter(SqliteParameter<T> source)
+      : base(source)
+    {
+    }
+
+    /// <summary>
+    /// Gets and sets the parameter value as a T
+    /// </summary>
+    public T TypedValue
+    {
+      get
+      {
+        if (_typed == false)
+        {
+          object value = base.Value;
+          return value is T ? (T)value : default(T);
+        }
+        return _typedValue;
+      }
+      set
+      {
+        _typedValue = value;
+        _typed = true;
+        base.Value = null;
+      }
+    }
+
+    /// <summary>
+    /// Gets and sets the parameter value.  A value of type T is kept as the TypedValue.
+    /// </summary>
+    public override object Value
+    {
+      get
+      {
+        return _typed ? _typedValue : base.Value;
+      }
+      set
+      {
+        if (value is T)
+        {
+          TypedValue = (T)value;
+          return;
+        }
+
+        _typedValue = default(T);
+        _typed = false;
+        base.Value = value;
+      }
+    }
+
+    /// <summary>
+    /// Clones a parameter
+    /// </summary>
+    /// <returns>A new, unassociated SqliteParameter&lt;T&gt;</returns>
+    public new object Clone()
+    {
+      return new SqliteParameter<T>(this);
+    }
+
+    internal override void Bind(SqliteStatement stmt, int index)
+    {
+      if (_typed && _dbType == (int)_naturalDbType && SqliteParameterBinder<T>.Bind != null)
+        SqliteParameterBinder<T>.Bind(stmt, index, _typedValue);
+      else if (_typed)
+        BindConverted(stmt, index);
+      else
+        base.Bind(stmt, index);
+    }
+
+    private void BindConverted(SqliteStatement stmt, int index)
+    {
+      object obj = _typedValue;
+      if (obj == DBNull.Value || obj == null)
+        stmt._sql.Bind_Null(stmt, index);
+      else
+        SqliteStatement.GetBinder(obj.GetType(), DbType)(stmt, index, obj);
+    }
+  }
+
+  /// <summary>
+  /// The function that binds values of type T to a statement as the DbType of T, or null for the types that need
+  /// converting first.
+  /// </summary>
+  internal static class SqliteParameterBinder<T>
+  {
+    internal static readonly Action<SqliteStatement, int, T> Bind = (Action<SqliteStatement, int, T>)Create();
+
+    private static object Create()
+    {
+      Type type = typeof(T);
+
+      if (type == typeof(long))
+        return new Action<SqliteStatement, int, long>((stmt, index, value) => stmt._sql.Bind_Int64(stmt, index, value));
+      if (type == typeof(int))
+        return new Action<SqliteStatement, int, int>((stmt, index, value) => stmt._sql.Bind_Int32(stmt, index, value));
+      if (type == typeof(short))
+        return new Action<SqliteStatement, int, short>((stmt, index, value) => stmt._sql.Bind_Int32(stmt, index, value));
+      if (type == typeof(byte))
+        return new Action<SqliteStatement, int, byte>((stmt, index, value) => stmt._sql.Bind_Int32(stmt, index, value));
+      if (type == typeof(bool))
+        return new Action<SqliteStatement, int, bool>((stmt, index, value) => stmt._sql.Bind_Int32(stmt, index, value ? 1 : 0));
+      if (type == typeof(double))
+        return new Action<SqliteStatement, int, double>((stmt, index, value) => stmt._sql.Bind_Double(stmt, index, value));
+      if (type == typeof(float))
+        return new Action<SqliteStatement, int, float>((stmt, index, value) => stmt._sql.Bind_Double(stmt, index, value));
+      if (type == typeof(DateTime))
+        return new Action<SqliteStatement, int, DateTime>((stmt, index, value) => stmt._sql.Bind_DateTime(stmt, index, value));
+      if (type == typeof(string))
+        return new Action<SqliteStatement, int, string>((stmt, index, value) =>
+          {
+            if (value == null) stmt._sql.Bind_Null(stmt, index);
+            else stmt._sql.Bind_Text(stmt, index, value);
+          });
+      if (type == typeof(byte[]))
+        return new Action<SqliteStatement, int, byte[]>((stmt, index, value) =>
+          {
+            if (value == null) stmt._sql.Bind_Null(stmt, index);
+            else stmt._sql.Bind_Blob(stmt, index, value);
+          });
+
+      if (type == typeof(long?))
+        return BindNullable<long>(SqliteParameterBinder<long>.Bind);
+      if (type == typeof(int?))
+        return BindNullable<int>(SqliteParameterBinder<int>.Bind);
+      if (type == typeof(short?))
+        return BindNullable<short>(SqliteParameterBinder<short>.Bind);
+      if (type == typeof(byte?))
+        return BindNullable<byte>(SqliteParameterBinder<byte>.Bind);
+      if (type == typeof(bool?))
+        return BindNullable<bool>(SqliteParameterBinder<bool>.Bind);
+      if (type == typeof(double?))
+        return BindNullable<double>(SqliteParameterBinder<double>.Bind);
+      if (type == typeof(float?))
+        return BindNullable<float>(SqliteParameterBinder<float>.Bind);
+      if (type == typeof(DateTime?))
+        return BindNullable<DateTime>(SqliteParameterBinder<DateTime>.Bind);
+
+      return null;
+    }
+
+    private static Action<SqliteStatement, int, U?> BindNullable<U>(Action<SqliteStatement, int, U> bind) where U : struct
+    {
+      return (stmt, index, value) =>
+        {
+          if (value.HasValue) bind(stmt, index, value.GetValueOrDefault());
+          else stmt._sql.Bind_Null(stmt, index);
+        };
+    }
   }
 
     // TODO : REMOVE
@@ -180,6 +180,20 @@ public SqliteParameter AddWithValue(string parameterName, object value)
       return param;
     }
 
+    /// <summary>
+    /// Adds a named/unnamed parameter that keeps its value as a T, so that binding it does not box it.
+    /// </summary>
+    /// <param name="parameterName">Name of the parameter, or null to indicate an unnamed parameter</param>
+    /// <param name="value">The initial value of the parameter</param>
+    /// <returns>Returns the SqliteParameter&lt;T&gt; object created during the call.</returns>
+    public SqliteParameter<T> AddWithTypedValue<T>(string parameterName, T value)
+    {
+      SqliteParameter<T> param = new SqliteParameter<T>(parameterName, value);
+      Add(param);
+
+      return param;
+    }
+
     /// <summary>
     /// Adds an array of parameters to the collection
     /// </summary>
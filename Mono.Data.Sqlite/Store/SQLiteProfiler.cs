@@ -0,0 +1,436 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ *
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.Collections.Generic;
+  using System.Diagnostics;
+  using MonoDataSqliteWrapper;
+
+  /// <summary>
+  /// Timings and counters of a SQL statement, either summed over every execution of the same statement text or for a
+  /// single execution.
+  /// </summary>
+  /// <remarks>
+  /// An execution starts with the first step after the statement was reset and ends when it is reset again, which the
+  /// data reader does once it has moved past the statement.  A whole SqliteCommand.ExecuteBatch() counts as one
+  /// execution.  EngineTime is measured by sqlite itself and stays zero on platforms whose sqlite wrapper cannot
+  /// register a trace callback; the same goes for whichever of the engine counters the wrapper does not keep.
+  /// </remarks>
+  public sealed class SqliteStatementProfile
+  {
+    /// <summary>
+    /// The number of histogram buckets.  Bucket 0 counts executions that took less than a microsecond, bucket i
+    /// those that took from 2^(i-1) up to 2^i microseconds, and the last bucket everything slower.
+    /// </summary>
+    public const int HistogramBuckets = 32;
+
+    internal readonly string _sql;
+    internal long _executions;
+    internal long _prepares;
+    internal long _rows;
+    internal long _prepareTicks;
+    internal long _stepTicks;
+    internal long _maxStepTicks;
+    internal long _busyTicks;
+    internal long _engineTicks;
+    internal long _fullScanSteps;
+    internal long _sorts;
+    internal long _autoIndexes;
+    internal long _vmSteps;
+    internal long _bytesMarshalled;
+    internal long[] _histogram;
+
+    internal SqliteStatementProfile(string sql, bool histogram)
+    {
+      _sql = sql;
+      if (histogram)
+        _histogram = new long[HistogramBuckets];
+    }
+
+    /// <summary>
+    /// The text of the statement
+    /// </summary>
+    public string Sql
+    {
+      get { return _sql; }
+    }
+
+    /// <summary>
+    /// The number of times the statement was executed
+    /// </summary>
+    public long Executions
+    {
+      get { return _executions; }
+    }
+
+    /// <summary>
+    /// The number of times the statement was prepared.  Fewer than Executions when the statement cache is enabled.
+    /// </summary>
+    public long Prepares
+    {
+      get { return _prepares; }
+    }
+
+    /// <summary>
+    /// The number of rows the statement returned, or for ExecuteBatch() the number of rows it bound
+    /// </summary>
+    public long Rows
+    {
+      get { return _rows; }
+    }
+
+    /// <summary>
+    /// The time spent preparing the statement
+    /// </summary>
+    public TimeSpan PrepareTime
+    {
+      get { return TimeSpan.FromTicks(_prepareTicks); }
+    }
+
+    /// <summary>
+    /// The time spent stepping through the statement, including BusyTime
+    /// </summary>
+    public TimeSpan StepTime
+    {
+      get { return TimeSpan.FromTicks(_stepTicks); }
+    }
+
+    /// <summary>
+    /// The StepTime of the slowest execution
+    /// </summary>
+    public TimeSpan MaxStepTime
+    {
+      get { return TimeSpan.FromTicks(_maxStepTicks); }
+    }
+
+    /// <summary>
+    /// The part of StepTime spent waiting for another connection to release a lock
+    /// </summary>
+    public TimeSpan BusyTime
+    {
+      get { return TimeSpan.FromTicks(_busyTicks); }
+    }
+
+    /// <summary>
+    /// The run time of the statement as measured by sqlite (SQLITE_TRACE_PROFILE), in steps of sqlite's clock, which
+    /// may be as coarse as a millisecond
+    /// </summary>
+    public TimeSpan EngineTime
+    {
+      get { return TimeSpan.FromTicks(_engineTicks); }
+    }
+
+    /// <summary>
+    /// The number of times sqlite stepped forward in a table as part of a full table scan (SQLITE_STMTSTATUS_FULLSCAN_STEP)
+    /// </summary>
+    public long FullScanSteps
+    {
+      get { return _fullScanSteps; }
+    }
+
+    /// <summary>
+    /// The number of sort operations (SQLITE_STMTSTATUS_SORT)
+    /// </summary>
+    public long Sorts
+    {
+      get { return _sorts; }
+    }
+
+    /// <summary>
+    /// The number of rows inserted into automatic indexes (SQLITE_STMTSTATUS_AUTOINDEX)
+    /// </summary>
+    public long AutoIndexes
+    {
+      get { return _autoIndexes; }
+    }
+
+    /// <summary>
+    /// The number of virtual machine operations (SQLITE_STMTSTATUS_VM_STEP)
+    /// </summary>
+    public long VmSteps
+    {
+      get { return _vmSteps; }
+    }
+
+    /// <summary>
+    /// The number of bytes of text and blob values copied out of sqlite
+    /// </summary>
+    public long BytesMarshalled
+    {
+      get { return _bytesMarshalled; }
+    }
+
+    /// <summary>
+    /// Returns the number of executions per StepTime bucket, see HistogramBuckets.  Empty for a single execution.
+    /// </summary>
+    public long[] GetHistogram()
+    {
+      return (_histogram != null) ? (long[])_histogram.Clone() : new long[0];
+    }
+
+    internal void Add(SqliteStatementProfile execution)
+    {
+      _executions += execution._executions;
+      _rows += execution._rows;
+      _stepTicks += execution._stepTicks;
+      _maxStepTicks = Math.Max(_maxStepTicks, execution._stepTicks);
+      _busyTicks += execution._busyTicks;
+      _engineTicks += execution._engineTicks;
+      _fullScanSteps += execution._fullScanSteps;
+      _sorts += execution._sorts;
+      _autoIndexes += execution._autoIndexes;
+      _vmSteps += execution._vmSteps;
+      _bytesMarshalled += execution._bytesMarshalled;
+
+      long micros = execution._stepTicks / 10;
+      int bucket = 0;
+      while (micros > 0 && bucket < HistogramBuckets - 1)
+      {
+        micros >>= 1;
+        bucket++;
+      }
+      _histogram[bucket]++;
+    }
+
+    internal SqliteStatementProfile Clone()
+    {
+      var copy = (SqliteStatementProfile)MemberwiseClone();
+      if (_histogram != null)
+        copy._histogram = (long[])_histogram.Clone();
+      return copy;
+    }
+  }
+
+  /// <summary>
+  /// Raised when an execution of a statement ends on a connection that is profiling its statements
+  /// </summary>
+  /// <param name="sender">The connection that executed the statement</param>
+  /// <param name="e">The timings and counters of the execution</param>
+  public delegate void SqliteStatementCompletedHandler(object sender, SqliteStatementCompletedEventArgs e);
+
+  /// <summary>
+  /// Passed to the StatementCompleted event of a connection
+  /// </summary>
+  public class SqliteStatementCompletedEventArgs : EventArgs
+  {
+    /// <summary>
+    /// The timings and counters of the execution that just ended, with Executions set to 1
+    /// </summary>
+    public readonly SqliteStatementProfile Execution;
+
+    internal SqliteStatementCompletedEventArgs(SqliteStatementProfile execution)
+    {
+      Execution = execution;
+    }
+  }
+
+  /// <summary>
+  /// Collects the timings and counters of the statements executed on a connection, per statement text.
+  /// </summary>
+  /// <remarks>
+  /// The connection's SQLite3 object reports to the profiler around each prepare, step and reset.  The execution in
+  /// progress is kept on the SqliteStatement and only added to the totals when it ends, so the lock is taken once per
+  /// execution rather than once per step.  The totals can be read from any thread.
+  /// </remarks>
+  internal sealed class SqliteProfiler
+  {
+    private const uint SQLITE_TRACE_PROFILE = 2;
+
+#if PORTABLE || (SILVERLIGHT && !WINDOWS_PHONE)
+    // There is no high resolution clock on these platforms
+    private static readonly double _tickLength = 1.0;
+#else
+    private static readonly double _tickLength = (double)TimeSpan.TicksPerSecond / Stopwatch.Frequency;
+#endif
+
+    private readonly Dictionary<string, SqliteStatementProfile> _profiles =
+      new Dictionary<string, SqliteStatementProfile>();
+
+    /// <summary>
+    /// The statement being stepped or reset, which is the one sqlite reports SQLITE_TRACE_PROFILE for
+    /// </summary>
+    private SqliteStatement _current;
+
+    /// <summary>
+    /// Registered with sqlite3_trace_v2 by SQLite3.SetProfiler()
+    /// </summary>
+    internal readonly SqliteTraceDelegate TraceCallback;
+
+    /// <summary>
+    /// Called with each execution once it has been added to the totals
+    /// </summary>
+    internal Action<SqliteStatementProfile> Completed;
+
+    internal SqliteProfiler()
+    {
+      TraceCallback = OnTrace;
+    }
+
+    internal static long Timestamp()
+    {
+#if PORTABLE || (SILVERLIGHT && !WINDOWS_PHONE)
+      return DateTime.UtcNow.Ticks;
+#else
+      return Stopwatch.GetTimestamp();
+#endif
+    }
+
+    /// <summary>
+    /// Returns the TimeSpan ticks elapsed since a Timestamp()
+    /// </summary>
+    private static long Elapsed(long start)
+    {
+      return (long)((Timestamp() - start) * _tickLength);
+    }
+
+    /// <summary>
+    /// Returns a copy of the totals of every statement executed since the profiler was created or cleared
+    /// </summary>
+    internal List<SqliteStatementProfile> GetProfiles()
+    {
+      lock (_profiles)
+      {
+        var profiles = new List<SqliteStatementProfile>(_profiles.Count);
+        foreach (SqliteStatementProfile profile in _profiles.Values)
+        {
+          profiles.Add(profile.Clone());
+        }
+        return profiles;
+      }
+    }
+
+    internal void Clear()
+    {
+      lock (_profiles)
+      {
+        _profiles.Clear();
+      }
+    }
+
+    /// <summary>
+    /// Records a statement that was prepared
+    /// </summary>
+    /// <param name="sql">The text of the statement</param>
+    /// <param name="start">The Timestamp() taken before preparing it</param>
+    internal void Prepared(string sql, long start)
+    {
+      long elapsed = Elapsed(start);
+      lock (_profiles)
+      {
+        SqliteStatementProfile profile = GetProfile(sql);
+        profile._prepares++;
+        profile._prepareTicks += elapsed;
+      }
+    }
+
+    /// <summary>
+    /// Called before stepping a statement, starting a new execution if the statement was reset since its last step
+    /// </summary>
+    /// <returns>The Timestamp() to pass to Stepped()</returns>
+    internal long Stepping(SqliteStatement stmt)
+    {
+      if (stmt._execution == null)
+      {
+        stmt._execution = new SqliteStatementProfile(stmt._sqlStatement, false);
+        stmt._execution._executions = 1;
+      }
+      _current = stmt;
+      return Timestamp();
+    }
+
+    /// <summary>
+    /// Called after stepping a statement, whether or not the step succeeded
+    /// </summary>
+    /// <param name="stmt">The statement</param>
+    /// <param name="start">What Stepping() returned</param>
+    /// <param name="rows">The number of rows the step returned</param>
+    /// <param name="busyTime">How long the step waited for locks</param>
+    internal void Stepped(SqliteStatement stmt, long start, int rows, TimeSpan busyTime)
+    {
+      _current = null;
+
+      SqliteStatementProfile execution = stmt._execution;
+      execution._stepTicks += Elapsed(start);
+      execution._rows += rows;
+      execution._busyTicks += busyTime.Ticks;
+    }
+
+    /// <summary>
+    /// Called before resetting a statement, whose execution may still have to be reported by sqlite
+    /// </summary>
+    internal void Resetting(SqliteStatement stmt)
+    {
+      _current = stmt;
+    }
+
+    /// <summary>
+    /// Counts the bytes of a text or blob value read from a statement
+    /// </summary>
+    internal void Marshalled(SqliteStatement stmt, long bytes)
+    {
+      if (stmt._execution != null)
+      {
+        stmt._execution._bytesMarshalled += bytes;
+      }
+    }
+
+    /// <summary>
+    /// Ends the execution of a statement and adds it to the totals of its text
+    /// </summary>
+    /// <param name="stmt">The statement, which has just been reset</param>
+    /// <param name="fullScanSteps">The SQLITE_STMTSTATUS_FULLSCAN_STEP counter of the execution</param>
+    /// <param name="sorts">The SQLITE_STMTSTATUS_SORT counter of the execution</param>
+    /// <param name="autoIndexes">The SQLITE_STMTSTATUS_AUTOINDEX counter of the execution</param>
+    /// <param name="vmSteps">The SQLITE_STMTSTATUS_VM_STEP counter of the execution</param>
+    internal void Complete(SqliteStatement stmt, int fullScanSteps, int sorts, int autoIndexes, int vmSteps)
+    {
+      _current = null;
+
+      SqliteStatementProfile execution = stmt._execution;
+      stmt._execution = null;
+
+      execution._fullScanSteps = fullScanSteps;
+      execution._sorts = sorts;
+      execution._autoIndexes = autoIndexes;
+      execution._vmSteps = vmSteps;
+
+      lock (_profiles)
+      {
+        GetProfile(execution._sql).Add(execution);
+      }
+
+      Action<SqliteStatementProfile> completed = Completed;
+      if (completed != null)
+      {
+        completed(execution);
+      }
+    }
+
+    private SqliteStatementProfile GetProfile(string sql)
+    {
+      SqliteStatementProfile profile;
+      if (_profiles.TryGetValue(sql, out profile) == false)
+      {
+        profile = new SqliteStatementProfile(sql, true);
+        _profiles.Add(sql, profile);
+      }
+      return profile;
+    }
+
+    private void OnTrace(object userState, uint type, long value)
+    {
+      SqliteStatement stmt = _current;
+      if (type == SQLITE_TRACE_PROFILE && stmt != null && stmt._execution != null)
+      {
+        // sqlite reports nanoseconds
+        stmt._execution._engineTicks += value / 100;
+      }
+    }
+  }
+}
@@ -0,0 +1,288 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ *
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.Globalization;
+
+  /// <summary>
+  /// A block of rows read in one call by SqliteDataReader.ReadBlock(), stored column by column in typed arrays.
+  /// </summary>
+  /// <remarks>
+  /// A block is meant to be reused from one ReadBlock() to the next, so its buffers are only allocated when the number
+  /// of columns changes or a blob doesn't fit.  Values are the values sqlite stored, typed by their storage class:
+  /// the declared column types and the connection's DateTime format are not applied, so a date comes back as the
+  /// string or number it was stored as.
+  /// </remarks>
+  public sealed class SqliteRowBlock
+  {
+    internal readonly int _capacity;
+    internal int _fieldCount;
+    internal int _rowCount;
+    internal int _blobBytes;
+    internal int _blobBytesNeeded;
+    internal byte[] _types;
+    internal long[] _integers;
+    internal double[] _doubles;
+    internal string[] _texts;
+    internal byte[] _blobs;
+    internal int[] _blobOffsets;
+
+    /// <summary>
+    /// Creates a block for up to the given number of rows
+    /// </summary>
+    /// <param name="capacity">The maximum number of rows a single ReadBlock() returns</param>
+    public SqliteRowBlock(int capacity)
+    {
+      if (capacity < 1)
+        throw new ArgumentOutOfRangeException("capacity");
+
+      _capacity = capacity;
+      _blobs = new byte[Math.Min(capacity, 1024) * 16];
+    }
+
+    /// <summary>
+    /// The maximum number of rows in the block
+    /// </summary>
+    public int Capacity
+    {
+      get { return _capacity; }
+    }
+
+    /// <summary>
+    /// The number of rows read into the block by the last ReadBlock()
+    /// </summary>
+    public int RowCount
+    {
+      get { return _rowCount; }
+    }
+
+    /// <summary>
+    /// The number of columns of each row
+    /// </summary>
+    public int FieldCount
+    {
+      get { return _fieldCount; }
+    }
+
+    /// <summary>
+    /// Returns the storage class of a value: Int64, Double, Text, Blob or Null
+    /// </summary>
+    /// <param name="row">The row within the block</param>
+    /// <param name="column">The column</param>
+    public TypeAffinity GetAffinity(int row, int column)
+    {
+      return (TypeAffinity)_types[CellIndex(row, column)];
+    }
+
+    /// <summary>
+    /// Returns true if the value is NULL
+    /// </summary>
+    public bool IsDBNull(int row, int column)
+    {
+      return _types[CellIndex(row, column)] == (byte)TypeAffinity.Null;
+    }
+
+    /// <summary>
+    /// Returns the value as a long.  Integers and floating point values are converted, anything else throws.
+    /// </summary>
+    public long GetInt64(int row, int column)
+    {
+      int cell = CellIndex(row, column);
+      switch ((TypeAffinity)_types[cell])
+      {
+        case TypeAffinity.Int64:
+          return _integers[cell];
+        case TypeAffinity.Double:
+          return (long)_doubles[cell];
+      }
+      throw InvalidCast(cell, typeof(long));
+    }
+
+    /// <summary>
+    /// Returns the value as an int.  Integers and floating point values are converted, anything else throws.
+    /// </summary>
+    public int GetInt32(int row, int column)
+    {
+      return (int)GetInt64(row, column);
+    }
+
+    /// <summary>
+    /// Returns the value as a double.  Integers and floating point values are converted, anything else throws.
+    /// </summary>
+    public double GetDouble(int row, int column)
+    {
+      int cell = CellIndex(row, column);
+      switch ((TypeAffinity)_types[cell])
+      {
+        case TypeAffinity.Double:
+          return _doubles[cell];
+        case TypeAffinity.Int64:
+          return _integers[cell];
+      }
+      throw InvalidCast(cell, typeof(double));
+    }
+
+    /// <summary>
+    /// Returns the value as a string.  Numbers are formatted with the invariant culture; blobs and NULL throw.
+    /// </summary>
+    public string GetString(int row, int column)
+    {
+      int cell = CellIndex(row, column);
+      switch ((TypeAffinity)_types[cell])
+      {
+        case TypeAffinity.Text:
+          return _texts[cell] ?? String.Empty;
+        case TypeAffinity.Int64:
+          return _integers[cell].ToString(CultureInfo.InvariantCulture);
+        case TypeAffinity.Double:
+          return _doubles[cell].ToString("R", CultureInfo.InvariantCulture);
+      }
+      throw InvalidCast(cell, typeof(string));
+    }
+
+    /// <summary>
+    /// Returns a copy of a blob value
+    /// </summary>
+    public byte[] GetBytes(int row, int column)
+    {
+      int cell = CellIndex(row, column);
+      if (_types[cell] != (byte)TypeAffinity.Blob)
+        throw InvalidCast(cell, typeof(byte[]));
+
+      var bytes = new byte[(int)_integers[cell]];
+      Buffer.BlockCopy(_blobs, _blobOffsets[cell], bytes, 0, bytes.Length);
+      return bytes;
+    }
+
+    /// <summary>
+    /// Copies part of a blob value into a buffer, the same way SqliteDataReader.GetBytes() does
+    /// </summary>
+    /// <param name="row">The row within the block</param>
+    /// <param name="column">The column</param>
+    /// <param name="fieldOffset">The offset within the blob to start copying from</param>
+    /// <param name="buffer">The buffer to copy into, or null to get the length of the blob</param>
+    /// <param name="bufferoffset">The offset within the buffer to start copying to</param>
+    /// <param name="length">The maximum number of bytes to copy</param>
+    /// <returns>The number of bytes copied, or the length of the blob if buffer is null</returns>
+    public long GetBytes(int row, int column, long fieldOffset, byte[] buffer, int bufferoffset, int length)
+    {
+      int cell = CellIndex(row, column);
+      if (_types[cell] != (byte)TypeAffinity.Blob)
+        throw InvalidCast(cell, typeof(byte[]));
+
+      long size = _integers[cell];
+      if (buffer == null)
+        return size;
+
+      if (fieldOffset < 0 || fieldOffset > size)
+        throw new ArgumentOutOfRangeException("fieldOffset");
+      if (bufferoffset < 0 || length < 0 || bufferoffset + length > buffer.Length)
+        throw new ArgumentOutOfRangeException("length");
+
+      int count = (int)Math.Min(length, size - fieldOffset);
+      Buffer.BlockCopy(_blobs, _blobOffsets[cell] + (int)fieldOffset, buffer, bufferoffset, count);
+      return count;
+    }
+
+    /// <summary>
+    /// Returns the value as a long, double, string, byte[] or DBNull.Value, depending on its storage class
+    /// </summary>
+    public object GetValue(int row, int column)
+    {
+      int cell = CellIndex(row, column);
+      switch ((TypeAffinity)_types[cell])
+      {
+        case TypeAffinity.Int64:
+          return _integers[cell];
+        case TypeAffinity.Double:
+          return _doubles[cell];
+        case TypeAffinity.Text:
+          return _texts[cell] ?? String.Empty;
+        case TypeAffinity.Blob:
+          return GetBytes(row, column);
+      }
+      return DBNull.Value;
+    }
+
+    /// <summary>
+    /// Empties the block and sizes its buffers for rows of the given number of columns
+    /// </summary>
+    internal void Reset(int fieldCount)
+    {
+      _rowCount = 0;
+      _blobBytes = 0;
+      if (_types == null || fieldCount != _fieldCount)
+      {
+        int cells = _capacity * fieldCount;
+        _types = new byte[cells];
+        _integers = new long[cells];
+        _doubles = new double[cells];
+        _texts = new string[cells];
+        _blobOffsets = new int[cells];
+        _fieldCount = fieldCount;
+      }
+      GrowBlobs();
+    }
+
+    /// <summary>
+    /// Makes room for the blobs of a row that did not fit, keeping the blobs of the rows already in the block
+    /// </summary>
+    internal void GrowBlobs()
+    {
+      if (_blobBytesNeeded > _blobs.Length)
+      {
+        byte[] blobs = new byte[Math.Max(_blobBytesNeeded, _blobs.Length * 2)];
+        Buffer.BlockCopy(_blobs, 0, blobs, 0, _blobBytes);
+        _blobs = blobs;
+      }
+      _blobBytesNeeded = 0;
+    }
+
+    /// <summary>
+    /// Takes in the rows stored from _rowCount up to rowCount, adding their blobs to the running total of BlobBytes()
+    /// </summary>
+    internal void Filled(int rowCount)
+    {
+      for (int column = 0; column < _fieldCount; column++)
+      {
+        for (int row = _rowCount; row < rowCount; row++)
+        {
+          int cell = column * _capacity + row;
+          if (_types[cell] == (byte)TypeAffinity.Blob)
+            _blobBytes = Math.Max(_blobBytes, _blobOffsets[cell] + (int)_integers[cell]);
+        }
+      }
+      _rowCount = rowCount;
+    }
+
+    /// <summary>
+    /// The number of bytes of _blobs used by the rows in the block
+    /// </summary>
+    internal int BlobBytes()
+    {
+      return _blobBytes;
+    }
+
+    private int CellIndex(int row, int column)
+    {
+      if (row < 0 || row >= _rowCount)
+        throw new ArgumentOutOfRangeException("row");
+      if (column < 0 || column >= _fieldCount)
+        throw new ArgumentOutOfRangeException("column");
+
+      return column * _capacity + row;
+    }
+
+    private InvalidCastException InvalidCast(int cell, Type type)
+    {
+      return new InvalidCastException(String.Format(CultureInfo.InvariantCulture, "Cannot convert {0} value to {1}",
+        (TypeAffinity)_types[cell], type.Name));
+    }
+  }
+}
@@ -46,9 +46,27 @@ internal sealed class SqliteStatement : IDisposable
     /// Command this statement belongs to (if any)
     /// </summary>
     internal SqliteCommand     _command;
+    /// <summary>
+    /// The execution in progress when the connection is profiling its statements, from the first step to the reset
+    /// </summary>
+    internal SqliteStatementProfile _execution;
+    /// <summary>
+    /// Whether the statement is a PRAGMA that may change a setting of the connection string, after which a pooled
+    /// connection runs the connection string's PRAGMA commands again when it is next opened
+    /// </summary>
+    internal bool _changesSettings;
 
     private string[] _types;
 
+    /// <summary>
+    /// The index in _paramNames of each parameter name, built by the first MapParameter() call
+    /// </summary>
+    private Dictionary<string, int> _paramOrdinals;
+    /// <summary>
+    /// The same, keyed by the names without their prefix character, for parameters named without one
+    /// </summary>
+    private Dictionary<string, int> _bareParamOrdinals;
+
     /// <summary>
     /// Initializes the statement and attempts to get all information about parameters in the statement
     /// </summary>
@@ -61,6 +79,7 @@ internal SqliteStatement(SQLiteBase sqlbase, SqliteStatementHandle stmt, string
       _sql     = sqlbase;
       _sqlite_stmt = stmt;
       _sqlStatement  = strCommand;
+      _changesSettings = SqliteConnectionOptions.ChangesSettings(strCommand);
 
       // Determine parameters for this statement (if any) and prepare space for them.
       int nCmdStart = 0;
@@ -99,27 +118,53 @@ internal SqliteStatement(SQLiteBase sqlbase, SqliteStatementHandle stmt, string
     /// <param name="p">The parameter to assign it</param>
     internal bool MapParameter(string s, SqliteParameter p)
     {
-      if (_paramNames == null) return false;
-      
-      int startAt = 0;
-      if (s.Length > 0)
-      {
-        if (":$@;".IndexOf(s[0]) == -1)
-          startAt = 1;
-      }
+      if (_paramNames == null || s.Length == 0) return false;
 
-      int x = _paramNames.Length;
-      for (int n = 0; n < x; n++)
+      if (_paramOrdinals == null)
       {
-        if (String.Compare(_paramNames[n], startAt, s, 0, Math.Max(_paramNames[n].Length - startAt, s.Length), StringComparison.OrdinalIgnoreCase) == 0)
+        // Built once for the life of the prepared statement, which the statement cache extends across commands
+        _paramOrdinals = new Dictionary<string, int>(_paramNames.Length, StringComparer.OrdinalIgnoreCase);
+        _bareParamOrdinals = new Dictionary<string, int>(_paramNames.Length, StringComparer.OrdinalIgnoreCase);
+        for (int x = 0; x < _paramNames.Length; x++)
         {
-          _paramValues[n] = p;
-          return true;
+          // Where two names only differ by their prefix, a name without one maps to the first, as it always has
+          string name = _paramNames[x];
+          if (_paramOrdinals.ContainsKey(name) == false)
+            _paramOrdinals.Add(name, x);
+          if (_bareParamOrdinals.ContainsKey(name.Substring(1)) == false)
+            _bareParamOrdinals.Add(name.Substring(1), x);
         }
       }
+
+      // A name given without its prefix matches whatever the prefix is in the SQL
+      bool prefixed = ":$@;".IndexOf(s[0]) != -1;
+
+      int n;
+      if ((prefixed ? _paramOrdinals : _bareParamOrdinals).TryGetValue(s, out n))
+      {
+        _paramValues[n] = p;
+        return true;
+      }
       return false;
     }
 
+    /// <summary>
+    /// Detaches the statement from its command and resets it, so another command with the same text can pick it up
+    /// from the connection's statement cache.
+    /// </summary>
+    /// <returns>False if the statement can't be reused and must be disposed instead</returns>
+    internal bool ResetForReuse()
+    {
+      if (_sql == null || _sqlite_stmt == null || _sql.ResetForReuse(this) == false)
+        return false;
+
+      if (_paramValues != null)
+        Array.Clear(_paramValues, 0, _paramValues.Length);
+
+      _command = null;
+      return true;
+    }
+
     #region IDisposable Members
     /// <summary>
     /// Disposes and finalizes the statement
@@ -134,6 +179,8 @@ public void Dispose()
       
       _paramNames = null;
       _paramValues = null;
+      _paramOrdinals = null;
+      _bareParamOrdinals = null;
       _sql = null;
       _sqlStatement = null;
     }
@@ -163,63 +210,91 @@ private void BindParameter(int index, SqliteParameter param)
       if (param == null)
         throw new SqliteException((int)SQLiteErrorCode.Error, "Insufficient parameters supplied to the command");
 
-      object obj = param.Value;
-      DbType objType = param.DbType;
+      param.Bind(this, index);
+    }
 
-      if (obj == DBNull.Value || obj == null)
-      {
-        _sql.Bind_Null(this, index);
-        return;
-      }
+    /// <summary>
+    /// Returns the function that binds values of the given type as the given DbType.  Parameters keep the one they
+    /// got for as long as their value's type and DbType stay the same, so the switch and the type inference run once
+    /// rather than on every execution, and values that already have the type the DbType is bound as are unboxed
+    /// directly instead of converted.
+    /// </summary>
+    /// <param name="type">The type of the value</param>
+    /// <param name="objType">The DbType of the parameter</param>
+    internal static Action<SqliteStatement, int, object> GetBinder(Type type, DbType objType)
+    {
+      // Arrays bind as the table of array(), whatever DbType was gleaned from them
+      if (type == typeof(long[]))
+        return (stmt, index, obj) => stmt._sql.Bind_Array(stmt, index, (long[])obj, null, null);
+      if (type == typeof(int[]))
+        return (stmt, index, obj) => stmt._sql.Bind_Array(stmt, index, Widen((int[])obj), null, null);
+      if (type == typeof(double[]))
+        return (stmt, index, obj) => stmt._sql.Bind_Array(stmt, index, null, (double[])obj, null);
+      if (type == typeof(string[]))
+        return (stmt, index, obj) => stmt._sql.Bind_Array(stmt, index, null, null, (string[])obj);
 
       if (objType == DbType.Object)
-        objType = SqliteConvert.TypeToDbType(obj.GetType());
+        objType = SqliteConvert.TypeToDbType(type);
 
       switch (objType)
       {
         case DbType.Date:
         case DbType.Time:
         case DbType.DateTime:
-          _sql.Bind_DateTime(this, index, Convert.ToDateTime(obj, CultureInfo.CurrentCulture));
-          break;
+          if (type == typeof(DateTime))
+            return (stmt, index, obj) => stmt._sql.Bind_DateTime(stmt, index, (DateTime)obj);
+          return (stmt, index, obj) => stmt._sql.Bind_DateTime(stmt, index, Convert.ToDateTime(obj, CultureInfo.CurrentCulture));
         case DbType.Int64:
         case DbType.UInt64:
         case DbType.UInt32:
-          _sql.Bind_Int64(this, index, Convert.ToInt64(obj, CultureInfo.CurrentCulture));
-          break;
+          if (type == typeof(long))
+            return (stmt, index, obj) => stmt._sql.Bind_Int64(stmt, index, (long)obj);
+          if (type == typeof(int))
+            return (stmt, index, obj) => stmt._sql.Bind_Int64(stmt, index, (int)obj);
+          return (stmt, index, obj) => stmt._sql.Bind_Int64(stmt, index, Convert.ToInt64(obj, CultureInfo.CurrentCulture));
         case DbType.Boolean:
         case DbType.Int16:
         case DbType.Int32:
         case DbType.UInt16:
         case DbType.SByte:
         case DbType.Byte:
-          _sql.Bind_Int32(this, index, Convert.ToInt32(obj, CultureInfo.CurrentCulture));
-          break;
+          if (type == typeof(int))
+            return (stmt, index, obj) => stmt._sql.Bind_Int32(stmt, index, (int)obj);
+          if (type == typeof(bool))
+            return (stmt, index, obj) => stmt._sql.Bind_Int32(stmt, index, (bool)obj ? 1 : 0);
+          return (stmt, index, obj) => stmt._sql.Bind_Int32(stmt, index, Convert.ToInt32(obj, CultureInfo.CurrentCulture));
         case DbType.Single:
         case DbType.Double:
         case DbType.Currency:
         //case DbType.Decimal: // Dont store decimal as double ... loses precision
-          _sql.Bind_Double(this, index, Convert.ToDouble(obj, CultureInfo.CurrentCulture));
-          break;
+          if (type == typeof(double))
+            return (stmt, index, obj) => stmt._sql.Bind_Double(stmt, index, (double)obj);
+          return (stmt, index, obj) => stmt._sql.Bind_Double(stmt, index, Convert.ToDouble(obj, CultureInfo.CurrentCulture));
         case DbType.Binary:
-          _sql.Bind_Blob(this, index, (byte[])obj);
-          break;
+          return (stmt, index, obj) => stmt._sql.Bind_Blob(stmt, index, (byte[])obj);
         case DbType.Guid:
-          if (_command.Connection._binaryGuid == true)
-            _sql.Bind_Blob(this, index, ((Guid)obj).ToByteArray());
-          else
-            _sql.Bind_Text(this, index, obj.ToString());
-
-          break;
+          return (stmt, index, obj) =>
+            {
+              if (stmt._command.Connection._binaryGuid == true)
+                stmt._sql.Bind_Blob(stmt, index, ((Guid)obj).ToByteArray());
+              else
+                stmt._sql.Bind_Text(stmt, index, obj.ToString());
+            };
         case DbType.Decimal: // Dont store decimal as double ... loses precision
-          _sql.Bind_Text(this, index, Convert.ToDecimal(obj, CultureInfo.CurrentCulture).ToString(CultureInfo.InvariantCulture));
-          break;
+          return (stmt, index, obj) => stmt._sql.Bind_Text(stmt, index, Convert.ToDecimal(obj, CultureInfo.CurrentCulture).ToString(CultureInfo.InvariantCulture));
         default:
-          _sql.Bind_Text(this, index, obj.ToString());
-          break;
+          return (stmt, index, obj) => stmt._sql.Bind_Text(stmt, index, obj.ToString());
       }
     }
 
+    private static long[] Widen(int[] values)
+    {
+      var widened = new long[values.Length];
+      for (int n = 0; n < values.Length; n++)
+        widened[n] = values[n];
+      return widened;
+    }
+
     internal string[] TypeDefinitions
     {
       get { return _types; }
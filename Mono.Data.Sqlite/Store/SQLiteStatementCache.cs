@@ -0,0 +1,220 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ * 
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.Collections.Generic;
+
+  /// <summary>
+  /// Bounded, least-recently-used cache of prepared statements for one open connection, keyed by command text.
+  /// </summary>
+  /// <remarks>
+  /// A command hands its statements back when its text changes or it is disposed, and the next command with the
+  /// same text adopts them instead of calling sqlite3_prepare again.  Cached statements are reset and have their
+  /// bindings cleared.  A statement invalidated by a schema change is rebuilt by SQLite3.Reset() the first time
+  /// it is stepped, just like a statement that was never cached.
+  /// </remarks>
+  internal sealed class SqliteStatementCache : IDisposable
+  {
+    /// <summary>
+    /// The statements prepared for one command text
+    /// </summary>
+    private sealed class Entry
+    {
+      internal string CommandText;
+      internal List<SqliteStatement> Statements;
+      internal string RemainingText;
+    }
+
+    /// <summary>
+    /// The connection the cached statements were prepared on.  Null once the connection has been closed.
+    /// </summary>
+    private SQLiteBase _sql;
+    private readonly int _capacity;
+    private readonly Dictionary<string, LinkedListNode<Entry>> _entries;
+    /// <summary>
+    /// Most recently used entries first
+    /// </summary>
+    private readonly LinkedList<Entry> _lru;
+    private long _hits;
+    private long _misses;
+
+    internal SqliteStatementCache(SQLiteBase sqlbase, int capacity)
+    {
+      _sql = sqlbase;
+      _capacity = capacity;
+      _entries = new Dictionary<string, LinkedListNode<Entry>>(StringComparer.Ordinal);
+      _lru = new LinkedList<Entry>();
+    }
+
+    /// <summary>
+    /// The maximum number of command texts kept in the cache
+    /// </summary>
+    internal int Capacity
+    {
+      get { return _capacity; }
+    }
+
+    /// <summary>
+    /// The number of command texts currently cached
+    /// </summary>
+    internal int Count
+    {
+      get { lock (_entries) return _entries.Count; }
+    }
+
+    internal long Hits
+    {
+      get { return _hits; }
+    }
+
+    internal long Misses
+    {
+      get { return _misses; }
+    }
+
+    /// <summary>
+    /// Removes and returns the statements cached for the given command text.
+    /// </summary>
+    /// <param name="commandText">The full command text</param>
+    /// <param name="statements">The statements prepared so far for the text</param>
+    /// <param name="remainingText">The text that has not been prepared yet, if any</param>
+    /// <returns>True on a cache hit</returns>
+    internal bool TryTake(string commandText, out List<SqliteStatement> statements, out string remainingText)
+    {
+      lock (_entries)
+      {
+        LinkedListNode<Entry> node;
+        if (commandText != null && _entries.TryGetValue(commandText, out node))
+        {
+          _entries.Remove(commandText);
+          _lru.Remove(node);
+          _hits++;
+
+          statements = node.Value.Statements;
+          remainingText = node.Value.RemainingText;
+          return true;
+        }
+
+        _misses++;
+      }
+
+      statements = null;
+      remainingText = null;
+      return false;
+    }
+
+    /// <summary>
+    /// Resets the statements and stores them under the command text, evicting the least recently used entry if the
+    /// cache is full.
+    /// </summary>
+    /// <param name="commandText">The full command text the statements were prepared from</param>
+    /// <param name="statements">The prepared statements</param>
+    /// <param name="remainingText">The text that has not been prepared yet</param>
+    /// <returns>False if the statements were not cached, in which case the caller still owns and must dispose them</returns>
+    internal bool Add(string commandText, List<SqliteStatement> statements, string remainingText)
+    {
+      // A null remaining text means preparing the command failed part way, so the list is not a usable prefix
+      if (String.IsNullOrEmpty(commandText) || statements == null || statements.Count == 0 || remainingText == null)
+        return false;
+
+      SqliteStatement stmt;
+      Entry evicted = null;
+
+      lock (_entries)
+      {
+        if (_sql == null || _entries.ContainsKey(commandText))
+          return false;
+
+        for (int n = 0; n < statements.Count; n++)
+        {
+          stmt = statements[n];
+          if (stmt._sql != _sql || stmt.ResetForReuse() == false)
+            return false;
+        }
+
+        if (_entries.Count >= _capacity)
+        {
+          evicted = _lru.Last.Value;
+          _lru.RemoveLast();
+          _entries.Remove(evicted.CommandText);
+        }
+
+        Entry entry = new Entry();
+        entry.CommandText = commandText;
+        entry.Statements = statements;
+        entry.RemainingText = remainingText;
+        _entries.Add(commandText, _lru.AddFirst(entry));
+      }
+
+      if (evicted != null)
+        DisposeStatements(evicted.Statements);
+
+      return true;
+    }
+
+    /// <summary>
+    /// Finalizes every cached statement
+    /// </summary>
+    internal void Clear()
+    {
+      List<Entry> entries;
+      lock (_entries)
+      {
+        entries = new List<Entry>(_lru);
+        _lru.Clear();
+        _entries.Clear();
+      }
+
+      foreach (Entry entry in entries)
+        DisposeStatements(entry.Statements);
+    }
+
+    /// <summary>
+    /// Stops accepting statements while the connection waits in the pool.  The cached statements stay prepared.
+    /// </summary>
+    internal void Detach()
+    {
+      lock (_entries)
+        _sql = null;
+    }
+
+    /// <summary>
+    /// Hands the cached statements of a pooled connection to the connection that took it out of the pool
+    /// </summary>
+    /// <param name="sqlbase">The new owner of the connection handle</param>
+    internal void Attach(SQLiteBase sqlbase)
+    {
+      lock (_entries)
+      {
+        _sql = sqlbase;
+        foreach (Entry entry in _lru)
+        {
+          for (int n = 0; n < entry.Statements.Count; n++)
+            entry.Statements[n]._sql = sqlbase;
+        }
+      }
+    }
+
+    /// <summary>
+    /// Finalizes every cached statement and stops accepting new ones.  Called when the connection closes, since
+    /// sqlite3_close() fails while statements are still outstanding.
+    /// </summary>
+    public void Dispose()
+    {
+      Detach();
+      Clear();
+    }
+
+    private static void DisposeStatements(List<SqliteStatement> statements)
+    {
+      for (int n = 0; n < statements.Count; n++)
+        statements[n].Dispose();
+    }
+  }
+}
@@ -0,0 +1,229 @@
+/********************************************************
+ * ADO.NET 2.0 Data Provider for SQLite Version 3.X
+ * Written by Robert Simpson (robert@blackcastlesoft.com)
+ *
+ * Released to the public domain, use at your own risk!
+ ********************************************************/
+
+namespace Mono.Data.Sqlite
+{
+  using System;
+  using System.Collections.Generic;
+  using System.Threading;
+  using System.Threading.Tasks;
+
+  /// <summary>
+  /// Runs the asynchronous operations of a connection one at a time and in order, on a thread of its own.
+  /// </summary>
+  /// <remarks>
+  /// Calls into sqlite block for as long as the disk I/O or the lock wait they do, so the ...Async() methods of
+  /// commands and readers queue them here instead of tying up the caller's thread or one of the thread pool's.  The
+  /// thread is started by the connection's first asynchronous operation and ends when the connection is closed.
+  /// Cancelling an operation's token while it runs interrupts the connection with sqlite3_interrupt(), which makes
+  /// the call in progress fail with SQLITE_INTERRUPT and the operation's task end up cancelled.  Tasks complete on the
+  /// thread pool, never on the worker, so a continuation that blocks cannot stall the connection's queue.
+  /// </remarks>
+  internal sealed class SqliteWorker
+  {
+    /// <summary>
+    /// The worker whose thread is the current one, if any
+    /// </summary>
+    [ThreadStatic]
+    private static SqliteWorker _current;
+
+    private readonly SqliteConnection _cnn;
+    private readonly Queue<Action> _queue = new Queue<Action>();
+    private readonly AutoResetEvent _wake = new AutoResetEvent(false);
+    private readonly Task _task;
+    private bool _stopping;
+    private bool _stoppedSelf;
+
+    internal SqliteWorker(SqliteConnection cnn)
+    {
+      _cnn = cnn;
+      _task = Task.Factory.StartNew(Run, TaskCreationOptions.LongRunning);
+    }
+
+    /// <summary>
+    /// Queues a piece of work for the connection
+    /// </summary>
+    /// <param name="work">The work, which runs on the worker's thread</param>
+    /// <param name="cancellationToken">Cancels the work before it starts, or interrupts it while it runs</param>
+    /// <returns>A task with the result of the work</returns>
+    internal Task<T> Run<T>(Func<T> work, CancellationToken cancellationToken)
+    {
+      var source = new TaskCompletionSource<T>();
+
+      Action item = () =>
+        {
+          if (cancellationToken.IsCancellationRequested)
+          {
+            Complete(source, default(T), null, true);
+            return;
+          }
+
+          T result = default(T);
+          Exception error = null;
+          using (cancellationToken.Register(Interrupt))
+          {
+            try
+            {
+              result = work();
+            }
+            catch (Exception ex)
+            {
+              error = ex;
+            }
+          }
+
+          // An interrupted call fails, but the operation was cancelled rather than wrong
+          var sqliteError = error as SqliteException;
+          bool cancelled = cancellationToken.IsCancellationRequested && sqliteError != null &&
+                           sqliteError.ErrorCode == SQLiteErrorCode.Interrupt;
+          Complete(source, result, cancelled ? null : error, cancelled);
+        };
+
+      lock (_queue)
+      {
+        if (_stopping)
+          throw new InvalidOperationException("Connection was closed, statement was terminated");
+
+        _queue.Enqueue(item);
+
+        // Set under the lock, so it cannot come after Stop() has disposed of the event
+        _wake.Set();
+      }
+
+      return source.Task;
+    }
+
+    /// <summary>
+    /// Lets the work already queued finish and ends the thread.  Called when the connection is closed.
+    /// </summary>
+    internal void Stop()
+    {
+      lock (_queue)
+      {
+        _stopping = true;
+      }
+      _wake.Set();
+
+      // The worker cannot wait for itself, as when a reader it runs closes the connection with it.  It disposes of
+      // the event on its way out then.
+      if (_current != this)
+      {
+        _task.Wait();
+        _wake.Dispose();
+      }
+      else
+        _stoppedSelf = true;
+    }
+
+    private void Interrupt()
+    {
+      SQLiteBase sql = _cnn._sql;
+      if (sql != null)
+        sql.Cancel();
+    }
+
+    private void Run()
+    {
+      _current = this;
+      while (true)
+      {
+        Action item = null;
+        lock (_queue)
+        {
+          if (_queue.Count > 0)
+            item = _queue.Dequeue();
+          else if (_stopping)
+            break;
+        }
+
+        if (item != null)
+          item();
+        else
+          _wake.WaitOne();
+      }
+      _current = null;
+
+      if (_stoppedSelf)
+        _wake.Dispose();
+    }
+
+    internal static void Complete<T>(TaskCompletionSource<T> source, T result, Exception error, bool cancelled)
+    {
+      // Completed here, the continuations that run synchronously, awaits among them, would run on the worker's thread
+      Task.Factory.StartNew(() =>
+        {
+          if (cancelled)
+            source.TrySetCanceled();
+          else if (error != null)
+            source.TrySetException(error);
+          else
+            source.TrySetResult(result);
+        });
+    }
+
+    /// <summary>
+    /// Returns a task that has already completed with the given result
+    /// </summary>
+    internal static Task<T> FromResult<T>(T result)
+    {
+      var source = new TaskCompletionSource<T>();
+      source.SetResult(result);
+      return source.Task;
+    }
+
+    /// <summary>
+    /// Chains an asynchronous step after a task, passing its result along.  If the task fails or is cancelled, the
+    /// returned task does the same without the step running.
+    /// </summary>
+    internal static Task<TResult> Then<T, TResult>(Task<T> task, Func<T, Task<TResult>> next)
+    {
+      var source = new TaskCompletionSource<TResult>();
+      task.ContinueWith(t =>
+        {
+          if (t.IsCanceled)
+          {
+            source.TrySetCanceled();
+            return;
+          }
+          if (t.IsFaulted)
+          {
+            source.TrySetException(t.Exception.InnerExceptions);
+            return;
+          }
+
+          Task<TResult> following;
+          try
+          {
+            following = next(t.Result);
+          }
+          catch (Exception ex)
+          {
+            source.TrySetException(ex);
+            return;
+          }
+          Forward(following, source);
+        }, TaskContinuationOptions.ExecuteSynchronously);
+      return source.Task;
+    }
+
+    /// <summary>
+    /// Completes a task source the way a task completed
+    /// </summary>
+    internal static void Forward<T>(Task<T> task, TaskCompletionSource<T> source)
+    {
+      task.ContinueWith(t =>
+        {
+          if (t.IsCanceled)
+            source.TrySetCanceled();
+          else if (t.IsFaulted)
+            source.TrySetException(t.Exception.InnerExceptions);
+          else
+            source.TrySetResult(t.Result);
+        }, TaskContinuationOptions.ExecuteSynchronously);
+    }
+  }
+}
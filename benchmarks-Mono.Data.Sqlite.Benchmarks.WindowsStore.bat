@@ -0,0 +1,2 @@
+"C:\Program Files\Microsoft Visual Studio 12.0\Common7\IDE\CommonExtensions\Microsoft\TestWindow\vstest.console.exe" "Mono.Data.Sqlite.Benchmarks\WindowsStore\AppPackages\Mono.Data.Sqlite.Benchmarks.WindowsStore_1.0.0.0_ARM_Release_Test\Mono.Data.Sqlite.Benchmarks.WindowsStore_1.0.0.0_ARM_Release.appx" /logger:trx
+pause
\ No newline at end of file